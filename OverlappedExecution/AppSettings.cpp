@@ -3,6 +3,13 @@
 
 using namespace SampleFramework12;
 
+static const char* MonitorWaitModesLabels[] =
+{
+    "Spin",
+    "Yield",
+    "Backoff",
+};
+
 namespace AppSettings
 {
     static SettingsContainer Settings;
@@ -13,6 +20,9 @@ namespace AppSettings
     BoolSetting StablePowerState;
     BoolSetting UseHiPriorityComputeQueue;
     BoolSetting ShowWorkloadUI;
+    BoolSetting ShowSimulatedTimeline;
+    MonitorWaitModesSetting MonitorWaitMode;
+    BoolSetting RecordTrace;
 
     ConstantBuffer<AppSettingsCBuffer> CBuffer;
     const uint32 CBufferRegister = 12;
@@ -42,6 +52,15 @@ namespace AppSettings
         ShowWorkloadUI.Initialize("ShowWorkloadUI", "General", "Show Workload UI", "", true);
         Settings.AddSetting(&ShowWorkloadUI);
 
+        ShowSimulatedTimeline.Initialize("ShowSimulatedTimeline", "General", "Show Simulated Timeline", "Overlays the timeline predicted by the CPU simulation of the workloads", false);
+        Settings.AddSetting(&ShowSimulatedTimeline);
+
+        MonitorWaitMode.Initialize("MonitorWaitMode", "General", "Monitor Wait Mode", "Controls how the monitor thread waits between polls of the workload start/end buffers", MonitorWaitModes::Backoff, 3, MonitorWaitModesLabels);
+        Settings.AddSetting(&MonitorWaitMode);
+
+        RecordTrace.Initialize("RecordTrace", "General", "Record Trace", "Records the raw start/end times of every workload to WorkloadTrace.bin. Run with --convert-trace to convert it to Chrome trace JSON.", false);
+        Settings.AddSetting(&RecordTrace);
+
         CBuffer.Initialize(BufferLifetime::Temporary);
     }
 
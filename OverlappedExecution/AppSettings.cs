@@ -1,3 +1,15 @@
+public enum MonitorWaitModes
+{
+    [EnumLabel("Spin")]
+    Spin,
+
+    [EnumLabel("Yield")]
+    Yield,
+
+    [EnumLabel("Backoff")]
+    Backoff,
+}
+
 public class Settings
 {
     const int MaxWorkloadElements = 1024 * 256;
@@ -30,5 +42,17 @@ public class Settings
 
         [UseAsShaderConstant(false)]
         bool ShowWorkloadUI = true;
+
+        [UseAsShaderConstant(false)]
+        [HelpText("Overlays the timeline predicted by the CPU simulation of the workloads")]
+        bool ShowSimulatedTimeline = false;
+
+        [UseAsShaderConstant(false)]
+        [HelpText("Controls how the monitor thread waits between polls of the workload start/end buffers")]
+        MonitorWaitModes MonitorWaitMode = MonitorWaitModes.Backoff;
+
+        [UseAsShaderConstant(false)]
+        [HelpText("Records the raw start/end times of every workload to WorkloadTrace.bin. Run with --convert-trace to convert it to Chrome trace JSON.")]
+        bool RecordTrace = false;
     }
 }
\ No newline at end of file
@@ -6,6 +6,17 @@
 
 using namespace SampleFramework12;
 
+enum class MonitorWaitModes
+{
+    Spin = 0,
+    Yield = 1,
+    Backoff = 2,
+
+    NumValues
+};
+
+typedef EnumSettingT<MonitorWaitModes> MonitorWaitModesSetting;
+
 namespace AppSettings
 {
     static const int64 MaxWorkloadElements = 262144;
@@ -20,6 +31,9 @@ namespace AppSettings
     extern BoolSetting StablePowerState;
     extern BoolSetting UseHiPriorityComputeQueue;
     extern BoolSetting ShowWorkloadUI;
+    extern BoolSetting ShowSimulatedTimeline;
+    extern MonitorWaitModesSetting MonitorWaitMode;
+    extern BoolSetting RecordTrace;
 
     struct AppSettingsCBuffer
     {
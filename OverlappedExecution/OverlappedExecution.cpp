@@ -10,6 +10,7 @@
 
 #include <PCH.h>
 
+#include <FileIO.h>
 #include <Input.h>
 #include <Utility.h>
 #include <ImGuiHelper.h>
@@ -23,6 +24,9 @@
 
 using namespace SampleFramework12;
 
+static const wchar* TraceFilePath = L"WorkloadTrace.bin";
+static const uint64 MaxTraceRecords = 64 * 1024;
+
 static const char* WorkloadNames[] =
 {
     "Compute Workload A",
@@ -35,7 +39,7 @@ static const char* WorkloadNames[] =
     "Compute Queue Workload C",
 };
 
-static const WorkloadType WorkloadTypes[] =
+static const WorkloadType DefaultWorkloadTypes[] =
 {
     WorkloadType::Compute,
     WorkloadType::Compute,
@@ -47,12 +51,28 @@ static const WorkloadType WorkloadTypes[] =
     WorkloadType::ComputeQueue,
 };
 
-StaticAssert_(ArraySize_(WorkloadNames) == NumWorkloads);
-StaticAssert_(ArraySize_(WorkloadTypes) == NumWorkloads);
+static const char* WorkloadTypeLabels[] =
+{
+    "Compute",
+    "Graphics",
+    "Compute Queue",
+};
+
+StaticAssert_(ArraySize_(WorkloadNames) == ArraySize_(DefaultWorkloadTypes));
+StaticAssert_(ArraySize_(WorkloadNames) <= MaxWorkloads);
+StaticAssert_(ArraySize_(WorkloadTypeLabels) == uint64(WorkloadType::NumValues));
+StaticAssert_(MaxWorkloads <= MonitorResult::MaxTargets);
+StaticAssert_(MaxWorkloads <= MaxTraceWorkloads);
 
 // Initializes the backing data for a single compute or graphics workload
-static void InitWorkload(Workload& workload, const char* name, WorkloadType type, uint64 workloadIdx)
+static void InitWorkload(Workload& workload, uint64 workloadIdx)
 {
+    if(workloadIdx < ArraySize_(WorkloadNames))
+        workload.Name = WorkloadNames[workloadIdx];
+    else
+        workload.Name = MakeString("Workload %llu", workloadIdx);
+    const char* name = workload.Name.c_str();
+
     // Create a custom heap that's uncached for the CPU, and (hopefully) uncached for the GPU as well
     D3D12_HEAP_DESC heapDesc = { };
     heapDesc.SizeInBytes = 128 * 1024;
@@ -93,13 +113,58 @@ static void InitWorkload(Workload& workload, const char* name, WorkloadType type
     counterBufferInit.InitialState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
     workload.CounterBuffer.Initialize(counterBufferInit);
     workload.CounterBuffer.Resource()->SetName(MakeString(L"%s Counter Buffer", name).c_str());
+}
+
+// Sets up the default graph, where each workload depends on the previous workload that was
+// submitted to the same queue
+static void SetDefaultWorkloadGraph(Workload* workloads, uint64& numWorkloads)
+{
+    numWorkloads = ArraySize_(DefaultWorkloadTypes);
+    for(uint64 i = 0; i < MaxWorkloads; ++i)
+    {
+        WorkloadNode& node = workloads[i].Node;
+        node.NumDependencies = 0;
+        if(i >= numWorkloads)
+            continue;
+
+        node.Type = DefaultWorkloadTypes[i];
+        if(i > 0 && QueueForWorkload(node.Type) == QueueForWorkload(DefaultWorkloadTypes[i - 1]))
+            node.AddDependency(i - 1);
+    }
+}
 
-    workload.Name = name;
-    workload.Type = type;
+// Command line options that are shared by the app and the offline commands
+static void AddAppCommandLineOptions(cxxopts::Options& options)
+{
+    options.add_options()
+         ("convert-trace", "Converts a recorded trace file to Chrome trace JSON", cxxopts::value<std::string>())
+         ("sweep", "Runs every configuration from a sweep spec, and writes out a report", cxxopts::value<std::string>())
+         ("simulate", "Runs the sweep through the CPU simulation instead of on the GPU")
+         ("o,output", "Output path for offline commands and sweep reports", cxxopts::value<std::string>());
+}
 
-    // Default to depending on the previous workload
-    if(workloadIdx > 0 && workloadIdx != ComputeQueueWorkloadA)
-        workload.DependsOn = workloadIdx - 1;
+static void LoadSweepSpec(const std::wstring& specPath, SweepSpec& spec)
+{
+    std::string errorString;
+    if(ParseSweepSpec(ReadFileAsString(specPath.c_str()), spec, errorString) == false)
+        throw Exception(L"Invalid sweep spec " + specPath + L": " + AnsiToWString(errorString.c_str()));
+}
+
+// Reports go next to the spec unless an output path is given. The report is written as JSON if
+// the output path has a .json extension, otherwise it's written as CSV.
+static std::wstring GetSweepReportPath(cxxopts::Options& options, const std::wstring& specPath)
+{
+    if(options.count("output"))
+        return AnsiToWString(options["output"].as<std::string>().c_str());
+    return GetFilePathWithoutExtension(specPath.c_str()) + L"_Results.csv";
+}
+
+static void WriteSweepReport(const std::wstring& reportPath, const std::vector<SweepResult>& results)
+{
+    if(GetFileExtension(reportPath.c_str()) == L"json")
+        WriteStringAsFile(reportPath.c_str(), SweepReportJSON(results, WorkloadNames));
+    else
+        WriteStringAsFile(reportPath.c_str(), SweepReportCSV(results, WorkloadNames));
 }
 
 static void ShutdownWorkload(Workload& workload)
@@ -113,6 +178,7 @@ static void ShutdownWorkload(Workload& workload)
 OverlappedExecution::OverlappedExecution(const wchar* cmdLine) :  App(L"Overlapped Execution", cmdLine)
 {
     minFeatureLevel = D3D_FEATURE_LEVEL_11_0;
+    workloads.Init(MaxWorkloads);
 }
 
 void OverlappedExecution::BeforeReset()
@@ -125,8 +191,23 @@ void OverlappedExecution::AfterReset()
 
 void OverlappedExecution::Initialize()
 {
-    for(uint64 i = 0; i < NumWorkloads; ++i)
-        InitWorkload(workloads[i], WorkloadNames[i], WorkloadTypes[i], i);
+    // Kick off the shaders first, so that they compile on the task scheduler while everything else gets created
+    ShaderPermutation workloadShaders[3];
+    workloadShaders[0].FunctionName = "WorkloadCS";
+    workloadShaders[0].Type = ShaderType::Compute;
+    workloadShaders[1].FunctionName = "WorkloadVS";
+    workloadShaders[1].Type = ShaderType::Vertex;
+    workloadShaders[2].FunctionName = "WorkloadPS";
+    workloadShaders[2].Type = ShaderType::Pixel;
+    for(uint64 i = 0; i < ArraySize_(workloadShaders); ++i)
+        workloadShaders[i].FilePath = L"Workload.hlsl";
+
+    PendingShader pendingShaders[ArraySize_(workloadShaders)];
+    CompileShaders(workloadShaders, ArraySize_(workloadShaders), pendingShaders, &taskScheduler);
+
+    for(uint64 i = 0; i < MaxWorkloads; ++i)
+        InitWorkload(workloads[i], i);
+    SetDefaultWorkloadGraph(workloads.Data(), numWorkloads);
 
     {
         // Create buffer with dummy input values to be read by workload shaders
@@ -192,12 +273,12 @@ void OverlappedExecution::Initialize()
         DX12::CreateRootSignature(&workloadRootSignature, rootSignatureDesc);
     }
 
-    workloadCS = CompileFromFile(L"Workload.hlsl", "WorkloadCS", ShaderType::Compute, ShaderProfile::SM51);
-    workloadVS = CompileFromFile(L"Workload.hlsl", "WorkloadVS", ShaderType::Vertex, ShaderProfile::SM51);
-    workloadPS = CompileFromFile(L"Workload.hlsl", "WorkloadPS", ShaderType::Pixel, ShaderProfile::SM51);
-
     waitFence.Init(0);
     computeFence.Init(0);
+    for(uint64 i = 0; i < NumWorkloadQueues; ++i)
+        queueFences[i].Init(0);
+
+    workloadMonitor.Initialize();
 
     workloadCBuffer.Initialize(BufferLifetime::Temporary);
 
@@ -229,71 +310,28 @@ void OverlappedExecution::Initialize()
 
     DX12::Adapter->GetDesc1(&adapterDesc);
 
+    // CreatePSOs() runs right after this, so the shaders need to be done
+    workloadCS = pendingShaders[0].Wait();
+    workloadVS = pendingShaders[1].Wait();
+    workloadPS = pendingShaders[2].Wait();
+
     AppSettings::SetWindowOpened(false);
 }
 
-// Checks the value of the shader start/end buffers to see when workloads start,
-// and when they complete
-static void TimeWorkloads(Workload** workloads, uint64 numWorkloads)
+// Adds the latest timings to the workload's stats, and replaces them with the filtered values
+// to reduce noise
+static void FilterWorkloadTimings(Workload& workload)
 {
-    uint64 completionCount = 0;
-
-    Timer shaderTimer;
-    shaderTimer.Update();
-    const uint32 signalValue = uint32(DX12::CurrentCPUFrame - 1);
-
-    for(uint64 i = 0; i < numWorkloads; ++i)
+    // Skip workloads that the monitor never saw finish
+    if(workload.EndTime > 0.0f)
     {
-        workloads[i]->StartTime = 0.0f;
-        workloads[i]->EndTime = 0.0f;
+        workload.StartStats.AddSample(workload.StartTime);
+        workload.EndStats.AddSample(workload.EndTime);
+        workload.DurationStats.AddSample(workload.EndTime - workload.StartTime);
     }
 
-    // Keep looping until we've seen the completion of all active workloads
-    while(completionCount < numWorkloads)
-    {
-        for(uint64 workloadIdx = 0; workloadIdx < numWorkloads; ++workloadIdx)
-        {
-            Workload& workload = *workloads[workloadIdx];
-            if(workload.StartTime != 0.0f && workload.EndTime != 0.0f)
-                continue;
-
-            const uint32* shaderStarted = workload.ShaderStartData;
-            const uint32* shaderEnded = workload.ShaderEndData;
-
-            shaderTimer.Update();
-            if(workload.StartTime == 0.0f && *shaderStarted >= signalValue)
-                workload.StartTime = shaderTimer.ElapsedMillisecondsF();
-
-            shaderTimer.Update();
-            if(workload.EndTime == 0.0f && *shaderEnded >= signalValue)
-                workload.EndTime = shaderTimer.ElapsedMillisecondsF();
-
-            if(workload.StartTime != 0.0f && workload.EndTime != 0.0f)
-                ++completionCount;
-        }
-    }
-
-    // Filter the workload timings to reduce noise
-    for(uint64 workloadIdx = 0; workloadIdx < numWorkloads; ++workloadIdx)
-    {
-        Workload& workload = *workloads[workloadIdx];
-
-        const uint64 filterSize = ArraySize_(workload.StartTimes);
-        const uint64 idx = DX12::CurrentCPUFrame % filterSize;
-        workload.StartTimes[idx] = workload.StartTime;
-        workload.EndTimes[idx] = workload.EndTime;
-
-        float startTimeSum = 0.0f;
-        float endTimeSum = 0.0f;
-        for(uint64 i = 0; i < filterSize; ++i)
-        {
-            startTimeSum += workload.StartTimes[i];
-            endTimeSum += workload.EndTimes[i];
-        }
-
-        workload.StartTime = float(startTimeSum / filterSize);
-        workload.EndTime = float(endTimeSum / filterSize);
-    }
+    workload.StartTime = float(workload.StartStats.Mean());
+    workload.EndTime = float(workload.EndStats.Mean());
 }
 
 void OverlappedExecution::Shutdown()
@@ -303,11 +341,15 @@ void OverlappedExecution::Shutdown()
     DX12::Release(computeCmdList);
     DX12::Release(computeQueue);
     DX12::Release(hiPriorityComputeQueue);
-    for(uint64 i = 0; i < NumWorkloads; ++i)
+    for(uint64 i = 0; i < MaxWorkloads; ++i)
         ShutdownWorkload(workloads[i]);
     DX12::Release(workloadRootSignature);
+    workloadMonitor.Shutdown();
+    traceRecorder.Shutdown();
     waitFence.Shutdown();
     computeFence.Shutdown();
+    for(uint64 i = 0; i < NumWorkloadQueues; ++i)
+        queueFences[i].Shutdown();
     workloadCBuffer.Shutdown();
     workloadInputBuffer.Shutdown();
     workloadOutputBuffer.Shutdown();
@@ -322,7 +364,7 @@ void OverlappedExecution::CreatePSOs()
         D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = { };
         psoDesc.CS = workloadCS.ByteCode();
         psoDesc.pRootSignature = workloadRootSignature;
-        DXCall(DX12::Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&workloadCSPSO)));
+        workloadCSPSO = DX12::CreateComputePSO(psoDesc);
     }
 
     {
@@ -343,7 +385,7 @@ void OverlappedExecution::CreatePSOs()
         psoDesc.SampleDesc.Quality = workloadRT.MSAAQuality;
         psoDesc.InputLayout.pInputElementDescs = nullptr;
         psoDesc.InputLayout.NumElements = 0;
-        DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&workloadGfxPSO)));
+        workloadGfxPSO = DX12::CreateGraphicsPSO(psoDesc);
     }
 }
 
@@ -368,6 +410,22 @@ void OverlappedExecution::BeforeFlush()
 
 }
 
+void OverlappedExecution::AddCommandLineOptions(cxxopts::Options& options)
+{
+    AddAppCommandLineOptions(options);
+}
+
+void OverlappedExecution::ReadCommandLineOptions(cxxopts::Options& options)
+{
+    if(options.count("sweep") == 0)
+        return;
+
+    const std::wstring specPath = AnsiToWString(options["sweep"].as<std::string>().c_str());
+    LoadSweepSpec(specPath, sweepSpec);
+    BuildSweepConfigs(sweepSpec, sweepConfigs);
+    sweepReportPath = GetSweepReportPath(options, specPath);
+}
+
 void OverlappedExecution::Update(const Timer& timer)
 {
     CPUProfileBlock profileBlock("Update (CPU)");
@@ -377,24 +435,197 @@ void OverlappedExecution::Update(const Timer& timer)
         // Wait for the last present to finish
         WaitForSingleObjectEx(swapChain.WaitableObject(), 1000, false);
 
-        // Let the GPU start working
-        waitFence.Clear(DX12::CurrentCPUFrame);
+        TimeWorkloads();
+    }
 
-        Workload* enabledWorkloads[NumWorkloads] = { };
-        uint64 numEnabledWorkloads = 0;
-        for(uint64 i = 0; i < NumWorkloads; ++i)
-            if(workloads[i].Enabled && workloads[i].LastUpdatedFrame == DX12::CurrentCPUFrame - 1)
-                enabledWorkloads[numEnabledWorkloads++] = &workloads[i];
+    if(sweepConfigs.size() > 0)
+        UpdateSweep();
 
-        if(numEnabledWorkloads > 0)
-            TimeWorkloads(enabledWorkloads, numEnabledWorkloads);
-    }
+    if(AppSettings::ShowSimulatedTimeline)
+        SimulateTimeline();
 
     // Toggle VSYNC
     swapChain.SetVSYNCEnabled(AppSettings::EnableVSync ? true : false);
 
     if(AppSettings::StablePowerState.Changed())
         DX12::Device->SetStablePowerState(AppSettings::StablePowerState);
+
+    if(AppSettings::RecordTrace.Changed())
+    {
+        if(AppSettings::RecordTrace)
+        {
+            // Every workload slot goes in the header, so that workloads added while recording have a name
+            const char* names[MaxWorkloads] = { };
+            for(uint64 i = 0; i < MaxWorkloads; ++i)
+                names[i] = workloads[i].Name.c_str();
+            traceRecorder.Initialize(TraceFilePath, MaxTraceRecords, names, MaxWorkloads);
+        }
+        else
+            traceRecorder.Shutdown();
+    }
+}
+
+// Picks up the timings from the monitor thread for the workloads that were released last frame,
+// and then arms it for the workloads that were submitted last frame before releasing them
+void OverlappedExecution::TimeWorkloads()
+{
+    workloadMonitor.WaitForIdle();
+
+    MonitorResult result;
+    while(workloadMonitor.PopResult(result))
+    {
+        for(uint64 i = 0; i < result.NumTargets; ++i)
+        {
+            Workload& workload = workloads[result.IDs[i]];
+            workload.StartTime = result.StartTimes[i];
+            workload.EndTime = result.EndTimes[i];
+            FilterWorkloadTimings(workload);
+
+            if(traceRecorder.Recording())
+            {
+                const TraceQueue queue = QueueForWorkload(workload.Node.Type) == WorkloadQueue::Compute ? TraceQueue::Compute : TraceQueue::Graphics;
+                const uint16 flags = result.TimedOut ? TraceRecordFlags_TimedOut : TraceRecordFlags_None;
+                traceRecorder.RecordWorkload(result.Frame - 1, result.IDs[i], queue, result.StartTSC[i], result.EndTSC[i], flags);
+            }
+        }
+
+        // Sweeps record the raw timings of every measured frame. The workloads were submitted on the
+        // frame before the one that the monitor was started on.
+        if(sweepConfigs.size() > 0 && sweepConfigIdx < sweepConfigs.size() && result.TimedOut == false &&
+           result.Frame - 1 >= sweepMeasureStartFrame && sweepSamples.NumFrames() < sweepSpec.NumMeasuredFrames)
+        {
+            SimTiming timings[MaxWorkloads];
+            for(uint64 i = 0; i < result.NumTargets; ++i)
+            {
+                timings[result.IDs[i]].StartTime = result.StartTimes[i];
+                timings[result.IDs[i]].EndTime = result.EndTimes[i];
+            }
+            sweepSamples.AddFrame(timings);
+        }
+    }
+
+    if(traceRecorder.Recording())
+        traceRecorder.SetTSCFrequency(workloadMonitor.TSCFrequency());
+
+    StaticAssert_(uint64(MonitorWaitModes::NumValues) == uint64(MonitorWaitPolicy::NumValues));
+    const MonitorWaitModes waitMode = AppSettings::MonitorWaitMode;
+    workloadMonitor.SetWaitPolicy(MonitorWaitPolicy(waitMode));
+
+    MonitorTarget targets[MaxWorkloads];
+    uint64 numTargets = 0;
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        const Workload& workload = workloads[i];
+        if(workload.Node.Enabled && workload.LastUpdatedFrame == DX12::CurrentCPUFrame - 1)
+        {
+            targets[numTargets].StartData = workload.ShaderStartData;
+            targets[numTargets].EndData = workload.ShaderEndData;
+            targets[numTargets].ID = i;
+            ++numTargets;
+        }
+    }
+
+    if(numTargets > 0)
+        workloadMonitor.BeginFrame(DX12::CurrentCPUFrame, uint32(DX12::CurrentCPUFrame - 1), targets, numTargets);
+
+    // Let the GPU start working
+    waitFence.Clear(DX12::CurrentCPUFrame);
+}
+
+// Steps through the configurations of a sweep, and writes out the report once they've all been measured
+void OverlappedExecution::UpdateSweep()
+{
+    if(sweepConfigIdx < sweepConfigs.size())
+    {
+        if(sweepSamples.NumFrames() < sweepSpec.NumMeasuredFrames)
+            return;
+
+        SweepResult result;
+        sweepSamples.Summarize(sweepConfigs[sweepConfigIdx], result);
+        sweepResults.push_back(result);
+        ++sweepConfigIdx;
+    }
+    else
+    {
+        sweepConfigIdx = 0;
+    }
+
+    if(sweepConfigIdx < sweepConfigs.size())
+    {
+        ApplySweepConfig(sweepConfigIdx);
+        return;
+    }
+
+    WriteSweepReport(sweepReportPath, sweepResults);
+    AddToLog(MakeString("Sweep finished, wrote %llu configurations to %ls", sweepResults.size(), sweepReportPath.c_str()).c_str());
+    sweepConfigs.clear();
+
+    // Close the window after this frame has been presented
+    PostMessage(window.GetHwnd(), WM_CLOSE, 0, 0);
+}
+
+// Switches the workloads and settings over to a sweep configuration. Every configuration uses the
+// same PSOs and buffers, so the only thing that's expensive is switching compute queues.
+void OverlappedExecution::ApplySweepConfig(uint64 configIdx)
+{
+    const SweepConfig& config = sweepConfigs[configIdx];
+
+    // Frames that are still in flight on the previous compute queue would overlap with the
+    // measurements on the new one
+    if(configIdx > 0 && config.HiPriorityCompute != sweepConfigs[configIdx - 1].HiPriorityCompute)
+    {
+        BeforeFlush();
+        DX12::FlushGPU();
+    }
+
+    numWorkloads = ArraySize_(DefaultWorkloadTypes);
+
+    WorkloadNode nodes[MaxWorkloads];
+    BuildSweepGraph(config.DependencyPattern, DefaultWorkloadTypes, numWorkloads, nodes);
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        Workload& workload = workloads[i];
+        workload.Node = nodes[i];
+        workload.NumGroups = Clamp<int32>(config.NumGroups, 1, int32(AppSettings::MaxWorkloadGroups));
+        workload.NumIterations = Clamp<int32>(config.NumIterations, 1, int32(AppSettings::MaxWorkloadIterations));
+    }
+
+    AppSettings::UseSplitBarriers.SetValue(config.SplitBarriers);
+    AppSettings::UseHiPriorityComputeQueue.SetValue(config.HiPriorityCompute);
+
+    sweepSamples.Reset(numWorkloads);
+    sweepMeasureStartFrame = DX12::CurrentCPUFrame + sweepSpec.NumWarmFrames;
+
+    AddToLog(MakeString("Sweep configuration %llu/%llu: %d groups, %d iterations, %s dependencies%s%s",
+                        configIdx + 1, uint64(sweepConfigs.size()), config.NumGroups, config.NumIterations,
+                        SweepDependencyPatternName(config.DependencyPattern),
+                        config.SplitBarriers ? ", split barriers" : "",
+                        config.HiPriorityCompute ? ", hi-priority compute" : "").c_str());
+}
+
+// Runs the CPU simulation of the current workload settings, so that it can be compared with the
+// timings that were measured on the GPU
+void OverlappedExecution::SimulateTimeline()
+{
+    SimWorkload simWorkloads[MaxWorkloads];
+    SimTiming measuredTimings[MaxWorkloads];
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        const Workload& workload = workloads[i];
+        simWorkloads[i].Node = workload.Node;
+        simWorkloads[i].NumGroups = workload.NumGroups;
+        simWorkloads[i].NumIterations = workload.NumIterations;
+
+        measuredTimings[i].StartTime = workload.StartTime;
+        measuredTimings[i].EndTime = workload.EndTime;
+    }
+
+    SimSettings simSettings;
+    simSettings.UseSplitBarriers = AppSettings::UseSplitBarriers;
+    simSettings.UseHiPriorityComputeQueue = AppSettings::UseHiPriorityComputeQueue;
+
+    SimulateWorkloads(simWorkloads, numWorkloads, simSettings, SimGPUDesc(), simulatedTimings);
+    simulatedError = CompareTimings(simWorkloads, simulatedTimings, measuredTimings, numWorkloads);
 }
 
 void OverlappedExecution::Render(const Timer& timer)
@@ -404,11 +635,18 @@ void OverlappedExecution::Render(const Timer& timer)
     CPUProfileBlock profileBlock("Render (CPU)");
     ProfileBlock gpuProfileBlock(cmdList, "Frame Time");
 
-    for(uint64 i = 0; i < NumWorkloads; ++i)
+    WorkloadNode nodes[MaxWorkloads];
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        nodes[i] = workloads[i].Node;
+    BuildWorkloadSchedule(nodes, numWorkloads, AppSettings::UseSplitBarriers, schedule);
+
+    // Tell the GPU to wait until we're ready to start timing shader executions
+    DX12::GfxQueue->Wait(waitFence.D3DFence, DX12::CurrentCPUFrame + 1);
+
+    for(uint64 i = 0; i < numWorkloads; ++i)
     {
         Workload& workload = workloads[i];
-        workload.BufferIsReadable = false;
-        if(workload.Enabled == false || workload.Type == WorkloadType::ComputeQueue)
+        if(workload.Node.Enabled == false || QueueForWorkload(workload.Node.Type) != WorkloadQueue::Direct)
             continue;
 
         // Clear the count buffer
@@ -425,66 +663,36 @@ void OverlappedExecution::Render(const Timer& timer)
     cmdList->OMSetRenderTargets(1, rtvHandles, false, nullptr);
     DX12::SetViewport(cmdList, workloadRT.Width(), workloadRT.Height());
 
-    for(uint64 currWorkloadIdx = 0; currWorkloadIdx < NumWorkloads; ++currWorkloadIdx)
+    const uint64 queueIdx = uint64(WorkloadQueue::Direct);
+    const GrowableList<ScheduleStep>& steps = schedule.Steps[queueIdx];
+    for(uint64 stepIdx = 0; stepIdx < steps.Count(); ++stepIdx)
     {
-        Workload& workload = workloads[currWorkloadIdx];
-        if(workload.Enabled == false || workload.Type == WorkloadType::ComputeQueue)
-            continue;
-
-        // Handle dependencies
-        if(workload.DependsOn < NumWorkloads && workloads[workload.DependsOn].Enabled && workloads[workload.DependsOn].BufferIsReadable == false)
+        const ScheduleStep& step = steps[stepIdx];
+        if(step.Type == ScheduleStepType::Barriers)
         {
-            Assert_(workload.DependsOn < currWorkloadIdx);
-            Workload& dependency = workloads[workload.DependsOn];
-
-            // Issue the barrier to synchronize
-            D3D12_RESOURCE_BARRIER barrier = { };
-            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            barrier.Transition.pResource = dependency.CounterBuffer.Resource();
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
-            barrier.Transition.Subresource = 0;
-
-            // For split barriers we're finishing the barrier here instead of issuing a new one
-            if(AppSettings::UseSplitBarriers)
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-
-            cmdList->ResourceBarrier(1, &barrier);
-
-            dependency.BufferIsReadable = true;
+            IssueScheduledBarriers(cmdList, step, D3D12_RESOURCE_STATE_GENERIC_READ);
         }
-
-        if(workload.Type == WorkloadType::Compute)
-            DoComputeWorkload(cmdList, workload, workloadOutputBuffer);
-        else if(workload.Type == WorkloadType::Graphics)
-            DoGraphicsWorkload(workload);
-
-        if(AppSettings::UseSplitBarriers)
+        else if(step.Type == ScheduleStepType::Workload)
         {
-            // See if anybody else depends on this workload
-            bool isDependedOn = false;
-            for(uint64 otherIdx = currWorkloadIdx + 1; otherIdx < NumWorkloads; ++otherIdx)
-            {
-                if(workloads[otherIdx].Enabled && workloads[otherIdx].DependsOn == currWorkloadIdx)
-                {
-                    isDependedOn = true;
-                    break;
-                }
-            }
+            Workload& workload = workloads[step.WorkloadIdx];
+            if(workload.Node.Type == WorkloadType::Graphics)
+                DoGraphicsWorkload(workload);
+            else
+                DoComputeWorkload(cmdList, workload, workloadOutputBuffer);
+        }
+        else
+        {
+            // Fences can only be signaled or waited on between submissions
+            DX12::SubmitCmdList();
 
-            if(isDependedOn)
-            {
-                // Start the transition barrier
-                D3D12_RESOURCE_BARRIER barrier = { };
-                barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
-                barrier.Transition.pResource = workload.CounterBuffer.Resource();
-                barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-                barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
-                barrier.Transition.Subresource = 0;
-                cmdList->ResourceBarrier(1, &barrier);
-            }
+            const uint64 fenceQueueIdx = uint64(step.FenceQueue);
+            const uint64 fenceValue = queueFenceBases[fenceQueueIdx] + step.FenceValue;
+            if(step.Type == ScheduleStepType::Signal)
+                queueFences[queueIdx].Signal(DX12::GfxQueue, fenceValue);
+            else
+                DX12::GfxQueue->Wait(queueFences[fenceQueueIdx].D3DFence, fenceValue);
+
+            cmdList->OMSetRenderTargets(1, rtvHandles, false, nullptr);
         }
     }
 
@@ -498,23 +706,23 @@ void OverlappedExecution::Render(const Timer& timer)
     RenderWorkloadUI();
     RenderHUD();
 
-    // Tell the GPU to wait until we're ready to start timing shader executions
-    DX12::GfxQueue->Wait(waitFence.D3DFence, DX12::CurrentCPUFrame + 1);
-
     RenderCompute();
 }
 
 void OverlappedExecution::RenderCompute()
 {
     ID3D12GraphicsCommandList* cmdList = computeCmdList;
+    ID3D12CommandQueue* queue = AppSettings::UseHiPriorityComputeQueue ? hiPriorityComputeQueue : computeQueue;
+
+    // Tell the GPU to wait until we're ready to start timing shader executions
+    queue->Wait(waitFence.D3DFence, DX12::CurrentCPUFrame + 1);
 
     DX12::SetDescriptorHeaps(cmdList);
 
-    for(uint64 i = 0; i < NumWorkloads; ++i)
+    for(uint64 i = 0; i < numWorkloads; ++i)
     {
         Workload& workload = workloads[i];
-        workload.BufferIsReadable = false;
-        if(workload.Enabled == false || workload.Type != WorkloadType::ComputeQueue)
+        if(workload.Node.Enabled == false || QueueForWorkload(workload.Node.Type) != WorkloadQueue::Compute)
             continue;
 
         // Clear the count buffer
@@ -527,69 +735,35 @@ void OverlappedExecution::RenderCompute()
         workload.CounterBuffer.UAVBarrier(cmdList);
     }
 
-    for(uint64 currWorkloadIdx = 0; currWorkloadIdx < NumWorkloads; ++currWorkloadIdx)
+    const uint64 queueIdx = uint64(WorkloadQueue::Compute);
+    const GrowableList<ScheduleStep>& steps = schedule.Steps[queueIdx];
+    for(uint64 stepIdx = 0; stepIdx < steps.Count(); ++stepIdx)
     {
-        Workload& workload = workloads[currWorkloadIdx];
-        if(workload.Enabled == false || workload.Type != WorkloadType::ComputeQueue)
-            continue;
-
-         // Handle dependencies
-        if(workload.DependsOn < NumWorkloads && workloads[workload.DependsOn].Enabled && workloads[workload.DependsOn].BufferIsReadable == false)
+        const ScheduleStep& step = steps[stepIdx];
+        if(step.Type == ScheduleStepType::Barriers)
         {
-            Assert_(workload.DependsOn < currWorkloadIdx);
-            Workload& dependency = workloads[workload.DependsOn];
-
-            // Issue the barrier to synchronize
-            D3D12_RESOURCE_BARRIER barrier = { };
-            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            barrier.Transition.pResource = dependency.CounterBuffer.Resource();
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-            barrier.Transition.Subresource = 0;
-
-            // For split barriers we're finishing the barrier here instead of issuing a new one
-            if(AppSettings::UseSplitBarriers)
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-
-            cmdList->ResourceBarrier(1, &barrier);
-
-            dependency.BufferIsReadable = true;
+            IssueScheduledBarriers(cmdList, step, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         }
-
-        DoComputeWorkload(cmdList, workload, computeWorkloadOutputBuffer);
-
-        if(AppSettings::UseSplitBarriers)
+        else if(step.Type == ScheduleStepType::Workload)
         {
-            // See if anybody else depends on this workload
-            bool isDependedOn = false;
-            for(uint64 otherIdx = currWorkloadIdx + 1; otherIdx < NumWorkloads; ++otherIdx)
-            {
-                if(workloads[otherIdx].Enabled && workloads[otherIdx].DependsOn == currWorkloadIdx)
-                {
-                    isDependedOn = true;
-                    break;
-                }
-            }
-
-            if(isDependedOn)
-            {
-                // Start the transition barrier
-                D3D12_RESOURCE_BARRIER barrier = { };
-                barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
-                barrier.Transition.pResource = workload.CounterBuffer.Resource();
-                barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-                barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-                barrier.Transition.Subresource = 0;
-                cmdList->ResourceBarrier(1, &barrier);
-            }
+            DoComputeWorkload(cmdList, workloads[step.WorkloadIdx], computeWorkloadOutputBuffer);
+        }
+        else
+        {
+            SubmitComputeCmdList(queue);
+
+            const uint64 fenceQueueIdx = uint64(step.FenceQueue);
+            const uint64 fenceValue = queueFenceBases[fenceQueueIdx] + step.FenceValue;
+            if(step.Type == ScheduleStepType::Signal)
+                queueFences[queueIdx].Signal(queue, fenceValue);
+            else
+                queue->Wait(queueFences[fenceQueueIdx].D3DFence, fenceValue);
         }
     }
 
-    // Tell the GPU to wait until we're ready to start timing shader executions
-    ID3D12CommandQueue* queue = AppSettings::UseHiPriorityComputeQueue ? hiPriorityComputeQueue : computeQueue;
-    queue->Wait(waitFence.D3DFence, DX12::CurrentCPUFrame + 1);
+    // Both queues have submitted all of their fence operations for this frame
+    for(uint64 i = 0; i < NumWorkloadQueues; ++i)
+        queueFenceBases[i] += schedule.NumSignals[i];
 
     // Submit on the compute queue
     DXCall(cmdList->Close());
@@ -618,9 +792,51 @@ void OverlappedExecution::RenderCompute()
     DXCall(cmdList->Reset(cmdAllocators[nextFrameIdx], nullptr));
 }
 
+// Issues a batch of barriers from the schedule with a single ResourceBarrier call. The counter buffers
+// are what each workload writes to, so they're used for synchronizing with the workloads that depend on it.
+void OverlappedExecution::IssueScheduledBarriers(ID3D12GraphicsCommandList* cmdList, const ScheduleStep& step, D3D12_RESOURCE_STATES readState)
+{
+    Assert_(step.NumBarriers <= MaxWorkloads);
+
+    D3D12_RESOURCE_BARRIER barriers[MaxWorkloads] = { };
+    const uint64 numBarriers = Min(step.NumBarriers, MaxWorkloads);
+    for(uint64 i = 0; i < numBarriers; ++i)
+    {
+        const ScheduledBarrier& scheduledBarrier = schedule.Barriers[step.BarrierStart + i];
+
+        D3D12_RESOURCE_BARRIER& barrier = barriers[i];
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource = workloads[scheduledBarrier.WorkloadIdx].CounterBuffer.Resource();
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        barrier.Transition.StateAfter = readState;
+        barrier.Transition.Subresource = 0;
+
+        if(scheduledBarrier.Type == ScheduledBarrierType::Begin)
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        else if(scheduledBarrier.Type == ScheduledBarrierType::End)
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+    }
+
+    cmdList->ResourceBarrier(uint32(numBarriers), barriers);
+}
+
+// Submits what's been recorded on the compute command list so far, so that the compute queue can
+// signal or wait on a fence in the middle of the frame
+void OverlappedExecution::SubmitComputeCmdList(ID3D12CommandQueue* queue)
+{
+    DXCall(computeCmdList->Close());
+
+    ID3D12CommandList* commandLists[] = { computeCmdList };
+    queue->ExecuteCommandLists(ArraySize_(commandLists), commandLists);
+
+    DXCall(computeCmdList->Reset(cmdAllocators[DX12::CurrFrameIdx], nullptr));
+    DX12::SetDescriptorHeaps(computeCmdList);
+}
+
 void OverlappedExecution::DoComputeWorkload(ID3D12GraphicsCommandList* cmdList, Workload& workload, const StructuredBuffer& workloadOutput)
 {
-    PIXMarker pixMarker(cmdList, workload.Name);
+    PIXMarker pixMarker(cmdList, workload.Name.c_str());
 
     cmdList->SetPipelineState(workloadCSPSO);
     cmdList->SetComputeRootSignature(workloadRootSignature);
@@ -647,7 +863,7 @@ void OverlappedExecution::DoGraphicsWorkload(Workload& workload)
 {
     ID3D12GraphicsCommandList* cmdList =  DX12::CmdList;
 
-    PIXMarker pixMarker(cmdList, workload.Name);
+    PIXMarker pixMarker(cmdList, workload.Name.c_str());
 
     DX12::SetViewport(cmdList, workloadRT.Width(), workload.NumGroups);
 
@@ -739,17 +955,26 @@ void OverlappedExecution::RenderHUD()
     Float2 frameTimeTextPos = Float2(timelineEndX - frameTimeTextSize.x, timelineY - (frameTimeTextSize.y * 2.0f) - 12.0f);
     drawList->AddText(ToImVec2(frameTimeTextPos), timelineColor, frameTimeText.c_str());
 
-    const float barHeight = 75.0f;
+    if(AppSettings::ShowSimulatedTimeline)
+    {
+        std::string simText = MakeString("Simulation Error: %.3fms mean, %.3fms max", simulatedError.MeanError, simulatedError.MaxError);
+        Float2 simTextSize = ToFloat2(ImGui::CalcTextSize(simText.c_str()));
+        Float2 simTextPos = Float2(timelineStartX + (timelineWidth - simTextSize.x) * 0.5f, timelineY - (simTextSize.y * 2.0f) - 12.0f);
+        drawList->AddText(ToImVec2(simTextPos), timelineColor, simText.c_str());
+    }
+
     const float barStartY = timelineY + 25.0f;
+    const float barHeight = Min(75.0f, (windowEnd.y - barStartY) / Max<uint64>(numWorkloads, 1));
     const uint32 barColor = ImColor(1.0f, 0.0f, 0.0f, 1.0f);
     const uint32 barOutlineColor = ImColor(1.0f, 1.0f, 1.0f, 1.0f);
     const uint32 barTextColor = ImColor(1.0f, 1.0f, 1.0f, 1.0f);
+    const uint32 simBarColor = ImColor(0.0f, 1.0f, 1.0f, 1.0f);
 
     // Draw the workloads
-    for(uint64 workloadIdx = 0; workloadIdx < NumWorkloads; ++workloadIdx)
+    for(uint64 workloadIdx = 0; workloadIdx < numWorkloads; ++workloadIdx)
     {
         const Workload& workload = workloads[workloadIdx];
-        if(workload.Enabled == false)
+        if(workload.Node.Enabled == false)
             continue;
 
         const float executionTime = workload.EndTime - workload.StartTime;
@@ -759,7 +984,8 @@ void OverlappedExecution::RenderHUD()
         drawList->AddRectFilled(ToImVec2(barStart), ToImVec2(barEnd), barColor);
         drawList->AddRect(ToImVec2(barStart), ToImVec2(barEnd), barOutlineColor);
 
-        std::string barText = MakeString("%s (%.2fms)", workload.Name, executionTime);
+        std::string barText = MakeString("%s (%.2fms, %.2fms p99)", workload.Name.c_str(), executionTime,
+                                         workload.DurationStats.Percentile(0.99));
         Float2 textSize = ToFloat2(ImGui::CalcTextSize(barText.c_str(), nullptr, false, barSize.x));
         if(textSize.x < barSize.x && textSize.y < barSize.y)
         {
@@ -767,16 +993,29 @@ void OverlappedExecution::RenderHUD()
             drawList->AddText(ImGui::GetWindowFont(), ImGui::GetWindowFontSize(), ToImVec2(textPos), barTextColor, barText.c_str(), nullptr, barSize.x);
         }
 
-        if(workload.DependsOn < NumWorkloads && workloads[workload.DependsOn].Enabled)
+        for(uint64 depIdx = 0; depIdx < workload.Node.NumDependencies; ++depIdx)
         {
-            const Workload& dependency = workloads[workload.DependsOn];
+            const uint64 dependencyIdx = workload.Node.Dependencies[depIdx];
+            const Workload& dependency = workloads[dependencyIdx];
+            if(dependency.Node.Enabled == false)
+                continue;
+
             const float dependencyExecutionTime = dependency.EndTime - dependency.StartTime;
-            Float2 dependencyStart = Float2(timelineStartX + timelineWidth * (dependency.StartTime / frameTime), barStartY + workload.DependsOn * barHeight);
+            Float2 dependencyStart = Float2(timelineStartX + timelineWidth * (dependency.StartTime / frameTime), barStartY + dependencyIdx * barHeight);
             Float2 dependencySize = Float2(timelineWidth * (dependencyExecutionTime / frameTime), barHeight);
             Float2 dependencyEndMidPoint = dependencyStart + dependencySize * Float2(1.0f, 0.5f);
             Float2 barStartMidPoint = barStart + Float2(0.0f, barSize.y * 0.5f);
             drawList->AddLine(ToImVec2(dependencyEndMidPoint), ToImVec2(barStartMidPoint), ImColor(1.0f, 1.0f, 0.0f, 1.0f));
         }
+
+        if(AppSettings::ShowSimulatedTimeline)
+        {
+            // Outline where the simulation thinks the workload should be
+            const SimTiming& simTiming = simulatedTimings[workloadIdx];
+            Float2 simStart = Float2(timelineStartX + timelineWidth * (simTiming.StartTime / frameTime), barStart.y + 2.0f);
+            Float2 simEnd = Float2(timelineStartX + timelineWidth * (simTiming.EndTime / frameTime), barEnd.y - 2.0f);
+            drawList->AddRect(ToImVec2(simStart), ToImVec2(simEnd), simBarColor);
+        }
     }
 
     ImGui::End();
@@ -784,7 +1023,8 @@ void OverlappedExecution::RenderHUD()
 
 void OverlappedExecution::RenderWorkloadUI()
 {
-    if(AppSettings::ShowWorkloadUI == false)
+    // Sweeps own the workload settings while they're running
+    if(AppSettings::ShowWorkloadUI == false || sweepConfigs.size() > 0)
         return;
 
     if(ImGui::Begin("Workload Settings", nullptr) == false)
@@ -793,66 +1033,177 @@ void OverlappedExecution::RenderWorkloadUI()
         return;
     }
 
-    const char* comboEntries[NumGfxQueueWorkloads + 1] = { };
-    comboEntries[0] = "None";
-    for(uint64 i = 0; i < NumGfxQueueWorkloads; ++i)
-        comboEntries[i + 1] = WorkloadNames[i];
-
-    const char* computeComboEntries[NumComputeQueueWorkloads + 1] = { };
-    computeComboEntries[0] = "None";
-    for(uint64 i = 0; i < NumComputeQueueWorkloads; ++i)
-        computeComboEntries[i + 1] = WorkloadNames[i + ComputeQueueWorkloadA];
+    const char* workloadNames[MaxWorkloads] = { };
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        workloadNames[i] = workloads[i].Name.c_str();
 
-    for(uint64 i = 0; i < NumWorkloads; ++i)
+    for(uint64 i = 0; i < numWorkloads; ++i)
     {
         Workload& workload = workloads[i];
-        if(ImGui::CollapsingHeader(workload.Name, nullptr, true, true))
+        if(ImGui::CollapsingHeader(workload.Name.c_str(), nullptr, true, true))
         {
-            ImGui::PushID(workload.Name);
+            ImGui::PushID(int32(i));
+
+            // Enabling, disabling or changing the type of a workload can't make the graph invalid
+            ImGui::Checkbox("Enable", &workload.Node.Enabled);
+
+            int32 type = int32(workload.Node.Type);
+            ImGui::Combo("Type", &type, WorkloadTypeLabels, int32(WorkloadType::NumValues));
+            workload.Node.Type = WorkloadType(type);
 
-            ImGui::Checkbox("Enable", &workload.Enabled);
             ImGui::SliderInt("Num Groups", &workload.NumGroups, 1, AppSettings::MaxWorkloadGroups);
             ImGui::SliderInt("Num Iterations", &workload.NumIterations, 1, AppSettings::MaxWorkloadIterations);
 
-            if(i > 0 && i < NumGfxQueueWorkloads)
+            // Removal waits until after the loop, so that the remaining dependencies don't shift under it
+            uint64 removeIdx = uint64(-1);
+            for(uint64 depIdx = 0; depIdx < workload.Node.NumDependencies; ++depIdx)
             {
-                int32 idx = int32(workload.DependsOn + 1);
-                ImGui::Combo("Depends On", &idx, comboEntries, int32(i + 1));
-                workload.DependsOn = uint64(idx - 1);
+                ImGui::PushID(int32(depIdx));
+
+                int32 dependency = int32(workload.Node.Dependencies[depIdx]);
+                if(ImGui::Combo("Depends On", &dependency, workloadNames, int32(numWorkloads)))
+                {
+                    WorkloadNode newNode = workload.Node;
+                    newNode.Dependencies[depIdx] = uint64(dependency);
+                    EditWorkloadGraph(i, newNode);
+                }
+
+                ImGui::SameLine();
+                if(ImGui::Button("Remove"))
+                    removeIdx = depIdx;
+
+                ImGui::PopID();
             }
-            else if(i > ComputeQueueWorkloadA)
+
+            if(removeIdx < workload.Node.NumDependencies)
             {
-                int32 idx = workload.DependsOn == uint64(-1) ? 0 : int32(workload.DependsOn + 1 - NumGfxQueueWorkloads);
-                ImGui::Combo("Depends On", &idx, computeComboEntries, int32(i + 1 - NumGfxQueueWorkloads));
-                workload.DependsOn = idx == 0 ? uint64(-1) : idx + NumGfxQueueWorkloads - 1;
+                WorkloadNode newNode = workload.Node;
+                newNode.RemoveDependencyAt(removeIdx);
+                EditWorkloadGraph(i, newNode);
+            }
+
+            if(workload.Node.NumDependencies < MaxWorkloadDependencies && ImGui::Button("Add Dependency"))
+            {
+                // Pick the first workload that can be added without creating a cycle
+                for(uint64 otherIdx = 0; otherIdx < numWorkloads; ++otherIdx)
+                {
+                    if(otherIdx == i || workload.Node.DependsOn(otherIdx))
+                        continue;
+
+                    WorkloadNode newNode = workload.Node;
+                    newNode.AddDependency(otherIdx);
+                    if(EditWorkloadGraph(i, newNode))
+                        break;
+                }
             }
 
             ImGui::PopID();
         }
     }
 
+    if(graphError.length() > 0)
+        ImGui::TextColored(ImVec4(1.0f, 0.25f, 0.25f, 1.0f), "%s", graphError.c_str());
+
+    if(numWorkloads < MaxWorkloads && ImGui::Button("Add Workload"))
+    {
+        Workload& workload = workloads[numWorkloads];
+        workload.Node = WorkloadNode();
+        workload.StartStats.Reset();
+        workload.EndStats.Reset();
+        workload.DurationStats.Reset();
+        workload.StartTime = 0.0f;
+        workload.EndTime = 0.0f;
+        ++numWorkloads;
+    }
+
+    if(numWorkloads > 1 && ImGui::Button("Remove Last Workload"))
+    {
+        --numWorkloads;
+        for(uint64 i = 0; i < numWorkloads; ++i)
+            workloads[i].Node.RemoveDependency(numWorkloads);
+    }
+
     if(ImGui::Button("Clear All Dependencies"))
     {
-        for(Workload& workload : workloads)
-            workload.DependsOn = uint64(-1);
+        for(uint64 i = 0; i < MaxWorkloads; ++i)
+            workloads[i].Node.NumDependencies = 0;
+        graphError.clear();
     }
 
-    if(ImGui::Button("Reset Dependencies To Defaults"))
+    if(ImGui::Button("Reset Graph To Defaults"))
+    {
+        SetDefaultWorkloadGraph(workloads.Data(), numWorkloads);
+        graphError.clear();
+    }
+
+    ImGui::End();
+}
+
+// Replaces a workload's node if the resulting graph is still valid, otherwise the error is kept
+// around for displaying in the UI
+bool OverlappedExecution::EditWorkloadGraph(uint64 workloadIdx, const WorkloadNode& newNode)
+{
+    Assert_(workloadIdx < numWorkloads);
+
+    WorkloadNode nodes[MaxWorkloads];
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        nodes[i] = workloads[i].Node;
+    nodes[workloadIdx] = newNode;
+
+    if(ValidateWorkloadGraph(nodes, numWorkloads, graphError) == false)
+        return false;
+
+    workloads[workloadIdx].Node = newNode;
+    return true;
+}
+
+// Handles the command line options that run without creating the app window or a D3D12 device.
+// Returns true if one of them was handled.
+static bool RunOfflineCommands(const wchar* cmdLine)
+{
+    try
     {
-        for(uint64 workloadIdx = 0; workloadIdx < NumWorkloads; ++workloadIdx)
+        cxxopts::Options options("OverlappedExecution", "");
+        AddAppCommandLineOptions(options);
+        App::ParseCommandLine(cmdLine, options);
+
+        if(options.count("convert-trace"))
         {
-            // Default to depending on the previous workload
-            if(workloadIdx > 0 && workloadIdx != ComputeQueueWorkloadA)
-                workloads[workloadIdx].DependsOn = workloadIdx - 1;
+            const std::wstring tracePath = AnsiToWString(options["convert-trace"].as<std::string>().c_str());
+            std::wstring jsonPath = GetFilePathWithoutExtension(tracePath.c_str()) + L".json";
+            if(options.count("output"))
+                jsonPath = AnsiToWString(options["output"].as<std::string>().c_str());
+
+            ConvertTraceToJSON(tracePath.c_str(), jsonPath.c_str());
+            return true;
         }
 
+        if(options.count("sweep") && options.count("simulate"))
+        {
+            const std::wstring specPath = AnsiToWString(options["sweep"].as<std::string>().c_str());
+            SweepSpec spec;
+            LoadSweepSpec(specPath, spec);
+
+            std::vector<SweepResult> results;
+            RunSimulatedSweep(spec, DefaultWorkloadTypes, ArraySize_(DefaultWorkloadTypes), SimGPUDesc(), results);
+            WriteSweepReport(GetSweepReportPath(options, specPath), results);
+            return true;
+        }
+    }
+    catch(SampleFramework12::Exception exception)
+    {
+        exception.ShowErrorMessage();
+        return true;
     }
 
-    ImGui::End();
+    return false;
 }
 
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow)
 {
+    if(RunOfflineCommands(lpCmdLine))
+        return 0;
+
     OverlappedExecution app(lpCmdLine);
     app.Run();
 }
@@ -13,32 +13,18 @@
 #include <PCH.h>
 
 #include <App.h>
+#include <TimingStats.h>
 #include <Graphics/GraphicsTypes.h>
 
-using namespace SampleFramework12;
+#include "TraceRecorder.h"
+#include "WorkloadGraph.h"
+#include "WorkloadMonitor.h"
+#include "WorkloadSim.h"
+#include "WorkloadSweep.h"
 
-enum Workloads : uint64
-{
-    ComputeWorkloadA = 0,
-    ComputeWorkloadB,
-    ComputeWorkloadC,
-    GfxWorkloadA,
-    ComputeWorkloadD,
-    ComputeQueueWorkloadA,
-    ComputeQueueWorkloadB,
-    ComputeQueueWorkloadC,
-
-    NumWorkloads,
-    NumGfxQueueWorkloads = ComputeQueueWorkloadA,
-    NumComputeQueueWorkloads = NumWorkloads - ComputeQueueWorkloadA,
-};
+using namespace SampleFramework12;
 
-enum class WorkloadType : uint64
-{
-    Compute,
-    Graphics,
-    ComputeQueue,
-};
+static const uint64 MaxWorkloads = 32;
 
 struct Workload
 {
@@ -48,18 +34,16 @@ struct Workload
     uint32* ShaderStartData = nullptr;
     uint32* ShaderEndData = nullptr;
     RawBuffer CounterBuffer;
-    float StartTimes[64] = { };
-    float EndTimes[64] = { };
+    TimingStats StartStats;
+    TimingStats EndStats;
+    TimingStats DurationStats;
     float StartTime = 0;
     float EndTime = 0;
-    const char* Name = nullptr;
+    std::string Name;
     uint64 LastUpdatedFrame = uint64(-1);
-    WorkloadType Type = WorkloadType::Compute;
+    WorkloadNode Node;
     int32 NumGroups = 8;
     int32 NumIterations = 64;
-    bool Enabled = true;
-    bool BufferIsReadable = false;
-    uint64 DependsOn = uint64(-1);
 };
 
 class OverlappedExecution : public App
@@ -80,9 +64,18 @@ protected:
     StructuredBuffer workloadOutputBuffer;
     StructuredBuffer computeWorkloadOutputBuffer;
 
-    Workload workloads[NumWorkloads];
+    Array<Workload> workloads;      // MaxWorkloads of them, too big to live inside the app object on the stack
+    uint64 numWorkloads = 0;
+    WorkloadSchedule schedule;
+    std::string graphError;
+    SimTiming simulatedTimings[MaxWorkloads];
+    SimTimingError simulatedError;
 
     Fence waitFence;
+    Fence queueFences[NumWorkloadQueues];
+    uint64 queueFenceBases[NumWorkloadQueues] = { };
+    WorkloadMonitor workloadMonitor;
+    TraceRecorder traceRecorder;
 
     ID3D12GraphicsCommandList* computeCmdList = nullptr;
     ID3D12CommandQueue* computeQueue = nullptr;
@@ -94,6 +87,15 @@ protected:
 
     DXGI_ADAPTER_DESC1 adapterDesc = { };
 
+    // Batch sweep state, only used when running with --sweep
+    SweepSpec sweepSpec;
+    std::vector<SweepConfig> sweepConfigs;
+    std::vector<SweepResult> sweepResults;
+    SweepSamples sweepSamples;
+    std::wstring sweepReportPath;
+    uint64 sweepConfigIdx = uint64(-1);
+    uint64 sweepMeasureStartFrame = 0;
+
     struct WorkloadConstants
     {
         uint32 FrameNum;
@@ -117,11 +119,21 @@ protected:
 
     virtual void BeforeFlush() override;
 
+    virtual void AddCommandLineOptions(cxxopts::Options& options) override;
+    virtual void ReadCommandLineOptions(cxxopts::Options& options) override;
+
     void RenderCompute();
+    void IssueScheduledBarriers(ID3D12GraphicsCommandList* cmdList, const ScheduleStep& step, D3D12_RESOURCE_STATES readState);
+    void SubmitComputeCmdList(ID3D12CommandQueue* queue);
     void DoComputeWorkload(ID3D12GraphicsCommandList* cmdList, Workload& workload, const StructuredBuffer& workloadOutput);
     void DoGraphicsWorkload(Workload& workload);
+    void TimeWorkloads();
+    void SimulateTimeline();
     void RenderHUD();
     void RenderWorkloadUI();
+    bool EditWorkloadGraph(uint64 workloadIdx, const WorkloadNode& newNode);
+    void UpdateSweep();
+    void ApplySweepConfig(uint64 configIdx);
 
 public:
 
@@ -0,0 +1,189 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Utility.h>
+
+#include "TraceRecorder.h"
+
+using namespace SampleFramework12;
+
+static const char* TraceQueueNames[] =
+{
+    "DIRECT Queue",
+    "COMPUTE Queue",
+};
+
+StaticAssert_(ArraySize_(TraceQueueNames) == uint64(TraceQueue::NumValues));
+StaticAssert_(sizeof(TraceRecord) == 32);
+
+TraceRecorder::~TraceRecorder()
+{
+    Assert_(header == nullptr);
+}
+
+void TraceRecorder::Initialize(const wchar* filePath, uint64 maxRecords, const char* const* workloadNames, uint64 numWorkloads)
+{
+    Assert_(header == nullptr);
+    Assert_(maxRecords > 0);
+    Assert_(numWorkloads <= MaxTraceWorkloads);
+
+    const uint64 fileSize = sizeof(TraceFileHeader) + maxRecords * sizeof(TraceRecord);
+
+    fileHandle = CreateFile(filePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to create trace file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    mappingHandle = CreateFileMapping(fileHandle, nullptr, PAGE_READWRITE, DWORD(fileSize >> 32), DWORD(fileSize), nullptr);
+    Win32Call(mappingHandle != nullptr);
+
+    void* view = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    Win32Call(view != nullptr);
+
+    // Touch every page now so that we don't take page faults while recording
+    memset(view, 0, fileSize);
+
+    header = reinterpret_cast<TraceFileHeader*>(view);
+    records = reinterpret_cast<TraceRecord*>(header + 1);
+
+    header->Magic = TraceFileMagic;
+    header->Version = TraceFileVersion;
+    header->HeaderSize = sizeof(TraceFileHeader);
+    header->RecordSize = sizeof(TraceRecord);
+    header->MaxRecords = maxRecords;
+    header->NumRecordsWritten = 0;
+    header->TSCFrequency = 0.0;
+    header->NumWorkloads = numWorkloads;
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        strncpy_s(header->WorkloadNames[i], workloadNames[i], _TRUNCATE);
+}
+
+void TraceRecorder::Shutdown()
+{
+    if(header == nullptr)
+        return;
+
+    FlushViewOfFile(header, 0);
+    UnmapViewOfFile(header);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+
+    header = nullptr;
+    records = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+void TraceRecorder::SetTSCFrequency(double tscFrequency)
+{
+    Assert_(header != nullptr);
+    header->TSCFrequency = tscFrequency;
+}
+
+void TraceRecorder::RecordWorkload(uint64 frame, uint64 workloadIdx, TraceQueue queue, uint64 startTSC, uint64 endTSC, uint16 flags)
+{
+    Assert_(header != nullptr);
+    Assert_(workloadIdx < header->NumWorkloads);
+
+    TraceRecord& record = records[header->NumRecordsWritten % header->MaxRecords];
+    record.Frame = frame;
+    record.StartTSC = startTSC;
+    record.EndTSC = endTSC;
+    record.WorkloadIdx = uint16(workloadIdx);
+    record.Queue = queue;
+    record.Flags = flags;
+    record.Padding = 0;
+
+    // Only bump the count once the record is complete, so that a reader never sees a partial record
+    MemoryBarrier();
+    ++header->NumRecordsWritten;
+}
+
+void ConvertTraceToJSON(const wchar* tracePath, const wchar* jsonPath)
+{
+    File file(tracePath, FileOpenMode::Read);
+    const uint64 fileSize = file.Size();
+
+    TraceFileHeader header = { };
+    if(fileSize < sizeof(TraceFileHeader))
+        throw Exception(std::wstring(L"Invalid trace file ") + tracePath);
+    file.Read(header);
+
+    if(header.Magic != TraceFileMagic || header.Version != TraceFileVersion || header.HeaderSize != sizeof(TraceFileHeader)
+       || header.RecordSize != sizeof(TraceRecord) || header.NumWorkloads > MaxTraceWorkloads)
+        throw Exception(std::wstring(L"Invalid trace file ") + tracePath);
+
+    if(fileSize < sizeof(TraceFileHeader) + header.MaxRecords * sizeof(TraceRecord))
+        throw Exception(std::wstring(L"Trace file ") + tracePath + L" is truncated");
+
+    std::vector<TraceRecord> records(size_t(header.MaxRecords));
+    if(header.MaxRecords > 0)
+        file.Read(header.MaxRecords * sizeof(TraceRecord), records.data());
+
+    // Walk the ring from the oldest record to the newest
+    const uint64 numRecords = Min(header.NumRecordsWritten, header.MaxRecords);
+    const uint64 firstRecord = header.NumRecordsWritten - numRecords;
+
+    uint64 baseTSC = uint64(-1);
+    for(uint64 i = 0; i < numRecords; ++i)
+    {
+        const TraceRecord& record = records[size_t((firstRecord + i) % header.MaxRecords)];
+        if(record.StartTSC != 0)
+            baseTSC = Min(baseTSC, record.StartTSC);
+    }
+
+    const double tscToUS = header.TSCFrequency > 0.0 ? 1000000.0 / header.TSCFrequency : 0.0;
+
+    // Each queue shows up as a process, with one thread per workload
+    std::string json = "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n";
+    for(uint64 queueIdx = 0; queueIdx < uint64(TraceQueue::NumValues); ++queueIdx)
+    {
+        json += MakeString("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %llu, \"args\": {\"name\": \"%s\"}},\n",
+                           queueIdx, TraceQueueNames[queueIdx]);
+
+        for(uint64 workloadIdx = 0; workloadIdx < header.NumWorkloads; ++workloadIdx)
+        {
+            header.WorkloadNames[workloadIdx][MaxTraceNameLength - 1] = 0;
+            json += MakeString("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %llu, \"tid\": %llu, \"args\": {\"name\": \"%s\"}},\n",
+                               queueIdx, workloadIdx, header.WorkloadNames[workloadIdx]);
+        }
+    }
+
+    for(uint64 i = 0; i < numRecords; ++i)
+    {
+        const TraceRecord& record = records[size_t((firstRecord + i) % header.MaxRecords)];
+        if(record.StartTSC == 0 || record.WorkloadIdx >= header.NumWorkloads || uint64(record.Queue) >= uint64(TraceQueue::NumValues))
+            continue;
+
+        const uint64 endTSC = Max(record.EndTSC, record.StartTSC);
+        const double startUS = (record.StartTSC - baseTSC) * tscToUS;
+        const double durationUS = (endTSC - record.StartTSC) * tscToUS;
+        const bool timedOut = (record.Flags & TraceRecordFlags_TimedOut) != 0;
+
+        json += MakeString("{\"name\": \"%s\", \"cat\": \"workload\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %u, "
+                           "\"tid\": %u, \"args\": {\"frame\": %llu, \"timedOut\": %s}},\n",
+                           header.WorkloadNames[record.WorkloadIdx], startUS, durationUS, uint32(record.Queue),
+                           uint32(record.WorkloadIdx), record.Frame, timedOut ? "true" : "false");
+    }
+
+    // Strip the trailing comma from the last event
+    if(json.back() == '\n' && json[json.size() - 2] == ',')
+        json.erase(json.size() - 2, 1);
+
+    json += "]\n}\n";
+
+    WriteStringAsFile(jsonPath, json);
+}
@@ -0,0 +1,88 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+// Records the raw start/end timestamps of every workload for every frame into a memory-mapped
+// ring buffer file. The file is created and mapped up-front, so recording a frame is just a few
+// stores into the mapped view: no allocations, no system calls, and a fixed memory footprint no
+// matter how long the capture runs. ConvertTraceToJSON turns the file into the Chrome trace event
+// format, which can be loaded in chrome://tracing or Perfetto.
+
+static const uint32 TraceFileMagic = 0x45435254;        // 'TRCE'
+static const uint32 TraceFileVersion = 1;
+static const uint64 MaxTraceWorkloads = 32;
+static const uint64 MaxTraceNameLength = 32;
+
+enum class TraceQueue : uint16
+{
+    Graphics = 0,
+    Compute = 1,
+
+    NumValues
+};
+
+enum TraceRecordFlags : uint16
+{
+    TraceRecordFlags_None = 0,
+    TraceRecordFlags_TimedOut = 1,
+};
+
+struct TraceRecord
+{
+    uint64 Frame;
+    uint64 StartTSC;
+    uint64 EndTSC;
+    uint16 WorkloadIdx;
+    TraceQueue Queue;
+    uint16 Flags;
+    uint16 Padding;
+};
+
+struct TraceFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 HeaderSize;
+    uint32 RecordSize;
+    uint64 MaxRecords;
+    uint64 NumRecordsWritten;           // Keeps counting after the ring wraps
+    double TSCFrequency;                // Ticks per second for the TSC values in the records
+    uint64 NumWorkloads;
+    char WorkloadNames[MaxTraceWorkloads][MaxTraceNameLength];
+};
+
+class TraceRecorder
+{
+
+public:
+
+    ~TraceRecorder();
+
+    void Initialize(const wchar* filePath, uint64 maxRecords, const char* const* workloadNames, uint64 numWorkloads);
+    void Shutdown();
+
+    bool Recording() const { return header != nullptr; }
+
+    void SetTSCFrequency(double tscFrequency);
+    void RecordWorkload(uint64 frame, uint64 workloadIdx, TraceQueue queue, uint64 startTSC, uint64 endTSC, uint16 flags);
+
+protected:
+
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+    TraceFileHeader* header = nullptr;
+    TraceRecord* records = nullptr;
+};
+
+// Converts a recorded trace file to Chrome trace event JSON
+void ConvertTraceToJSON(const wchar* tracePath, const wchar* jsonPath);
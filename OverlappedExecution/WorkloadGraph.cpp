@@ -0,0 +1,533 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Utility.h>
+#include <SF12_Math.h>
+
+#include "WorkloadGraph.h"
+
+using namespace SampleFramework12;
+
+static const uint64 InvalidIdx = uint64(-1);
+
+enum class BarrierState : uint8
+{
+    None,
+    Begun,
+    Readable,
+};
+
+// == WorkloadNode ================================================================================
+
+bool WorkloadNode::DependsOn(uint64 workloadIdx) const
+{
+    for(uint64 i = 0; i < NumDependencies; ++i)
+        if(Dependencies[i] == workloadIdx)
+            return true;
+    return false;
+}
+
+bool WorkloadNode::AddDependency(uint64 workloadIdx)
+{
+    if(DependsOn(workloadIdx))
+        return true;
+    if(NumDependencies >= MaxWorkloadDependencies)
+        return false;
+
+    Dependencies[NumDependencies++] = workloadIdx;
+    return true;
+}
+
+void WorkloadNode::RemoveDependency(uint64 workloadIdx)
+{
+    for(uint64 i = 0; i < NumDependencies; ++i)
+    {
+        if(Dependencies[i] == workloadIdx)
+        {
+            RemoveDependencyAt(i);
+            return;
+        }
+    }
+}
+
+void WorkloadNode::RemoveDependencyAt(uint64 dependencyIdx)
+{
+    Assert_(dependencyIdx < NumDependencies);
+    for(uint64 i = dependencyIdx + 1; i < NumDependencies; ++i)
+        Dependencies[i - 1] = Dependencies[i];
+    --NumDependencies;
+}
+
+// == Graph helpers ===============================================================================
+
+// Dependency edges stored by producer, so that we can quickly find everyone that consumes a workload
+struct ConsumerLists
+{
+    Array<uint64, FrameAllocator> Start;    // Consumers of workload i are Consumers[Start[i]] through Consumers[Start[i + 1] - 1]
+    Array<uint64, FrameAllocator> Consumers;
+};
+
+static bool EdgeIsActive(const WorkloadNode* nodes, uint64 consumerIdx, uint64 producerIdx)
+{
+    return nodes[consumerIdx].Enabled && nodes[producerIdx].Enabled;
+}
+
+static void BuildConsumerLists(const WorkloadNode* nodes, uint64 numNodes, bool activeOnly, ConsumerLists& lists)
+{
+    lists.Start.Init(numNodes + 1, 0);
+
+    uint64 numEdges = 0;
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        const WorkloadNode& node = nodes[nodeIdx];
+        for(uint64 i = 0; i < node.NumDependencies; ++i)
+        {
+            const uint64 depIdx = node.Dependencies[i];
+            if(activeOnly && EdgeIsActive(nodes, nodeIdx, depIdx) == false)
+                continue;
+            ++lists.Start[depIdx + 1];
+            ++numEdges;
+        }
+    }
+
+    for(uint64 i = 0; i < numNodes; ++i)
+        lists.Start[i + 1] += lists.Start[i];
+
+    lists.Consumers.Init(numEdges);
+    Array<uint64, FrameAllocator> offsets(numNodes);
+    for(uint64 i = 0; i < numNodes; ++i)
+        offsets[i] = lists.Start[i];
+
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        const WorkloadNode& node = nodes[nodeIdx];
+        for(uint64 i = 0; i < node.NumDependencies; ++i)
+        {
+            const uint64 depIdx = node.Dependencies[i];
+            if(activeOnly && EdgeIsActive(nodes, nodeIdx, depIdx) == false)
+                continue;
+            lists.Consumers[offsets[depIdx]++] = nodeIdx;
+        }
+    }
+}
+
+bool ValidateWorkloadGraph(const WorkloadNode* nodes, uint64 numNodes, std::string& errorString)
+{
+    errorString.clear();
+
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        const WorkloadNode& node = nodes[nodeIdx];
+        if(node.NumDependencies > MaxWorkloadDependencies)
+        {
+            errorString = MakeString("Workload %llu has more than %llu dependencies", nodeIdx, MaxWorkloadDependencies);
+            return false;
+        }
+
+        for(uint64 i = 0; i < node.NumDependencies; ++i)
+        {
+            const uint64 depIdx = node.Dependencies[i];
+            if(depIdx >= numNodes)
+            {
+                errorString = MakeString("Workload %llu depends on workload %llu, which doesn't exist", nodeIdx, depIdx);
+                return false;
+            }
+
+            if(depIdx == nodeIdx)
+            {
+                errorString = MakeString("Workload %llu depends on itself", nodeIdx);
+                return false;
+            }
+        }
+    }
+
+    // Kahn's algorithm: anything that never runs out of unresolved dependencies is part of a cycle
+    FrameAllocatorScope frameAllocatorScope;
+    ConsumerLists consumerLists;
+    BuildConsumerLists(nodes, numNodes, false, consumerLists);
+
+    Array<uint64, FrameAllocator> numUnresolved(numNodes);
+    FixedList<uint64, FrameAllocator> ready(numNodes);
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        numUnresolved[nodeIdx] = nodes[nodeIdx].NumDependencies;
+        if(numUnresolved[nodeIdx] == 0)
+            ready.Add(nodeIdx);
+    }
+
+    for(uint64 readyIdx = 0; readyIdx < ready.Count(); ++readyIdx)
+    {
+        const uint64 nodeIdx = ready[readyIdx];
+        for(uint64 i = consumerLists.Start[nodeIdx]; i < consumerLists.Start[nodeIdx + 1]; ++i)
+        {
+            const uint64 consumerIdx = consumerLists.Consumers[i];
+            if(--numUnresolved[consumerIdx] == 0)
+                ready.Add(consumerIdx);
+        }
+    }
+
+    if(ready.Count() < numNodes)
+    {
+        for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+        {
+            if(numUnresolved[nodeIdx] > 0)
+            {
+                errorString = MakeString("Workload %llu is part of a dependency cycle", nodeIdx);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// == Scheduling ==================================================================================
+
+// Per-queue state used while emitting the steps for a queue
+struct QueueBuildState
+{
+    WorkloadQueue Queue = WorkloadQueue::Direct;
+    GrowableList<ScheduleStep>* Steps = nullptr;
+    uint64 Segment = 0;                                     // Incremented every time the queue submits
+    FixedList<uint64, FrameAllocator> OpenBegins;           // Split barriers that have begun but not ended
+    FixedList<uint64, FrameAllocator> PendingBegins;        // Split barriers to begin in the next batch
+};
+
+static void AddBarrier(WorkloadSchedule& schedule, uint64 workloadIdx, ScheduledBarrierType type)
+{
+    ScheduledBarrier barrier;
+    barrier.WorkloadIdx = workloadIdx;
+    barrier.Type = type;
+    schedule.Barriers.Add(barrier);
+}
+
+static void AddBarrierStep(QueueBuildState& state, uint64 barrierStart, uint64 barrierEnd)
+{
+    if(barrierEnd == barrierStart)
+        return;
+
+    ScheduleStep step;
+    step.Type = ScheduleStepType::Barriers;
+    step.BarrierStart = barrierStart;
+    step.NumBarriers = barrierEnd - barrierStart;
+    state.Steps->Add(step);
+}
+
+// Split barriers can't straddle a submission, so anything that's still open gets ended right before
+// the queue submits. Anything that was only pending never needs to begin, since the submission
+// itself takes care of synchronizing with the work that came before it.
+static void CloseSplitBarriers(WorkloadSchedule& schedule, QueueBuildState& state, Array<BarrierState, FrameAllocator>& barrierStates)
+{
+    const uint64 barrierStart = schedule.Barriers.Count();
+    for(uint64 i = 0; i < state.OpenBegins.Count(); ++i)
+    {
+        AddBarrier(schedule, state.OpenBegins[i], ScheduledBarrierType::End);
+        barrierStates[state.OpenBegins[i]] = BarrierState::Readable;
+    }
+
+    AddBarrierStep(state, barrierStart, schedule.Barriers.Count());
+    state.OpenBegins.RemoveAll();
+    state.PendingBegins.RemoveAll();
+}
+
+void BuildWorkloadSchedule(const WorkloadNode* nodes, uint64 numNodes, bool useSplitBarriers, WorkloadSchedule& schedule)
+{
+    for(uint64 queueIdx = 0; queueIdx < NumWorkloadQueues; ++queueIdx)
+    {
+        schedule.Steps[queueIdx].RemoveAll();
+        schedule.NumSignals[queueIdx] = 0;
+    }
+    schedule.Barriers.RemoveAll();
+    schedule.NumLevels = 0;
+
+    if(schedule.Levels.Size() != numNodes)
+        schedule.Levels.Init(numNodes);
+    if(numNodes == 0)
+        return;
+
+    Array<uint64>& levels = schedule.Levels;
+    levels.Fill(WorkloadSchedule::InvalidLevel);
+
+    // All of the temporaries below come from the frame allocator, so that building the schedule every
+    // frame doesn't hit the heap. The scope hands the memory back when we're done.
+    FrameAllocatorScope frameAllocatorScope;
+
+    // Only edges between enabled workloads matter from here on
+    ConsumerLists consumerLists;
+    BuildConsumerLists(nodes, numNodes, true, consumerLists);
+
+    // Work out the level of each workload with a topological sort, where the level is the length of the
+    // longest chain of dependencies leading up to a workload
+    Array<uint64, FrameAllocator> numUnresolved(numNodes, 0);
+    FixedList<uint64, FrameAllocator> ready(numNodes);
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        const WorkloadNode& node = nodes[nodeIdx];
+        if(node.Enabled == false)
+            continue;
+
+        for(uint64 i = 0; i < node.NumDependencies; ++i)
+            if(EdgeIsActive(nodes, nodeIdx, node.Dependencies[i]))
+                ++numUnresolved[nodeIdx];
+
+        if(numUnresolved[nodeIdx] == 0)
+        {
+            levels[nodeIdx] = 0;
+            ready.Add(nodeIdx);
+        }
+    }
+
+    for(uint64 readyIdx = 0; readyIdx < ready.Count(); ++readyIdx)
+    {
+        const uint64 nodeIdx = ready[readyIdx];
+        schedule.NumLevels = Max(schedule.NumLevels, levels[nodeIdx] + 1);
+
+        for(uint64 i = consumerLists.Start[nodeIdx]; i < consumerLists.Start[nodeIdx + 1]; ++i)
+        {
+            const uint64 consumerIdx = consumerLists.Consumers[i];
+            if(levels[consumerIdx] == WorkloadSchedule::InvalidLevel || levels[consumerIdx] < levels[nodeIdx] + 1)
+                levels[consumerIdx] = levels[nodeIdx] + 1;
+            if(--numUnresolved[consumerIdx] == 0)
+                ready.Add(consumerIdx);
+        }
+    }
+
+#if UseAsserts_
+    // Every enabled workload should have been reached, unless the graph has a cycle
+    uint64 numEnabled = 0;
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+        numEnabled += nodes[nodeIdx].Enabled ? 1 : 0;
+    Assert_(ready.Count() == numEnabled);
+#endif
+
+    // Sort the enabled workloads by level, keeping them in index order within a level
+    const uint64 numActive = ready.Count();
+    Array<uint64, FrameAllocator> levelStart(schedule.NumLevels + 1, 0);
+    for(uint64 i = 0; i < numActive; ++i)
+        ++levelStart[levels[ready[i]] + 1];
+    for(uint64 level = 0; level < schedule.NumLevels; ++level)
+        levelStart[level + 1] += levelStart[level];
+
+    Array<uint64, FrameAllocator> order(numActive);
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+        if(levels[nodeIdx] != WorkloadSchedule::InvalidLevel)
+            order[levelStart[levels[nodeIdx]]++] = nodeIdx;
+
+    // Find out which workloads are consumed on another queue (and so need a fence signal after them),
+    // and where the first consumer on the same queue is
+    Array<bool, FrameAllocator> needsSignal(numNodes, false);
+    Array<uint64, FrameAllocator> firstConsumerLevel(numNodes, WorkloadSchedule::InvalidLevel);
+    for(uint64 nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        const WorkloadQueue queue = QueueForWorkload(nodes[nodeIdx].Type);
+        for(uint64 i = consumerLists.Start[nodeIdx]; i < consumerLists.Start[nodeIdx + 1]; ++i)
+        {
+            const uint64 consumerIdx = consumerLists.Consumers[i];
+            if(QueueForWorkload(nodes[consumerIdx].Type) != queue)
+                needsSignal[nodeIdx] = true;
+            else
+                firstConsumerLevel[nodeIdx] = Min(firstConsumerLevel[nodeIdx], levels[consumerIdx]);
+        }
+    }
+
+    // Assign fence values up-front, since a queue can wait on a signal that the other queue emits later
+    // in its list. Every level that contains a workload with a cross-queue consumer gets a signal.
+    Array<uint64, FrameAllocator> signalValues(numNodes, 0);
+    for(uint64 queueIdx = 0; queueIdx < NumWorkloadQueues; ++queueIdx)
+    {
+        uint64 groupStart = 0;
+        while(groupStart < numActive)
+        {
+            const uint64 level = levels[order[groupStart]];
+            uint64 groupEnd = groupStart;
+            bool signal = false;
+            while(groupEnd < numActive && levels[order[groupEnd]] == level)
+            {
+                const uint64 nodeIdx = order[groupEnd];
+                if(uint64(QueueForWorkload(nodes[nodeIdx].Type)) == queueIdx && needsSignal[nodeIdx])
+                    signal = true;
+                ++groupEnd;
+            }
+
+            if(signal)
+            {
+                ++schedule.NumSignals[queueIdx];
+                for(uint64 i = groupStart; i < groupEnd; ++i)
+                    if(uint64(QueueForWorkload(nodes[order[i]].Type)) == queueIdx)
+                        signalValues[order[i]] = schedule.NumSignals[queueIdx];
+            }
+
+            groupStart = groupEnd;
+        }
+    }
+
+    // Now emit the steps for each queue, one level at a time
+    Array<BarrierState, FrameAllocator> barrierStates(numNodes, BarrierState::None);
+    Array<uint64, FrameAllocator> segments(numNodes, InvalidIdx);
+    FixedList<uint64, FrameAllocator> group(numNodes);
+    for(uint64 queueIdx = 0; queueIdx < NumWorkloadQueues; ++queueIdx)
+    {
+        QueueBuildState state;
+        state.Queue = WorkloadQueue(queueIdx);
+        state.Steps = &schedule.Steps[queueIdx];
+        state.OpenBegins.Init(numNodes);
+        state.PendingBegins.Init(numNodes);
+
+        uint64 lastWaitValues[NumWorkloadQueues] = { };
+
+        uint64 orderIdx = 0;
+        while(orderIdx < numActive)
+        {
+            // Gather up the workloads from this queue at the next level
+            group.RemoveAll();
+            const uint64 level = levels[order[orderIdx]];
+            for(; orderIdx < numActive && levels[order[orderIdx]] == level; ++orderIdx)
+                if(QueueForWorkload(nodes[order[orderIdx]].Type) == state.Queue)
+                    group.Add(order[orderIdx]);
+
+            if(group.Count() == 0)
+                continue;
+
+            // Wait for the other queues to finish the workloads that this level depends on
+            uint64 waitValues[NumWorkloadQueues] = { };
+            bool needsWait = false;
+            for(uint64 i = 0; i < group.Count(); ++i)
+            {
+                const WorkloadNode& node = nodes[group[i]];
+                for(uint64 depIdx = 0; depIdx < node.NumDependencies; ++depIdx)
+                {
+                    const uint64 dependency = node.Dependencies[depIdx];
+                    const uint64 depQueue = uint64(QueueForWorkload(nodes[dependency].Type));
+                    if(nodes[dependency].Enabled == false || depQueue == queueIdx)
+                        continue;
+
+                    waitValues[depQueue] = Max(waitValues[depQueue], signalValues[dependency]);
+                    needsWait = needsWait || waitValues[depQueue] > lastWaitValues[depQueue];
+                }
+            }
+
+            if(needsWait)
+            {
+                CloseSplitBarriers(schedule, state, barrierStates);
+
+                for(uint64 otherQueue = 0; otherQueue < NumWorkloadQueues; ++otherQueue)
+                {
+                    if(waitValues[otherQueue] <= lastWaitValues[otherQueue])
+                        continue;
+
+                    ScheduleStep step;
+                    step.Type = ScheduleStepType::Wait;
+                    step.FenceQueue = WorkloadQueue(otherQueue);
+                    step.FenceValue = waitValues[otherQueue];
+                    state.Steps->Add(step);
+
+                    lastWaitValues[otherQueue] = waitValues[otherQueue];
+                }
+
+                ++state.Segment;
+            }
+
+            // Coalesce everything that needs to happen before this level into a single batch: the split
+            // barriers that begin after the previous level, and the barriers for this level's dependencies
+            const uint64 barrierStart = schedule.Barriers.Count();
+            for(uint64 i = 0; i < state.PendingBegins.Count(); ++i)
+            {
+                AddBarrier(schedule, state.PendingBegins[i], ScheduledBarrierType::Begin);
+                barrierStates[state.PendingBegins[i]] = BarrierState::Begun;
+                state.OpenBegins.Add(state.PendingBegins[i]);
+            }
+            state.PendingBegins.RemoveAll();
+
+            for(uint64 i = 0; i < group.Count(); ++i)
+            {
+                const WorkloadNode& node = nodes[group[i]];
+                for(uint64 depIdx = 0; depIdx < node.NumDependencies; ++depIdx)
+                {
+                    const uint64 dependency = node.Dependencies[depIdx];
+                    if(nodes[dependency].Enabled == false || QueueForWorkload(nodes[dependency].Type) != state.Queue)
+                        continue;
+
+                    // Work from an earlier submission is already synchronized
+                    if(segments[dependency] != state.Segment || barrierStates[dependency] == BarrierState::Readable)
+                        continue;
+
+                    if(barrierStates[dependency] == BarrierState::Begun)
+                    {
+                        AddBarrier(schedule, dependency, ScheduledBarrierType::End);
+                        for(uint64 openIdx = 0; openIdx < state.OpenBegins.Count(); ++openIdx)
+                        {
+                            if(state.OpenBegins[openIdx] == dependency)
+                            {
+                                state.OpenBegins.Remove(openIdx);
+                                break;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        AddBarrier(schedule, dependency, ScheduledBarrierType::Full);
+                    }
+
+                    barrierStates[dependency] = BarrierState::Readable;
+                }
+            }
+
+            AddBarrierStep(state, barrierStart, schedule.Barriers.Count());
+
+            bool signal = false;
+            for(uint64 i = 0; i < group.Count(); ++i)
+            {
+                ScheduleStep step;
+                step.Type = ScheduleStepType::Workload;
+                step.WorkloadIdx = group[i];
+                state.Steps->Add(step);
+
+                segments[group[i]] = state.Segment;
+                signal = signal || needsSignal[group[i]];
+            }
+
+            if(signal)
+            {
+                CloseSplitBarriers(schedule, state, barrierStates);
+
+                ScheduleStep step;
+                step.Type = ScheduleStepType::Signal;
+                step.FenceQueue = state.Queue;
+                step.FenceValue = signalValues[group[0]];
+                state.Steps->Add(step);
+
+                ++state.Segment;
+            }
+            else if(useSplitBarriers)
+            {
+                // Find the next level that has work on this queue. Split barriers only help if there's
+                // something to overlap with in between the producer and its first consumer.
+                uint64 nextLevel = WorkloadSchedule::InvalidLevel;
+                for(uint64 i = orderIdx; i < numActive; ++i)
+                {
+                    if(QueueForWorkload(nodes[order[i]].Type) == state.Queue)
+                    {
+                        nextLevel = levels[order[i]];
+                        break;
+                    }
+                }
+
+                for(uint64 i = 0; i < group.Count(); ++i)
+                {
+                    const uint64 consumerLevel = firstConsumerLevel[group[i]];
+                    if(consumerLevel != WorkloadSchedule::InvalidLevel && consumerLevel > nextLevel)
+                        state.PendingBegins.Add(group[i]);
+                }
+            }
+        }
+    }
+}
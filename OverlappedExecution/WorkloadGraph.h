@@ -0,0 +1,117 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include <Containers.h>
+
+using namespace SampleFramework12;
+
+// Workloads form a DAG, where every workload can depend on any number of other workloads (up to
+// MaxWorkloadDependencies) on either queue. BuildWorkloadSchedule turns the graph into an ordered list
+// of commands for each queue: workloads are submitted level-by-level in topological order, all of the
+// barriers needed before a level are coalesced into a single batch, and dependencies that cross
+// queues are synchronized with fences. None of this touches D3D12, so the same schedule drives both
+// Render()/RenderCompute() and the CPU simulation.
+
+static const uint64 MaxWorkloadDependencies = 8;
+
+enum class WorkloadType : uint64
+{
+    Compute,
+    Graphics,
+    ComputeQueue,
+
+    NumValues
+};
+
+enum class WorkloadQueue : uint64
+{
+    Direct = 0,
+    Compute,
+
+    NumValues
+};
+
+static const uint64 NumWorkloadQueues = uint64(WorkloadQueue::NumValues);
+
+inline WorkloadQueue QueueForWorkload(WorkloadType type)
+{
+    return type == WorkloadType::ComputeQueue ? WorkloadQueue::Compute : WorkloadQueue::Direct;
+}
+
+struct WorkloadNode
+{
+    WorkloadType Type = WorkloadType::Compute;
+    bool Enabled = true;
+    uint64 NumDependencies = 0;
+    uint64 Dependencies[MaxWorkloadDependencies] = { };
+
+    bool DependsOn(uint64 workloadIdx) const;
+    bool AddDependency(uint64 workloadIdx);
+    void RemoveDependency(uint64 workloadIdx);
+    void RemoveDependencyAt(uint64 dependencyIdx);
+};
+
+enum class ScheduleStepType : uint64
+{
+    Barriers,       // Issue Barriers[BarrierStart] through Barriers[BarrierStart + NumBarriers - 1] in one call
+    Workload,       // Dispatch or draw WorkloadIdx
+    Signal,         // Submit everything recorded so far, then signal this queue's fence with FenceValue
+    Wait,           // Submit everything recorded so far, then wait for FenceQueue's fence to reach FenceValue
+};
+
+enum class ScheduledBarrierType : uint64
+{
+    Full,           // Regular transition barrier
+    Begin,          // Start of a split barrier, issued as soon as the workload has been submitted
+    End,            // End of a split barrier, issued right before the first workload that needs it
+};
+
+// Transitions the output of WorkloadIdx so that later workloads on the same queue can consume it
+struct ScheduledBarrier
+{
+    uint64 WorkloadIdx = 0;
+    ScheduledBarrierType Type = ScheduledBarrierType::Full;
+};
+
+struct ScheduleStep
+{
+    ScheduleStepType Type = ScheduleStepType::Workload;
+    uint64 WorkloadIdx = 0;
+    uint64 BarrierStart = 0;
+    uint64 NumBarriers = 0;
+    WorkloadQueue FenceQueue = WorkloadQueue::Direct;
+    uint64 FenceValue = 0;          // Counts up from 1 within a frame, add the per-frame base when submitting
+};
+
+// The lists are rebuilt every frame, but keep their storage through RemoveAll() so that they stop
+// allocating once they've grown to fit the graph. They stay on the heap rather than the frame allocator,
+// since the schedule lives across frames and FrameAllocator::Reset() would pull the memory out from under it.
+struct WorkloadSchedule
+{
+    static const uint64 InvalidLevel = uint64(-1);
+
+    GrowableList<ScheduleStep> Steps[NumWorkloadQueues];
+    GrowableList<ScheduledBarrier> Barriers;
+    uint64 NumSignals[NumWorkloadQueues] = { };
+
+    Array<uint64> Levels;           // Graph depth of each workload, InvalidLevel for disabled workloads
+    uint64 NumLevels = 0;
+};
+
+// Checks for out-of-range indices, self-dependencies and cycles. Disabled workloads are included,
+// so that enabling a workload can never produce an invalid graph.
+bool ValidateWorkloadGraph(const WorkloadNode* nodes, uint64 numNodes, std::string& errorString);
+
+// Builds the per-queue command lists for the enabled workloads in a graph that passed validation
+void BuildWorkloadSchedule(const WorkloadNode* nodes, uint64 numNodes, bool useSplitBarriers, WorkloadSchedule& schedule);
@@ -0,0 +1,280 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <intrin.h>
+
+#include <Exceptions.h>
+#include <SF12_Math.h>
+
+#include "WorkloadMonitor.h"
+
+using namespace SampleFramework12;
+
+// Only re-measure the TSC frequency once this much time has passed since the reference point,
+// so that the error from the QPC/TSC read pair stays small
+static const double MinCalibrationTime = 0.1;
+
+static uint64 ReadTSC()
+{
+    return __rdtsc();
+}
+
+static int64 ReadQPC()
+{
+    LARGE_INTEGER qpc = { };
+    QueryPerformanceCounter(&qpc);
+    return qpc.QuadPart;
+}
+
+WorkloadMonitor::WorkloadMonitor() : waitPolicy(uint64(MonitorWaitPolicy::Backoff)), armed(false),
+                                     exiting(false), numDroppedResults(0)
+{
+}
+
+WorkloadMonitor::~WorkloadMonitor()
+{
+    Assert_(thread.joinable() == false);
+}
+
+void WorkloadMonitor::Initialize(const MonitorSettings& monitorSettings)
+{
+    Assert_(thread.joinable() == false);
+    Assert_(uint64(monitorSettings.WaitPolicy) < uint64(MonitorWaitPolicy::NumValues));
+
+    settings = monitorSettings;
+    settings.MaxBackoffPauses = Max(settings.MaxBackoffPauses, 1u);
+    waitPolicy.store(uint64(settings.WaitPolicy));
+
+    wakeEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+    Win32Call(wakeEvent != 0);
+
+    // Manual-reset, starts out signaled since there's nothing to monitor yet
+    idleEvent = CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET | CREATE_EVENT_INITIAL_SET, EVENT_ALL_ACCESS);
+    Win32Call(idleEvent != 0);
+
+    CalibrateTSC(true);
+
+    armed.store(false);
+    exiting.store(false);
+    thread = std::thread(&WorkloadMonitor::MonitorThread, this);
+}
+
+void WorkloadMonitor::Shutdown()
+{
+    if(thread.joinable() == false)
+        return;
+
+    // Any frame that's still being monitored will either complete or time out
+    WaitForIdle();
+
+    exiting.store(true);
+    SetEvent(wakeEvent);
+    thread.join();
+
+    CloseHandle(wakeEvent);
+    CloseHandle(idleEvent);
+    wakeEvent = nullptr;
+    idleEvent = nullptr;
+}
+
+// Measures the TSC frequency against QPC. The initial calibration blocks for a few milliseconds
+// to get a usable value, after that the frequency is refined over the full time since the
+// reference point was taken.
+void WorkloadMonitor::CalibrateTSC(bool initial)
+{
+    if(initial)
+    {
+        LARGE_INTEGER qpcFreq = { };
+        QueryPerformanceFrequency(&qpcFreq);
+        qpcFrequency = qpcFreq.QuadPart;
+
+        calibrationQPC = ReadQPC();
+        calibrationTSC = ReadTSC();
+
+        const int64 endQPC = calibrationQPC + qpcFrequency / 200;
+        while(ReadQPC() < endQPC)
+            YieldProcessor();
+    }
+
+    const int64 currQPC = ReadQPC();
+    const uint64 currTSC = ReadTSC();
+    const double elapsed = double(currQPC - calibrationQPC) / double(qpcFrequency);
+    if(initial || elapsed >= MinCalibrationTime)
+        tscFrequency = double(currTSC - calibrationTSC) / elapsed;
+}
+
+void WorkloadMonitor::BeginFrame(uint64 frameNum, uint32 signal, const MonitorTarget* frameTargets, uint64 numFrameTargets)
+{
+    Assert_(thread.joinable());
+    Assert_(armed.load() == false);
+    Assert_(numFrameTargets <= MonitorResult::MaxTargets);
+
+    CalibrateTSC(false);
+
+    numTargets = Min(numFrameTargets, MonitorResult::MaxTargets);
+    for(uint64 i = 0; i < numTargets; ++i)
+        targets[i] = frameTargets[i];
+    frame = frameNum;
+    signalValue = signal;
+    tscToMS = 1000.0 / tscFrequency;
+
+    ResetEvent(idleEvent);
+
+    // Stamp the base time last, so that it's as close as possible to the GPU being released
+    baseTSC = ReadTSC();
+    armed.store(true, std::memory_order_release);
+    SetEvent(wakeEvent);
+}
+
+void WorkloadMonitor::WaitForIdle()
+{
+    if(thread.joinable())
+        WaitForSingleObject(idleEvent, INFINITE);
+}
+
+bool WorkloadMonitor::Idle() const
+{
+    return armed.load(std::memory_order_acquire) == false;
+}
+
+bool WorkloadMonitor::PopResult(MonitorResult& result)
+{
+    return results.Pop(result);
+}
+
+void WorkloadMonitor::SetWaitPolicy(MonitorWaitPolicy policy)
+{
+    Assert_(uint64(policy) < uint64(MonitorWaitPolicy::NumValues));
+    waitPolicy.store(uint64(policy), std::memory_order_relaxed);
+}
+
+void WorkloadMonitor::MonitorThread()
+{
+    while(true)
+    {
+        WaitForSingleObject(wakeEvent, INFINITE);
+
+        if(exiting.load())
+            break;
+
+        if(armed.load(std::memory_order_acquire) == false)
+            continue;
+
+        MonitorFrame();
+
+        armed.store(false, std::memory_order_release);
+        SetEvent(idleEvent);
+    }
+}
+
+// Polls the targets until every one of them has ended (or we hit the timeout)
+void WorkloadMonitor::MonitorFrame()
+{
+    uint64 startTSC[MonitorResult::MaxTargets] = { };
+    uint64 endTSC[MonitorResult::MaxTargets] = { };
+    bool started[MonitorResult::MaxTargets] = { };
+    bool ended[MonitorResult::MaxTargets] = { };
+
+    const MonitorWaitPolicy policy = MonitorWaitPolicy(waitPolicy.load(std::memory_order_relaxed));
+    const uint64 timeoutTicks = uint64(settings.TimeoutMS / tscToMS);
+    const uint32 maxPauses = settings.MaxBackoffPauses;
+    uint32 numPauses = 1;
+    uint64 numEnded = 0;
+    bool timedOut = false;
+
+    while(numEnded < numTargets)
+    {
+        // Every transition seen during this pass gets the same timestamp
+        const uint64 tsc = ReadTSC();
+        bool sawTransition = false;
+
+        for(uint64 i = 0; i < numTargets; ++i)
+        {
+            if(ended[i])
+                continue;
+
+            const MonitorTarget& target = targets[i];
+            if(started[i] == false && *target.StartData >= signalValue)
+            {
+                startTSC[i] = tsc;
+                started[i] = true;
+                sawTransition = true;
+            }
+
+            if(*target.EndData >= signalValue)
+            {
+                // The shader may have started and finished between reading the two values
+                if(started[i] == false)
+                {
+                    startTSC[i] = tsc;
+                    started[i] = true;
+                }
+
+                endTSC[i] = tsc;
+                ended[i] = true;
+                sawTransition = true;
+                ++numEnded;
+            }
+        }
+
+        if(numEnded == numTargets)
+            break;
+
+        if(tsc - baseTSC >= timeoutTicks)
+        {
+            timedOut = true;
+            break;
+        }
+
+        if(sawTransition)
+        {
+            // Something is happening, so poll more frequently
+            numPauses = 1;
+            continue;
+        }
+
+        if(policy == MonitorWaitPolicy::Spin)
+        {
+            YieldProcessor();
+        }
+        else if(policy == MonitorWaitPolicy::Yield)
+        {
+            SwitchToThread();
+        }
+        else
+        {
+            for(uint32 i = 0; i < numPauses; ++i)
+                YieldProcessor();
+
+            if(numPauses < maxPauses)
+                numPauses = Min(numPauses * 2, maxPauses);
+            else
+                SwitchToThread();
+        }
+    }
+
+    MonitorResult result;
+    result.Frame = frame;
+    result.NumTargets = numTargets;
+    result.TimedOut = timedOut;
+    for(uint64 i = 0; i < numTargets; ++i)
+    {
+        result.IDs[i] = targets[i].ID;
+        result.StartTimes[i] = started[i] ? float((startTSC[i] - baseTSC) * tscToMS) : 0.0f;
+        result.EndTimes[i] = ended[i] ? float((endTSC[i] - baseTSC) * tscToMS) : 0.0f;
+        result.StartTSC[i] = startTSC[i];
+        result.EndTSC[i] = endTSC[i];
+    }
+
+    if(results.Push(result) == false)
+        ++numDroppedResults;
+}
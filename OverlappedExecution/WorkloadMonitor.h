@@ -0,0 +1,173 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include <atomic>
+#include <thread>
+
+#include <Assert.h>
+
+// Watches the start/end readback buffers for a frame's worth of workloads from a dedicated thread,
+// and hands the observed timings back through a lock-free ring. Transitions are stamped with a
+// single TSC read per polling pass, which keeps the timer out of the measurements and means that
+// the main thread no longer has to spin while the GPU works. The monitor only ever reads through
+// the pointers in MonitorTarget, so it can be driven by plain memory instead of a readback heap.
+
+enum class MonitorWaitPolicy : uint64
+{
+    Spin = 0,       // Pause instruction between polls, lowest latency but occupies a full core
+    Yield,          // Gives up the time slice between polls
+    Backoff,        // Exponentially increasing pause count between polls, yielding once it maxes out
+
+    NumValues
+};
+
+struct MonitorSettings
+{
+    MonitorWaitPolicy WaitPolicy = MonitorWaitPolicy::Backoff;
+    uint32 MaxBackoffPauses = 256;          // Upper limit on the pause count for MonitorWaitPolicy::Backoff
+    float TimeoutMS = 1000.0f;              // Gives up on a frame if its workloads haven't finished by then
+};
+
+// Location of the values that a workload's shader writes when it starts and ends. A workload is
+// considered to have started/ended once the value is >= the signal value passed to BeginFrame.
+struct MonitorTarget
+{
+    const volatile uint32* StartData = nullptr;
+    const volatile uint32* EndData = nullptr;
+    uint64 ID = 0;
+};
+
+// Timings observed for a single frame, in milliseconds relative to the call to BeginFrame. The raw
+// TSC values are also provided. A time of 0 means that the transition was never seen.
+struct MonitorResult
+{
+    static const uint64 MaxTargets = 64;
+
+    uint64 Frame = 0;
+    uint64 NumTargets = 0;
+    uint64 IDs[MaxTargets] = { };
+    float StartTimes[MaxTargets] = { };
+    float EndTimes[MaxTargets] = { };
+    uint64 StartTSC[MaxTargets] = { };
+    uint64 EndTSC[MaxTargets] = { };
+    bool TimedOut = false;
+};
+
+// Fixed-size single-producer/single-consumer ring buffer. NumElements must be a power of 2.
+template<typename T, uint64 NumElements> class SPSCRing
+{
+    StaticAssert_((NumElements & (NumElements - 1)) == 0);
+
+protected:
+
+    T elements[NumElements];
+    std::atomic<uint64> writeIdx;
+    std::atomic<uint64> readIdx;
+
+public:
+
+    SPSCRing() : writeIdx(0), readIdx(0)
+    {
+    }
+
+    // Producer side, fails if the ring is full
+    bool Push(const T& item)
+    {
+        const uint64 write = writeIdx.load(std::memory_order_relaxed);
+        if(write - readIdx.load(std::memory_order_acquire) == NumElements)
+            return false;
+
+        elements[write % NumElements] = item;
+        writeIdx.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, fails if the ring is empty
+    bool Pop(T& item)
+    {
+        const uint64 read = readIdx.load(std::memory_order_relaxed);
+        if(read == writeIdx.load(std::memory_order_acquire))
+            return false;
+
+        item = elements[read % NumElements];
+        readIdx.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64 Count() const
+    {
+        return writeIdx.load(std::memory_order_acquire) - readIdx.load(std::memory_order_acquire);
+    }
+};
+
+class WorkloadMonitor
+{
+
+public:
+
+    WorkloadMonitor();
+    ~WorkloadMonitor();
+
+    void Initialize(const MonitorSettings& settings = MonitorSettings());
+    void Shutdown();
+
+    // Arms the monitor with a new set of targets. The monitor needs to be idle, so call WaitForIdle
+    // first. For accurate timings this should be called right before letting the GPU start working.
+    void BeginFrame(uint64 frame, uint32 signalValue, const MonitorTarget* targets, uint64 numTargets);
+
+    // Blocks until the monitor is done with the frame passed to BeginFrame
+    void WaitForIdle();
+    bool Idle() const;
+
+    // Returns the oldest result that hasn't been consumed yet
+    bool PopResult(MonitorResult& result);
+
+    // Can be called at any time, takes effect on the next frame
+    void SetWaitPolicy(MonitorWaitPolicy policy);
+
+    uint64 NumDroppedResults() const { return numDroppedResults.load(); }
+    double TSCFrequency() const { return tscFrequency; }
+
+protected:
+
+    void MonitorThread();
+    void MonitorFrame();
+    void CalibrateTSC(bool initial);
+
+    MonitorSettings settings;
+    std::atomic<uint64> waitPolicy;
+
+    std::thread thread;
+    HANDLE wakeEvent = nullptr;
+    HANDLE idleEvent = nullptr;
+    std::atomic<bool> armed;
+    std::atomic<bool> exiting;
+    std::atomic<uint64> numDroppedResults;
+
+    // State for the armed frame, only written while the monitor thread is idle
+    MonitorTarget targets[MonitorResult::MaxTargets];
+    uint64 numTargets = 0;
+    uint64 frame = 0;
+    uint32 signalValue = 0;
+    uint64 baseTSC = 0;
+    double tscToMS = 0.0;
+
+    // Reference points for measuring the TSC frequency against QPC
+    uint64 calibrationTSC = 0;
+    int64 calibrationQPC = 0;
+    int64 qpcFrequency = 0;
+    double tscFrequency = 0.0;
+
+    SPSCRing<MonitorResult, 8> results;
+};
@@ -0,0 +1,373 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <atomic>
+#include <thread>
+
+#include <SF12_Math.h>
+
+#include "WorkloadSim.h"
+
+using namespace SampleFramework12;
+
+static const uint64 GfxQueueIdx = uint64(WorkloadQueue::Direct);
+static const uint64 ComputeQueueIdx = uint64(WorkloadQueue::Compute);
+static const uint64 NumQueues = NumWorkloadQueues;
+static const uint64 InvalidIdx = uint64(-1);
+static const double NoEvent = 1e30;
+
+struct SimWorkloadState
+{
+    uint64 GroupsToLaunch = 0;
+    uint64 GroupsRemaining = 0;
+    uint64 QueuePos = InvalidIdx;   // Position in the queue's Order list
+    double GroupDuration = 0.0;
+    double IssueLatency = 0.0;
+    double ReadyTime = 0.0;         // Time at which the front-end has issued the workload
+    double StartTime = 0.0;
+    double EndTime = 0.0;
+    bool Started = false;
+    bool Done = false;
+};
+
+struct SimQueueState
+{
+    const GrowableList<ScheduleStep>* Steps = nullptr;
+    uint64 StepIdx = 0;                         // Next step for the front-end to process
+    FixedList<uint64, FrameAllocator> Order;    // Workload indices, in submission order
+    uint64 NumIssued = 0;
+    uint64 NumDone = 0;                         // Length of the fully-completed prefix of Order
+    uint64 LaunchIdx = 0;                       // Position in Order that's currently launching thread groups
+    uint64 SignaledValue = 0;                   // Last fence value signaled by this queue
+    double FrontEndTime = 0.0;
+    bool PendingBarrier = false;                // A barrier batch was issued, the next workload pays for it
+};
+
+static void UpdateNumDone(SimQueueState& queue, const Array<SimWorkloadState, FrameAllocator>& states)
+{
+    while(queue.NumDone < queue.Order.Count() && states[queue.Order[queue.NumDone]].Done)
+        ++queue.NumDone;
+}
+
+// Works out how much of the queue needs to be finished before a batch of barriers can complete. A regular
+// transition barrier drains everything that came before it on the queue, while the end of a split barrier
+// only needs to wait for the work that was submitted before the matching begin.
+static uint64 BarrierWaitCount(const WorkloadSchedule& schedule, const ScheduleStep& step, const SimQueueState& queue,
+                               const Array<SimWorkloadState, FrameAllocator>& states)
+{
+    uint64 waitCount = 0;
+    for(uint64 i = 0; i < step.NumBarriers; ++i)
+    {
+        const ScheduledBarrier& barrier = schedule.Barriers[step.BarrierStart + i];
+        if(barrier.Type == ScheduledBarrierType::Full)
+            waitCount = Max(waitCount, queue.NumIssued);
+        else if(barrier.Type == ScheduledBarrierType::End)
+            waitCount = Max(waitCount, states[barrier.WorkloadIdx].QueuePos + 1);
+    }
+
+    return waitCount;
+}
+
+// Lets the front-end of a queue process as many commands as it can. Commands are processed in-order, so a
+// barrier or fence wait that's still blocked stalls everything behind it. Returns true if anything was processed.
+static bool IssueCommands(const WorkloadSchedule& schedule, const SimGPUDesc& gpu, double currTime, uint64 queueIdx,
+                          SimQueueState* queues, Array<SimWorkloadState, FrameAllocator>& states)
+{
+    SimQueueState& queue = queues[queueIdx];
+    bool progress = false;
+    while(queue.StepIdx < queue.Steps->Count())
+    {
+        const ScheduleStep& step = (*queue.Steps)[queue.StepIdx];
+        if(step.Type == ScheduleStepType::Barriers)
+        {
+            UpdateNumDone(queue, states);
+            if(queue.NumDone < BarrierWaitCount(schedule, step, queue, states))
+                break;
+
+            queue.PendingBarrier = true;
+        }
+        else if(step.Type == ScheduleStepType::Workload)
+        {
+            SimWorkloadState& state = states[step.WorkloadIdx];
+            double issueTime = Max(queue.FrontEndTime, currTime);
+            if(queue.PendingBarrier)
+                issueTime += gpu.BarrierLatency;
+            issueTime += state.IssueLatency;
+
+            state.ReadyTime = issueTime;
+            queue.FrontEndTime = issueTime;
+            queue.PendingBarrier = false;
+            ++queue.NumIssued;
+        }
+        else if(step.Type == ScheduleStepType::Signal)
+        {
+            // The fence is signaled once everything submitted before it has completed
+            UpdateNumDone(queue, states);
+            if(queue.NumDone < queue.NumIssued)
+                break;
+
+            queue.SignaledValue = step.FenceValue;
+        }
+        else if(step.Type == ScheduleStepType::Wait)
+        {
+            if(queues[uint64(step.FenceQueue)].SignaledValue < step.FenceValue)
+                break;
+
+            queue.FrontEndTime = Max(queue.FrontEndTime, currTime) + gpu.FenceLatency;
+        }
+
+        ++queue.StepIdx;
+        progress = true;
+    }
+
+    return progress;
+}
+
+void SimulateWorkloads(const SimWorkload* workloads, uint64 numWorkloads, const SimSettings& settings,
+                       const SimGPUDesc& gpu, SimTiming* timings)
+{
+    Assert_(workloads != nullptr || numWorkloads == 0);
+    Assert_(timings != nullptr || numWorkloads == 0);
+    Assert_(gpu.NumShaderSlots > 0);
+    Assert_(gpu.ThreadGroupSize > 0);
+
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        timings[i] = SimTiming();
+
+    if(numWorkloads == 0)
+        return;
+
+    // The schedule keeps its lists between simulations on the same thread, and everything else comes from
+    // the frame allocator, so that simulating every frame doesn't hit the heap
+    FrameAllocatorScope frameAllocatorScope;
+    Array<WorkloadNode, FrameAllocator> nodes(numWorkloads);
+    for(uint64 i = 0; i < numWorkloads; ++i)
+        nodes[i] = workloads[i].Node;
+
+    static thread_local WorkloadSchedule schedule;
+    BuildWorkloadSchedule(nodes.Data(), numWorkloads, settings.UseSplitBarriers, schedule);
+
+    Array<SimWorkloadState, FrameAllocator> states(numWorkloads);
+    SimQueueState queues[NumQueues];
+    uint64 numActive = 0;
+    for(uint64 queueIdx = 0; queueIdx < NumQueues; ++queueIdx)
+    {
+        SimQueueState& queue = queues[queueIdx];
+        queue.Steps = &schedule.Steps[queueIdx];
+        queue.Order.Init(numWorkloads);
+
+        for(uint64 stepIdx = 0; stepIdx < queue.Steps->Count(); ++stepIdx)
+        {
+            const ScheduleStep& step = (*queue.Steps)[stepIdx];
+            if(step.Type != ScheduleStepType::Workload)
+                continue;
+
+            const SimWorkload& workload = workloads[step.WorkloadIdx];
+            const uint64 numThreads = uint64(workload.NumGroups) * 1024;
+            SimWorkloadState& state = states[step.WorkloadIdx];
+            state.GroupsToLaunch = (numThreads + gpu.ThreadGroupSize - 1) / gpu.ThreadGroupSize;
+            state.GroupsRemaining = state.GroupsToLaunch;
+            state.GroupDuration = workload.NumIterations * double(gpu.IterationTime);
+            state.IssueLatency = workload.Node.Type == WorkloadType::Graphics ? gpu.DrawLatency : gpu.DispatchLatency;
+            state.QueuePos = queue.Order.Count();
+
+            queue.Order.Add(step.WorkloadIdx);
+            ++numActive;
+        }
+    }
+
+    queues[ComputeQueueIdx].FrontEndTime = gpu.ComputeQueueLatency;
+
+    Array<double, FrameAllocator> slotEndTimes(gpu.NumShaderSlots, 0.0);
+    Array<uint64, FrameAllocator> slotWorkloads(gpu.NumShaderSlots, InvalidIdx);
+    uint64 numFreeSlots = gpu.NumShaderSlots;
+    uint64 nextFreeSlot = 0;
+    uint64 numCompleted = 0;
+    uint64 lastLaunchQueue = ComputeQueueIdx;
+    double currTime = 0.0;
+
+    while(numCompleted < numActive)
+    {
+        // Let the front-end of each queue issue as many commands as it can. A signal on one queue can
+        // unblock a wait on the other, so keep going until neither of them can make progress.
+        bool progress = true;
+        while(progress)
+        {
+            progress = false;
+            for(uint64 queueIdx = 0; queueIdx < NumQueues; ++queueIdx)
+                progress = IssueCommands(schedule, gpu, currTime, queueIdx, queues, states) || progress;
+        }
+
+        // Fill up the free shader slots. Groups from a single queue launch in submission order, and the two
+        // queues either take turns or the COMPUTE queue always wins when it's marked as high-priority.
+        while(numFreeSlots > 0)
+        {
+            bool canLaunch[NumQueues] = { };
+            for(uint64 queueIdx = 0; queueIdx < NumQueues; ++queueIdx)
+            {
+                SimQueueState& queue = queues[queueIdx];
+                while(queue.LaunchIdx < queue.NumIssued && states[queue.Order[queue.LaunchIdx]].GroupsToLaunch == 0)
+                    ++queue.LaunchIdx;
+
+                canLaunch[queueIdx] = queue.LaunchIdx < queue.NumIssued &&
+                                      states[queue.Order[queue.LaunchIdx]].ReadyTime <= currTime;
+            }
+
+            uint64 launchQueue = InvalidIdx;
+            if(canLaunch[GfxQueueIdx] && canLaunch[ComputeQueueIdx])
+            {
+                if(settings.UseHiPriorityComputeQueue)
+                    launchQueue = ComputeQueueIdx;
+                else
+                    launchQueue = (lastLaunchQueue + 1) % NumQueues;
+            }
+            else if(canLaunch[GfxQueueIdx])
+                launchQueue = GfxQueueIdx;
+            else if(canLaunch[ComputeQueueIdx])
+                launchQueue = ComputeQueueIdx;
+
+            if(launchQueue == InvalidIdx)
+                break;
+
+            const uint64 workloadIdx = queues[launchQueue].Order[queues[launchQueue].LaunchIdx];
+            SimWorkloadState& state = states[workloadIdx];
+            if(state.Started == false)
+            {
+                state.StartTime = currTime;
+                state.Started = true;
+            }
+
+            while(slotWorkloads[nextFreeSlot] != InvalidIdx)
+                nextFreeSlot = (nextFreeSlot + 1) % gpu.NumShaderSlots;
+
+            slotWorkloads[nextFreeSlot] = workloadIdx;
+            slotEndTimes[nextFreeSlot] = currTime + state.GroupDuration;
+            --numFreeSlots;
+            --state.GroupsToLaunch;
+            lastLaunchQueue = launchQueue;
+        }
+
+        // Advance to the next point where something can change: either a thread group finishes,
+        // or the front-end finishes issuing a command
+        double nextTime = NoEvent;
+        for(uint64 slotIdx = 0; slotIdx < gpu.NumShaderSlots; ++slotIdx)
+            if(slotWorkloads[slotIdx] != InvalidIdx)
+                nextTime = Min(nextTime, slotEndTimes[slotIdx]);
+
+        for(uint64 queueIdx = 0; queueIdx < NumQueues; ++queueIdx)
+        {
+            const SimQueueState& queue = queues[queueIdx];
+            if(queue.LaunchIdx < queue.NumIssued && states[queue.Order[queue.LaunchIdx]].ReadyTime > currTime)
+                nextTime = Min(nextTime, states[queue.Order[queue.LaunchIdx]].ReadyTime);
+        }
+
+        Assert_(nextTime < NoEvent);
+        if(nextTime >= NoEvent)
+            break;
+
+        currTime = nextTime;
+
+        for(uint64 slotIdx = 0; slotIdx < gpu.NumShaderSlots; ++slotIdx)
+        {
+            const uint64 workloadIdx = slotWorkloads[slotIdx];
+            if(workloadIdx == InvalidIdx || slotEndTimes[slotIdx] > currTime)
+                continue;
+
+            SimWorkloadState& state = states[workloadIdx];
+            Assert_(state.GroupsRemaining > 0);
+            --state.GroupsRemaining;
+            if(state.GroupsRemaining == 0)
+            {
+                state.EndTime = slotEndTimes[slotIdx];
+                state.Done = true;
+                ++numCompleted;
+            }
+
+            slotWorkloads[slotIdx] = InvalidIdx;
+            ++numFreeSlots;
+        }
+    }
+
+    // Convert from microseconds to milliseconds, to match the timings measured by the app
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        if(states[i].Done == false)
+            continue;
+
+        timings[i].StartTime = float(states[i].StartTime / 1000.0);
+        timings[i].EndTime = float(states[i].EndTime / 1000.0);
+    }
+}
+
+void SimulateWorkloads(const SimJob& job)
+{
+    SimulateWorkloads(job.Workloads, job.NumWorkloads, job.Settings, job.GPU, job.Timings);
+}
+
+void SimulateWorkloads(const SimJob* jobs, uint64 numJobs, uint32 numThreads)
+{
+    if(numThreads == 0)
+        numThreads = Max(std::thread::hardware_concurrency(), 1u);
+    numThreads = uint32(Min<uint64>(numThreads, numJobs));
+
+    if(numThreads <= 1)
+    {
+        for(uint64 i = 0; i < numJobs; ++i)
+            SimulateWorkloads(jobs[i]);
+        return;
+    }
+
+    // Each thread grabs the next job in the list until they're all done
+    std::atomic<uint64> nextJob(0);
+    auto threadFunc = [&]()
+    {
+        while(true)
+        {
+            const uint64 jobIdx = nextJob.fetch_add(1);
+            if(jobIdx >= numJobs)
+                break;
+            SimulateWorkloads(jobs[jobIdx]);
+        }
+    };
+
+    Array<std::thread> threads(numThreads - 1);
+    for(uint64 i = 0; i < threads.Size(); ++i)
+        threads[i] = std::thread(threadFunc);
+
+    threadFunc();
+
+    for(uint64 i = 0; i < threads.Size(); ++i)
+        threads[i].join();
+}
+
+SimTimingError CompareTimings(const SimWorkload* workloads, const SimTiming* simulated,
+                              const SimTiming* measured, uint64 numWorkloads)
+{
+    SimTimingError error;
+    uint64 numSamples = 0;
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        if(workloads[i].Node.Enabled == false)
+            continue;
+
+        const float startError = std::abs(simulated[i].StartTime - measured[i].StartTime);
+        const float endError = std::abs(simulated[i].EndTime - measured[i].EndTime);
+        error.MaxError = Max(error.MaxError, Max(startError, endError));
+        error.MeanError += startError + endError;
+        numSamples += 2;
+    }
+
+    if(numSamples > 0)
+        error.MeanError /= float(numSamples);
+
+    return error;
+}
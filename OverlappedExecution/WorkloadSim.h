@@ -0,0 +1,85 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include <Containers.h>
+
+#include "WorkloadGraph.h"
+
+// CPU-only simulation of the workload timeline. This walks the same WorkloadSchedule that Render() and
+// RenderCompute() use for submitting workloads, barriers and fences, but replaces the D3D12 device with a simple model of a GPU that has
+// a DIRECT and a COMPUTE queue feeding a shared pool of shader slots. It doesn't touch D3D12 at all,
+// so it can be used to sweep through workload configurations without a GPU.
+
+// The parts of a workload that affect its execution, as exposed in the workload UI
+struct SimWorkload
+{
+    WorkloadNode Node;
+    int32 NumGroups = 8;
+    int32 NumIterations = 64;
+};
+
+// Parameters for the modelled GPU, all times are in microseconds
+struct SimGPUDesc
+{
+    uint32 NumShaderSlots = 64;         // Number of thread groups that can be resident at once
+    uint32 ThreadGroupSize = 64;        // Threads per group, matches [numthreads] in Workload.hlsl
+    float IterationTime = 0.75f;        // Time for a thread group to complete a single workload iteration
+    float DispatchLatency = 1.0f;       // Front-end cost of issuing a dispatch
+    float DrawLatency = 2.0f;           // Front-end + rasterizer setup cost of issuing a draw
+    float BarrierLatency = 4.0f;        // Cache flush/invalidate cost paid once a barrier's wait completes
+    float ComputeQueueLatency = 5.0f;   // Delay before the COMPUTE queue starts processing commands
+    float FenceLatency = 10.0f;         // Submission + scheduling cost paid by a queue after a fence wait completes
+};
+
+struct SimSettings
+{
+    bool UseSplitBarriers = false;
+    bool UseHiPriorityComputeQueue = false;
+};
+
+// Simulated start and end times, in milliseconds from the point where the queues start executing
+struct SimTiming
+{
+    float StartTime = 0.0f;
+    float EndTime = 0.0f;
+};
+
+struct SimJob
+{
+    const SimWorkload* Workloads = nullptr;
+    uint64 NumWorkloads = 0;
+    SimSettings Settings;
+    SimGPUDesc GPU;
+    SimTiming* Timings = nullptr;       // Output, needs NumWorkloads elements
+};
+
+struct SimTimingError
+{
+    float MaxError = 0.0f;
+    float MeanError = 0.0f;
+};
+
+// Simulates a single frame's worth of workloads, which need to form a valid graph (see ValidateWorkloadGraph).
+// Disabled workloads get zeroed timings.
+void SimulateWorkloads(const SimWorkload* workloads, uint64 numWorkloads, const SimSettings& settings,
+                       const SimGPUDesc& gpu, SimTiming* timings);
+void SimulateWorkloads(const SimJob& job);
+
+// Runs a batch of simulations spread across multiple threads. Passing 0 for numThreads will use one
+// thread per hardware thread.
+void SimulateWorkloads(const SimJob* jobs, uint64 numJobs, uint32 numThreads = 0);
+
+// Compares simulated timings against measured timings (from the app or a captured trace)
+SimTimingError CompareTimings(const SimWorkload* workloads, const SimTiming* simulated,
+                              const SimTiming* measured, uint64 numWorkloads);
@@ -0,0 +1,421 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <algorithm>
+
+#include <Utility.h>
+#include <SF12_Math.h>
+
+#include "WorkloadSweep.h"
+
+using namespace SampleFramework12;
+
+static const char* DependencyPatternNames[] =
+{
+    "none",
+    "queue-chain",
+    "serial",
+    "fan-out",
+};
+
+StaticAssert_(ArraySize_(DependencyPatternNames) == uint64(SweepDependencyPattern::NumValues));
+
+const char* SweepDependencyPatternName(SweepDependencyPattern pattern)
+{
+    Assert_(uint64(pattern) < uint64(SweepDependencyPattern::NumValues));
+    return DependencyPatternNames[uint64(pattern)];
+}
+
+// == SweepSamples ================================================================================
+
+void SweepSamples::Reset(uint64 newNumWorkloads)
+{
+    numWorkloads = newNumWorkloads;
+    numFrames = 0;
+    timings.clear();
+}
+
+void SweepSamples::AddFrame(const SimTiming* frameTimings)
+{
+    timings.insert(timings.end(), frameTimings, frameTimings + numWorkloads);
+    ++numFrames;
+}
+
+// Nearest-rank percentile of a sorted list
+static float Percentile(const std::vector<float>& sorted, double p)
+{
+    if(sorted.size() == 0)
+        return 0.0f;
+
+    const uint64 rank = uint64(std::ceil(p * sorted.size()));
+    return sorted[Clamp<uint64>(rank, 1, sorted.size()) - 1];
+}
+
+void SweepSamples::Summarize(const SweepConfig& config, SweepResult& result) const
+{
+    result.Config = config;
+    result.NumFrames = numFrames;
+    result.Workloads.clear();
+    result.Workloads.resize(numWorkloads);
+
+    std::vector<float> durations(numFrames);
+    std::vector<float> frameTimes(numFrames, 0.0f);
+    for(uint64 workloadIdx = 0; workloadIdx < numWorkloads; ++workloadIdx)
+    {
+        SweepWorkloadResult& workloadResult = result.Workloads[workloadIdx];
+        double startSum = 0.0;
+        double endSum = 0.0;
+        double durationSum = 0.0;
+        for(uint64 frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+        {
+            const SimTiming& timing = timings[frameIdx * numWorkloads + workloadIdx];
+            durations[frameIdx] = timing.EndTime - timing.StartTime;
+            frameTimes[frameIdx] = Max(frameTimes[frameIdx], timing.EndTime);
+
+            startSum += timing.StartTime;
+            endSum += timing.EndTime;
+            durationSum += durations[frameIdx];
+        }
+
+        if(numFrames == 0)
+            continue;
+
+        std::sort(durations.begin(), durations.end());
+        workloadResult.StartMean = float(startSum / numFrames);
+        workloadResult.EndMean = float(endSum / numFrames);
+        workloadResult.DurationMean = float(durationSum / numFrames);
+        workloadResult.DurationP50 = Percentile(durations, 0.5);
+        workloadResult.DurationP99 = Percentile(durations, 0.99);
+        workloadResult.DurationMax = durations.back();
+    }
+
+    result.FrameMean = 0.0f;
+    for(uint64 frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+        result.FrameMean += frameTimes[frameIdx];
+    if(numFrames > 0)
+        result.FrameMean /= float(numFrames);
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    result.FrameP99 = Percentile(frameTimes, 0.99);
+}
+
+// == Spec parsing ================================================================================
+
+static std::string TrimString(const std::string& str)
+{
+    const char* whiteSpace = " \t\r\n";
+    const std::string::size_type start = str.find_first_not_of(whiteSpace);
+    if(start == std::string::npos)
+        return std::string();
+    const std::string::size_type end = str.find_last_not_of(whiteSpace);
+    return str.substr(start, end - start + 1);
+}
+
+static bool ParseInt(const std::string& str, int64 minValue, int64& value)
+{
+    char* end = nullptr;
+    value = strtoll(str.c_str(), &end, 10);
+    return end != str.c_str() && *end == 0 && value >= minValue;
+}
+
+static bool ParseBool(const std::string& str, bool& value)
+{
+    if(str == "1" || str == "true" || str == "on")
+        value = true;
+    else if(str == "0" || str == "false" || str == "off")
+        value = false;
+    else
+        return false;
+    return true;
+}
+
+bool ParseSweepSpec(const std::string& text, SweepSpec& spec, std::string& errorString)
+{
+    spec = SweepSpec();
+    errorString.clear();
+
+    std::vector<std::string> lines;
+    Split(text, lines, "\n");
+
+    for(uint64 lineIdx = 0; lineIdx < lines.size(); ++lineIdx)
+    {
+        std::string line = lines[lineIdx];
+        const std::string::size_type commentPos = line.find('#');
+        if(commentPos != std::string::npos)
+            line.erase(commentPos);
+        line = TrimString(line);
+        if(line.length() == 0)
+            continue;
+
+        const std::string::size_type equalsPos = line.find('=');
+        if(equalsPos == std::string::npos)
+        {
+            errorString = MakeString("Line %llu: expected \"key = value\"", lineIdx + 1);
+            return false;
+        }
+
+        const std::string key = TrimString(line.substr(0, equalsPos));
+        std::vector<std::string> values;
+        Split(line.substr(equalsPos + 1), values, ", \t\r");
+        if(values.size() == 0)
+        {
+            errorString = MakeString("Line %llu: no values given for \"%s\"", lineIdx + 1, key.c_str());
+            return false;
+        }
+
+        for(const std::string& value : values)
+        {
+            int64 intValue = 0;
+            bool boolValue = false;
+            bool valid = true;
+            if(key == "groups" || key == "iterations")
+            {
+                valid = ParseInt(value, 1, intValue) && intValue <= INT32_MAX;
+                if(valid)
+                    (key == "groups" ? spec.NumGroups : spec.NumIterations).push_back(int32(intValue));
+            }
+            else if(key == "warm_frames" || key == "measured_frames")
+            {
+                valid = values.size() == 1 && ParseInt(value, key == "warm_frames" ? 0 : 1, intValue);
+                if(valid)
+                    (key == "warm_frames" ? spec.NumWarmFrames : spec.NumMeasuredFrames) = uint64(intValue);
+            }
+            else if(key == "split_barriers" || key == "hi_priority_compute")
+            {
+                valid = ParseBool(value, boolValue);
+                if(valid)
+                    (key == "split_barriers" ? spec.SplitBarriers : spec.HiPriorityCompute).push_back(boolValue);
+            }
+            else if(key == "dependencies")
+            {
+                valid = false;
+                for(uint64 i = 0; i < uint64(SweepDependencyPattern::NumValues); ++i)
+                {
+                    if(value == DependencyPatternNames[i])
+                    {
+                        spec.DependencyPatterns.push_back(SweepDependencyPattern(i));
+                        valid = true;
+                    }
+                }
+            }
+            else
+            {
+                errorString = MakeString("Line %llu: unknown parameter \"%s\"", lineIdx + 1, key.c_str());
+                return false;
+            }
+
+            if(valid == false)
+            {
+                errorString = MakeString("Line %llu: invalid value \"%s\" for \"%s\"", lineIdx + 1, value.c_str(), key.c_str());
+                return false;
+            }
+        }
+    }
+
+    // Anything that isn't swept uses the same defaults as the app
+    const SweepConfig defaults;
+    if(spec.NumGroups.size() == 0)
+        spec.NumGroups.push_back(defaults.NumGroups);
+    if(spec.NumIterations.size() == 0)
+        spec.NumIterations.push_back(defaults.NumIterations);
+    if(spec.DependencyPatterns.size() == 0)
+        spec.DependencyPatterns.push_back(defaults.DependencyPattern);
+    if(spec.SplitBarriers.size() == 0)
+        spec.SplitBarriers.push_back(defaults.SplitBarriers);
+    if(spec.HiPriorityCompute.size() == 0)
+        spec.HiPriorityCompute.push_back(defaults.HiPriorityCompute);
+
+    return true;
+}
+
+// == Configurations ==============================================================================
+
+void BuildSweepConfigs(const SweepSpec& spec, std::vector<SweepConfig>& configs)
+{
+    configs.clear();
+    configs.reserve(spec.HiPriorityCompute.size() * spec.SplitBarriers.size() * spec.DependencyPatterns.size() *
+                    spec.NumGroups.size() * spec.NumIterations.size());
+
+    // Nothing in a configuration requires new PSOs or buffers. Switching to a different compute queue
+    // is the only change that needs the GPU to be flushed (so that frames from the old queue don't
+    // overlap with measurements on the new one), so that goes in the outermost loop.
+    for(bool hiPriority : spec.HiPriorityCompute)
+    {
+        for(bool splitBarriers : spec.SplitBarriers)
+        {
+            for(SweepDependencyPattern pattern : spec.DependencyPatterns)
+            {
+                for(int32 numGroups : spec.NumGroups)
+                {
+                    for(int32 numIterations : spec.NumIterations)
+                    {
+                        SweepConfig config;
+                        config.NumGroups = numGroups;
+                        config.NumIterations = numIterations;
+                        config.DependencyPattern = pattern;
+                        config.SplitBarriers = splitBarriers;
+                        config.HiPriorityCompute = hiPriority;
+                        configs.push_back(config);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BuildSweepGraph(SweepDependencyPattern pattern, const WorkloadType* types, uint64 numWorkloads, WorkloadNode* nodes)
+{
+    uint64 firstOnQueue[NumWorkloadQueues] = { };
+    uint64 lastOnQueue[NumWorkloadQueues] = { };
+    bool queueUsed[NumWorkloadQueues] = { };
+
+    for(uint64 i = 0; i < numWorkloads; ++i)
+    {
+        WorkloadNode& node = nodes[i];
+        node = WorkloadNode();
+        node.Type = types[i];
+
+        const uint64 queueIdx = uint64(QueueForWorkload(node.Type));
+        if(pattern == SweepDependencyPattern::QueueChain && queueUsed[queueIdx])
+            node.AddDependency(lastOnQueue[queueIdx]);
+        else if(pattern == SweepDependencyPattern::Serial && i > 0)
+            node.AddDependency(i - 1);
+        else if(pattern == SweepDependencyPattern::FanOut && queueUsed[queueIdx])
+            node.AddDependency(firstOnQueue[queueIdx]);
+
+        if(queueUsed[queueIdx] == false)
+            firstOnQueue[queueIdx] = i;
+        lastOnQueue[queueIdx] = i;
+        queueUsed[queueIdx] = true;
+    }
+}
+
+void RunSimulatedSweep(const SweepSpec& spec, const WorkloadType* types, uint64 numWorkloads,
+                       const SimGPUDesc& gpu, std::vector<SweepResult>& results)
+{
+    std::vector<SweepConfig> configs;
+    BuildSweepConfigs(spec, configs);
+
+    const uint64 numConfigs = configs.size();
+    std::vector<SimWorkload> workloads(numConfigs * numWorkloads);
+    std::vector<SimTiming> timings(numConfigs * numWorkloads);
+    std::vector<SimJob> jobs(numConfigs);
+    std::vector<WorkloadNode> nodes(numWorkloads);
+
+    for(uint64 configIdx = 0; configIdx < numConfigs; ++configIdx)
+    {
+        const SweepConfig& config = configs[configIdx];
+        BuildSweepGraph(config.DependencyPattern, types, numWorkloads, nodes.data());
+
+        SimWorkload* configWorkloads = &workloads[configIdx * numWorkloads];
+        for(uint64 i = 0; i < numWorkloads; ++i)
+        {
+            configWorkloads[i].Node = nodes[i];
+            configWorkloads[i].NumGroups = config.NumGroups;
+            configWorkloads[i].NumIterations = config.NumIterations;
+        }
+
+        SimJob& job = jobs[configIdx];
+        job.Workloads = configWorkloads;
+        job.NumWorkloads = numWorkloads;
+        job.Settings.UseSplitBarriers = config.SplitBarriers;
+        job.Settings.UseHiPriorityComputeQueue = config.HiPriorityCompute;
+        job.GPU = gpu;
+        job.Timings = &timings[configIdx * numWorkloads];
+    }
+
+    SimulateWorkloads(jobs.data(), numConfigs);
+
+    results.clear();
+    results.resize(numConfigs);
+
+    SweepSamples samples;
+    for(uint64 configIdx = 0; configIdx < numConfigs; ++configIdx)
+    {
+        samples.Reset(numWorkloads);
+        samples.AddFrame(jobs[configIdx].Timings);
+        samples.Summarize(configs[configIdx], results[configIdx]);
+    }
+}
+
+// == Reports =====================================================================================
+
+static std::string EscapeJSON(const char* str)
+{
+    std::string escaped;
+    for(const char* c = str; *c != 0; ++c)
+    {
+        if(*c == '"' || *c == '\\')
+            escaped += '\\';
+        escaped += *c;
+    }
+    return escaped;
+}
+
+std::string SweepReportCSV(const std::vector<SweepResult>& results, const char* const* workloadNames)
+{
+    std::string csv = "config,groups,iterations,dependencies,split_barriers,hi_priority_compute,frames,"
+                      "frame_mean_ms,frame_p99_ms,workload,start_mean_ms,end_mean_ms,duration_mean_ms,"
+                      "duration_p50_ms,duration_p99_ms,duration_max_ms\n";
+
+    for(uint64 resultIdx = 0; resultIdx < results.size(); ++resultIdx)
+    {
+        const SweepResult& result = results[resultIdx];
+        const SweepConfig& config = result.Config;
+        for(uint64 workloadIdx = 0; workloadIdx < result.Workloads.size(); ++workloadIdx)
+        {
+            const SweepWorkloadResult& workload = result.Workloads[workloadIdx];
+            csv += MakeString("%llu,%d,%d,%s,%d,%d,%llu,%.4f,%.4f,\"%s\",%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                              resultIdx, config.NumGroups, config.NumIterations,
+                              SweepDependencyPatternName(config.DependencyPattern), config.SplitBarriers ? 1 : 0,
+                              config.HiPriorityCompute ? 1 : 0, result.NumFrames, result.FrameMean, result.FrameP99,
+                              workloadNames[workloadIdx], workload.StartMean, workload.EndMean, workload.DurationMean,
+                              workload.DurationP50, workload.DurationP99, workload.DurationMax);
+        }
+    }
+
+    return csv;
+}
+
+std::string SweepReportJSON(const std::vector<SweepResult>& results, const char* const* workloadNames)
+{
+    std::string json = "{\n  \"configs\": [\n";
+
+    for(uint64 resultIdx = 0; resultIdx < results.size(); ++resultIdx)
+    {
+        const SweepResult& result = results[resultIdx];
+        const SweepConfig& config = result.Config;
+        json += MakeString("    {\n      \"groups\": %d, \"iterations\": %d, \"dependencies\": \"%s\", "
+                           "\"split_barriers\": %s, \"hi_priority_compute\": %s,\n"
+                           "      \"frames\": %llu, \"frame_mean_ms\": %.4f, \"frame_p99_ms\": %.4f,\n"
+                           "      \"workloads\": [\n",
+                           config.NumGroups, config.NumIterations, SweepDependencyPatternName(config.DependencyPattern),
+                           config.SplitBarriers ? "true" : "false", config.HiPriorityCompute ? "true" : "false",
+                           result.NumFrames, result.FrameMean, result.FrameP99);
+
+        for(uint64 workloadIdx = 0; workloadIdx < result.Workloads.size(); ++workloadIdx)
+        {
+            const SweepWorkloadResult& workload = result.Workloads[workloadIdx];
+            json += MakeString("        { \"name\": \"%s\", \"start_mean_ms\": %.4f, \"end_mean_ms\": %.4f, "
+                               "\"duration_mean_ms\": %.4f, \"duration_p50_ms\": %.4f, \"duration_p99_ms\": %.4f, "
+                               "\"duration_max_ms\": %.4f }%s\n",
+                               EscapeJSON(workloadNames[workloadIdx]).c_str(), workload.StartMean, workload.EndMean,
+                               workload.DurationMean, workload.DurationP50, workload.DurationP99, workload.DurationMax,
+                               workloadIdx + 1 < result.Workloads.size() ? "," : "");
+        }
+
+        json += MakeString("      ]\n    }%s\n", resultIdx + 1 < results.size() ? "," : "");
+    }
+
+    json += "  ]\n}\n";
+    return json;
+}
@@ -0,0 +1,120 @@
+//=================================================================================================
+//
+//  Overlapped Execution Sample
+//  by MJP
+//  http://mynameismjp.wordpress.com/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+#include "WorkloadGraph.h"
+#include "WorkloadSim.h"
+
+// Batch benchmarking of workload configurations. A sweep spec lists the values to try for each
+// parameter, and every combination of them becomes a configuration that gets run for a number of
+// warm-up frames followed by a number of measured frames. The app runs sweeps on the GPU, or the
+// whole sweep can be run through the CPU simulation. None of the code in here touches D3D12 or the
+// file system, so that the same code drives both.
+//
+// Sweep specs are text files with one "key = value, value, ..." line per parameter, and '#' comments:
+//
+//   groups = 8, 32, 128
+//   iterations = 16, 64
+//   dependencies = none, queue-chain, serial, fan-out
+//   split_barriers = 0, 1
+//   hi_priority_compute = 0, 1
+//   warm_frames = 16
+//   measured_frames = 64
+
+enum class SweepDependencyPattern : uint64
+{
+    None,           // No dependencies at all
+    QueueChain,     // Each workload depends on the previous one on the same queue (the app's default graph)
+    Serial,         // Each workload depends on the previous one, including across queues
+    FanOut,         // Every workload depends on the first workload on its queue
+
+    NumValues
+};
+
+struct SweepSpec
+{
+    std::vector<int32> NumGroups;
+    std::vector<int32> NumIterations;
+    std::vector<SweepDependencyPattern> DependencyPatterns;
+    std::vector<bool> SplitBarriers;
+    std::vector<bool> HiPriorityCompute;
+    uint64 NumWarmFrames = 16;
+    uint64 NumMeasuredFrames = 64;
+};
+
+struct SweepConfig
+{
+    int32 NumGroups = 8;
+    int32 NumIterations = 64;
+    SweepDependencyPattern DependencyPattern = SweepDependencyPattern::QueueChain;
+    bool SplitBarriers = false;
+    bool HiPriorityCompute = false;
+};
+
+struct SweepWorkloadResult
+{
+    float StartMean = 0.0f;
+    float EndMean = 0.0f;
+    float DurationMean = 0.0f;
+    float DurationP50 = 0.0f;
+    float DurationP99 = 0.0f;
+    float DurationMax = 0.0f;
+};
+
+struct SweepResult
+{
+    SweepConfig Config;
+    uint64 NumFrames = 0;
+    float FrameMean = 0.0f;         // Time from the start of the frame until the last workload finishes
+    float FrameP99 = 0.0f;
+    std::vector<SweepWorkloadResult> Workloads;
+};
+
+// Collects the timings of every measured frame for a single configuration
+class SweepSamples
+{
+
+public:
+
+    void Reset(uint64 numWorkloads);
+    void AddFrame(const SimTiming* timings);
+    void Summarize(const SweepConfig& config, SweepResult& result) const;
+
+    uint64 NumFrames() const { return numFrames; }
+
+protected:
+
+    uint64 numWorkloads = 0;
+    uint64 numFrames = 0;
+    std::vector<SimTiming> timings;     // numFrames * numWorkloads
+};
+
+const char* SweepDependencyPatternName(SweepDependencyPattern pattern);
+
+// Parses the text of a sweep spec. Parameters that aren't listed get the app's defaults.
+bool ParseSweepSpec(const std::string& text, SweepSpec& spec, std::string& errorString);
+
+// Expands a spec into the list of configurations to run, ordered so that switching between
+// consecutive configurations is as cheap as possible on the GPU
+void BuildSweepConfigs(const SweepSpec& spec, std::vector<SweepConfig>& configs);
+
+// Sets up the dependencies for a sweep configuration, given the type of each workload
+void BuildSweepGraph(SweepDependencyPattern pattern, const WorkloadType* types, uint64 numWorkloads, WorkloadNode* nodes);
+
+// Runs every configuration through the CPU simulation. The simulation is deterministic, so each
+// configuration is only simulated once instead of running warm and measured frames.
+void RunSimulatedSweep(const SweepSpec& spec, const WorkloadType* types, uint64 numWorkloads,
+                       const SimGPUDesc& gpu, std::vector<SweepResult>& results);
+
+std::string SweepReportCSV(const std::vector<SweepResult>& results, const char* const* workloadNames);
+std::string SweepReportJSON(const std::vector<SweepResult>& results, const char* const* workloadNames);
@@ -0,0 +1,182 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Allocators.h"
+
+namespace SampleFramework12
+{
+
+// Blocks are allocated with their header in front of the memory that gets handed out
+struct LinearAllocator::Block
+{
+    Block* Next = nullptr;
+    uint64 Size = 0;
+    uint64 Used = 0;
+};
+
+LinearAllocator::LinearAllocator()
+{
+}
+
+LinearAllocator::LinearAllocator(uint64 blockSize_)
+{
+    Init(blockSize_);
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    Shutdown();
+}
+
+void LinearAllocator::Init(uint64 blockSize_)
+{
+    Assert_(blockSize_ > 0);
+    Shutdown();
+    blockSize = blockSize_;
+}
+
+void LinearAllocator::Shutdown()
+{
+    Block* block = firstBlock;
+    while(block != nullptr)
+    {
+        Block* next = block->Next;
+        block->~Block();
+        ::operator delete(block);
+        block = next;
+    }
+
+    firstBlock = nullptr;
+    currBlock = nullptr;
+    numBlocks = 0;
+}
+
+LinearAllocator::Block* LinearAllocator::AddBlock(Block* prev, uint64 minSize)
+{
+    const uint64 size = minSize > blockSize ? minSize : blockSize;
+    Block* block = new (::operator new(sizeof(Block) + size)) Block;
+    block->Size = size;
+    if(prev != nullptr)
+    {
+        block->Next = prev->Next;
+        prev->Next = block;
+    }
+    ++numBlocks;
+    return block;
+}
+
+void* LinearAllocator::Allocate(uint64 size, uint64 alignment)
+{
+    Assert_(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    // Asking for alignment extra bytes guarantees that the allocation fits in a fresh block
+    if(currBlock == nullptr)
+    {
+        firstBlock = AddBlock(nullptr, size + alignment);
+        currBlock = firstBlock;
+    }
+
+    while(true)
+    {
+        uint8* blockData = reinterpret_cast<uint8*>(currBlock + 1);
+        const uint64 address = reinterpret_cast<uint64>(blockData) + currBlock->Used;
+        const uint64 start = currBlock->Used + (((address + alignment - 1) & ~(alignment - 1)) - address);
+        if(start + size <= currBlock->Size)
+        {
+            currBlock->Used = start + size;
+            return blockData + start;
+        }
+
+        // Move on to the next block in the chain, or add a new one if that one's too small as well
+        Block* next = currBlock->Next;
+        if(next == nullptr || next->Size < size + alignment)
+            next = AddBlock(currBlock, size + alignment);
+        currBlock = next;
+        currBlock->Used = 0;
+    }
+}
+
+LinearAllocator::Mark LinearAllocator::GetMark() const
+{
+    Mark mark;
+    mark.Block = currBlock;
+    mark.Used = currBlock != nullptr ? currBlock->Used : 0;
+    return mark;
+}
+
+void LinearAllocator::Rewind(const Mark& mark)
+{
+    if(mark.Block == nullptr)
+    {
+        // Nothing had been allocated when the mark was taken
+        currBlock = firstBlock;
+        if(currBlock != nullptr)
+            currBlock->Used = 0;
+        return;
+    }
+
+    currBlock = reinterpret_cast<Block*>(mark.Block);
+    Assert_(mark.Used <= currBlock->Used);
+    currBlock->Used = mark.Used;
+}
+
+void LinearAllocator::Reset()
+{
+    if(numBlocks > 1)
+    {
+        // Replace the chain with one block that can hold all of it
+        uint64 totalSize = 0;
+        for(Block* block = firstBlock; block != nullptr; block = block->Next)
+            totalSize += block->Size;
+
+        Shutdown();
+        firstBlock = AddBlock(nullptr, totalSize);
+    }
+
+    currBlock = firstBlock;
+    if(currBlock != nullptr)
+        currBlock->Used = 0;
+}
+
+// == FrameAllocator ==============================================================================
+
+static thread_local LinearAllocator ThreadFrameAllocator;
+static thread_local uint64 NumOpenScopes = 0;
+
+void* FrameAllocator::Allocate(uint64 size, uint64 alignment)
+{
+    return ThreadFrameAllocator.Allocate(size, alignment);
+}
+
+LinearAllocator& FrameAllocator::ThreadAllocator()
+{
+    return ThreadFrameAllocator;
+}
+
+void FrameAllocator::Reset()
+{
+    Assert_(NumOpenScopes == 0);
+    ThreadFrameAllocator.Reset();
+}
+
+FrameAllocatorScope::FrameAllocatorScope() : mark(ThreadFrameAllocator.GetMark())
+{
+    ++NumOpenScopes;
+}
+
+FrameAllocatorScope::~FrameAllocatorScope()
+{
+    Assert_(NumOpenScopes > 0);
+    --NumOpenScopes;
+    ThreadFrameAllocator.Rewind(mark);
+}
+
+}
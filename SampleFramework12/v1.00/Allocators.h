@@ -0,0 +1,161 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+#include "Assert.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+// Linear (bump pointer) allocator. Memory is handed out from a chain of blocks, and the only way to
+// free it is to rewind to an earlier mark or reset the whole thing. When an allocation doesn't fit
+// in the current block another block gets added to the chain. On Reset the chain is collapsed into
+// a single block that's big enough to hold everything that was allocated since the last reset, so
+// that a workload that repeats every frame stops hitting the heap after the first frame or two.
+class LinearAllocator
+{
+
+public:
+
+    struct Mark
+    {
+        void* Block = nullptr;
+        uint64 Used = 0;
+    };
+
+    static const uint64 DefaultBlockSize = 64 * 1024;
+
+    LinearAllocator();
+    explicit LinearAllocator(uint64 blockSize);
+    ~LinearAllocator();
+
+    void Init(uint64 blockSize);
+    void Shutdown();
+
+    void* Allocate(uint64 size, uint64 alignment);
+
+    Mark GetMark() const;
+    void Rewind(const Mark& mark);
+    void Reset();
+
+    uint64 BlockSize() const { return blockSize; }
+    uint64 NumBlocks() const { return numBlocks; }
+
+protected:
+
+    struct Block;
+
+    Block* AddBlock(Block* prev, uint64 minSize);
+
+    uint64 blockSize = DefaultBlockSize;
+    uint64 numBlocks = 0;
+    Block* firstBlock = nullptr;
+    Block* currBlock = nullptr;
+
+private:
+
+    LinearAllocator(const LinearAllocator& other);
+    LinearAllocator& operator=(const LinearAllocator& other);
+};
+
+// Allocator policies for Array, FixedList, GrowableList and SmallList (see Containers.h)
+
+// Regular heap allocations, used by default
+struct HeapAllocator
+{
+    static void* Allocate(uint64 size, uint64 alignment)
+    {
+        // operator new returns memory aligned for any fundamental type
+        Assert_(alignment <= 16);
+        return ::operator new(size);
+    }
+
+    static void Free(void* memory)
+    {
+        ::operator delete(memory);
+    }
+};
+
+// Allocates from a linear allocator owned by the calling thread. Free doesn't do anything, the memory
+// is reclaimed when the enclosing FrameAllocatorScope goes away, or for the main thread when
+// DX12::EndFrame resets the allocator. So containers using this must not outlive the current frame on
+// the main thread, and must be inside of a FrameAllocatorScope on any other thread.
+struct FrameAllocator
+{
+    static void* Allocate(uint64 size, uint64 alignment);
+
+    static void Free(void*)
+    {
+    }
+
+    static LinearAllocator& ThreadAllocator();
+
+    // Called once per frame from the main thread, after everything allocated during the frame is dead
+    static void Reset();
+};
+
+// Passes everything through to another allocator policy and counts the calls, so that tests can
+// check that code using it stops allocating once it reaches a steady state
+template<typename BaseAllocator = HeapAllocator> struct CountingAllocator
+{
+    static void* Allocate(uint64 size, uint64 alignment)
+    {
+        ++NumAllocations;
+        NumBytesAllocated += size;
+        return BaseAllocator::Allocate(size, alignment);
+    }
+
+    static void Free(void* memory)
+    {
+        if(memory != nullptr)
+            ++NumFrees;
+        BaseAllocator::Free(memory);
+    }
+
+    static void ResetCounts()
+    {
+        NumAllocations = 0;
+        NumFrees = 0;
+        NumBytesAllocated = 0;
+    }
+
+    static std::atomic<uint64> NumAllocations;
+    static std::atomic<uint64> NumFrees;
+    static std::atomic<uint64> NumBytesAllocated;
+};
+
+template<typename BaseAllocator> std::atomic<uint64> CountingAllocator<BaseAllocator>::NumAllocations;
+template<typename BaseAllocator> std::atomic<uint64> CountingAllocator<BaseAllocator>::NumFrees;
+template<typename BaseAllocator> std::atomic<uint64> CountingAllocator<BaseAllocator>::NumBytesAllocated;
+
+// Rewinds the calling thread's frame allocator when it goes out of scope. Declare it before any
+// containers that use FrameAllocator, so that it outlives them.
+class FrameAllocatorScope
+{
+
+public:
+
+    FrameAllocatorScope();
+    ~FrameAllocatorScope();
+
+protected:
+
+    LinearAllocator::Mark mark;
+
+private:
+
+    FrameAllocatorScope(const FrameAllocatorScope& other);
+    FrameAllocatorScope& operator=(const FrameAllocatorScope& other);
+};
+
+}
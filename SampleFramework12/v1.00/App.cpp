@@ -32,9 +32,20 @@ namespace SampleFramework12
 
 App* GlobalApp = nullptr;
 
+// Reports what was saved by sharing byte code and PSOs between shaders that compiled to the same thing
+static void LogShaderSharingStats()
+{
+    const ShaderCacheStats shaderStats = GetShaderCacheStats();
+    const DX12::PSOCacheStats psoStats = DX12::GetPSOCacheStats();
+    WriteLog("Shader byte code: %llu unique, %llu shared (%llu bytes saved). PSOs: %llu, %llu of %llu requests shared an existing PSO",
+             shaderStats.NumUniqueByteCodes, shaderStats.NumSharedByteCodes, shaderStats.ByteCodeBytesSaved,
+             psoStats.NumPSOs, psoStats.NumSharedRequests, psoStats.NumRequests);
+}
+
 App::App(const wchar* appName, const wchar* cmdLine) : window(nullptr, appName, WS_OVERLAPPEDWINDOW,
                                                                      WS_EX_APPWINDOW, 1280, 720),
-                                                              applicationName(appName)
+                                                              applicationName(appName),
+                                                              commandLine(cmdLine != nullptr ? cmdLine : L"")
 
 {
     GlobalApp = this;
@@ -42,8 +53,6 @@ App::App(const wchar* appName, const wchar* cmdLine) : window(nullptr, appName,
         timeDeltaBuffer[i] = 0.0f;
 
     SampledSpectrum::Init();
-
-    ParseCommandLine(cmdLine);
 }
 
 App::~App()
@@ -55,6 +64,7 @@ int32 App::Run()
 {
     try
     {
+        ParseCommandLine();
 
         Initialize_Internal();
 
@@ -62,6 +72,8 @@ int32 App::Run()
 
         CreatePSOs_Internal();
 
+        LogShaderSharingStats();
+
         while(window.IsAlive())
         {
             if(!window.IsMinimized())
@@ -136,8 +148,19 @@ void App::BeforeFlush()
 {
 }
 
-void App::ParseCommandLine(const wchar* cmdLine)
+void App::AddCommandLineOptions(cxxopts::Options& options)
+{
+}
+
+void App::ReadCommandLineOptions(cxxopts::Options& options)
 {
+}
+
+void App::ParseCommandLine(const wchar* cmdLine, cxxopts::Options& options)
+{
+    options.add_options()
+         ("a,adapter", "GPU adapter index", cxxopts::value<int32>());
+
     if(cmdLine == nullptr)
         return;
 
@@ -157,10 +180,6 @@ void App::ParseCommandLine(const wchar* cmdLine)
     int32 argc = int32(numParts + 1);
     char** argv = partStrings.Data();
 
-    cxxopts::Options options("App", "");
-    options.add_options()
-         ("a,adapter", "GPU adapter index", cxxopts::value<int32>());
-
     try
     {
         options.parse(argc, argv);
@@ -168,13 +187,28 @@ void App::ParseCommandLine(const wchar* cmdLine)
     catch(cxxopts::missing_argument_exception&)
     {
     }
+    catch(cxxopts::OptionException& exception)
+    {
+        throw Exception(MakeString("Invalid command line: %s", exception.what()));
+    }
+}
+
+void App::ParseCommandLine()
+{
+    cxxopts::Options options("App", "");
+    AddCommandLineOptions(options);
+    ParseCommandLine(commandLine.c_str(), options);
 
     if(options.count("adapter"))
         adapterIdx = options["adapter"].as<int32>();
+
+    ReadCommandLineOptions(options);
 }
 
 void App::Initialize_Internal()
 {
+    taskScheduler.Initialize();
+
     DX12::Initialize(minFeatureLevel, adapterIdx);
 
     window.SetClientArea(swapChain.Width(), swapChain.Height());
@@ -206,6 +240,7 @@ void App::Shutdown_Internal()
     DestroyPSOs();
     ImGuiHelper::Shutdown();
     ShutdownShaders();
+    taskScheduler.WaitforAllAndShutdown();
     spriteRenderer.Shutdown();
     font.Shutdown();
     swapChain.Shutdown();
@@ -234,10 +269,11 @@ void App::Update_Internal()
 
 void App::Render_Internal()
 {
-    if(UpdateShaders())
+    if(UpdateShaders(&taskScheduler))
     {
-        DestroyPSOs();
-        CreatePSOs();
+        DestroyPSOs_Internal();
+        CreatePSOs_Internal();
+        LogShaderSharingStats();
     }
 
     AppSettings::UpdateCBuffer();
@@ -282,6 +318,9 @@ void App::CreatePSOs_Internal()
     ImGuiHelper::CreatePSOs(swapChain.Format());
 
     CreatePSOs();
+
+    // Everything has asked for the PSOs it needs, so whatever's left over was for old shaders or formats
+    DX12::PurgePSOCache();
 }
 
 void App::DestroyPSOs_Internal()
@@ -16,6 +16,7 @@
 #include "Timer.h"
 #include "Graphics\\SpriteFont.h"
 #include "Graphics\\SpriteRenderer.h"
+#include "EnkiTS\\TaskScheduler.h"
 
 namespace SampleFramework12
 {
@@ -46,6 +47,11 @@ protected:
 
     virtual void BeforeFlush();
 
+    // Called from Run() before anything gets initialized, so that the app can add its own command
+    // line options and then read them once the command line has been parsed
+    virtual void AddCommandLineOptions(cxxopts::Options& options);
+    virtual void ReadCommandLineOptions(cxxopts::Options& options);
+
     void Exit();
     void ToggleFullScreen(bool fullScreen);
     void CalculateFPS();
@@ -59,12 +65,15 @@ protected:
     SpriteFont font;
     SpriteRenderer spriteRenderer;
 
+    enki::TaskScheduler taskScheduler;
+
     static const uint32 NumTimeDeltaSamples = 64;
     float timeDeltaBuffer[NumTimeDeltaSamples] = { };
     uint32 currentTimeDeltaSample = 0;
     uint32 fps = 0;
 
     std::wstring applicationName;
+    std::wstring commandLine;
     std::string globalHelpText = "MJPs sample framework for DX11";
 
     bool showWindow = true;
@@ -82,7 +91,7 @@ protected:
 
 private:
 
-    void ParseCommandLine(const wchar* cmdLine);
+    void ParseCommandLine();
 
     void Initialize_Internal();
     void Shutdown_Internal();
@@ -107,6 +116,10 @@ public:
     SpriteRenderer& SpriteRenderer() { return spriteRenderer; }
 
     void AddToLog(const char* msg);
+
+    // Parses a command line using the framework's options, plus any options that were added by
+    // the caller. Throws an Exception if the command line is invalid.
+    static void ParseCommandLine(const wchar* cmdLine, cxxopts::Options& options);
 };
 
 extern App* GlobalApp;
@@ -0,0 +1,243 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ChunkedFile.h"
+#include "Utility.h"
+
+#include <exception>
+
+namespace SampleFramework12
+{
+
+static const uint8 ZeroPadding[ChunkedFileAlignment] = { };
+
+static uint64 AlignChunkedFileOffset(uint64 offset)
+{
+    return (offset + ChunkedFileAlignment - 1) & ~(ChunkedFileAlignment - 1);
+}
+
+static std::string FourCCString(uint32 id)
+{
+    const char chars[5] = { char(id), char(id >> 8), char(id >> 16), char(id >> 24), 0 };
+    return std::string(chars);
+}
+
+static Hash CombineBlockHash(Hash hash, const void* block, uint64 blockSize, bool firstBlock)
+{
+    Hash blockHash = GenerateHash(block, int(blockSize));
+    return firstBlock ? blockHash : CombineHashes(hash, blockHash);
+}
+
+// GenerateHash takes an int size, so sections are hashed in fixed-size blocks that are then combined.
+// The writer streams data through a buffer of the same size, so both sides end up with the same hash.
+Hash HashChunkedFileSection(const void* data, uint64 size)
+{
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    Hash hash;
+    for(uint64 offset = 0; offset < size; offset += ChunkedFileHashBlockSize)
+        hash = CombineBlockHash(hash, bytes + offset, Min(size - offset, ChunkedFileHashBlockSize), offset == 0);
+    return hash;
+}
+
+// == ChunkedFileWriter ===========================================================================
+
+ChunkedFileWriter::ChunkedFileWriter(const wchar* path, uint32 contentType, uint32 contentVersion) : filePath(path)
+{
+    file.Open(path, FileOpenMode::Write);
+    buffer.Init(ChunkedFileHashBlockSize);
+    sections.Init(8);
+
+    header.Magic = ChunkedFileMagic;
+    header.FormatVersion = ChunkedFileFormatVersion;
+    header.ContentType = contentType;
+    header.ContentVersion = contentVersion;
+
+    // Leave room for the header, which is filled in once the section table has been written. The
+    // placeholder is zeroed so that readers reject the file if Finish() never gets that far.
+    const ChunkedFileHeader placeholderHeader;
+    file.Write(sizeof(ChunkedFileHeader), &placeholderHeader);
+    fileOffset = sizeof(ChunkedFileHeader);
+}
+
+ChunkedFileWriter::~ChunkedFileWriter()
+{
+    if(finished)
+        return;
+
+    // Finish() can throw, so it's never called from here. Leaving out the call is only expected when
+    // an exception is unwinding through the code that was writing the file.
+    // The placeholder header already makes the file unreadable, but there's no point leaving it around.
+    Assert_(std::uncaught_exceptions() > 0);
+    file.Close();
+    DeleteFile(filePath.c_str());
+}
+
+void ChunkedFileWriter::FlushBlock()
+{
+    Assert_(inSection);
+    if(bufferUsed == 0)
+        return;
+
+    ChunkedFileSection& section = sections[sections.Count() - 1];
+    section.DataHash = CombineBlockHash(section.DataHash, buffer.Data(), bufferUsed, section.Size == 0);
+    section.Size += bufferUsed;
+
+    file.Write(bufferUsed, buffer.Data());
+    fileOffset += bufferUsed;
+    bufferUsed = 0;
+}
+
+void ChunkedFileWriter::WritePadding()
+{
+    const uint64 alignedOffset = AlignChunkedFileOffset(fileOffset);
+    if(alignedOffset > fileOffset)
+        file.Write(alignedOffset - fileOffset, ZeroPadding);
+    fileOffset = alignedOffset;
+}
+
+void ChunkedFileWriter::BeginSection(uint32 id)
+{
+    Assert_(inSection == false);
+    Assert_(finished == false);
+
+    WritePadding();
+
+    ChunkedFileSection section;
+    section.ID = id;
+    section.Offset = fileOffset;
+    sections.Add(section);
+
+    inSection = true;
+}
+
+void ChunkedFileWriter::EndSection()
+{
+    Assert_(inSection);
+    FlushBlock();
+    inSection = false;
+}
+
+void ChunkedFileWriter::SerializeData(uint64 size, const void* data)
+{
+    Assert_(inSection);
+
+    // Everything goes through the buffer, so that the section is hashed in whole blocks
+    const uint8* src = reinterpret_cast<const uint8*>(data);
+    while(size > 0)
+    {
+        const uint64 copySize = Min(size, buffer.Size() - bufferUsed);
+        memcpy(buffer.Data() + bufferUsed, src, copySize);
+        bufferUsed += copySize;
+        src += copySize;
+        size -= copySize;
+
+        if(bufferUsed == buffer.Size())
+            FlushBlock();
+    }
+}
+
+void ChunkedFileWriter::Finish()
+{
+    Assert_(finished == false);
+    if(inSection)
+        EndSection();
+
+    WritePadding();
+
+    header.TableOffset = fileOffset;
+    header.NumSections = sections.Count();
+    header.TableHash = HashChunkedFileSection(sections.Data(), sections.Count() * sizeof(ChunkedFileSection));
+    file.Write(sections.Count() * sizeof(ChunkedFileSection), sections.Data());
+    file.WriteAt(0, sizeof(ChunkedFileHeader), &header);
+    file.Close();
+
+    finished = true;
+}
+
+// == ChunkedFileReader ===========================================================================
+
+ChunkedFileReader::ChunkedFileReader(const wchar* path, uint32 contentType) : filePath(path)
+{
+    file.Open(path);
+    if(file.Size() < sizeof(ChunkedFileHeader))
+        throw Exception(MakeString(L"File '%ls' is too small to be a chunked file", path));
+
+    memcpy(&header, file.Data(), sizeof(ChunkedFileHeader));
+    if(header.Magic != ChunkedFileMagic)
+        throw Exception(MakeString(L"File '%ls' is not a chunked file", path));
+    if(header.FormatVersion != ChunkedFileFormatVersion)
+        throw Exception(MakeString(L"Chunked file '%ls' has format version %u, expected version %u",
+                                   path, header.FormatVersion, ChunkedFileFormatVersion));
+    if(header.ContentType != contentType)
+        throw Exception(MakeString(L"Chunked file '%ls' has the wrong type of content", path));
+
+    const uint64 tableSize = header.NumSections * sizeof(ChunkedFileSection);
+    if(header.TableOffset % ChunkedFileAlignment != 0 || header.TableOffset > file.Size() ||
+       header.NumSections > (file.Size() - header.TableOffset) / sizeof(ChunkedFileSection))
+        throw Exception(MakeString(L"Chunked file '%ls' has a corrupt section table", path));
+
+    sections = reinterpret_cast<const ChunkedFileSection*>(file.Data() + header.TableOffset);
+    Hash tableHash = HashChunkedFileSection(sections, tableSize);
+    if((tableHash == header.TableHash) == false)
+        throw Exception(MakeString(L"Chunked file '%ls' has a corrupt section table", path));
+
+    for(uint64 i = 0; i < header.NumSections; ++i)
+    {
+        const ChunkedFileSection& section = sections[i];
+        if(section.Offset % ChunkedFileAlignment != 0 || section.Offset > header.TableOffset ||
+           section.Size > header.TableOffset - section.Offset)
+            throw Exception(MakeString(L"Chunked file '%ls' has a section that's out of bounds", path));
+    }
+}
+
+bool ChunkedFileReader::IsChunkedFile(const wchar* path)
+{
+    File file(path, FileOpenMode::Read);
+    if(file.Size() < sizeof(uint32))
+        return false;
+
+    uint32 magic = 0;
+    file.Read(magic);
+    return magic == ChunkedFileMagic;
+}
+
+const ChunkedFileSection* ChunkedFileReader::FindSection(uint32 id) const
+{
+    for(uint64 i = 0; i < header.NumSections; ++i)
+        if(sections[i].ID == id)
+            return &sections[i];
+    return nullptr;
+}
+
+const ChunkedFileSection& ChunkedFileReader::GetSection(uint32 id) const
+{
+    const ChunkedFileSection* section = FindSection(id);
+    if(section == nullptr)
+        throw Exception(MakeString(L"Chunked file '%ls' is missing section '%hs'", filePath.c_str(),
+                                   FourCCString(id).c_str()));
+
+    return *section;
+}
+
+void ChunkedFileReader::ValidateSection(const ChunkedFileSection& section) const
+{
+    Hash dataHash = HashChunkedFileSection(SectionData(section), section.Size);
+    if((dataHash == section.DataHash) == false)
+        throw Exception(MakeString(L"Section '%hs' of chunked file '%ls' is corrupt",
+                                   FourCCString(section.ID).c_str(), filePath.c_str()));
+}
+
+MemoryReadSerializer ChunkedFileReader::SectionSerializer(const ChunkedFileSection& section) const
+{
+    return MemoryReadSerializer(SectionData(section), section.Size);
+}
+
+}
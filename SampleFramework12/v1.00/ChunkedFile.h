@@ -0,0 +1,142 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "FileIO.h"
+#include "Containers.h"
+#include "MurmurHash.h"
+#include "Serialization.h"
+
+namespace SampleFramework12
+{
+
+// Chunked binary container. The file starts with a header, followed by a list of sections that each
+// start on a 64-byte boundary, and ends with a table that has the ID, location and hash of every
+// section. Readers can validate and pull out individual sections without touching the rest of the
+// file, and bulk data such as vertices can be used straight out of a memory-mapped view.
+
+inline constexpr uint32 MakeFourCC(char a, char b, char c, char d)
+{
+    return uint32(uint8(a)) | (uint32(uint8(b)) << 8) | (uint32(uint8(c)) << 16) | (uint32(uint8(d)) << 24);
+}
+
+static const uint32 ChunkedFileMagic = MakeFourCC('S', 'F', 'C', 'F');
+static const uint32 ChunkedFileFormatVersion = 1;
+static const uint64 ChunkedFileAlignment = 64;
+
+// Section hashes are built from GenerateHash over blocks of this size, combined with CombineHashes
+static const uint64 ChunkedFileHashBlockSize = 1024 * 1024;
+
+struct ChunkedFileHeader
+{
+    uint32 Magic = 0;
+    uint32 FormatVersion = 0;
+    uint32 ContentType = 0;         // FourCC for what's in the file, for instance a mesh
+    uint32 ContentVersion = 0;      // Version of the content, bumped whenever the layout of a section changes
+    uint64 TableOffset = 0;
+    uint64 NumSections = 0;
+    Hash TableHash;
+};
+
+struct ChunkedFileSection
+{
+    uint32 ID = 0;
+    uint32 Padding = 0;
+    uint64 Offset = 0;
+    uint64 Size = 0;
+    Hash DataHash;
+};
+
+Hash HashChunkedFileSection(const void* data, uint64 size);
+
+// Writes a chunked file front to back. Data for the current section goes through SerializeItem and
+// SerializeData, so it can be used as a write serializer. The header and section table are written by
+// Finish(), which has to be called explicitly. If the writer is destroyed before that (for instance
+// because an exception was thrown part of the way through) the incomplete file is deleted.
+class ChunkedFileWriter
+{
+
+private:
+
+    File file;
+    std::wstring filePath;
+    GrowableList<ChunkedFileSection> sections;
+    ChunkedFileHeader header;
+    Array<uint8> buffer;
+    uint64 bufferUsed = 0;
+    uint64 fileOffset = 0;
+    bool inSection = false;
+    bool finished = false;
+
+    void FlushBlock();
+    void WritePadding();
+
+    ChunkedFileWriter(const ChunkedFileWriter& other);
+    ChunkedFileWriter& operator=(const ChunkedFileWriter& other);
+
+public:
+
+    ChunkedFileWriter(const wchar* path, uint32 contentType, uint32 contentVersion);
+    ~ChunkedFileWriter();
+
+    void BeginSection(uint32 id);
+    void EndSection();
+    void Finish();
+
+    template<typename T> void SerializeItem(const T& data)
+    {
+        SerializeData(sizeof(T), &data);
+    }
+
+    void SerializeData(uint64 size, const void* data);
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+};
+
+// Maps a chunked file and checks the header and section table, without reading any of the sections.
+// Section data is only hashed when ValidateSection is called, which is safe to do from multiple
+// threads at once.
+class ChunkedFileReader
+{
+
+private:
+
+    MappedFile file;
+    ChunkedFileHeader header;
+    const ChunkedFileSection* sections = nullptr;
+    std::wstring filePath;
+
+    ChunkedFileReader(const ChunkedFileReader& other);
+    ChunkedFileReader& operator=(const ChunkedFileReader& other);
+
+public:
+
+    ChunkedFileReader(const wchar* path, uint32 contentType);
+
+    // Returns true if the file starts with a chunked file header
+    static bool IsChunkedFile(const wchar* path);
+
+    const ChunkedFileSection* FindSection(uint32 id) const;
+    const ChunkedFileSection& GetSection(uint32 id) const;
+    void ValidateSection(const ChunkedFileSection& section) const;
+
+    const uint8* SectionData(const ChunkedFileSection& section) const { return file.Data() + section.Offset; }
+    MemoryReadSerializer SectionSerializer(const ChunkedFileSection& section) const;
+
+    // Accessors
+    uint32 ContentVersion() const { return header.ContentVersion; }
+    uint64 NumSections() const { return header.NumSections; }
+    const ChunkedFileSection& Section(uint64 idx) const { Assert_(idx < header.NumSections); return sections[idx]; }
+};
+
+}
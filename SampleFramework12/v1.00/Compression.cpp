@@ -0,0 +1,512 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Compression.h"
+#include "Utility.h"
+#include "EnkiTS/TaskScheduler.h"
+
+#include <exception>
+
+namespace SampleFramework12
+{
+
+// Implemented at the bottom of TinyEXR.cpp, which is where miniz lives
+uint64 MinizCompress(const void* src, uint64 srcSize, void* dst, uint64 dstCapacity, int level);
+bool MinizDecompress(const void* src, uint64 srcSize, void* dst, uint64 dstSize);
+
+static const int DeflateLevel = 6;
+
+// == LZ codec ====================================================================================
+
+// Each sequence starts with a token byte holding the number of literals in the top 4 bits and the
+// match length minus 4 in the bottom 4 bits. A nibble of 15 means that more length bytes follow, which
+// are added up until one of them is less than 255. The literals come next, then a 16-bit little-endian
+// match offset and any extra match length bytes. The last sequence only has literals.
+
+static const uint64 LZMinMatch = 4;
+static const uint64 LZMaxOffset = 65535;
+static const uint64 LZHashBits = 14;
+static const uint64 LZLastLiterals = 5;         // The last bytes of a block are always literals
+static const uint64 LZMatchSearchEnd = 12;      // Matches can't start this close to the end of a block
+
+static uint32 LZRead32(const uint8* ptr)
+{
+    uint32 value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static uint32 LZHash(uint32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZHashBits);
+}
+
+static bool LZWriteLength(uint8*& op, const uint8* opEnd, uint64 length)
+{
+    length -= 15;
+    for(; length >= 255; length -= 255)
+    {
+        if(op == opEnd)
+            return false;
+        *op++ = 255;
+    }
+
+    if(op == opEnd)
+        return false;
+    *op++ = uint8(length);
+    return true;
+}
+
+static bool LZReadLength(const uint8*& ip, const uint8* ipEnd, uint64& length)
+{
+    uint8 lengthByte = 0;
+    do
+    {
+        if(ip == ipEnd)
+            return false;
+        lengthByte = *ip++;
+        length += lengthByte;
+    } while(lengthByte == 255);
+
+    return true;
+}
+
+// Pass a match length of 0 for the final sequence
+static bool LZWriteSequence(uint8*& op, const uint8* opEnd, const uint8* literals, uint64 numLiterals,
+                            uint64 matchOffset, uint64 matchLength)
+{
+    if(op == opEnd)
+        return false;
+    uint8* token = op++;
+
+    *token = uint8(Min<uint64>(numLiterals, 15) << 4);
+    if(numLiterals >= 15 && LZWriteLength(op, opEnd, numLiterals) == false)
+        return false;
+
+    if(numLiterals > uint64(opEnd - op))
+        return false;
+    memcpy(op, literals, numLiterals);
+    op += numLiterals;
+
+    if(matchLength == 0)
+        return true;
+
+    if(opEnd - op < 2)
+        return false;
+    *op++ = uint8(matchOffset);
+    *op++ = uint8(matchOffset >> 8);
+
+    const uint64 extraLength = matchLength - LZMinMatch;
+    *token |= uint8(Min<uint64>(extraLength, 15));
+    if(extraLength >= 15 && LZWriteLength(op, opEnd, extraLength) == false)
+        return false;
+
+    return true;
+}
+
+static uint64 LZCompress(const uint8* src, uint64 srcSize, uint8* dst, uint64 dstCapacity)
+{
+    Assert_(srcSize < UINT32_MAX);
+
+    static const uint32 EmptySlot = UINT32_MAX;
+    uint32 hashTable[1 << LZHashBits];
+    memset(hashTable, 0xFF, sizeof(hashTable));
+
+    uint8* op = dst;
+    const uint8* opEnd = dst + dstCapacity;
+    uint64 anchor = 0;
+    uint64 pos = 0;
+    const uint64 searchEnd = srcSize > LZMatchSearchEnd ? srcSize - LZMatchSearchEnd : 0;
+
+    while(pos < searchEnd)
+    {
+        const uint32 sequence = LZRead32(src + pos);
+        const uint32 hash = LZHash(sequence);
+        const uint64 candidate = hashTable[hash];
+        hashTable[hash] = uint32(pos);
+
+        if(candidate == EmptySlot || pos - candidate > LZMaxOffset || LZRead32(src + candidate) != sequence)
+        {
+            // Take bigger steps the longer it's been since the last match, so that incompressible data goes by quickly
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+
+        uint64 matchPos = candidate;
+        while(pos > anchor && matchPos > 0 && src[pos - 1] == src[matchPos - 1])
+        {
+            --pos;
+            --matchPos;
+        }
+
+        const uint64 maxLength = srcSize - LZLastLiterals - pos;
+        uint64 matchLength = LZMinMatch;
+        while(matchLength < maxLength && src[pos + matchLength] == src[matchPos + matchLength])
+            ++matchLength;
+
+        if(LZWriteSequence(op, opEnd, src + anchor, pos - anchor, pos - matchPos, matchLength) == false)
+            return 0;
+
+        pos += matchLength;
+        anchor = pos;
+    }
+
+    if(LZWriteSequence(op, opEnd, src + anchor, srcSize - anchor, 0, 0) == false)
+        return 0;
+
+    return uint64(op - dst);
+}
+
+static bool LZDecompress(const uint8* src, uint64 srcSize, uint8* dst, uint64 dstSize)
+{
+    const uint8* ip = src;
+    const uint8* ipEnd = src + srcSize;
+    uint8* op = dst;
+    const uint8* opEnd = dst + dstSize;
+
+    while(ip < ipEnd)
+    {
+        const uint8 token = *ip++;
+
+        uint64 numLiterals = token >> 4;
+        if(numLiterals == 15 && LZReadLength(ip, ipEnd, numLiterals) == false)
+            return false;
+        if(numLiterals > uint64(ipEnd - ip) || numLiterals > uint64(opEnd - op))
+            return false;
+
+        // Most runs are short, so copy a fixed 16 bytes when there's room to spill over
+        if(numLiterals <= 16 && ipEnd - ip >= 16 && opEnd - op >= 16)
+            memcpy(op, ip, 16);
+        else
+            memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        if(ip == ipEnd)
+            break;
+
+        if(ipEnd - ip < 2)
+            return false;
+        const uint64 matchOffset = uint64(ip[0]) | (uint64(ip[1]) << 8);
+        ip += 2;
+        if(matchOffset == 0 || matchOffset > uint64(op - dst))
+            return false;
+
+        uint64 matchLength = token & 15;
+        if(matchLength == 15 && LZReadLength(ip, ipEnd, matchLength) == false)
+            return false;
+        matchLength += LZMinMatch;
+        if(matchLength > uint64(opEnd - op))
+            return false;
+
+        // Copy 8 bytes at a time when the match is at least that far back, which also works for matches
+        // that overlap the output. Closer matches repeat a short pattern, so those go one byte at a time.
+        const uint8* match = op - matchOffset;
+        uint8* matchEnd = op + matchLength;
+        if(matchOffset >= 8 && uint64(opEnd - op) >= matchLength + 8)
+        {
+            for(; op < matchEnd; op += 8, match += 8)
+                memcpy(op, match, 8);
+        }
+        else
+        {
+            for(; op < matchEnd; ++op, ++match)
+                *op = *match;
+        }
+        op = matchEnd;
+    }
+
+    return op == opEnd;
+}
+
+// == Block compression ===========================================================================
+
+uint64 CompressBlock(CompressionCodec codec, const void* src, uint64 srcSize, void* dst, uint64 dstCapacity)
+{
+    if(codec == CompressionCodec::Deflate)
+        return MinizCompress(src, srcSize, dst, dstCapacity, DeflateLevel);
+    else if(codec == CompressionCodec::LZ)
+        return LZCompress(reinterpret_cast<const uint8*>(src), srcSize, reinterpret_cast<uint8*>(dst), dstCapacity);
+
+    Assert_(codec == CompressionCodec::None);
+    if(srcSize > dstCapacity)
+        return 0;
+    memcpy(dst, src, srcSize);
+    return srcSize;
+}
+
+bool DecompressBlock(CompressionCodec codec, const void* src, uint64 srcSize, void* dst, uint64 dstSize)
+{
+    if(codec == CompressionCodec::Deflate)
+        return MinizDecompress(src, srcSize, dst, dstSize);
+    else if(codec == CompressionCodec::LZ)
+        return LZDecompress(reinterpret_cast<const uint8*>(src), srcSize, reinterpret_cast<uint8*>(dst), dstSize);
+    else if(codec == CompressionCodec::None && srcSize == dstSize)
+    {
+        memcpy(dst, src, srcSize);
+        return true;
+    }
+
+    return false;
+}
+
+// == CompressedWriteSerializer ===================================================================
+
+CompressedWriteSerializer::CompressedWriteSerializer(const wchar* path, CompressionCodec codec, uint64 blockSize) : filePath(path)
+{
+    Assert_(uint32(codec) < uint32(CompressionCodec::NumValues));
+    Assert_(blockSize > 0 && blockSize <= MaxCompressionBlockSize);
+
+    file.Open(path, FileOpenMode::Write);
+    buffer.Init(blockSize);
+    compressedBuffer.Init(blockSize);
+    blocks.Init(64);
+
+    header.Magic = CompressedFileMagic;
+    header.Codec = codec;
+    header.BlockSize = blockSize;
+
+    // The header gets filled in once everything else has been written, and until then it's zeroed
+    const CompressedFileHeader placeholderHeader;
+    file.Write(sizeof(CompressedFileHeader), &placeholderHeader);
+    fileOffset = sizeof(CompressedFileHeader);
+}
+
+CompressedWriteSerializer::~CompressedWriteSerializer()
+{
+    if(finished)
+        return;
+
+    // Finish() can throw, so it's never called from here. The stream was cut off part of the way through,
+    // which should only happen when an exception is unwinding through the code doing the serializing.
+    Assert_(std::uncaught_exceptions() > 0);
+    file.Close();
+    DeleteFile(filePath.c_str());
+}
+
+void CompressedWriteSerializer::CompressBuffer()
+{
+    if(bufferUsed == 0)
+        return;
+
+    // Anything that doesn't get smaller is stored as-is
+    CompressedBlock block;
+    block.Offset = fileOffset;
+    block.CompressedSize = CompressBlock(header.Codec, buffer.Data(), bufferUsed, compressedBuffer.Data(), bufferUsed - 1);
+    if(block.CompressedSize == 0)
+    {
+        block.CompressedSize = bufferUsed;
+        file.Write(bufferUsed, buffer.Data());
+    }
+    else
+    {
+        file.Write(block.CompressedSize, compressedBuffer.Data());
+    }
+
+    blocks.Add(block);
+    fileOffset += block.CompressedSize;
+    header.UncompressedSize += bufferUsed;
+    bufferUsed = 0;
+}
+
+void CompressedWriteSerializer::SerializeData(uint64 size, const void* data)
+{
+    Assert_(finished == false);
+
+    const uint8* src = reinterpret_cast<const uint8*>(data);
+    while(size > 0)
+    {
+        const uint64 copySize = Min(size, buffer.Size() - bufferUsed);
+        memcpy(buffer.Data() + bufferUsed, src, copySize);
+        bufferUsed += copySize;
+        src += copySize;
+        size -= copySize;
+
+        if(bufferUsed == buffer.Size())
+            CompressBuffer();
+    }
+}
+
+void CompressedWriteSerializer::Finish()
+{
+    Assert_(finished == false);
+
+    CompressBuffer();
+
+    header.NumBlocks = blocks.Count();
+    header.TableOffset = fileOffset;
+    file.Write(blocks.Count() * sizeof(CompressedBlock), blocks.Data());
+    file.WriteAt(0, sizeof(CompressedFileHeader), &header);
+    file.Close();
+
+    finished = true;
+}
+
+// == Compressed streams ==========================================================================
+
+void CompressStream(CompressionCodec codec, const void* src, uint64 srcSize, GrowableList<uint8>& dst, uint64 blockSize)
+{
+    Assert_(uint32(codec) < uint32(CompressionCodec::NumValues));
+    Assert_(blockSize > 0 && blockSize <= MaxCompressionBlockSize);
+
+    CompressedFileHeader header;
+    header.Magic = CompressedFileMagic;
+    header.Codec = codec;
+    header.BlockSize = blockSize;
+    header.UncompressedSize = srcSize;
+    header.NumBlocks = (srcSize + blockSize - 1) / blockSize;
+
+    // Blocks that don't get smaller are stored as-is, so the stream can't be any bigger than this
+    const uint64 headerStart = dst.Count();
+    dst.Reserve(headerStart + sizeof(CompressedFileHeader) + srcSize + header.NumBlocks * sizeof(CompressedBlock));
+    dst.AddMultiple(0, sizeof(CompressedFileHeader));
+
+    Array<CompressedBlock> blocks(header.NumBlocks);
+    Array<uint8> compressedBuffer(Min(blockSize, srcSize));
+    const uint8* srcBytes = reinterpret_cast<const uint8*>(src);
+    for(uint64 i = 0; i < header.NumBlocks; ++i)
+    {
+        const uint64 blockStart = i * blockSize;
+        const uint64 blockBytes = Min(srcSize - blockStart, blockSize);
+
+        CompressedBlock& block = blocks[i];
+        block.Offset = dst.Count() - headerStart;
+        block.CompressedSize = CompressBlock(codec, srcBytes + blockStart, blockBytes, compressedBuffer.Data(), blockBytes - 1);
+        if(block.CompressedSize == 0)
+        {
+            block.CompressedSize = blockBytes;
+            dst.Append(srcBytes + blockStart, blockBytes);
+        }
+        else
+        {
+            dst.Append(compressedBuffer.Data(), block.CompressedSize);
+        }
+    }
+
+    header.TableOffset = dst.Count() - headerStart;
+    dst.Append(reinterpret_cast<const uint8*>(blocks.Data()), blocks.MemorySize());
+    memcpy(dst.Data() + headerStart, &header, sizeof(CompressedFileHeader));
+}
+
+// Checks everything that can be checked without decompressing, before anything gets allocated, so that
+// a corrupt header can't ask for more memory than the compressed data could ever expand to
+static void ReadCompressedStreamHeader(const uint8* src, uint64 srcSize, const wchar* name, CompressedFileHeader& header)
+{
+    if(srcSize < sizeof(CompressedFileHeader))
+        throw Exception(MakeString(L"File '%ls' is too small to be a compressed file", name));
+
+    memcpy(&header, src, sizeof(CompressedFileHeader));
+    if(header.Magic != CompressedFileMagic || uint32(header.Codec) >= uint32(CompressionCodec::NumValues))
+        throw Exception(MakeString(L"File '%ls' is not a compressed file", name));
+
+    if(header.BlockSize == 0 || header.BlockSize > MaxCompressionBlockSize ||
+       header.TableOffset < sizeof(CompressedFileHeader) || header.TableOffset > srcSize ||
+       header.UncompressedSize / MaxCompressionRatio > header.TableOffset - sizeof(CompressedFileHeader))
+        throw Exception(MakeString(L"Compressed file '%ls' has a corrupt header", name));
+
+    if(header.NumBlocks > (srcSize - header.TableOffset) / sizeof(CompressedBlock) ||
+       header.NumBlocks != (header.UncompressedSize + header.BlockSize - 1) / header.BlockSize)
+        throw Exception(MakeString(L"Compressed file '%ls' has a corrupt block table", name));
+}
+
+uint64 DecompressedStreamSize(const void* src, uint64 srcSize, const wchar* name)
+{
+    CompressedFileHeader header;
+    ReadCompressedStreamHeader(reinterpret_cast<const uint8*>(src), srcSize, name, header);
+    return header.UncompressedSize;
+}
+
+void DecompressStream(const void* src, uint64 srcSize, void* dst, uint64 dstSize, const wchar* name,
+                      enki::TaskScheduler* taskScheduler)
+{
+    const uint8* srcBytes = reinterpret_cast<const uint8*>(src);
+    CompressedFileHeader header;
+    ReadCompressedStreamHeader(srcBytes, srcSize, name, header);
+    if(header.UncompressedSize != dstSize)
+        throw Exception(MakeString(L"Compressed file '%ls' decompresses to %llu bytes instead of %llu",
+                                   name, header.UncompressedSize, dstSize));
+
+    const uint64 numBlocks = header.NumBlocks;
+    Array<CompressedBlock> blocks(numBlocks);
+    if(numBlocks > 0)
+        memcpy(blocks.Data(), srcBytes + header.TableOffset, numBlocks * sizeof(CompressedBlock));
+
+    for(uint64 i = 0; i < numBlocks; ++i)
+        if(blocks[i].Offset < sizeof(CompressedFileHeader) || blocks[i].Offset > header.TableOffset ||
+           blocks[i].CompressedSize > header.TableOffset - blocks[i].Offset)
+            throw Exception(MakeString(L"Compressed file '%ls' has a corrupt block table", name));
+
+    uint8* dstBytes = reinterpret_cast<uint8*>(dst);
+    std::atomic<bool> corrupt(false);
+    auto decompressBlocks = [&](uint64 start, uint64 end)
+    {
+        for(uint64 i = start; i < end; ++i)
+        {
+            const uint64 blockStart = i * header.BlockSize;
+            const uint64 blockSize = Min(header.UncompressedSize - blockStart, header.BlockSize);
+            const CompressedBlock& block = blocks[i];
+            const CompressionCodec codec = block.CompressedSize == blockSize ? CompressionCodec::None : header.Codec;
+            if(DecompressBlock(codec, srcBytes + block.Offset, block.CompressedSize, dstBytes + blockStart, blockSize) == false)
+                corrupt = true;
+        }
+    };
+
+    if(taskScheduler != nullptr && numBlocks > 1)
+    {
+        enki::TaskSet task(uint32(numBlocks), [&](enki::TaskSetPartition range, uint32_t)
+        {
+            decompressBlocks(range.start, range.end);
+        });
+
+        taskScheduler->AddTaskSetToPipe(&task);
+        taskScheduler->WaitforTaskSet(&task);
+    }
+    else
+    {
+        decompressBlocks(0, numBlocks);
+    }
+
+    if(corrupt)
+        throw Exception(MakeString(L"Compressed file '%ls' has corrupt data", name));
+}
+
+// == CompressedReadSerializer ====================================================================
+
+CompressedReadSerializer::CompressedReadSerializer(const wchar* path, enki::TaskScheduler* taskScheduler)
+{
+    MappedFile file(path);
+    data.Init(DecompressedStreamSize(file.Data(), file.Size(), path));
+    DecompressStream(file.Data(), file.Size(), data.Data(), data.Size(), path, taskScheduler);
+}
+
+const uint8* CompressedReadSerializer::Consume(uint64 size)
+{
+    if(size > data.Size() - offset)
+        throw Exception(MakeString(L"Tried to read %llu bytes at offset %llu from a file that's only %llu bytes",
+                                   size, offset, data.Size()));
+
+    const uint8* ptr = data.Data() + offset;
+    offset += size;
+    return ptr;
+}
+
+bool IsCompressedFile(const wchar* filePath)
+{
+    File file(filePath, FileOpenMode::Read);
+    if(file.Size() < sizeof(uint32))
+        return false;
+
+    uint32 magic = 0;
+    file.Read(magic);
+    return magic == CompressedFileMagic;
+}
+
+}
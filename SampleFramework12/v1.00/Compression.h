@@ -0,0 +1,174 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "FileIO.h"
+#include "Containers.h"
+#include "Serialization.h"
+
+namespace enki
+{
+    class TaskScheduler;
+}
+
+namespace SampleFramework12
+{
+
+enum class CompressionCodec : uint32
+{
+    None = 0,
+    Deflate = 1,        // zlib streams from the copy of miniz in TinyEXR.cpp. Smaller, but slow to compress.
+    LZ = 2,             // Byte-oriented LZ77 in the style of LZ4. Decompresses at memcpy-like speeds.
+
+    NumValues
+};
+
+// Returns the compressed size, or 0 if the compressed data wouldn't fit in dstCapacity bytes
+uint64 CompressBlock(CompressionCodec codec, const void* src, uint64 srcSize, void* dst, uint64 dstCapacity);
+
+// Returns false if the data is corrupt, or doesn't decompress to exactly dstSize bytes
+bool DecompressBlock(CompressionCodec codec, const void* src, uint64 srcSize, void* dst, uint64 dstSize);
+
+// Compressed files are split into independently compressed blocks, followed by a table with the
+// location of each block. Blocks that don't get any smaller are stored as-is.
+static const uint32 CompressedFileMagic = 0x5A434653;     // "SFCZ"
+static const uint64 DefaultCompressionBlockSize = 256 * 1024;
+static const uint64 MaxCompressionBlockSize = 64 * 1024 * 1024;
+
+// Neither codec can do better than this (deflate tops out at about 1032:1, LZ at about 255:1), which
+// lets readers reject headers that claim more data than the file could possibly decompress to
+static const uint64 MaxCompressionRatio = 1032;
+
+struct CompressedFileHeader
+{
+    uint32 Magic = 0;
+    CompressionCodec Codec = CompressionCodec::None;
+    uint64 BlockSize = 0;
+    uint64 UncompressedSize = 0;
+    uint64 NumBlocks = 0;
+    uint64 TableOffset = 0;
+};
+
+struct CompressedBlock
+{
+    uint64 Offset = 0;
+    uint64 CompressedSize = 0;      // Equal to the uncompressed size if the block is stored as-is
+};
+
+// Compresses data into the same layout as a compressed file, but in memory, so that it can be stored
+// inside of another file (for instance in a chunked file section)
+void CompressStream(CompressionCodec codec, const void* src, uint64 srcSize, GrowableList<uint8>& dst,
+                    uint64 blockSize = DefaultCompressionBlockSize);
+
+// Checks the header and block table of a compressed stream, and returns how big it is once it's
+// decompressed. The name is only used for error messages. Throws if the stream is corrupt.
+uint64 DecompressedStreamSize(const void* src, uint64 srcSize, const wchar* name);
+
+// Decompresses a whole stream into dst, which has to be exactly DecompressedStreamSize() bytes. If a
+// task scheduler is passed in, the blocks are spread across its threads. Throws if the stream is corrupt.
+void DecompressStream(const void* src, uint64 srcSize, void* dst, uint64 dstSize, const wchar* name,
+                      enki::TaskScheduler* taskScheduler = nullptr);
+
+// Write serializer that compresses everything into a compressed file. Finish() has to be called once
+// everything has been serialized, and until then the file has a zeroed header that readers reject.
+// If the serializer is destroyed without being finished, the incomplete file is deleted.
+class CompressedWriteSerializer
+{
+
+private:
+
+    File file;
+    std::wstring filePath;
+    CompressedFileHeader header;
+    GrowableList<CompressedBlock> blocks;
+    Array<uint8> buffer;
+    Array<uint8> compressedBuffer;
+    uint64 bufferUsed = 0;
+    uint64 fileOffset = 0;
+    bool finished = false;
+
+    void CompressBuffer();
+
+    CompressedWriteSerializer(const CompressedWriteSerializer& other);
+    CompressedWriteSerializer& operator=(const CompressedWriteSerializer& other);
+
+public:
+
+    CompressedWriteSerializer(const wchar* path, CompressionCodec codec, uint64 blockSize = DefaultCompressionBlockSize);
+    ~CompressedWriteSerializer();
+
+    void Finish();
+
+    template<typename T> void SerializeItem(const T& data)
+    {
+        SerializeData(sizeof(T), &data);
+    }
+
+    void SerializeData(uint64 size, const void* data);
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+};
+
+// Decompresses an entire compressed file up front, and then reads from memory. If a task scheduler
+// is passed in, the blocks are spread across its threads.
+class CompressedReadSerializer
+{
+
+private:
+
+    Array<uint8> data;
+    uint64 offset = 0;
+
+    const uint8* Consume(uint64 size);
+
+public:
+
+    explicit CompressedReadSerializer(const wchar* path, enki::TaskScheduler* taskScheduler = nullptr);
+
+    template<typename T> void SerializeItem(T& item)
+    {
+        memcpy(&item, Consume(sizeof(T)), sizeof(T));
+    }
+
+    void SerializeData(uint64 size, void* dst)
+    {
+        if(size > 0)
+            memcpy(dst, Consume(size), size);
+    }
+
+    uint64 Offset() const { return offset; }
+    uint64 Size() const { return data.Size(); }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+bool IsCompressedFile(const wchar* filePath);
+
+// Convenience functions for compressed file serialization
+template<typename T>
+void SerializeFromCompressedFile(const wchar* filePath, T& item, enki::TaskScheduler* taskScheduler = nullptr)
+{
+    CompressedReadSerializer serializer(filePath, taskScheduler);
+    SerializeItem(serializer, item);
+}
+
+template<typename T>
+void SerializeToCompressedFile(const wchar* filePath, const T& item, CompressionCodec codec = CompressionCodec::LZ)
+{
+    CompressedWriteSerializer serializer(filePath, codec);
+    SerializeItem(serializer, const_cast<T&>(item));
+    serializer.Finish();
+}
+
+}
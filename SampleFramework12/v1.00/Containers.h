@@ -11,15 +11,120 @@
 
 #include "PCH.h"
 #include "Assert.h"
+#include "Allocators.h"
+#include "MurmurHash.h"
 
 namespace SampleFramework12
 {
 
-template<typename T> class Array
+// Helpers for managing elements in uninitialized storage. The containers below only construct the
+// elements that are actually in use, and move them around with placement new and move construction.
+// Trivially copyable types skip all of that and get relocated with memcpy/memmove. The storage itself
+// comes from the Allocator policy, see Allocators.h.
+template<typename T, typename Allocator = HeapAllocator, bool TriviallyCopyable = std::is_trivially_copyable<T>::value>
+struct ContainerElements
+{
+    static T* Allocate(uint64 numElements)
+    {
+        return numElements > 0 ? static_cast<T*>(Allocator::Allocate(numElements * sizeof(T), alignof(T))) : nullptr;
+    }
+
+    static void Free(T* elements)
+    {
+        if(elements != nullptr)
+            Allocator::Free(elements);
+    }
+
+    static void Construct(T* elements, uint64 numElements)
+    {
+        for(uint64 i = 0; i < numElements; ++i)
+            new (elements + i) T;
+    }
+
+    static void ConstructCopies(T* elements, uint64 numElements, const T& value)
+    {
+        for(uint64 i = 0; i < numElements; ++i)
+            new (elements + i) T(value);
+    }
+
+    static void Destroy(T* elements, uint64 numElements)
+    {
+        for(uint64 i = 0; i < numElements; ++i)
+            elements[i].~T();
+    }
+
+    // Copies into uninitialized storage
+    static void CopyConstruct(T* dst, const T* src, uint64 numElements)
+    {
+        for(uint64 i = 0; i < numElements; ++i)
+            new (dst + i) T(src[i]);
+    }
+
+    // Moves into uninitialized storage, leaving the source uninitialized
+    static void Relocate(T* dst, T* src, uint64 numElements)
+    {
+        for(uint64 i = 0; i < numElements; ++i)
+        {
+            new (dst + i) T(std::move(src[i]));
+            src[i].~T();
+        }
+    }
+
+    // Moves elements [idx, count) up by gapSize, leaving [idx, idx + gapSize) uninitialized
+    static void OpenGap(T* elements, uint64 count, uint64 idx, uint64 gapSize)
+    {
+        for(uint64 i = count; i > idx; --i)
+        {
+            new (elements + i - 1 + gapSize) T(std::move(elements[i - 1]));
+            elements[i - 1].~T();
+        }
+    }
+
+    // Moves elements [idx + gapSize, count) down into the uninitialized gap at idx
+    static void CloseGap(T* elements, uint64 count, uint64 idx, uint64 gapSize)
+    {
+        for(uint64 i = idx + gapSize; i < count; ++i)
+        {
+            new (elements + i - gapSize) T(std::move(elements[i]));
+            elements[i].~T();
+        }
+    }
+};
+
+template<typename T, typename Allocator> struct ContainerElements<T, Allocator, true> : public ContainerElements<T, Allocator, false>
+{
+    static void CopyConstruct(T* dst, const T* src, uint64 numElements)
+    {
+        if(numElements > 0)
+            memcpy(dst, src, numElements * sizeof(T));
+    }
+
+    static void Relocate(T* dst, T* src, uint64 numElements)
+    {
+        if(numElements > 0)
+            memcpy(dst, src, numElements * sizeof(T));
+    }
+
+    static void OpenGap(T* elements, uint64 count, uint64 idx, uint64 gapSize)
+    {
+        if(count > idx)
+            memmove(elements + idx + gapSize, elements + idx, (count - idx) * sizeof(T));
+    }
+
+    static void CloseGap(T* elements, uint64 count, uint64 idx, uint64 gapSize)
+    {
+        if(count > idx + gapSize)
+            memmove(elements + idx, elements + idx + gapSize, (count - idx - gapSize) * sizeof(T));
+    }
+};
+
+template<typename T, typename Allocator = HeapAllocator> class Array
 {
 
 protected:
 
+    typedef ContainerElements<T, Allocator> Elements;
+
     uint64 size = 0;
     T* data = nullptr;
 
@@ -39,25 +144,61 @@ public:
         Init(numElements, fillValue);
     }
 
+    Array(const Array& other)
+    {
+        *this = other;
+    }
+
+    Array(Array&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
     ~Array()
     {
         Shutdown();
     }
 
+    Array& operator=(const Array& other)
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            data = Elements::Allocate(other.size);
+            Elements::CopyConstruct(data, other.data, other.size);
+            size = other.size;
+        }
+        return *this;
+    }
+
+    Array& operator=(Array&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            size = other.size;
+            data = other.data;
+            other.size = 0;
+            other.data = nullptr;
+        }
+        return *this;
+    }
+
     void Init(uint64 numElements)
     {
         Shutdown();
 
         size = numElements;
-        if(size > 0)
-            data = new T[size];
+        data = Elements::Allocate(size);
+        Elements::Construct(data, size);
     }
 
     void Shutdown()
     {
         if(data)
         {
-            delete[] data;
+            Elements::Destroy(data, size);
+            Elements::Free(data);
             data = nullptr;
         }
         size = 0;
@@ -65,8 +206,11 @@ public:
 
     void Init(uint64 numElements, T fillValue)
     {
-        Init(numElements);
-        Fill(fillValue);
+        Shutdown();
+
+        size = numElements;
+        data = Elements::Allocate(size);
+        Elements::ConstructCopies(data, size, fillValue);
     }
 
     void Resize(uint64 numElements)
@@ -80,11 +224,14 @@ public:
             return;
         }
 
-        T* newData = new T[numElements];
-        for(uint64 i = 0; i < size; ++i)
-            newData[i] = data[i];
+        // Move over the elements we're keeping instead of default-constructing and then copying them
+        const uint64 numKept = numElements < size ? numElements : size;
+        T* newData = Elements::Allocate(numElements);
+        Elements::Relocate(newData, data, numKept);
+        Elements::Construct(newData + numKept, numElements - numKept);
+        Elements::Destroy(data + numKept, size - numKept);
+        Elements::Free(data);
 
-        Shutdown();
         data = newData;
         size = numElements;
     }
@@ -135,12 +282,18 @@ public:
     }
 };
 
-template<typename T> class FixedList
+// FixedList and GrowableList only construct the first Count() elements, the rest of the storage is left
+// uninitialized. Removed elements are destroyed, so the fillValue overloads of Remove/RemoveAll are
+// equivalent to the plain versions.
+template<typename T, typename Allocator = HeapAllocator> class FixedList
 {
 
 protected:
 
-    Array<T> array;
+    typedef ContainerElements<T, Allocator> Elements;
+
+    T* data = nullptr;
+    uint64 capacity = 0;
     uint64 count = 0;
 
 public:
@@ -159,23 +312,77 @@ public:
         Init(maxCount, initialCount, fillValue);
     }
 
+    FixedList(const FixedList& other)
+    {
+        *this = other;
+    }
+
+    FixedList(FixedList&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    ~FixedList()
+    {
+        Shutdown();
+    }
+
+    FixedList& operator=(const FixedList& other)
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            data = Elements::Allocate(other.capacity);
+            Elements::CopyConstruct(data, other.data, other.count);
+            capacity = other.capacity;
+            count = other.count;
+        }
+        return *this;
+    }
+
+    FixedList& operator=(FixedList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            data = other.data;
+            capacity = other.capacity;
+            count = other.count;
+            other.data = nullptr;
+            other.capacity = 0;
+            other.count = 0;
+        }
+        return *this;
+    }
+
     void Init(uint64 maxCount, uint64 initialCount = 0)
     {
         Assert_(initialCount < maxCount);
         Assert_(maxCount > 0);
-        array.Init(maxCount);
+        Shutdown();
+        data = Elements::Allocate(maxCount);
+        capacity = maxCount;
+        Elements::Construct(data, initialCount);
         count = initialCount;
     }
 
     void Init(uint64 maxCount, uint64 initialCount, T fillValue)
     {
-        Init(maxCount, initialCount);
-        array.Fill(fillValue);
+        Assert_(initialCount < maxCount);
+        Assert_(maxCount > 0);
+        Shutdown();
+        data = Elements::Allocate(maxCount);
+        capacity = maxCount;
+        Elements::ConstructCopies(data, initialCount, fillValue);
+        count = initialCount;
     }
 
     void Shutdown()
     {
-        array.Shutdown();
+        Elements::Destroy(data, count);
+        Elements::Free(data);
+        data = nullptr;
+        capacity = 0;
         count = 0;
     }
 
@@ -186,50 +393,56 @@ public:
 
     uint64 MaxCount() const
     {
-        return array.Size();
+        return capacity;
     }
 
     const T& operator[](uint64 idx) const
     {
         Assert_(idx < count);
-        return array[idx];
+        return data[idx];
     }
 
     T& operator[](uint64 idx)
     {
         Assert_(idx < count);
-        return array[idx];
+        return data[idx];
     }
 
     const T* Data() const
     {
-        return array.Data();
+        return data;
     }
 
     T* Data()
     {
-        return array.Data();
+        return data;
     }
 
     void Fill(T value)
     {
         for(uint64 i = 0; i < count; ++i)
-            array[i] = value;
+            data[i] = value;
     }
 
     uint64 Add(T item)
     {
-        Assert_(count < array.Size());
-        array[count] = item;
+        Assert_(count < capacity);
+        new (data + count) T(std::move(item));
         return count++;
     }
 
     T& Add()
     {
-        Assert_(count < array.Size());
-        const uint64 idx = count++;
-        new (&array[idx]) T;
-        return array[idx];
+        Assert_(count < capacity);
+        new (data + count) T;
+        return data[count++];
+    }
+
+    template<typename... Args> T& EmplaceBack(Args&&... args)
+    {
+        Assert_(count < capacity);
+        new (data + count) T(std::forward<Args>(args)...);
+        return data[count++];
     }
 
     void AddMultiple(T item, uint64 itemCount)
@@ -237,9 +450,8 @@ public:
         if(itemCount == 0)
             return;
 
-        Assert_(count + (itemCount - 1) < array.Size());
-        for(uint64 i = 0; i < itemCount; ++i)
-            array[i + count] = item;
+        Assert_(count + (itemCount - 1) < capacity);
+        Elements::ConstructCopies(data + count, itemCount, item);
         count += itemCount;
     }
 
@@ -248,74 +460,84 @@ public:
         if(itemCount == 0)
             return;
 
-        Assert_(count + (itemCount - 1) < array.Size());
-        for(uint64 i = 0; i < itemCount; ++i)
-            array[i + count] = items[i];
+        Assert_(count + (itemCount - 1) < capacity);
+        Elements::CopyConstruct(data + count, items, itemCount);
         count += itemCount;
     }
 
     void Insert(T item, uint64 idx)
     {
-        Assert_(count < array.Size());
+        Assert_(count < capacity);
         Assert_(idx <= count);
-        if(idx == count)
-        {
-            Add(item);
-            return;
-        }
 
-        for(int64 i = count; i > int64(idx); --i)
-            array[i] = array[i - 1];
-
-        array[idx] = item;
+        Elements::OpenGap(data, count, idx, 1);
+        new (data + idx) T(std::move(item));
         ++count;
     }
 
     void Remove(uint64 idx)
     {
-        Assert_(idx < count);
-        for(uint64 i = idx; i < count - 1; ++i)
-            array[i] = array[i + 1];
-        --count;
+        RemoveMultiple(idx, 1);
     }
 
     void Remove(uint64 idx, T fillValue)
     {
         Remove(idx);
-        array[count] = fillValue;
     }
 
     void RemoveMultiple(uint64 idx, uint64 numItems)
     {
         Assert_(idx < count);
         Assert_(idx + numItems <= count);
-        for(uint64 i = idx + numItems; i < count; ++i)
-            array[i - numItems] = array[i];
+        Elements::Destroy(data + idx, numItems);
+        Elements::CloseGap(data, count, idx, numItems);
         count -= numItems;
     }
 
     void RemoveAll()
     {
+        Elements::Destroy(data, count);
         count = 0;
     }
 
     void RemoveAll(T fillValue)
     {
-        uint64 oldCount = count;
         RemoveAll();
-        for(uint64 i = 0; i < oldCount; ++i)
-            array[i] = fillValue;
     }
 };
 
-template<typename T> class GrowableList
+template<typename T, typename Allocator = HeapAllocator> class GrowableList
 {
 
 protected:
 
-    Array<T> array;
+    typedef ContainerElements<T, Allocator> Elements;
+
+    T* data = nullptr;
+    uint64 capacity = 0;
     uint64 count = 0;
 
+    uint64 GrownCapacity(uint64 minCapacity) const
+    {
+        uint64 newSize = capacity;
+        if(newSize == 0)
+            newSize = 16;
+
+        while(minCapacity > newSize)
+            newSize *= 2;
+
+        return newSize;
+    }
+
+    void Reallocate(uint64 newCapacity)
+    {
+        T* newData = Elements::Allocate(newCapacity);
+        Elements::Relocate(newData, data, count);
+        Elements::Free(data);
+        data = newData;
+        capacity = newCapacity;
+    }
+
 public:
 
     GrowableList()
@@ -332,21 +554,75 @@ public:
         Init(initialMaxCount, initialCount, fillValue);
     }
 
+    GrowableList(const GrowableList& other)
+    {
+        *this = other;
+    }
+
+    GrowableList(GrowableList&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    ~GrowableList()
+    {
+        Shutdown();
+    }
+
+    GrowableList& operator=(const GrowableList& other)
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            data = Elements::Allocate(other.capacity);
+            Elements::CopyConstruct(data, other.data, other.count);
+            capacity = other.capacity;
+            count = other.count;
+        }
+        return *this;
+    }
+
+    GrowableList& operator=(GrowableList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            data = other.data;
+            capacity = other.capacity;
+            count = other.count;
+            other.data = nullptr;
+            other.capacity = 0;
+            other.count = 0;
+        }
+        return *this;
+    }
+
     void Init(uint64 initialMaxCount, uint64 initialCount = 0)
     {
-        array.Init(initialMaxCount);
+        Assert_(initialCount <= initialMaxCount);
+        Shutdown();
+        data = Elements::Allocate(initialMaxCount);
+        capacity = initialMaxCount;
+        Elements::Construct(data, initialCount);
         count = initialCount;
     }
 
     void Init(uint64 initialMaxCount, uint64 initialCount, T fillValue)
     {
-        Init(initialMaxCount, initialCount);
-        array.Fill(fillValue);
+        Assert_(initialCount <= initialMaxCount);
+        Shutdown();
+        data = Elements::Allocate(initialMaxCount);
+        capacity = initialMaxCount;
+        Elements::ConstructCopies(data, initialCount, fillValue);
+        count = initialCount;
     }
 
     void Shutdown()
     {
-        array.Shutdown();
+        Elements::Destroy(data, count);
+        Elements::Free(data);
+        data = nullptr;
+        capacity = 0;
         count = 0;
     }
 
@@ -357,60 +633,72 @@ public:
 
     uint64 CurrentMaxCount() const
     {
-        return array.Size();
+        return capacity;
     }
 
     const T& operator[](uint64 idx) const
     {
         Assert_(idx < count);
-        return array[idx];
+        return data[idx];
     }
 
     T& operator[](uint64 idx)
     {
         Assert_(idx < count);
-        return array[idx];
+        return data[idx];
     }
 
     const T* Data() const
     {
-        return array.Data();
+        return data;
     }
 
     T* Data()
     {
-        return array.Data();
+        return data;
     }
 
     void Fill(T value)
     {
         for(uint64 i = 0; i < count; ++i)
-            array[i] = value;
+            data[i] = value;
     }
 
     void Reserve(uint64 newMaxSize)
     {
-        if(newMaxSize <= array.Size())
+        if(newMaxSize <= capacity)
             return;
 
-        uint64 arraySize = array.Size();
-        if(arraySize == 0)
-            arraySize = 16;
-
-        while(newMaxSize > arraySize)
-            arraySize *= 2;
-
-        array.Resize(arraySize);
+        Reallocate(GrownCapacity(newMaxSize));
     }
 
     uint64 Add(T item)
     {
         Reserve(count + 1);
 
-        array[count] = item;
+        new (data + count) T(std::move(item));
         return count++;
     }
 
+    template<typename... Args> T& EmplaceBack(Args&&... args)
+    {
+        if(count < capacity)
+        {
+            new (data + count) T(std::forward<Args>(args)...);
+            return data[count++];
+        }
+
+        // Construct the new element before moving the old ones, in case the arguments refer to them
+        const uint64 newCapacity = GrownCapacity(count + 1);
+        T* newData = Elements::Allocate(newCapacity);
+        new (newData + count) T(std::forward<Args>(args)...);
+        Elements::Relocate(newData, data, count);
+        Elements::Free(data);
+        data = newData;
+        capacity = newCapacity;
+        return data[count++];
+    }
+
     void AddMultiple(T item, uint64 itemCount)
     {
         if(itemCount == 0)
@@ -418,8 +706,7 @@ public:
 
         Reserve(count + itemCount);
 
-        for(uint64 i = 0; i < itemCount; ++i)
-            array[i + count] = item;
+        Elements::ConstructCopies(data + count, itemCount, item);
         count += itemCount;
     }
 
@@ -430,64 +717,613 @@ public:
 
         Reserve(count + itemCount);
 
-        for(uint64 i = 0; i < itemCount; ++i)
-            array[i + count] = items[i];
+        Elements::CopyConstruct(data + count, items, itemCount);
         count += itemCount;
     }
 
     void Insert(T item, uint64 idx)
     {
         Assert_(idx <= count);
-        if(idx == count)
-        {
-            Add(item);
-            return;
-        }
 
         Reserve(count + 1);
 
-        for(int64 i = count; i > int64(idx); --i)
-            array[i] = array[i - 1];
-
-        array[idx] = item;
+        Elements::OpenGap(data, count, idx, 1);
+        new (data + idx) T(std::move(item));
         ++count;
     }
 
     void Remove(uint64 idx)
     {
-        Assert_(idx < count);
-        for (uint64 i = idx; i < count - 1; ++i)
-            array[i] = array[i + 1];
-        --count;
+        RemoveMultiple(idx, 1);
     }
 
     void Remove(uint64 idx, T fillValue)
     {
         Remove(idx);
-        array[count] = fillValue;
     }
 
     void RemoveMultiple(uint64 idx, uint64 numItems)
     {
         Assert_(idx < count);
         Assert_(idx + numItems <= count);
-        for (uint64 i = idx + numItems; i < count; ++i)
-            array[i - numItems] = array[i];
+        Elements::Destroy(data + idx, numItems);
+        Elements::CloseGap(data, count, idx, numItems);
         count -= numItems;
     }
 
     void RemoveAll()
     {
+        Elements::Destroy(data, count);
         count = 0;
     }
 
     void RemoveAll(T fillValue)
     {
-        uint64 oldCount = count;
         RemoveAll();
-        for (uint64 i = 0; i < oldCount; ++i)
-            array[i] = fillValue;
     }
 };
 
+// GrowableList with room for N elements inside of the list itself, so that lists that usually stay small
+// never touch the allocator. Once the list grows past N elements they get moved to allocated storage,
+// and stay there until Shutdown() is called.
+template<typename T, uint64 N, typename Allocator = HeapAllocator> class SmallList
+{
+    StaticAssert_(N > 0);
+
+protected:
+
+    typedef ContainerElements<T, Allocator> Elements;
+
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inlineStorage;
+    T* data = nullptr;
+    uint64 capacity = N;
+    uint64 count = 0;
+
+    T* InlineData()
+    {
+        return reinterpret_cast<T*>(&inlineStorage);
+    }
+
+    bool IsInline() const
+    {
+        return data == reinterpret_cast<const T*>(&inlineStorage);
+    }
+
+    uint64 GrownCapacity(uint64 minCapacity) const
+    {
+        uint64 newSize = capacity;
+        while(minCapacity > newSize)
+            newSize *= 2;
+
+        return newSize;
+    }
+
+    void Reallocate(uint64 newCapacity)
+    {
+        T* newData = Elements::Allocate(newCapacity);
+        Elements::Relocate(newData, data, count);
+        if(IsInline() == false)
+            Elements::Free(data);
+        data = newData;
+        capacity = newCapacity;
+    }
+
+public:
+
+    SmallList() : data(InlineData())
+    {
+    }
+
+    SmallList(const SmallList& other) : data(InlineData())
+    {
+        *this = other;
+    }
+
+    SmallList(SmallList&& other) noexcept : data(InlineData())
+    {
+        *this = std::move(other);
+    }
+
+    ~SmallList()
+    {
+        Shutdown();
+    }
+
+    SmallList& operator=(const SmallList& other)
+    {
+        if(this != &other)
+        {
+            RemoveAll();
+            Reserve(other.count);
+            Elements::CopyConstruct(data, other.data, other.count);
+            count = other.count;
+        }
+        return *this;
+    }
+
+    SmallList& operator=(SmallList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            if(other.IsInline())
+            {
+                // Inline elements can't be stolen, so move them over one at a time
+                Elements::Relocate(data, other.data, other.count);
+                count = other.count;
+                other.count = 0;
+            }
+            else
+            {
+                data = other.data;
+                capacity = other.capacity;
+                count = other.count;
+                other.data = other.InlineData();
+                other.capacity = N;
+                other.count = 0;
+            }
+        }
+        return *this;
+    }
+
+    void Shutdown()
+    {
+        Elements::Destroy(data, count);
+        if(IsInline() == false)
+            Elements::Free(data);
+        data = InlineData();
+        capacity = N;
+        count = 0;
+    }
+
+    uint64 Count() const
+    {
+        return count;
+    }
+
+    uint64 CurrentMaxCount() const
+    {
+        return capacity;
+    }
+
+    const T& operator[](uint64 idx) const
+    {
+        Assert_(idx < count);
+        return data[idx];
+    }
+
+    T& operator[](uint64 idx)
+    {
+        Assert_(idx < count);
+        return data[idx];
+    }
+
+    const T* Data() const
+    {
+        return data;
+    }
+
+    T* Data()
+    {
+        return data;
+    }
+
+    void Fill(T value)
+    {
+        for(uint64 i = 0; i < count; ++i)
+            data[i] = value;
+    }
+
+    void Reserve(uint64 newMaxSize)
+    {
+        if(newMaxSize <= capacity)
+            return;
+
+        Reallocate(GrownCapacity(newMaxSize));
+    }
+
+    uint64 Add(T item)
+    {
+        Reserve(count + 1);
+
+        new (data + count) T(std::move(item));
+        return count++;
+    }
+
+    template<typename... Args> T& EmplaceBack(Args&&... args)
+    {
+        if(count < capacity)
+        {
+            new (data + count) T(std::forward<Args>(args)...);
+            return data[count++];
+        }
+
+        // Construct the new element before moving the old ones, in case the arguments refer to them
+        const uint64 newCapacity = GrownCapacity(count + 1);
+        T* newData = Elements::Allocate(newCapacity);
+        new (newData + count) T(std::forward<Args>(args)...);
+        Elements::Relocate(newData, data, count);
+        if(IsInline() == false)
+            Elements::Free(data);
+        data = newData;
+        capacity = newCapacity;
+        return data[count++];
+    }
+
+    void AddMultiple(T item, uint64 itemCount)
+    {
+        if(itemCount == 0)
+            return;
+
+        Reserve(count + itemCount);
+
+        Elements::ConstructCopies(data + count, itemCount, item);
+        count += itemCount;
+    }
+
+    void Append(const T* items, uint64 itemCount)
+    {
+        if(itemCount == 0)
+            return;
+
+        Reserve(count + itemCount);
+
+        Elements::CopyConstruct(data + count, items, itemCount);
+        count += itemCount;
+    }
+
+    void Insert(T item, uint64 idx)
+    {
+        Assert_(idx <= count);
+
+        Reserve(count + 1);
+
+        Elements::OpenGap(data, count, idx, 1);
+        new (data + idx) T(std::move(item));
+        ++count;
+    }
+
+    void Remove(uint64 idx)
+    {
+        RemoveMultiple(idx, 1);
+    }
+
+    void RemoveMultiple(uint64 idx, uint64 numItems)
+    {
+        Assert_(idx < count);
+        Assert_(idx + numItems <= count);
+        Elements::Destroy(data + idx, numItems);
+        Elements::CloseGap(data, count, idx, numItems);
+        count -= numItems;
+    }
+
+    void RemoveAll()
+    {
+        Elements::Destroy(data, count);
+        count = 0;
+    }
+};
+
+// Hash functions used by HashMap. Integers, enums and pointers get run through the MurmurHash3 finalizer,
+// strings go through the full MurmurHash. Specialize this for other key types.
+template<typename K> struct HashMapHasher
+{
+    static uint64 HashKey(const K& key)
+    {
+        uint64 h = uint64(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+template<typename K> struct HashMapHasher<K*>
+{
+    static uint64 HashKey(K* key)
+    {
+        return HashMapHasher<uint64>::HashKey(reinterpret_cast<uint64>(key));
+    }
+};
+
+template<> struct HashMapHasher<std::string>
+{
+    static uint64 HashKey(const std::string& key)
+    {
+        return GenerateHash(key.data(), int(key.length())).A;
+    }
+};
+
+template<> struct HashMapHasher<std::wstring>
+{
+    static uint64 HashKey(const std::wstring& key)
+    {
+        return GenerateHash(key.data(), int(key.length() * sizeof(wchar))).A;
+    }
+};
+
+// Hash keys are already well mixed
+template<> struct HashMapHasher<Hash>
+{
+    static uint64 HashKey(const Hash& key)
+    {
+        return key.A;
+    }
+};
+
+// Open-addressing hash map using Robin Hood hashing with linear probing. Entries live in one flat array,
+// with a parallel array of bytes holding how far each entry is from its ideal slot (0 for empty slots).
+// Lookups only touch the byte array until they reach a slot with a matching distance, and stop as soon
+// as they hit a slot that's closer to its ideal position than the key would be. Removals shift the
+// following entries back instead of leaving tombstones. Pointers returned by Find() are only valid
+// until the next Insert() or Remove().
+template<typename K, typename V, typename Hasher = HashMapHasher<K>, typename Allocator = HeapAllocator> class HashMap
+{
+
+public:
+
+    struct Entry
+    {
+        K Key;
+        V Value;
+
+        Entry(K&& key, V&& value) : Key(std::move(key)), Value(std::move(value))
+        {
+        }
+    };
+
+protected:
+
+    typedef ContainerElements<Entry, Allocator> Elements;
+    typedef ContainerElements<uint8, Allocator> DistanceElements;
+
+    static const uint64 InvalidIdx = uint64(-1);
+    static const uint64 MinCapacity = 16;
+    static const uint32 MaxDistance = 255;
+
+    Entry* entries = nullptr;
+    uint8* distances = nullptr;
+    uint64 capacity = 0;
+    uint64 count = 0;
+
+    uint64 FindIndex(const K& key) const
+    {
+        if(count == 0)
+            return InvalidIdx;
+
+        const uint64 mask = capacity - 1;
+        uint64 idx = Hasher::HashKey(key) & mask;
+        for(uint32 dist = 1; dist <= distances[idx]; ++dist)
+        {
+            if(distances[idx] == dist && entries[idx].Key == key)
+                return idx;
+            idx = (idx + 1) & mask;
+        }
+
+        return InvalidIdx;
+    }
+
+    // Adds a key that isn't in the map yet, bumping any entries that are closer to their ideal slot
+    void InsertNew(K&& key, V&& value)
+    {
+        const uint64 mask = capacity - 1;
+        uint64 idx = Hasher::HashKey(key) & mask;
+        uint32 dist = 1;
+        while(true)
+        {
+            if(distances[idx] == 0)
+            {
+                new (entries + idx) Entry(std::move(key), std::move(value));
+                distances[idx] = uint8(dist);
+                ++count;
+                return;
+            }
+
+            if(distances[idx] < dist)
+            {
+                std::swap(key, entries[idx].Key);
+                std::swap(value, entries[idx].Value);
+                const uint32 prevDist = distances[idx];
+                distances[idx] = uint8(dist);
+                dist = prevDist;
+            }
+
+            idx = (idx + 1) & mask;
+            ++dist;
+
+            if(dist > MaxDistance)
+            {
+                // The probe distance doesn't fit in a byte anymore, so spread things out
+                Rehash(capacity * 2);
+                InsertNew(std::move(key), std::move(value));
+                return;
+            }
+        }
+    }
+
+    void Rehash(uint64 newCapacity)
+    {
+        Entry* oldEntries = entries;
+        uint8* oldDistances = distances;
+        const uint64 oldCapacity = capacity;
+
+        entries = Elements::Allocate(newCapacity);
+        distances = DistanceElements::Allocate(newCapacity);
+        memset(distances, 0, newCapacity);
+        capacity = newCapacity;
+        count = 0;
+
+        for(uint64 i = 0; i < oldCapacity; ++i)
+        {
+            if(oldDistances[i] == 0)
+                continue;
+
+            InsertNew(std::move(oldEntries[i].Key), std::move(oldEntries[i].Value));
+            oldEntries[i].~Entry();
+        }
+
+        Elements::Free(oldEntries);
+        DistanceElements::Free(oldDistances);
+    }
+
+    static uint64 CapacityForCount(uint64 numEntries)
+    {
+        // Keep the load factor at or below 7/8
+        uint64 newCapacity = MinCapacity;
+        while(numEntries * 8 > newCapacity * 7)
+            newCapacity *= 2;
+        return newCapacity;
+    }
+
+public:
+
+    HashMap()
+    {
+    }
+
+    explicit HashMap(uint64 initialCount)
+    {
+        Reserve(initialCount);
+    }
+
+    HashMap(HashMap&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    ~HashMap()
+    {
+        Shutdown();
+    }
+
+    HashMap& operator=(HashMap&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Shutdown();
+            entries = other.entries;
+            distances = other.distances;
+            capacity = other.capacity;
+            count = other.count;
+            other.entries = nullptr;
+            other.distances = nullptr;
+            other.capacity = 0;
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    void Shutdown()
+    {
+        RemoveAll();
+        Elements::Free(entries);
+        DistanceElements::Free(distances);
+        entries = nullptr;
+        distances = nullptr;
+        capacity = 0;
+    }
+
+    uint64 Count() const
+    {
+        return count;
+    }
+
+    uint64 Capacity() const
+    {
+        return capacity;
+    }
+
+    void Reserve(uint64 numEntries)
+    {
+        const uint64 newCapacity = CapacityForCount(numEntries);
+        if(newCapacity > capacity)
+            Rehash(newCapacity);
+    }
+
+    const V* Find(const K& key) const
+    {
+        const uint64 idx = FindIndex(key);
+        return idx != InvalidIdx ? &entries[idx].Value : nullptr;
+    }
+
+    V* Find(const K& key)
+    {
+        const uint64 idx = FindIndex(key);
+        return idx != InvalidIdx ? &entries[idx].Value : nullptr;
+    }
+
+    bool Contains(const K& key) const
+    {
+        return FindIndex(key) != InvalidIdx;
+    }
+
+    // Adds the key, or replaces the value if the key is already in the map
+    void Insert(K key, V value)
+    {
+        const uint64 idx = FindIndex(key);
+        if(idx != InvalidIdx)
+        {
+            entries[idx].Value = std::move(value);
+            return;
+        }
+
+        if((count + 1) * 8 > capacity * 7)
+            Rehash(CapacityForCount(count + 1));
+
+        InsertNew(std::move(key), std::move(value));
+    }
+
+    bool Remove(const K& key)
+    {
+        uint64 idx = FindIndex(key);
+        if(idx == InvalidIdx)
+            return false;
+
+        entries[idx].~Entry();
+
+        // Shift back everything after it that isn't already in its ideal slot
+        const uint64 mask = capacity - 1;
+        uint64 nextIdx = (idx + 1) & mask;
+        while(distances[nextIdx] > 1)
+        {
+            Elements::Relocate(entries + idx, entries + nextIdx, 1);
+            distances[idx] = distances[nextIdx] - 1;
+            idx = nextIdx;
+            nextIdx = (nextIdx + 1) & mask;
+        }
+
+        distances[idx] = 0;
+        --count;
+        return true;
+    }
+
+    void RemoveAll()
+    {
+        for(uint64 i = 0; i < capacity; ++i)
+        {
+            if(distances[i] != 0)
+            {
+                entries[i].~Entry();
+                distances[i] = 0;
+            }
+        }
+        count = 0;
+    }
+
+    // Calls func(key, value) for every entry, in no particular order
+    template<typename Func> void ForEach(Func func) const
+    {
+        for(uint64 i = 0; i < capacity; ++i)
+            if(distances[i] != 0)
+                func(entries[i].Key, entries[i].Value);
+    }
+
+private:
+
+    HashMap(const HashMap& other);
+    HashMap& operator=(const HashMap& other);
+};
+
 }
\ No newline at end of file
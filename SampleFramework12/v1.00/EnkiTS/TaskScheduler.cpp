@@ -19,16 +19,22 @@
 #include "PCH.h"
 
 #include <assert.h>
+#include <vector>
+#include <algorithm>
 
 #include "TaskScheduler.h"
 #include "LockLessMultiReadPipe.h"
+#include "WorkStealingDeque.h"
+
+// WaitOnAddress and WakeByAddress*
+#pragma comment(lib, "Synchronization.lib")
 
 
 using namespace enki;
 
 
 static const uint32_t PIPESIZE_LOG2 = 8;
-static const uint32_t SPIN_COUNT = 100;
+static const uint32_t DEFAULT_SPIN_COUNT = 100;
 
 // thread_local not well supported yet by C++11 compilers.
 #ifdef _MSC_VER
@@ -45,6 +51,23 @@ static const uint32_t SPIN_COUNT = 100;
 static const uint32_t									 NO_THREAD_NUM = 0xFFFFFFFF;
 static thread_local uint32_t                             gtl_threadNum = NO_THREAD_NUM;
 static thread_local enki::TaskScheduler*                 gtl_pCurrTS   = NULL;
+static thread_local uint32_t                             gtl_randomState = 0;
+
+// xorshift32, used to pick victims for work stealing. Each thread has its own state so
+// threads don't contend for it, and start from different seeds so they don't all pick the same victim.
+static uint32_t NextRandom()
+{
+	uint32_t x = gtl_randomState;
+	if( 0 == x )
+	{
+		x = ( gtl_threadNum * 0x9E3779B9 ) | 1;
+	}
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	gtl_randomState = x;
+	return x;
+}
 
 
 namespace enki 
@@ -57,11 +80,14 @@ namespace enki
 
 	// we derive class TaskPipe rather than typedef to get forward declaration working easily
 	class TaskPipe : public LockLessMultiReadPipe<PIPESIZE_LOG2,enki::SubTaskSet> {};
+	class TaskDeque : public WorkStealingDeque<PIPESIZE_LOG2,enki::SubTaskSet> {};
 
 	struct ThreadArgs
 	{
 		uint32_t		threadNum;
 		TaskScheduler*  pTaskScheduler;
+		bool			bSetAffinity;
+		GROUP_AFFINITY	affinity;
 	};
 
 	class ThreadNum
@@ -157,6 +183,10 @@ void TaskScheduler::TaskingThreadFunction( const ThreadArgs& args_ )
     
     uint32_t threadNum				= args_.threadNum;
 	TaskScheduler*  pTS				= args_.pTaskScheduler;
+	if( args_.bSetAffinity )
+	{
+		SetThreadGroupAffinity( GetCurrentThread(), &args_.affinity, NULL );
+	}
     gtl_threadNum					= threadNum;
 	gtl_pCurrTS						= pTS;
 	pTS->m_NumThreadsRunning.fetch_add(1, std::memory_order_relaxed );
@@ -169,9 +199,14 @@ void TaskScheduler::TaskingThreadFunction( const ThreadArgs& args_ )
 		{
 			// no tasks, will spin then wait
 			++spinCount;
-			if( spinCount > SPIN_COUNT )
+			if( spinCount > pTS->m_SpinCount.load( std::memory_order_relaxed ) )
 			{
 				pTS->WaitForTasks<false>( threadNum );
+				spinCount = 0;
+			}
+			else
+			{
+				YieldProcessor();
 			}
 		}
 		else
@@ -187,10 +222,118 @@ void TaskScheduler::TaskingThreadFunction( const ThreadArgs& args_ )
 }
 
 
+// Returns the affinity mask of every physical core, ordered for the given affinity mode
+static void GetOrderedCores( ThreadAffinityMode mode_, std::vector<GROUP_AFFINITY>& cores_out_ )
+{
+	DWORD size = 0;
+	GetLogicalProcessorInformationEx( RelationAll, NULL, &size );
+	if( GetLastError() != ERROR_INSUFFICIENT_BUFFER )
+	{
+		return;
+	}
+	std::vector<uint8_t> buffer( size );
+	if( !GetLogicalProcessorInformationEx( RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer.data(), &size ) )
+	{
+		return;
+	}
+
+	std::vector<GROUP_AFFINITY> coreMasks;
+	std::vector<GROUP_AFFINITY> cacheMasks;
+	std::vector<GROUP_AFFINITY> numaMasks;
+	for( DWORD offset = 0; offset < size; )
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* pInfo = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)( buffer.data() + offset );
+		if( RelationProcessorCore == pInfo->Relationship )
+		{
+			// a core can't span processor groups
+			coreMasks.push_back( pInfo->Processor.GroupMask[0] );
+		}
+		else if( RelationCache == pInfo->Relationship && 3 == pInfo->Cache.Level )
+		{
+			cacheMasks.push_back( pInfo->Cache.GroupMask );
+		}
+		else if( RelationNumaNode == pInfo->Relationship )
+		{
+			numaMasks.push_back( pInfo->NumaNode.GroupMask );
+		}
+		offset += pInfo->Size;
+	}
+
+	struct OrderedCore
+	{
+		uint32_t		numaNode;
+		uint32_t		cache;
+		uint32_t		cacheInNode;	// index of the L3 cache within its NUMA node
+		uint32_t		coreInCache;	// index of the core within its L3 cache
+		uint32_t		index;
+	};
+
+	std::vector<OrderedCore> ordered( coreMasks.size() );
+	std::vector<uint32_t> numCoresPerCache( cacheMasks.size() + 1, 0 );
+	std::vector<uint32_t> numCachesPerNode( numaMasks.size() + 1, 0 );
+	std::vector<uint32_t> cacheInNode( cacheMasks.size() + 1, 0xFFFFFFFF );
+	for( uint32_t core = 0; core < coreMasks.size(); ++core )
+	{
+		// machines without an L3 or NUMA information get put in one extra cache/node at the end
+		const GROUP_AFFINITY& coreMask = coreMasks[ core ];
+		uint32_t cache = 0;
+		while( cache < cacheMasks.size() && ( cacheMasks[ cache ].Group != coreMask.Group || 0 == ( cacheMasks[ cache ].Mask & coreMask.Mask ) ) )
+		{
+			++cache;
+		}
+		uint32_t numaNode = 0;
+		while( numaNode < numaMasks.size() && ( numaMasks[ numaNode ].Group != coreMask.Group || 0 == ( numaMasks[ numaNode ].Mask & coreMask.Mask ) ) )
+		{
+			++numaNode;
+		}
+		if( 0xFFFFFFFF == cacheInNode[ cache ] )
+		{
+			cacheInNode[ cache ] = numCachesPerNode[ numaNode ]++;
+		}
+
+		ordered[ core ].numaNode    = numaNode;
+		ordered[ core ].cache       = cache;
+		ordered[ core ].cacheInNode = cacheInNode[ cache ];
+		ordered[ core ].coreInCache = numCoresPerCache[ cache ]++;
+		ordered[ core ].index       = core;
+	}
+
+	if( THREAD_AFFINITY_SPREAD == mode_ )
+	{
+		// take one core from each NUMA node in turn, then from each L3 within the nodes
+		std::stable_sort( ordered.begin(), ordered.end(), []( const OrderedCore& a, const OrderedCore& b )
+		{
+			if( a.coreInCache != b.coreInCache ) { return a.coreInCache < b.coreInCache; }
+			if( a.cacheInNode != b.cacheInNode ) { return a.cacheInNode < b.cacheInNode; }
+			return a.numaNode < b.numaNode;
+		} );
+	}
+	else
+	{
+		std::stable_sort( ordered.begin(), ordered.end(), []( const OrderedCore& a, const OrderedCore& b )
+		{
+			if( a.numaNode != b.numaNode ) { return a.numaNode < b.numaNode; }
+			return a.cache < b.cache;
+		} );
+	}
+
+	cores_out_.clear();
+	for( uint32_t core = 0; core < ordered.size(); ++core )
+	{
+		cores_out_.push_back( coreMasks[ ordered[ core ].index ] );
+	}
+}
+
 void TaskScheduler::StartThreads()
 {
     m_bRunning = true;
 
+	std::vector<GROUP_AFFINITY> cores;
+	if( THREAD_AFFINITY_NONE != m_ThreadAffinityMode )
+	{
+		GetOrderedCores( m_ThreadAffinityMode, cores );
+	}
+
     // m_NumEnkiThreads stores the number of internal threads required.
 	if( m_NumEnkiThreads )
 	{
@@ -198,8 +341,16 @@ void TaskScheduler::StartThreads()
 		m_pThreads      = new std::thread*[m_NumEnkiThreads];
 		for( uint32_t thread = 0; thread < m_NumEnkiThreads; ++thread )
 		{
+			// the first core is left for the thread calling Initialize. There are usually more threads
+			// than physical cores, and the ones that don't get a core to themselves are left unpinned
+			// rather than sharing one with another pinned thread.
 			m_pThreadArgStore[thread].threadNum      = thread;
 			m_pThreadArgStore[thread].pTaskScheduler = this;
+			m_pThreadArgStore[thread].bSetAffinity   = thread + 1 < cores.size();
+			if( m_pThreadArgStore[thread].bSetAffinity )
+			{
+				m_pThreadArgStore[thread].affinity = cores[ thread + 1 ];
+			}
 			m_pThreads[thread] = new std::thread( TaskingThreadFunction, m_pThreadArgStore[thread] );
 		}
 	}
@@ -222,18 +373,16 @@ void TaskScheduler::Cleanup( bool bWait_ )
     // wait for them threads quit before deleting data
 	if( m_bRunning )
 	{
-		{
-			std::unique_lock<std::mutex> lk( m_NewTaskEventMutex );
-			m_bRunning = false;
-			m_bUserThreadsCanRun = false;
-		}
+		m_bRunning = false;
+		m_bUserThreadsCanRun = false;
+		WakeAllThreads();
 		while( bWait_ && m_NumThreadsRunning )
 		{
-			// keep firing event to ensure all threads pick up state of m_bRunning
-           m_NewTaskEvent.notify_all();
-        }
+			// keep waking threads to ensure all of them pick up state of m_bRunning
+			WakeAllThreads();
+		}
 
-		for( uint32_t thread = 1; thread < m_NumEnkiThreads; ++thread )
+		for( uint32_t thread = 0; thread < m_NumEnkiThreads; ++thread )
 		{
 			m_pThreads[thread]->detach();
 			delete m_pThreads[thread];
@@ -250,8 +399,14 @@ void TaskScheduler::Cleanup( bool bWait_ )
 		m_NumThreadsRunning = 0;
 		m_UserThreadStackIndex = 0;
 
-		delete[] m_pPipesPerThread;
-		m_pPipesPerThread = 0;
+		for( uint32_t priority = 0; priority < TASK_PRIORITY_NUM; ++priority )
+		{
+			delete[] m_pPipesPerThread[ priority ];
+			m_pPipesPerThread[ priority ] = 0;
+
+			delete[] m_pDequesPerThread[ priority ];
+			m_pDequesPerThread[ priority ] = 0;
+		}
 
 		delete[] m_pUserThreadNumStack;
 		m_pUserThreadNumStack = 0;
@@ -266,9 +421,34 @@ bool TaskScheduler::TryRunTask( uint32_t threadNum, uint32_t& hintPipeToCheck_io
 		return false;
 	}
 
-    // check for tasks
+	uint32_t numPriorities = GetNumPrioritiesForThread( threadNum );
+	for( uint32_t priority = 0; priority < numPriorities; ++priority )
+	{
+		if( TryRunTask( threadNum, priority, hintPipeToCheck_io_ ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TaskScheduler::TryRunTask( uint32_t threadNum, uint32_t priority, uint32_t& hintPipeToCheck_io_ )
+{
     SubTaskSet subTask;
-    bool bHaveTask = m_pPipesPerThread[ threadNum ].WriterTryReadFront( &subTask );
+	if( SCHEDULING_MODE_WORK_STEALING == m_SchedulingMode )
+	{
+		bool bHaveTask = m_pDequesPerThread[ priority ][ threadNum ].OwnerTryPopBottom( &subTask )
+					  || TryStealTask( threadNum, priority, &subTask );
+		if( bHaveTask )
+		{
+			SplitAndRunTask( threadNum, subTask );
+		}
+		return bHaveTask;
+	}
+
+    // check for tasks
+    TaskPipe* pPipes = m_pPipesPerThread[ priority ];
+    bool bHaveTask = pPipes[ threadNum ].WriterTryReadFront( &subTask );
 
 	uint32_t threadToCheck = hintPipeToCheck_io_;
 	uint32_t checkCount = 0;
@@ -277,7 +457,7 @@ bool TaskScheduler::TryRunTask( uint32_t threadNum, uint32_t& hintPipeToCheck_io
 		threadToCheck = ( hintPipeToCheck_io_ + checkCount ) % m_NumThreads;
 		if( threadToCheck != threadNum )
 		{
-			bHaveTask = m_pPipesPerThread[ threadToCheck ].ReaderTryReadBack( &subTask );
+			bHaveTask = pPipes[ threadToCheck ].ReaderTryReadBack( &subTask );
 		}
 		++checkCount;
     }
@@ -289,37 +469,189 @@ bool TaskScheduler::TryRunTask( uint32_t threadNum, uint32_t& hintPipeToCheck_io
 
         // the task has already been divided up by AddTaskSetToPipe, so just run it
         subTask.pTask->ExecuteRange( subTask.partition, threadNum );
-        subTask.pTask->m_RunningCount.fetch_sub(1,std::memory_order_relaxed );
+        ReleaseRunningCount( subTask.pTask, 1 );
     }
 
     return bHaveTask;
 }
 
-template<bool ISUSERTASK>
-void TaskScheduler::WaitForTasks( uint32_t threadNum )
+bool TaskScheduler::TryStealTask( uint32_t threadNum, uint32_t priority, SubTaskSet* pSubTask )
 {
-	bool bHaveTasks = false;
-	for( uint32_t thread = 0; thread < m_NumThreads; ++thread )
+	// start at a random victim, so that thieves spread out rather than all hitting the same deque
+	TaskDeque* pDeques = m_pDequesPerThread[ priority ];
+	uint32_t firstVictim = NextRandom() % m_NumThreads;
+	for( uint32_t checkCount = 0; checkCount < m_NumThreads; ++checkCount )
 	{
-		if( !m_pPipesPerThread[ thread ].IsPipeEmpty() )
+		uint32_t victim = ( firstVictim + checkCount ) % m_NumThreads;
+		if( victim != threadNum && pDeques[ victim ].ThiefTryStealTop( pSubTask ) )
 		{
-			bHaveTasks = true;
-			break;
+			return true;
 		}
 	}
-	if( !bHaveTasks )
+	return false;
+}
+
+void TaskScheduler::SplitAndRunTask( uint32_t threadNum, SubTaskSet subTask )
+{
+	// Lazy binary splitting: whenever our deque is empty, nobody can steal from us, so we give
+	// away the upper half of the range. Otherwise we keep running the range in small pieces,
+	// so that a thief taking our last half causes it to be split again.
+	ITaskSet* pTask = subTask.pTask;
+	uint32_t rangeToRun = pTask->m_SetSize / m_NumPartitions;
+	if( rangeToRun < pTask->m_MinRange ) { rangeToRun = pTask->m_MinRange; }
+	if( rangeToRun == 0 ) { rangeToRun = 1; }
+
+	TaskDeque& deque = m_pDequesPerThread[ pTask->m_Priority ][ threadNum ];
+	while( subTask.partition.end - subTask.partition.start > rangeToRun )
 	{
-		std::unique_lock<std::mutex> lk( m_NewTaskEventMutex );
+		if( deque.IsDequeEmpty() )
+		{
+			SubTaskSet upperHalf = subTask;
+			upperHalf.partition.start = subTask.partition.start + ( subTask.partition.end - subTask.partition.start ) / 2;
+			subTask.partition.end = upperHalf.partition.start;
+
+			// count the new partition before it can be stolen and completed
+			pTask->m_RunningCount.fetch_add( 1, std::memory_order_relaxed );
+			deque.OwnerPushBottom( upperHalf );
+			WakeThreadsForNewTasks( 1, pTask->m_Priority );
+		}
+		else
+		{
+			if( TASK_PRIORITY_HIGH != pTask->m_Priority )
+			{
+				// don't make high priority work wait for the whole of a large low priority set
+				uint32_t hintPipeToCheck_io = threadNum + 1;
+				while( TryRunTask( threadNum, TASK_PRIORITY_HIGH, hintPipeToCheck_io ) ) {}
+			}
 
-		// check potential event variables after lock held
-		if( !m_bRunning || ( ISUSERTASK && !m_bUserThreadsCanRun ) )
+			TaskSetPartition partition;
+			partition.start = subTask.partition.start;
+			partition.end = subTask.partition.start + rangeToRun;
+			subTask.partition.start = partition.end;
+			pTask->ExecuteRange( partition, threadNum );
+		}
+	}
+
+	pTask->ExecuteRange( subTask.partition, threadNum );
+	ReleaseRunningCount( pTask, 1 );
+}
+
+uint32_t TaskScheduler::GetNumPrioritiesForThread( uint32_t threadNum ) const
+{
+	// the high priority only threads are the first enkiTS threads
+	bool bHighPriorityOnly = threadNum < m_NumHighPriorityOnlyThreads && threadNum < m_NumEnkiThreads;
+	return bHighPriorityOnly ? TASK_PRIORITY_HIGH + 1 : TASK_PRIORITY_NUM;
+}
+
+bool TaskScheduler::HaveTasks( uint32_t numPriorities ) const
+{
+	for( uint32_t priority = 0; priority < numPriorities; ++priority )
+	{
+		for( uint32_t thread = 0; thread < m_NumThreads; ++thread )
 		{
-			return;
+			bool bEmpty = SCHEDULING_MODE_WORK_STEALING == m_SchedulingMode ? m_pDequesPerThread[ priority ][ thread ].IsDequeEmpty()
+																			 : m_pPipesPerThread[ priority ][ thread ].IsPipeEmpty();
+			if( !bEmpty )
+			{
+				return true;
+			}
 		}
-		++m_NumThreadsWaiting;
-		m_NewTaskEvent.wait( lk );
-		--m_NumThreadsWaiting;
 	}
+	return false;
+}
+
+void TaskScheduler::ReleaseRunningCount( ITaskSet* pTaskSet, int32_t count )
+{
+	// the task set may be deleted as soon as it's complete, so read the list of dependents first.
+	// The list itself lives in the dependent task sets, which can't be complete yet.
+	Dependency* pDependent = pTaskSet->m_pDependents;
+	if( count != pTaskSet->m_RunningCount.fetch_sub( count, std::memory_order_acq_rel ) )
+	{
+		return;
+	}
+
+	while( pDependent )
+	{
+		ITaskSet* pTaskToRun = pDependent->pTaskToRunOnCompletion;
+		pDependent = pDependent->pNext;
+
+		int32_t completed = pTaskToRun->m_DependenciesCompletedCount.fetch_add( 1, std::memory_order_acq_rel ) + 1;
+		if( completed == pTaskToRun->m_DependenciesCount )
+		{
+			// all predecessors are done, so nothing else can touch the count until the next run
+			pTaskToRun->m_DependenciesCompletedCount.store( 0, std::memory_order_relaxed );
+			AddTaskSetToPipe( pTaskToRun );
+		}
+	}
+}
+
+void TaskScheduler::MarkDependentsIncomplete( ITaskSet* pTaskSet )
+{
+	for( Dependency* pDependent = pTaskSet->m_pDependents; pDependent; pDependent = pDependent->pNext )
+	{
+		pDependent->pTaskToRunOnCompletion->m_RunningCount.store( 1, std::memory_order_relaxed );
+		MarkDependentsIncomplete( pDependent->pTaskToRunOnCompletion );
+	}
+}
+
+void TaskScheduler::WakeThreadsForNewTasks( uint32_t numNewTasks, uint32_t priority )
+{
+	if( 0 == numNewTasks )
+	{
+		return;
+	}
+
+	// Bumping the epoch after adding the tasks means a thread which is about to park either sees the
+	// tasks, or sees the epoch change and doesn't park. Both are seq_cst so that if we don't see a
+	// thread as waiting, it's guaranteed to see the new epoch.
+	m_TaskEpoch.fetch_add( 1, std::memory_order_seq_cst );
+	uint32_t numWaiting = (uint32_t)m_NumThreadsWaiting.load( std::memory_order_seq_cst );
+	if( 0 == numWaiting )
+	{
+		return;
+	}
+
+	// wake one thread per task. High priority only threads can't run low priority tasks, so if
+	// some of them are woken up instead we need enough extra wakes to reach the other threads.
+	uint32_t numToWake = numNewTasks;
+	if( TASK_PRIORITY_HIGH != priority )
+	{
+		numToWake += m_NumHighPriorityOnlyThreads;
+	}
+	if( numToWake >= numWaiting )
+	{
+		WakeByAddressAll( (void*)&m_TaskEpoch );
+	}
+	else
+	{
+		for( uint32_t i = 0; i < numToWake; ++i )
+		{
+			WakeByAddressSingle( (void*)&m_TaskEpoch );
+		}
+	}
+}
+
+void TaskScheduler::WakeAllThreads()
+{
+	m_TaskEpoch.fetch_add( 1, std::memory_order_seq_cst );
+	WakeByAddressAll( (void*)&m_TaskEpoch );
+}
+
+template<bool ISUSERTASK>
+void TaskScheduler::WaitForTasks( uint32_t threadNum )
+{
+	// register as waiting before reading the epoch, see WakeThreadsForNewTasks
+	m_NumThreadsWaiting.fetch_add( 1, std::memory_order_seq_cst );
+	uint32_t epoch = m_TaskEpoch.load( std::memory_order_seq_cst );
+
+	if( m_bRunning && !( ISUSERTASK && !m_bUserThreadsCanRun ) && !HaveTasks( GetNumPrioritiesForThread( threadNum ) ) )
+	{
+		// returns straight away if the epoch has already changed. std::atomic<uint32_t> has the
+		// same layout as a uint32_t, so we can park on it directly.
+		WaitOnAddress( (volatile void*)&m_TaskEpoch, &epoch, sizeof( epoch ), INFINITE );
+	}
+
+	m_NumThreadsWaiting.fetch_sub( 1, std::memory_order_relaxed );
 }
 
 void    TaskScheduler::AddTaskSetToPipe( ITaskSet* pTaskSet )
@@ -331,17 +663,34 @@ void    TaskScheduler::AddTaskSetToPipe( ITaskSet* pTaskSet )
 
     // set completion to -1 to guarantee it won't be found complete until all subtasks added
     pTaskSet->m_RunningCount.store( -1, std::memory_order_relaxed );
+	if( 0 == pTaskSet->m_DependenciesCount )
+	{
+		// only needed for the root of a graph, as dependents can't start until their predecessors complete
+		MarkDependentsIncomplete( pTaskSet );
+	}
     ThreadNum threadNum( this );
 	if( threadNum.m_ThreadNum == NO_THREAD_NUM )
 	{
 		// just run in this thread
         pTaskSet->ExecuteRange( subTask.partition, threadNum.m_ThreadNum );
-        pTaskSet->m_RunningCount.store( 0, std::memory_order_relaxed );
+        ReleaseRunningCount( pTaskSet, -1 );
         return;
 	}
 
+	if( SCHEDULING_MODE_WORK_STEALING == m_SchedulingMode )
+	{
+		// add the whole set, it's split up as threads run and steal it. The count starts at 1 rather
+		// than -1 as splitting can add partitions before we'd have had a chance to fix it up.
+		TaskPriority priority = pTaskSet->m_Priority;
+		pTaskSet->m_RunningCount.store( 1, std::memory_order_relaxed );
+		m_pDequesPerThread[ priority ][ threadNum.m_ThreadNum ].OwnerPushBottom( subTask );
+		WakeThreadsForNewTasks( 1, priority );
+		return;
+	}
+
     // divide task up and add to pipe
     uint32_t rangeToRun = subTask.pTask->m_SetSize / m_NumPartitions;
+    if( rangeToRun < subTask.pTask->m_MinRange ) { rangeToRun = subTask.pTask->m_MinRange; }
     if( rangeToRun == 0 ) { rangeToRun = 1; }
     uint32_t rangeLeft = subTask.partition.end - subTask.partition.start ;
     int32_t numAdded = 0;
@@ -357,7 +706,7 @@ void    TaskScheduler::AddTaskSetToPipe( ITaskSet* pTaskSet )
 
         // add the partition to the pipe
         ++numAdded;
-        if( !m_pPipesPerThread[ gtl_threadNum ].WriterTryWriteFront( subTask ) )
+        if( !m_pPipesPerThread[ pTaskSet->m_Priority ][ gtl_threadNum ].WriterTryWriteFront( subTask ) )
         {
             subTask.pTask->ExecuteRange( subTask.partition, gtl_threadNum );
             --numAdded;
@@ -365,11 +714,60 @@ void    TaskScheduler::AddTaskSetToPipe( ITaskSet* pTaskSet )
     }
 
     // increment completion count by number added plus one to account for start value
-    pTaskSet->m_RunningCount.fetch_add( numAdded + 1, std::memory_order_relaxed );
+    TaskPriority priority = pTaskSet->m_Priority;
+    ReleaseRunningCount( pTaskSet, -( numAdded + 1 ) );
 
-    if( m_NumThreadsWaiting.load( std::memory_order_relaxed )  )
-    {
-		m_NewTaskEvent.notify_all();
+    WakeThreadsForNewTasks( numAdded, priority );
+}
+
+void ITaskSet::SetDependency( Dependency& dependency_, ITaskSet* pDependencyTask_ )
+{
+	assert( pDependencyTask_ != this );
+	assert( GetIsComplete() && pDependencyTask_->GetIsComplete() );
+
+	ClearDependency( dependency_ );
+	dependency_.pDependencyTask = pDependencyTask_;
+	dependency_.pTaskToRunOnCompletion = this;
+	dependency_.pNext = pDependencyTask_->m_pDependents;
+	pDependencyTask_->m_pDependents = &dependency_;
+	++m_DependenciesCount;
+}
+
+void ITaskSet::ClearDependency( Dependency& dependency_ )
+{
+	if( NULL == dependency_.pDependencyTask )
+	{
+		return;
+	}
+	assert( dependency_.pTaskToRunOnCompletion == this );
+	assert( GetIsComplete() && dependency_.pDependencyTask->GetIsComplete() );
+
+	Dependency** ppDependent = &dependency_.pDependencyTask->m_pDependents;
+	while( *ppDependent != &dependency_ )
+	{
+		ppDependent = &(*ppDependent)->pNext;
+	}
+	*ppDependent = dependency_.pNext;
+	--m_DependenciesCount;
+
+	dependency_.pDependencyTask = NULL;
+	dependency_.pTaskToRunOnCompletion = NULL;
+	dependency_.pNext = NULL;
+}
+
+ITaskSet::~ITaskSet()
+{
+	while( m_pDependents )
+	{
+		m_pDependents->pTaskToRunOnCompletion->ClearDependency( *m_pDependents );
+	}
+}
+
+Dependency::~Dependency()
+{
+	if( pTaskToRunOnCompletion )
+	{
+		pTaskToRunOnCompletion->ClearDependency( *this );
 	}
 }
 
@@ -403,15 +801,7 @@ void    TaskScheduler::WaitforAll()
     while( bHaveTasks || ( m_NumThreadsWaiting.load( std::memory_order_relaxed ) < m_NumThreadsRunning.load( std::memory_order_relaxed ) - amRunningThread ) )
     {
         TryRunTask( threadNum.m_ThreadNum, hintPipeToCheck_io );
-        bHaveTasks = false;
-        for( uint32_t thread = 0; thread < m_NumThreads; ++thread )
-        {
-            if( !m_pPipesPerThread[ thread ].IsPipeEmpty() )
-            {
-                bHaveTasks = true;
-                break;
-            }
-        }
+        bHaveTasks = HaveTasks( TASK_PRIORITY_NUM );
      }
 }
 
@@ -421,6 +811,34 @@ void    TaskScheduler::WaitforAllAndShutdown()
     Cleanup( true );
 }
 
+void TaskScheduler::SetSchedulingMode( SchedulingMode mode_ )
+{
+	assert( !m_bRunning );
+	m_SchedulingMode = mode_;
+}
+
+SchedulingMode TaskScheduler::GetSchedulingMode() const
+{
+	return m_SchedulingMode;
+}
+
+void TaskScheduler::SetSpinCount( uint32_t spinCount_ )
+{
+	m_SpinCount.store( spinCount_, std::memory_order_relaxed );
+}
+
+void TaskScheduler::SetThreadAffinityMode( ThreadAffinityMode mode_ )
+{
+	assert( !m_bRunning );
+	m_ThreadAffinityMode = mode_;
+}
+
+void TaskScheduler::SetNumHighPriorityOnlyThreads( uint32_t numThreads_ )
+{
+	assert( !m_bRunning );
+	m_NumHighPriorityOnlyThreads = numThreads_;
+}
+
 uint32_t TaskScheduler::GetNumTaskThreads() const
 {
     return m_NumThreads;
@@ -450,9 +868,14 @@ void	TaskScheduler::UserThreadRunTasks()
 		{
 			// no tasks, will spin then wait
 			++spinCount;
-			if( spinCount > SPIN_COUNT )
+			if( spinCount > m_SpinCount.load( std::memory_order_relaxed ) )
 			{
 				WaitForTasks<true>( threadNum.m_ThreadNum );
+				spinCount = 0;
+			}
+			else
+			{
+				YieldProcessor();
 			}
 		}
 		else
@@ -464,15 +887,14 @@ void	TaskScheduler::UserThreadRunTasks()
 
 void	TaskScheduler::StopUserThreadRunTasks()
 {
-	{
-		std::unique_lock<std::mutex> lk( m_NewTaskEventMutex );
-		m_bUserThreadsCanRun = false;
-	}
-	m_NewTaskEvent.notify_all();
+	m_bUserThreadsCanRun = false;
+	WakeAllThreads();
 }
 
 TaskScheduler::TaskScheduler()
-		: m_pPipesPerThread(NULL)
+		: m_SchedulingMode(SCHEDULING_MODE_PIPES)
+		, m_ThreadAffinityMode(THREAD_AFFINITY_NONE)
+		, m_NumHighPriorityOnlyThreads(0)
 		, m_NumThreads(0)
 		, m_NumEnkiThreads(0)
 		, m_NumUserThreads(0)
@@ -483,9 +905,16 @@ TaskScheduler::TaskScheduler()
 		, m_pThreads(NULL)
 		, m_NumThreadsRunning(0)
 		, m_NumThreadsWaiting(0)
+		, m_TaskEpoch(0)
+		, m_SpinCount(DEFAULT_SPIN_COUNT)
 		, m_NumPartitions(0)
 		, m_bUserThreadsCanRun(false)
 {
+	for( uint32_t priority = 0; priority < TASK_PRIORITY_NUM; ++priority )
+	{
+		m_pPipesPerThread[ priority ] = NULL;
+		m_pDequesPerThread[ priority ] = NULL;
+	}
 }
 
 TaskScheduler::~TaskScheduler()
@@ -515,7 +944,17 @@ void TaskScheduler::InitializeWithUserThreads( uint32_t numUserThreads_, uint32_
 	m_NumEnkiThreads = numThreads_;
 	m_NumUserThreads = numUserThreads_;
 
-    m_pPipesPerThread = new TaskPipe[ m_NumThreads ];
+	for( uint32_t priority = 0; priority < TASK_PRIORITY_NUM; ++priority )
+	{
+		if( SCHEDULING_MODE_WORK_STEALING == m_SchedulingMode )
+		{
+			m_pDequesPerThread[ priority ] = new TaskDeque[ m_NumThreads ];
+		}
+		else
+		{
+			m_pPipesPerThread[ priority ] = new TaskPipe[ m_NumThreads ];
+		}
+	}
 	m_pUserThreadNumStack = new std::atomic<uint32_t>[ m_NumUserThreads ];
 	for( uint32_t i = 0; i < m_NumUserThreads; ++i )
 	{
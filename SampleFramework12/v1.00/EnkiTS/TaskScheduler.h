@@ -20,7 +20,6 @@
 
 #include <atomic>
 #include <thread>
-#include <condition_variable>
 #include <stdint.h>
 #include <functional>
 
@@ -34,11 +33,43 @@ namespace enki
 	};
 
 	class  TaskScheduler;
+	class  ITaskSet;
 	class  TaskPipe;
+	class  TaskDeque;
+	struct SubTaskSet;
 	struct ThreadArgs;
 	class  ThreadNum;
 
 
+	enum TaskPriority
+	{
+		TASK_PRIORITY_HIGH,     // frame critical work, always picked up before any low priority work
+		TASK_PRIORITY_LOW,      // background work such as asset loading or precomputation
+
+		TASK_PRIORITY_NUM
+	};
+
+	// Links a task set to one that has to complete before it can run, see ITaskSet::SetDependency.
+	// Usually a member of the dependent task set, with one Dependency per predecessor.
+	// Destroying a Dependency clears it.
+	struct Dependency
+	{
+		Dependency()
+			: pDependencyTask(NULL)
+			, pTaskToRunOnCompletion(NULL)
+			, pNext(NULL)
+		{}
+		~Dependency();
+
+		ITaskSet*               pDependencyTask;
+		ITaskSet*               pTaskToRunOnCompletion;
+		Dependency*             pNext;                  // next task set depending on pDependencyTask
+
+	private:
+		Dependency(			   const Dependency& nocopy_ );
+		Dependency& operator=( const Dependency& nocopy_ );
+	};
+
 	// Subclass ITaskSet to create tasks.
 	// TaskSets can be re-used, but check
 	class ITaskSet
@@ -46,13 +77,27 @@ namespace enki
 	public:
         ITaskSet()
             : m_SetSize(1)
+            , m_MinRange(1)
+            , m_Priority(TASK_PRIORITY_HIGH)
             , m_RunningCount(0)
+            , m_pDependents(NULL)
+            , m_DependenciesCount(0)
+            , m_DependenciesCompletedCount(0)
         {}
 
         ITaskSet( uint32_t setSize_ )
             : m_SetSize( setSize_ )
+            , m_MinRange(1)
+            , m_Priority(TASK_PRIORITY_HIGH)
             , m_RunningCount(0)
+            , m_pDependents(NULL)
+            , m_DependenciesCount(0)
+            , m_DependenciesCompletedCount(0)
         {}
+
+		// Clears the dependencies of any task sets depending on this one
+		virtual ~ITaskSet();
+
 		// Execute range should be overloaded to process tasks. It will be called with a
 		// range_ where range.start >= 0; range.start < range.end; and range.end < m_SetSize;
 		// The range values should be mapped so that linearly processing them in order is cache friendly
@@ -65,13 +110,37 @@ namespace enki
 		// Size of set - usually the number of data items to be processed, see ExecuteRange. Defaults to 1
 		uint32_t                m_SetSize;
 
+		// Smallest range the set will be split into, unless the set itself is smaller. Defaults to 1
+		// Raise this when ExecuteRange has a significant per-call overhead.
+		uint32_t                m_MinRange;
+
+		// Which queue the set is added to. Threads check every high priority queue before looking
+		// at the low priority ones, and a low priority set that's been split up (see SCHEDULING_MODE_WORK_STEALING)
+		// checks for high priority work between each piece. Defaults to TASK_PRIORITY_HIGH.
+		TaskPriority            m_Priority;
+
 		bool                    GetIsComplete() const
 		{
 			return 0 == m_RunningCount.load( std::memory_order_relaxed );
 		}
+
+		// Makes this task set wait for pDependencyTask_ to complete. Once all of the task sets it
+		// depends on have completed it is added to the scheduler by the thread that completed the
+		// last one, so only task sets without dependencies should be passed to AddTaskSetToPipe.
+		// Adding a task set marks everything that depends on it, directly or not, as incomplete,
+		// so waiting on the last task set of a graph waits for the whole graph.
+		// Dependencies stay in place when the task sets complete, so a graph can be set up once
+		// and run many times. Cycles are not allowed.
+		// Neither task set can be running when setting or clearing dependencies.
+		void                    SetDependency( Dependency& dependency_, ITaskSet* pDependencyTask_ );
+		void                    ClearDependency( Dependency& dependency_ );
+
 	private:
 		friend class           TaskScheduler;
 		std::atomic<int32_t>   m_RunningCount;
+		Dependency*            m_pDependents;
+		int32_t                m_DependenciesCount;
+		std::atomic<int32_t>   m_DependenciesCompletedCount;
 	};
 
 	// A utility task set for creating tasks based on std::func.
@@ -93,6 +162,32 @@ namespace enki
 	};
 
 
+	enum SchedulingMode
+	{
+		// Task sets are split into a fixed number of partitions up front, and added to a
+		// fixed size pipe. If the pipe is full the remaining partitions are run inline.
+		SCHEDULING_MODE_PIPES,
+
+		// Task sets are added whole to a per-thread Chase-Lev deque. Idle threads steal from
+		// randomly chosen victims, and a running range is halved whenever its thread's deque
+		// has been emptied, so the work is only split as far as needed to keep threads busy.
+		SCHEDULING_MODE_WORK_STEALING,
+	};
+
+	enum ThreadAffinityMode
+	{
+		// Threads are left to the OS scheduler
+		THREAD_AFFINITY_NONE,
+
+		// Each thread is pinned to its own physical core, alternating between NUMA nodes and L3
+		// caches so that the threads have as much cache and memory bandwidth as possible.
+		THREAD_AFFINITY_SPREAD,
+
+		// Each thread is pinned to its own physical core, filling up an L3 cache and NUMA node before
+		// moving to the next one, so that threads working on the same data share a cache.
+		THREAD_AFFINITY_COMPACT,
+	};
+
 	class TaskScheduler
 	{
 	public:
@@ -141,10 +236,33 @@ namespace enki
 		// numUserThreads_ task functions.
 		void			InitializeWithUserThreads( uint32_t numUserThreads_, uint32_t numThreads_ );
 
+		// Sets how task sets are distributed between threads, defaults to SCHEDULING_MODE_PIPES.
+		// Must be called before initializing, or after WaitforAllAndShutdown().
+		void			SetSchedulingMode( SchedulingMode mode_ );
+		SchedulingMode	GetSchedulingMode() const;
+
+		// Sets how enkiTS threads are assigned to cores, defaults to THREAD_AFFINITY_NONE.
+		// The first core in the chosen order is left for the thread which calls Initialize, and
+		// threads beyond the number of physical cores (such as with hyper-threading) are left unpinned.
+		// Must be called before initializing, or after WaitforAllAndShutdown().
+		void			SetThreadAffinityMode( ThreadAffinityMode mode_ );
+
+		// Reserves numThreads_ of the enkiTS threads for TASK_PRIORITY_HIGH task sets, so that
+		// high priority work never has to wait for long running low priority work to finish.
+		// Clamped to the number of enkiTS threads, defaults to 0.
+		// Must be called before initializing, or after WaitforAllAndShutdown().
+		void			SetNumHighPriorityOnlyThreads( uint32_t numThreads_ );
+
+		// Sets how many times an idle thread looks for tasks before it parks until new tasks are
+		// added. Higher counts wake up faster after a short gap in the work, but burn more CPU while
+		// there's nothing to do. Can be called at any time, defaults to 100.
+		void			SetSpinCount( uint32_t spinCount_ );
+
 
 		// Adds the TaskSet to pipe and returns if the pipe is not full.
 		// If the pipe is full, pTaskSet is run.
 		// should only be called from main thread, or within a task
+		// pTaskSet should not have any dependencies, as they are added automatically.
 		void            AddTaskSetToPipe( ITaskSet* pTaskSet );
 
 		// Runs the TaskSets in pipe until true == pTaskSet->GetIsComplete();
@@ -200,11 +318,24 @@ namespace enki
 		template<bool ISUSERTASK>
 		void             WaitForTasks( uint32_t threadNum );
 		bool             TryRunTask( uint32_t threadNum, uint32_t& hintPipeToCheck_io_ );
+		bool             TryRunTask( uint32_t threadNum, uint32_t priority, uint32_t& hintPipeToCheck_io_ );
+		bool             TryStealTask( uint32_t threadNum, uint32_t priority, SubTaskSet* pSubTask );
+		void             SplitAndRunTask( uint32_t threadNum, SubTaskSet subTask );
+		uint32_t         GetNumPrioritiesForThread( uint32_t threadNum ) const;
+		bool             HaveTasks( uint32_t numPriorities ) const;
+		void             WakeThreadsForNewTasks( uint32_t numNewTasks, uint32_t priority );
+		void             WakeAllThreads();
+		void             ReleaseRunningCount( ITaskSet* pTaskSet, int32_t count );
+		static void      MarkDependentsIncomplete( ITaskSet* pTaskSet );
 		void             StartThreads();
 		void             Cleanup( bool bWait_ );
 
 
-		TaskPipe*                                                m_pPipesPerThread;
+		TaskPipe*                                                m_pPipesPerThread[ TASK_PRIORITY_NUM ];
+		TaskDeque*                                               m_pDequesPerThread[ TASK_PRIORITY_NUM ];
+		SchedulingMode                                           m_SchedulingMode;
+		ThreadAffinityMode                                       m_ThreadAffinityMode;
+		uint32_t                                                 m_NumHighPriorityOnlyThreads;
 
 		uint32_t                                                 m_NumThreads;
 		uint32_t												 m_NumEnkiThreads;
@@ -218,8 +349,8 @@ namespace enki
 		std::atomic<int32_t>                                     m_NumThreadsRunning;
 		std::atomic<int32_t>                                     m_NumThreadsWaiting;
 		uint32_t                                                 m_NumPartitions;
-		std::condition_variable                                  m_NewTaskEvent;
-		std::mutex												 m_NewTaskEventMutex;
+		std::atomic<uint32_t>                                    m_TaskEpoch;    // changes whenever tasks are added, idle threads park on it
+		std::atomic<uint32_t>                                    m_SpinCount;
 
 
 		TaskScheduler( const TaskScheduler& nocopy );
@@ -0,0 +1,193 @@
+// Copyright (c) 2013 Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgement in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+
+
+namespace enki
+{
+    // WorkStealingDeque - Chase-Lev work stealing deque, single owner and multiple thieves
+    // The owner pushes and pops at the bottom of the deque, thieves steal from the top, so the owner works
+    // on the most recently added (smallest, cache hot) items while thieves take the oldest (largest) ones.
+    // See "Dynamic Circular Work-Stealing Deque" (Chase & Lev) and "Correct and Efficient Work-Stealing
+    // for Weak Memory Models" (Le, Pop, Cohen & Zappa Nardelli) for the memory ordering used here.
+    // Unlike LockLessMultiReadPipe the deque never fills up: the owner doubles the buffer when it runs
+    // out of space. Old buffers may still be read by thieves, so they are kept until the deque is destroyed.
+    // T is the contained type, and must be trivially copyable. A thief may read an element while the owner
+    // is overwriting it, but in that case the thief's CAS on the top index fails and the value is discarded.
+    template<uint8_t cInitialSizeLog2, typename T> class WorkStealingDeque
+    {
+    public:
+        WorkStealingDeque();
+        ~WorkStealingDeque();
+
+        // OwnerPushBottom always succeeds, growing the deque if needed
+        // This is thread safe for the single owner, but should not be called by thieves
+        void OwnerPushBottom(    const T& in );
+
+        // OwnerTryPopBottom returns false if the deque was empty, or a thief took the last item
+        // This is thread safe for the single owner, but should not be called by thieves
+        bool OwnerTryPopBottom(  T* pOut );
+
+        // ThiefTryStealTop returns false if the deque was empty, or we lost a race with another thread
+        // This is thread safe for both multiple thieves and the owner
+        bool ThiefTryStealTop(   T* pOut );
+
+        // IsDequeEmpty() is a utility function, not intended for general use
+        // Should only be used very prudently.
+        bool IsDequeEmpty() const
+        {
+            return m_Bottom.load( std::memory_order_relaxed ) <= m_Top.load( std::memory_order_relaxed );
+        }
+
+    private:
+        struct Buffer
+        {
+            int64_t                     indexMask;
+            T*                          pItems;
+            Buffer*                     pPrevious;  // retired buffers, freed with the deque
+        };
+
+        static Buffer*                  CreateBuffer( int64_t size, Buffer* pPrevious );
+
+        WorkStealingDeque(            const WorkStealingDeque& nocopy_ );
+        WorkStealingDeque& operator=( const WorkStealingDeque& nocopy_ );
+
+        // top and bottom are padded onto separate cache lines, as top is written by thieves and bottom by the owner
+        std::atomic<int64_t>            m_Top;
+        char                            m_Padding[ 64 - sizeof( std::atomic<int64_t> ) ];
+        std::atomic<int64_t>            m_Bottom;
+        std::atomic<Buffer*>            m_pBuffer;
+    };
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        WorkStealingDeque<cInitialSizeLog2,T>::WorkStealingDeque()
+        : m_Top(0)
+        , m_Bottom(0)
+        , m_pBuffer( CreateBuffer( int64_t(1) << cInitialSizeLog2, NULL ) )
+    {
+        assert( cInitialSizeLog2 < 32 );
+    }
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        WorkStealingDeque<cInitialSizeLog2,T>::~WorkStealingDeque()
+    {
+        Buffer* pBuffer = m_pBuffer.load( std::memory_order_relaxed );
+        while( pBuffer )
+        {
+            Buffer* pPrevious = pBuffer->pPrevious;
+            delete[] pBuffer->pItems;
+            delete pBuffer;
+            pBuffer = pPrevious;
+        }
+    }
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        typename WorkStealingDeque<cInitialSizeLog2,T>::Buffer* WorkStealingDeque<cInitialSizeLog2,T>::CreateBuffer( int64_t size, Buffer* pPrevious )
+    {
+        Buffer* pBuffer = new Buffer;
+        pBuffer->indexMask = size - 1;
+        pBuffer->pItems = new T[ size ];
+        pBuffer->pPrevious = pPrevious;
+        return pBuffer;
+    }
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        void WorkStealingDeque<cInitialSizeLog2,T>::OwnerPushBottom( const T& in )
+    {
+        int64_t bottom = m_Bottom.load( std::memory_order_relaxed );
+        int64_t top = m_Top.load( std::memory_order_acquire );
+        Buffer* pBuffer = m_pBuffer.load( std::memory_order_relaxed );
+
+        if( bottom - top > pBuffer->indexMask )
+        {
+            // full, so copy the live items into a buffer twice the size. Thieves which loaded the old buffer
+            // can still read from it, since the items in [top, bottom) are unchanged in both.
+            Buffer* pNewBuffer = CreateBuffer( ( pBuffer->indexMask + 1 ) * 2, pBuffer );
+            for( int64_t i = top; i < bottom; ++i )
+            {
+                pNewBuffer->pItems[ i & pNewBuffer->indexMask ] = pBuffer->pItems[ i & pBuffer->indexMask ];
+            }
+            m_pBuffer.store( pNewBuffer, std::memory_order_release );
+            pBuffer = pNewBuffer;
+        }
+
+        pBuffer->pItems[ bottom & pBuffer->indexMask ] = in;
+
+        // the item has to be visible before a thief can see the new bottom
+        std::atomic_thread_fence( std::memory_order_release );
+        m_Bottom.store( bottom + 1, std::memory_order_relaxed );
+    }
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        bool WorkStealingDeque<cInitialSizeLog2,T>::OwnerTryPopBottom( T* pOut )
+    {
+        // reserve the bottom item before looking at top, so that a thief racing for the same item sees it has gone
+        int64_t bottom = m_Bottom.load( std::memory_order_relaxed ) - 1;
+        Buffer* pBuffer = m_pBuffer.load( std::memory_order_relaxed );
+        m_Bottom.store( bottom, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t top = m_Top.load( std::memory_order_relaxed );
+
+        if( top > bottom )
+        {
+            // empty
+            m_Bottom.store( bottom + 1, std::memory_order_relaxed );
+            return false;
+        }
+
+        *pOut = pBuffer->pItems[ bottom & pBuffer->indexMask ];
+        if( top == bottom )
+        {
+            // last item, so we have to race any thieves for it by advancing top
+            bool success = m_Top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+            m_Bottom.store( bottom + 1, std::memory_order_relaxed );
+            return success;
+        }
+        return true;
+    }
+
+    template<uint8_t cInitialSizeLog2, typename T> inline
+        bool WorkStealingDeque<cInitialSizeLog2,T>::ThiefTryStealTop( T* pOut )
+    {
+        int64_t top = m_Top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t bottom = m_Bottom.load( std::memory_order_acquire );
+        if( top >= bottom )
+        {
+            return false;
+        }
+
+        Buffer* pBuffer = m_pBuffer.load( std::memory_order_acquire );
+        T item = pBuffer->pItems[ top & pBuffer->indexMask ];
+        if( !m_Top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+        {
+            // another thief or the owner got there first
+            return false;
+        }
+
+        *pOut = item;
+        return true;
+    }
+
+}
@@ -116,7 +116,7 @@ uint64 GetFileTimestamp(const wchar* filePath)
 // Returns the contents of a file as a string
 std::string ReadFileAsString(const wchar* filePath)
 {
-    File file(filePath, FileOpenMode::Read);
+    File file(filePath, FileOpenMode::Read, FileAccessHint::Sequential);
     uint64 fileSize = file.Size();
 
     std::string fileContents;
@@ -135,14 +135,35 @@ void WriteStringAsFile(const wchar* filePath, const std::string& data)
 
 // == File ========================================================================================
 
+// The largest amount of data that's passed to a single ReadFile/WriteFile call. This is a multiple of
+// any sector size, so that unbuffered I/O stays aligned when a big request gets split up.
+static const uint64 MaxIOChunkSize = 1024 * 1024 * 1024;
+
+static DWORD AccessHintFlags(FileAccessHint accessHint)
+{
+    if(accessHint == FileAccessHint::Sequential)
+        return FILE_FLAG_SEQUENTIAL_SCAN;
+    else if(accessHint == FileAccessHint::Random)
+        return FILE_FLAG_RANDOM_ACCESS;
+    else if(accessHint == FileAccessHint::Unbuffered)
+        return FILE_FLAG_NO_BUFFERING;
+    return 0;
+}
+
+static void ThrowReadPastEnd(uint64 offset, uint64 size, uint64 bytesRead)
+{
+    throw Exception(MakeString(L"Tried to read %llu bytes at offset %llu, but only %llu bytes were available",
+                               size, offset, bytesRead));
+}
+
 File::File() : fileHandle(INVALID_HANDLE_VALUE), openMode(FileOpenMode::Read)
 {
 }
 
-File::File(const wchar* filePath, FileOpenMode openMode) : fileHandle(INVALID_HANDLE_VALUE),
-                                                           openMode(FileOpenMode::Read)
+File::File(const wchar* filePath, FileOpenMode openMode, FileAccessHint accessHint) : fileHandle(INVALID_HANDLE_VALUE),
+                                                                                     openMode(FileOpenMode::Read)
 {
-    Open(filePath, openMode);
+    Open(filePath, openMode, accessHint);
 }
 
 File::~File()
@@ -151,23 +172,40 @@ File::~File()
     Assert_(fileHandle == INVALID_HANDLE_VALUE);
 }
 
-void File::Open(const wchar* filePath, FileOpenMode openMode_)
+void File::Open(const wchar* filePath, FileOpenMode openMode_, FileAccessHint accessHint)
 {
     Assert_(fileHandle == INVALID_HANDLE_VALUE);
     openMode = openMode_;
 
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | AccessHintFlags(accessHint);
+
     if(openMode == FileOpenMode::Read)
     {
         Assert_(FileExists(filePath));
 
         // Open the file
-        fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+        if(fileHandle == INVALID_HANDLE_VALUE)
+        {
+            std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+            Assert_(false);
+            throw Win32Exception(GetLastError(), errPrefix.c_str());
+        }
+    }
+    else if(openMode == FileOpenMode::Append)
+    {
+        // Other handles can keep reading (or mapping) the file while it's being added to, or replace it
+        const DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+        fileHandle = CreateFile(filePath, GENERIC_WRITE, shareMode, NULL, OPEN_ALWAYS, flags, NULL);
         if(fileHandle == INVALID_HANDLE_VALUE)
         {
             std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
             Assert_(false);
             throw Win32Exception(GetLastError(), errPrefix.c_str());
         }
+
+        LARGE_INTEGER distance = { };
+        Win32Call(SetFilePointerEx(fileHandle, distance, NULL, FILE_END));
     }
     else
     {
@@ -176,7 +214,7 @@ void File::Open(const wchar* filePath, FileOpenMode openMode_)
             Win32Call(DeleteFile(filePath));
 
         // Create the file
-        fileHandle = CreateFile(filePath, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        fileHandle = CreateFile(filePath, GENERIC_WRITE, 0, NULL, CREATE_NEW, flags, NULL);
         if(fileHandle == INVALID_HANDLE_VALUE)
         {
             std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
@@ -202,17 +240,121 @@ void File::Read(uint64 size, void* data) const
     Assert_(fileHandle != INVALID_HANDLE_VALUE);
     Assert_(openMode == FileOpenMode::Read);
 
-    DWORD bytesRead = 0;
-    Win32Call(ReadFile(fileHandle, data, static_cast<DWORD>(size), &bytesRead, NULL));
+    // ReadFile takes a DWORD size, so big reads need to be split up
+    uint8* dst = reinterpret_cast<uint8*>(data);
+    uint64 totalRead = 0;
+    while(totalRead < size)
+    {
+        const DWORD chunkSize = DWORD(Min(size - totalRead, MaxIOChunkSize));
+        DWORD bytesRead = 0;
+        Win32Call(ReadFile(fileHandle, dst + totalRead, chunkSize, &bytesRead, NULL));
+        totalRead += bytesRead;
+
+        if(bytesRead < chunkSize)
+        {
+            LARGE_INTEGER position = { };
+            LARGE_INTEGER zero = { };
+            Win32Call(SetFilePointerEx(fileHandle, zero, &position, FILE_CURRENT));
+            ThrowReadPastEnd(uint64(position.QuadPart) - totalRead, size, totalRead);
+        }
+    }
 }
 
 void File::Write(uint64 size, const void* data) const
 {
     Assert_(fileHandle != INVALID_HANDLE_VALUE);
-    Assert_(openMode == FileOpenMode::Write);
+    Assert_(openMode != FileOpenMode::Read);
+
+    const uint8* src = reinterpret_cast<const uint8*>(data);
+    uint64 totalWritten = 0;
+    while(totalWritten < size)
+    {
+        const DWORD chunkSize = DWORD(Min(size - totalWritten, MaxIOChunkSize));
+        DWORD bytesWritten = 0;
+        Win32Call(WriteFile(fileHandle, src + totalWritten, chunkSize, &bytesWritten, NULL));
+        totalWritten += bytesWritten;
+    }
+}
+
+void File::ReadAt(uint64 offset, uint64 size, void* data) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+    Assert_(openMode == FileOpenMode::Read);
+
+    // Passing an OVERLAPPED to a synchronous handle reads from its offset, which saves a seek call
+    uint8* dst = reinterpret_cast<uint8*>(data);
+    uint64 totalRead = 0;
+    while(totalRead < size)
+    {
+        const uint64 chunkOffset = offset + totalRead;
+        const DWORD chunkSize = DWORD(Min(size - totalRead, MaxIOChunkSize));
+
+        OVERLAPPED overlapped = { };
+        overlapped.Offset = DWORD(chunkOffset);
+        overlapped.OffsetHigh = DWORD(chunkOffset >> 32);
+
+        DWORD bytesRead = 0;
+        if(ReadFile(fileHandle, dst + totalRead, chunkSize, &bytesRead, &overlapped) == FALSE)
+        {
+            const DWORD error = GetLastError();
+            if(error != ERROR_HANDLE_EOF)
+                throw Win32Exception(error);
+        }
+
+        totalRead += bytesRead;
+        if(bytesRead < chunkSize)
+            ThrowReadPastEnd(offset, size, totalRead);
+    }
+}
+
+void File::WriteAt(uint64 offset, uint64 size, const void* data) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+    Assert_(openMode != FileOpenMode::Read);
+
+    const uint8* src = reinterpret_cast<const uint8*>(data);
+    uint64 totalWritten = 0;
+    while(totalWritten < size)
+    {
+        const uint64 chunkOffset = offset + totalWritten;
+        const DWORD chunkSize = DWORD(Min(size - totalWritten, MaxIOChunkSize));
+
+        OVERLAPPED overlapped = { };
+        overlapped.Offset = DWORD(chunkOffset);
+        overlapped.OffsetHigh = DWORD(chunkOffset >> 32);
+
+        DWORD bytesWritten = 0;
+        Win32Call(WriteFile(fileHandle, src + totalWritten, chunkSize, &bytesWritten, &overlapped));
+        totalWritten += bytesWritten;
+    }
+}
+
+void File::ReadRanges(const FileReadRange* ranges, uint64 numRanges) const
+{
+    Assert_(ranges != nullptr || numRanges == 0);
+    for(uint64 i = 0; i < numRanges; ++i)
+        ReadAt(ranges[i].Offset, ranges[i].Size, ranges[i].Data);
+}
+
+void File::Lock(uint64 offset, uint64 size) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
 
-    DWORD bytesWritten = 0;
-    Win32Call(WriteFile(fileHandle, data, static_cast<DWORD>(size), &bytesWritten, NULL));
+    OVERLAPPED overlapped = { };
+    overlapped.Offset = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+    Win32Call(LockFileEx(fileHandle, LOCKFILE_EXCLUSIVE_LOCK, 0, DWORD(size), DWORD(size >> 32), &overlapped));
+}
+
+void File::Unlock(uint64 offset, uint64 size) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+
+    OVERLAPPED overlapped = { };
+    overlapped.Offset = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+    const BOOL unlocked = UnlockFileEx(fileHandle, 0, DWORD(size), DWORD(size >> 32), &overlapped);
+    Assert_(unlocked);
 }
 
 uint64 File::Size() const
@@ -225,4 +367,254 @@ uint64 File::Size() const
     return fileSize.QuadPart;
 }
 
+// == AsyncRead ===================================================================================
+
+AsyncRead::AsyncRead()
+{
+    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    Win32Call(overlapped.hEvent != NULL);
+}
+
+AsyncRead::~AsyncRead()
+{
+    // The OS is still writing into this OVERLAPPED (and the caller's buffer), so wait for it
+    if(pending)
+    {
+        DWORD bytesRead = 0;
+        GetOverlappedResult(fileHandle, &overlapped, &bytesRead, TRUE);
+        pending = false;
+    }
+
+    Win32Call(CloseHandle(overlapped.hEvent));
+    overlapped.hEvent = NULL;
+}
+
+void AsyncRead::IssueChunk()
+{
+    Assert_(pending == false);
+    Assert_(remaining > 0);
+
+    chunkSize = uint32(Min(remaining, MaxIOChunkSize));
+    overlapped.Offset = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+
+    // This can finish right away if the data is cached, in which case the event gets signaled and
+    // GetOverlappedResult picks up the result the same way as for a read that went to the disk
+    if(ReadFile(fileHandle, data, chunkSize, NULL, &overlapped) == FALSE)
+    {
+        const DWORD error = GetLastError();
+        if(error == ERROR_HANDLE_EOF)
+            ThrowReadPastEnd(offset, remaining, 0);
+        else if(error != ERROR_IO_PENDING)
+            throw Win32Exception(error);
+    }
+
+    pending = true;
+}
+
+bool AsyncRead::FinishChunk(bool wait)
+{
+    Assert_(pending);
+
+    DWORD bytesRead = 0;
+    if(GetOverlappedResult(fileHandle, &overlapped, &bytesRead, wait ? TRUE : FALSE) == FALSE)
+    {
+        const DWORD error = GetLastError();
+        if(error == ERROR_IO_INCOMPLETE)
+            return false;
+
+        pending = false;
+        if(error == ERROR_HANDLE_EOF)
+            ThrowReadPastEnd(offset, remaining, 0);
+        throw Win32Exception(error);
+    }
+
+    pending = false;
+    if(bytesRead < chunkSize)
+        ThrowReadPastEnd(offset, remaining, bytesRead);
+
+    data += chunkSize;
+    offset += chunkSize;
+    remaining -= chunkSize;
+    if(remaining > 0)
+        IssueChunk();
+
+    return true;
+}
+
+bool AsyncRead::IsDone()
+{
+    while(pending)
+    {
+        if(FinishChunk(false) == false)
+            return false;
+    }
+
+    return true;
+}
+
+void AsyncRead::Wait()
+{
+    while(pending)
+        FinishChunk(true);
+}
+
+// == AsyncFile ===================================================================================
+
+AsyncFile::AsyncFile()
+{
+}
+
+AsyncFile::AsyncFile(const wchar* filePath, FileAccessHint accessHint)
+{
+    Open(filePath, accessHint);
+}
+
+AsyncFile::~AsyncFile()
+{
+    Close();
+}
+
+void AsyncFile::Open(const wchar* filePath, FileAccessHint accessHint)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(FileExists(filePath));
+
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | AccessHintFlags(accessHint);
+    fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+        Assert_(false);
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    LARGE_INTEGER fileSize;
+    Win32Call(GetFileSizeEx(fileHandle, &fileSize));
+    size = fileSize.QuadPart;
+}
+
+void AsyncFile::Close()
+{
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        Win32Call(CloseHandle(fileHandle));
+    fileHandle = INVALID_HANDLE_VALUE;
+
+    size = 0;
+}
+
+void AsyncFile::BeginRead(AsyncRead& read, uint64 offset, uint64 numBytes, void* data) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+    Assert_(read.pending == false);
+    Assert_(data != nullptr || numBytes == 0);
+
+    read.fileHandle = fileHandle;
+    read.data = reinterpret_cast<uint8*>(data);
+    read.offset = offset;
+    read.remaining = numBytes;
+    read.chunkSize = 0;
+
+    if(numBytes > 0)
+        read.IssueChunk();
+}
+
+void AsyncFile::ReadRanges(const FileReadRange* ranges, uint64 numRanges) const
+{
+    Assert_(ranges != nullptr || numRanges == 0);
+
+    // Recycle the reads in the order they were issued, so that there's always a full queue in front of the disk
+    AsyncRead reads[MaxReadsInFlight];
+    for(uint64 i = 0; i < numRanges; ++i)
+    {
+        AsyncRead& read = reads[i % MaxReadsInFlight];
+        read.Wait();
+        BeginRead(read, ranges[i].Offset, ranges[i].Size, ranges[i].Data);
+    }
+
+    for(uint64 i = 0; i < MaxReadsInFlight; ++i)
+        reads[i].Wait();
+}
+
+// == MappedFile ==================================================================================
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::MappedFile(const wchar* filePath, bool allowAppends)
+{
+    Open(filePath, allowAppends);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+void MappedFile::Open(const wchar* filePath, bool allowAppends)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(FileExists(filePath));
+
+    // Files are almost always read front to back, so let the cache manager read ahead aggressively.
+    // Sharing delete access lets the file be replaced while it's mapped, the view keeps the old contents.
+    DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_DELETE;
+    if(allowAppends)
+        shareMode |= FILE_SHARE_WRITE;
+    fileHandle = CreateFile(filePath, GENERIC_READ, shareMode, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+        Assert_(false);
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    // From here on, a failure has to close what's already open before throwing. The destructor doesn't
+    // run when this throws from the constructor, and Open() can't be called again on a half-open file.
+    LARGE_INTEGER fileSize;
+    if(GetFileSizeEx(fileHandle, &fileSize) == FALSE)
+        CloseAndThrow(L"Failed to get the size of file ", filePath);
+    size = fileSize.QuadPart;
+
+    // Empty files can't be mapped, so there's nothing else to do for those
+    if(size == 0)
+        return;
+
+    mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == NULL)
+        CloseAndThrow(L"Failed to map file ", filePath);
+
+    data = reinterpret_cast<const uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+        CloseAndThrow(L"Failed to map a view of file ", filePath);
+}
+
+void MappedFile::CloseAndThrow(const wchar* errMsg, const wchar* filePath)
+{
+    const DWORD error = GetLastError();
+    Close();
+
+    std::wstring errPrefix = std::wstring(errMsg) + filePath + L":\n";
+    throw Win32Exception(error, errPrefix.c_str());
+}
+
+void MappedFile::Close()
+{
+    if(data != nullptr)
+        Win32Call(UnmapViewOfFile(data));
+    data = nullptr;
+
+    if(mappingHandle != NULL)
+        Win32Call(CloseHandle(mappingHandle));
+    mappingHandle = NULL;
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        Win32Call(CloseHandle(fileHandle));
+    fileHandle = INVALID_HANDLE_VALUE;
+
+    size = 0;
+}
+
 }
\ No newline at end of file
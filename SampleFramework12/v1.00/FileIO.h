@@ -34,6 +34,24 @@ enum class FileOpenMode
 {
     Read = 0,
     Write = 1,
+    Append = 2,             // Keeps the existing contents (or creates the file), and starts writing at the end
+};
+
+// Tells the OS how a file is going to be accessed, so that it can pick a caching strategy
+enum class FileAccessHint
+{
+    Default = 0,
+    Sequential = 1,         // Read ahead aggressively, and drop pages from the cache once they've been read
+    Random = 2,             // Don't bother reading ahead
+    Unbuffered = 3,         // Bypass the file cache. Offsets, sizes and buffer addresses must be multiples of the sector size.
+};
+
+// A region of a file, and where to read it to
+struct FileReadRange
+{
+    uint64 Offset = 0;
+    uint64 Size = 0;
+    void* Data = nullptr;
 };
 
 class File
@@ -48,24 +66,142 @@ public:
 
     // Lifetime
     File();
-    File(const wchar* filePath, FileOpenMode openMode);
+    File(const wchar* filePath, FileOpenMode openMode, FileAccessHint accessHint = FileAccessHint::Default);
     ~File();
 
     // Explicit Open and close
-    void Open(const wchar* filePath, FileOpenMode openMode);
+    void Open(const wchar* filePath, FileOpenMode openMode, FileAccessHint accessHint = FileAccessHint::Default);
     void Close();
 
-    // I/O
+    // I/O at the current file position. Reading past the end of the file throws.
     void Read(uint64 size, void* data) const;
     void Write(uint64 size, const void* data) const;
 
     template<typename T> void Read(T& data) const;
     template<typename T> void Write(const T& data) const;
 
+    // I/O at an explicit offset. The file position ends up after the data that was read or written.
+    void ReadAt(uint64 offset, uint64 size, void* data) const;
+    void WriteAt(uint64 offset, uint64 size, const void* data) const;
+    void ReadRanges(const FileReadRange* ranges, uint64 numRanges) const;
+
+    // Exclusive byte-range lock that's respected by other handles and processes. The range can be past the
+    // end of the file. Lock() blocks until the range is free, and Unlock() doesn't throw.
+    void Lock(uint64 offset, uint64 size) const;
+    void Unlock(uint64 offset, uint64 size) const;
+
     // Accessors
     uint64 Size() const;
 };
 
+// A read that's in flight on an AsyncFile. It needs to stay at the same address until the read is
+// done, and waits for the read to finish if it's destroyed early. Reads bigger than the largest
+// size a single ReadFile call can handle are split up, with each piece issued once the previous one
+// finishes.
+class AsyncRead
+{
+
+private:
+
+    OVERLAPPED overlapped = { };
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    uint8* data = nullptr;
+    uint64 offset = 0;
+    uint64 remaining = 0;
+    uint32 chunkSize = 0;
+    bool pending = false;
+
+    void IssueChunk();
+    bool FinishChunk(bool wait);
+
+    AsyncRead(const AsyncRead& other);
+    AsyncRead& operator=(const AsyncRead& other);
+
+    friend class AsyncFile;
+
+public:
+
+    AsyncRead();
+    ~AsyncRead();
+
+    // Returns true once all of the data has arrived, without blocking
+    bool IsDone();
+
+    // Blocks until all of the data has arrived
+    void Wait();
+};
+
+// Read-only file that uses overlapped I/O, so that the caller can keep working (for instance decoding
+// the last chunk of data) while the disk is busy. Any number of reads can be in flight at once.
+class AsyncFile
+{
+
+private:
+
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    uint64 size = 0;
+
+    AsyncFile(const AsyncFile& other);
+    AsyncFile& operator=(const AsyncFile& other);
+
+public:
+
+    static const uint64 MaxReadsInFlight = 32;
+
+    // Lifetime
+    AsyncFile();
+    explicit AsyncFile(const wchar* filePath, FileAccessHint accessHint = FileAccessHint::Default);
+    ~AsyncFile();
+
+    // Explicit Open and close. Any reads that are still in flight must be waited on before closing.
+    void Open(const wchar* filePath, FileAccessHint accessHint = FileAccessHint::Default);
+    void Close();
+
+    // Starts reading a region of the file. Reading past the end of the file throws, either here or when the read completes.
+    void BeginRead(AsyncRead& read, uint64 offset, uint64 numBytes, void* data) const;
+
+    // Reads a list of regions, keeping up to MaxReadsInFlight of them in flight at any given time
+    void ReadRanges(const FileReadRange* ranges, uint64 numRanges) const;
+
+    // Accessors
+    uint64 Size() const { return size; }
+};
+
+// Read-only view of an entire file, mapped into the address space instead of read into memory. With
+// allowAppends, the file can be opened with FileOpenMode::Append while it's mapped, but anything
+// written to it afterwards isn't part of the view. The file can be replaced by moving another file over
+// it while it's mapped, which leaves the view with the old contents.
+class MappedFile
+{
+
+private:
+
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = NULL;
+    const uint8* data = nullptr;
+    uint64 size = 0;
+
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+    void CloseAndThrow(const wchar* errMsg, const wchar* filePath);
+
+public:
+
+    // Lifetime
+    MappedFile();
+    explicit MappedFile(const wchar* filePath, bool allowAppends = false);
+    ~MappedFile();
+
+    // Explicit Open and close
+    void Open(const wchar* filePath, bool allowAppends = false);
+    void Close();
+
+    // Accessors
+    const uint8* Data() const { return data; }
+    uint64 Size() const { return size; }
+};
+
 // == File ========================================================================================
 
 template<typename T> void File::Read(T& data) const
@@ -0,0 +1,258 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "FileWatcher.h"
+#include "FileIO.h"
+#include "Exceptions.h"
+#include "Utility.h"
+
+using std::wstring;
+
+namespace SampleFramework12
+{
+
+// Full path in lower case, so that paths from AddFile() can be matched against what the OS reports
+static wstring CanonicalPath(const wchar* filePath)
+{
+    wchar fullPath[MAX_PATH] = { };
+    const DWORD length = GetFullPathName(filePath, MAX_PATH, fullPath, nullptr);
+    if(length == 0 || length >= MAX_PATH)
+        throw Win32Exception(GetLastError(), (wstring(L"Failed to get the full path for ") + filePath).c_str());
+
+    wstring path(fullPath, length);
+    for(uint64 i = 0; i < path.length(); ++i)
+        path[i] = towlower(path[i]);
+    return path;
+}
+
+// == FileChangeQueue =============================================================================
+
+void FileChangeQueue::Init(uint64 debounceMS)
+{
+    debounceTime = debounceMS;
+}
+
+void FileChangeQueue::Shutdown()
+{
+    lastChanged.Shutdown();
+}
+
+void FileChangeQueue::MarkChanged(const wstring& filePath, uint64 currTimeMS)
+{
+    lastChanged.Insert(filePath, currTimeMS);
+}
+
+void FileChangeQueue::PopSettledFiles(uint64 currTimeMS, GrowableList<wstring>& changedFiles)
+{
+    if(lastChanged.Count() == 0)
+        return;
+
+    const uint64 firstNewFile = changedFiles.Count();
+    lastChanged.ForEach([&](const wstring& filePath, uint64 changeTime)
+    {
+        if(currTimeMS - changeTime >= debounceTime)
+            changedFiles.Add(filePath);
+    });
+
+    for(uint64 i = firstNewFile; i < changedFiles.Count(); ++i)
+        lastChanged.Remove(changedFiles[i]);
+}
+
+// == PollingFileWatcher ==========================================================================
+
+PollingFileWatcher::PollingFileWatcher(uint64 filesPerUpdate_, uint64 debounceMS) : filesPerUpdate(filesPerUpdate_)
+{
+    Assert_(filesPerUpdate > 0);
+    changeQueue.Init(debounceMS);
+}
+
+void PollingFileWatcher::AddFile(const wchar* filePath)
+{
+    WatchedFile file;
+    file.FilePath = filePath;
+    file.TimeStamp = GetFileTimestamp(filePath);
+    files.Add(file);
+}
+
+void PollingFileWatcher::GetChangedFiles(GrowableList<wstring>& changedFiles)
+{
+    const uint64 currTime = GetTickCount64();
+    const uint64 numToCheck = Min(filesPerUpdate, files.Count());
+    for(uint64 i = 0; i < numToCheck; ++i)
+    {
+        currFile = (currFile + 1) % files.Count();
+
+        // The file might be in the middle of being replaced, in which case it gets checked again next time around
+        WatchedFile& file = files[currFile];
+        if(FileExists(file.FilePath.c_str()) == false)
+            continue;
+
+        const uint64 newTimeStamp = GetFileTimestamp(file.FilePath.c_str());
+        if(newTimeStamp != file.TimeStamp)
+        {
+            file.TimeStamp = newTimeStamp;
+            changeQueue.MarkChanged(file.FilePath, currTime);
+        }
+    }
+
+    changeQueue.PopSettledFiles(currTime, changedFiles);
+}
+
+// == DirectoryFileWatcher ========================================================================
+
+DirectoryFileWatcher::DirectoryFileWatcher(uint64 debounceMS) : fallback(1, debounceMS)
+{
+    changeQueue.Init(debounceMS);
+}
+
+DirectoryFileWatcher::~DirectoryFileWatcher()
+{
+    for(uint64 i = 0; i < directories.Count(); ++i)
+    {
+        CloseDirectory(*directories[i]);
+        delete directories[i];
+    }
+    directories.Shutdown();
+}
+
+void DirectoryFileWatcher::AddFile(const wchar* filePath)
+{
+    const wstring fullPath = CanonicalPath(filePath);
+    if(watchedFiles.Contains(fullPath))
+        return;
+
+    const wstring dirPath = GetDirectoryFromFilePath(fullPath.c_str());
+    WatchedDirectory* dir = FindDirectory(dirPath);
+    if(dir == nullptr)
+    {
+        dir = new WatchedDirectory();
+        dir->DirPath = dirPath;
+        dir->DirHandle = CreateFile(dirPath.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        dir->NotifyBuffer.Init(NotifyBufferSize / sizeof(uint32));
+        directories.Add(dir);
+
+        if(dir->DirHandle == INVALID_HANDLE_VALUE || BeginRead(*dir) == false)
+        {
+            WriteLog(L"Can't watch directory '%ls' for changes, falling back to polling", dirPath.c_str());
+            CloseDirectory(*dir);
+        }
+    }
+
+    watchedFiles.Insert(fullPath, filePath);
+    if(dir->DirHandle != INVALID_HANDLE_VALUE)
+        dir->FilePaths.Add(filePath);
+    else
+        fallback.AddFile(filePath);
+}
+
+void DirectoryFileWatcher::GetChangedFiles(GrowableList<wstring>& changedFiles)
+{
+    const uint64 currTime = GetTickCount64();
+    for(uint64 i = 0; i < directories.Count(); ++i)
+    {
+        WatchedDirectory& dir = *directories[i];
+        if(dir.DirHandle != INVALID_HANDLE_VALUE && HasOverlappedIoCompleted(&dir.Overlapped))
+            ProcessNotifications(dir, currTime);
+    }
+
+    changeQueue.PopSettledFiles(currTime, changedFiles);
+    fallback.GetChangedFiles(changedFiles);
+}
+
+DirectoryFileWatcher::WatchedDirectory* DirectoryFileWatcher::FindDirectory(const wstring& dirPath)
+{
+    for(uint64 i = 0; i < directories.Count(); ++i)
+        if(directories[i]->DirPath == dirPath)
+            return directories[i];
+    return nullptr;
+}
+
+bool DirectoryFileWatcher::BeginRead(WatchedDirectory& dir)
+{
+    dir.Overlapped = OVERLAPPED();
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    return ReadDirectoryChangesW(dir.DirHandle, dir.NotifyBuffer.Data(), DWORD(dir.NotifyBuffer.MemorySize()), FALSE,
+                                 filter, NULL, &dir.Overlapped, NULL) != FALSE;
+}
+
+void DirectoryFileWatcher::ProcessNotifications(WatchedDirectory& dir, uint64 currTimeMS)
+{
+    DWORD numBytes = 0;
+    if(GetOverlappedResult(dir.DirHandle, &dir.Overlapped, &numBytes, FALSE) == FALSE)
+        numBytes = 0;
+
+    // An empty result means that the buffer overflowed, and we don't know which files changed
+    if(numBytes == 0)
+    {
+        for(uint64 i = 0; i < dir.FilePaths.Count(); ++i)
+            changeQueue.MarkChanged(dir.FilePaths[i], currTimeMS);
+    }
+    else
+    {
+        const uint8* notifyData = reinterpret_cast<const uint8*>(dir.NotifyBuffer.Data());
+        uint64 offset = 0;
+        while(true)
+        {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(notifyData + offset);
+
+            // Renaming over the file counts too, since that's how some editors save
+            if(info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+            {
+                wstring filePath = dir.DirPath;
+                filePath.append(info->FileName, info->FileNameLength / sizeof(wchar));
+                for(uint64 i = dir.DirPath.length(); i < filePath.length(); ++i)
+                    filePath[i] = towlower(filePath[i]);
+
+                const wstring* watchedPath = watchedFiles.Find(filePath);
+                if(watchedPath != nullptr)
+                    changeQueue.MarkChanged(*watchedPath, currTimeMS);
+            }
+
+            if(info->NextEntryOffset == 0)
+                break;
+            offset += info->NextEntryOffset;
+        }
+    }
+
+    if(BeginRead(dir) == false)
+    {
+        // Hand the files over to polling so that they're still watched
+        WriteLog(L"Lost track of changes to directory '%ls', falling back to polling", dir.DirPath.c_str());
+        for(uint64 i = 0; i < dir.FilePaths.Count(); ++i)
+            fallback.AddFile(dir.FilePaths[i].c_str());
+        CloseDirectory(dir);
+    }
+}
+
+void DirectoryFileWatcher::CloseDirectory(WatchedDirectory& dir)
+{
+    if(dir.DirHandle == INVALID_HANDLE_VALUE)
+        return;
+
+    // The read has to be finished before the buffer can go away
+    if(HasOverlappedIoCompleted(&dir.Overlapped) == false && CancelIoEx(dir.DirHandle, &dir.Overlapped))
+    {
+        DWORD numBytes = 0;
+        GetOverlappedResult(dir.DirHandle, &dir.Overlapped, &numBytes, TRUE);
+    }
+
+    CloseHandle(dir.DirHandle);
+    dir.DirHandle = INVALID_HANDLE_VALUE;
+    dir.FilePaths.Shutdown();
+}
+
+FileWatcher* CreateFileWatcher(uint64 debounceMS)
+{
+    return new DirectoryFileWatcher(debounceMS);
+}
+
+}
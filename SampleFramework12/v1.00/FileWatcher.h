@@ -0,0 +1,131 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers.h"
+
+namespace SampleFramework12
+{
+
+// Editors often save a file with several writes (or write a temporary file and rename it), so a
+// change is only reported once the file has been left alone for this long
+static const uint64 DefaultFileChangeDebounceMS = 100;
+
+// Keeps track of files that have changed, and hands them out once they've settled
+class FileChangeQueue
+{
+
+public:
+
+    void Init(uint64 debounceMS);
+    void Shutdown();
+
+    void MarkChanged(const std::wstring& filePath, uint64 currTimeMS);
+
+    // Appends the files that haven't changed again for at least the debounce time, and takes them out of the queue
+    void PopSettledFiles(uint64 currTimeMS, GrowableList<std::wstring>& changedFiles);
+
+    uint64 Count() const { return lastChanged.Count(); }
+
+private:
+
+    HashMap<std::wstring, uint64> lastChanged;
+    uint64 debounceTime = DefaultFileChangeDebounceMS;
+};
+
+// Watches a set of files for changes. GetChangedFiles() is meant to be called once per frame, and
+// only costs anything when a file has actually changed.
+class FileWatcher
+{
+
+public:
+
+    virtual ~FileWatcher()
+    {
+    }
+
+    virtual void AddFile(const wchar* filePath) = 0;
+
+    // Appends the files that have changed since they were added or last reported, using the same paths
+    // that were passed to AddFile()
+    virtual void GetChangedFiles(GrowableList<std::wstring>& changedFiles) = 0;
+};
+
+// Checks the timestamps of a few files on every call, cycling through all of them. This works
+// everywhere, but the time that it takes to notice a change grows with the number of files.
+class PollingFileWatcher : public FileWatcher
+{
+
+public:
+
+    explicit PollingFileWatcher(uint64 filesPerUpdate = 1, uint64 debounceMS = DefaultFileChangeDebounceMS);
+
+    void AddFile(const wchar* filePath) override;
+    void GetChangedFiles(GrowableList<std::wstring>& changedFiles) override;
+
+private:
+
+    struct WatchedFile
+    {
+        std::wstring FilePath;
+        uint64 TimeStamp = 0;
+    };
+
+    GrowableList<WatchedFile> files;
+    FileChangeQueue changeQueue;
+    uint64 filesPerUpdate = 1;
+    uint64 currFile = 0;
+};
+
+// Uses ReadDirectoryChangesW on the directory of each file, so that the OS tells us about changes
+// instead of us asking about every file. The reads are overlapped, and checking on them is just a
+// look at the OVERLAPPED structure until one of them completes. Files in directories that can't be
+// watched this way (for instance some network shares) fall back to a PollingFileWatcher.
+class DirectoryFileWatcher : public FileWatcher
+{
+
+public:
+
+    explicit DirectoryFileWatcher(uint64 debounceMS = DefaultFileChangeDebounceMS);
+    ~DirectoryFileWatcher();
+
+    void AddFile(const wchar* filePath) override;
+    void GetChangedFiles(GrowableList<std::wstring>& changedFiles) override;
+
+private:
+
+    static const uint64 NotifyBufferSize = 16 * 1024;
+
+    struct WatchedDirectory
+    {
+        std::wstring DirPath;               // Full path in lower case, ending with a backslash
+        HANDLE DirHandle = INVALID_HANDLE_VALUE;
+        OVERLAPPED Overlapped = { };
+        Array<uint32> NotifyBuffer;         // FILE_NOTIFY_INFORMATION needs to be DWORD-aligned
+        GrowableList<std::wstring> FilePaths;   // As they were passed to AddFile
+    };
+
+    WatchedDirectory* FindDirectory(const std::wstring& dirPath);
+    bool BeginRead(WatchedDirectory& dir);
+    void ProcessNotifications(WatchedDirectory& dir, uint64 currTimeMS);
+    void CloseDirectory(WatchedDirectory& dir);
+
+    GrowableList<WatchedDirectory*> directories;
+    HashMap<std::wstring, std::wstring> watchedFiles;       // Full lower-case path -> path passed to AddFile
+    FileChangeQueue changeQueue;
+    PollingFileWatcher fallback;
+};
+
+// Returns a DirectoryFileWatcher, delete it when done
+FileWatcher* CreateFileWatcher(uint64 debounceMS = DefaultFileChangeDebounceMS);
+
+}
@@ -12,6 +12,7 @@
 #include "DX12_Upload.h"
 #include "DX12_Helpers.h"
 #include "GraphicsTypes.h"
+#include "..\\Allocators.h"
 
 #if Debug_
     #define UseDebugDevice_ 1
@@ -43,14 +44,17 @@ static const uint64 NumCmdAllocators = RenderLatency;
 static ID3D12CommandAllocator* CmdAllocators[NumCmdAllocators] = { };
 static Fence FrameFence;
 
-static GrowableList<IUnknown*> DeferredReleases[RenderLatency];
+// These outlive the frame that queued them, so they can't come from the frame allocator. The inline
+// storage covers a typical frame's worth of releases, and a list that spills keeps its storage.
+static const uint64 NumInlineDeferredReleases = 64;
+static SmallList<IUnknown*, NumInlineDeferredReleases> DeferredReleases[RenderLatency];
 static bool ShuttingDown = false;
 
 static void ProcessDeferredReleases(uint64 idx)
 {
     for(uint64 i = 0; i < DeferredReleases[idx].Count(); ++i)
         DeferredReleases[idx][i]->Release();
-    DeferredReleases[idx].RemoveAll(nullptr);
+    DeferredReleases[idx].RemoveAll();
 }
 
 void Initialize(D3D_FEATURE_LEVEL minFeatureLevel, uint32 adapterIdx)
@@ -244,6 +248,25 @@ void EndFrame(IDXGISwapChain4* swapChain, uint32 syncIntervals)
 
     // See if we have any deferred releases to process
     ProcessDeferredReleases(CurrFrameIdx);
+
+    // Anything allocated from the frame allocator on this thread is dead now
+    FrameAllocator::Reset();
+}
+
+// Executes the current command list in the middle of a frame, so that the app can synchronize the
+// queue against another queue. The command list keeps using the current frame's allocator. Note that
+// the GPU doesn't wait for resource uploads that were queued this frame until EndFrame.
+void SubmitCmdList()
+{
+    Assert_(Device);
+
+    DXCall(CmdList->Close());
+
+    ID3D12CommandList* commandLists[] = { CmdList };
+    GfxQueue->ExecuteCommandLists(ArraySize_(commandLists), commandLists);
+
+    DXCall(CmdList->Reset(CmdAllocators[CurrFrameIdx], nullptr));
+    SetDescriptorHeaps(CmdList);
 }
 
 void FlushGPU()
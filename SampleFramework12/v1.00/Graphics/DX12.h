@@ -39,6 +39,7 @@ void Shutdown();
 // Frame submission synchronization
 void BeginFrame();
 void EndFrame(IDXGISwapChain4* swapChain, uint32 syncIntervals);
+void SubmitCmdList();           // Submits what's been recorded so far in CmdList, and keeps recording into it
 void FlushGPU();
 
 void DeferredRelease_(IUnknown* resource);
@@ -375,6 +375,8 @@ void Initialize_Helpers()
 
 void Shutdown_Helpers()
 {
+    Shutdown_PSOCache();
+
     SRVDescriptorHeap.Free(NullTexture2DSRV);
 
     RTVDescriptorHeap.Shutdown();
@@ -11,6 +11,7 @@
 
 #include "..\\PCH.h"
 #include "DX12.h"
+#include "PSOCache.h"
 
 namespace SampleFramework12
 {
@@ -264,10 +264,10 @@ void Initialize_Upload()
         psoDesc.CS = convertCS.ByteCode();
         psoDesc.pRootSignature = convertRootSignature;
         psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-        Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&convertPSO));
+        convertPSO = CreateComputePSO(psoDesc);
 
         psoDesc.CS = convertArrayCS.ByteCode();
-        Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&convertArrayPSO));
+        convertArrayPSO = CreateComputePSO(psoDesc);
     }
 
     convertFence.Init(0);
@@ -0,0 +1,404 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "MeshOptimizer.h"
+#include "..\\Containers.h"
+
+namespace SampleFramework12
+{
+
+// Tuning values from Forsyth's article. The cache size is what the scoring models, and doesn't need to
+// match the hardware exactly.
+static const uint64 ForsythCacheSize = 32;
+static const float CacheDecayPower = 1.5f;
+static const float LastTriangleScore = 0.75f;
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+static const uint64 NumValenceScores = 32;
+
+static const uint64 InvalidTriangle = uint64(-1);
+static const uint32 UnassignedVertex = uint32(-1);
+
+static Float3 GetPosition(const void* positionData, uint64 positionStride, uint64 idx)
+{
+    Float3 position;
+    memcpy(&position, reinterpret_cast<const uint8*>(positionData) + idx * positionStride, sizeof(Float3));
+    return position;
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint64 numIndices, uint64 numVertices, uint64 cacheSize)
+{
+    Assert_(numIndices % 3 == 0);
+    Assert_(cacheSize > 0);
+
+    // A vertex is in the FIFO if fewer than cacheSize vertices have been transformed since it was,
+    // which avoids having to actually shift entries through a queue
+    Array<uint32> cacheTimestamps(numVertices, 0);
+    uint32 timestamp = uint32(cacheSize) + 1;
+
+    VertexCacheStats stats;
+    stats.NumTriangles = numIndices / 3;
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        const uint32 vtxIdx = indices[i];
+        Assert_(vtxIdx < numVertices);
+
+        if(cacheTimestamps[vtxIdx] == 0)
+            ++stats.NumVertices;
+
+        if(timestamp - cacheTimestamps[vtxIdx] > cacheSize)
+        {
+            cacheTimestamps[vtxIdx] = timestamp++;
+            ++stats.NumTransforms;
+        }
+    }
+
+    return stats;
+}
+
+// == Forsyth =====================================================================================
+
+struct ForsythScores
+{
+    float CachePosition[ForsythCacheSize];
+    float Valence[NumValenceScores];
+
+    ForsythScores()
+    {
+        for(uint64 i = 0; i < ForsythCacheSize; ++i)
+        {
+            // The vertices of the last triangle get a fixed score, so that the next triangle isn't just
+            // another one that shares all of the same vertices
+            if(i < 3)
+                CachePosition[i] = LastTriangleScore;
+            else
+                CachePosition[i] = std::pow(1.0f - float(i - 3) / float(ForsythCacheSize - 3), CacheDecayPower);
+        }
+
+        Valence[0] = 0.0f;
+        for(uint64 i = 1; i < NumValenceScores; ++i)
+            Valence[i] = ValenceBoostScale * std::pow(float(i), -ValenceBoostPower);
+    }
+
+    float VertexScore(int32 cachePosition, uint32 numRemainingTriangles) const
+    {
+        // Nothing left to draw with this vertex, so it shouldn't pull in any triangles
+        if(numRemainingTriangles == 0)
+            return -1.0f;
+
+        float score = cachePosition >= 0 ? CachePosition[cachePosition] : 0.0f;
+        if(numRemainingTriangles < NumValenceScores)
+            score += Valence[numRemainingTriangles];
+        else
+            score += ValenceBoostScale * std::pow(float(numRemainingTriangles), -ValenceBoostPower);
+
+        return score;
+    }
+};
+
+void OptimizeVertexCache(uint32* indices, uint64 numIndices, uint64 numVertices)
+{
+    Assert_(numIndices % 3 == 0);
+
+    const uint64 numTriangles = numIndices / 3;
+    if(numTriangles == 0)
+        return;
+
+    static const ForsythScores scores;
+
+    // Build a list of the triangles that use each vertex. Triangles get removed from these lists as
+    // they're added to the output, so only the first numActiveTriangles[vtxIdx] entries are valid.
+    Array<uint32> numActiveTriangles(numVertices, 0);
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        Assert_(indices[i] < numVertices);
+        ++numActiveTriangles[indices[i]];
+    }
+
+    Array<uint32> adjacencyOffsets(numVertices);
+    uint32 adjacencyOffset = 0;
+    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+    {
+        adjacencyOffsets[vtxIdx] = adjacencyOffset;
+        adjacencyOffset += numActiveTriangles[vtxIdx];
+    }
+
+    Array<uint32> adjacency(numIndices);
+    {
+        Array<uint32> adjacencyCounts(numVertices, 0);
+        for(uint64 i = 0; i < numIndices; ++i)
+        {
+            const uint32 vtxIdx = indices[i];
+            adjacency[adjacencyOffsets[vtxIdx] + adjacencyCounts[vtxIdx]++] = uint32(i / 3);
+        }
+    }
+
+    Array<int32> cachePositions(numVertices, -1);
+    Array<float> vertexScores(numVertices);
+    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+        vertexScores[vtxIdx] = scores.VertexScore(-1, numActiveTriangles[vtxIdx]);
+
+    Array<uint8> triangleAdded(numTriangles, 0);
+    uint64 bestTriangle = InvalidTriangle;
+    float bestScore = -1.0f;
+    for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
+    {
+        const uint32* triangle = indices + triIdx * 3;
+        const float score = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+        if(score > bestScore)
+        {
+            bestTriangle = triIdx;
+            bestScore = score;
+        }
+    }
+
+    Array<uint32> output(numIndices);
+    uint32 cache[ForsythCacheSize + 3] = { };
+    uint32 newCache[ForsythCacheSize + 3] = { };
+    uint64 cacheCount = 0;
+    uint64 scanCursor = 0;
+
+    for(uint64 outputIdx = 0; outputIdx < numTriangles; ++outputIdx)
+    {
+        if(bestTriangle == InvalidTriangle)
+        {
+            // Nothing in the cache has any triangles left, so start again from the first triangle that
+            // hasn't been added yet
+            while(triangleAdded[scanCursor])
+                ++scanCursor;
+            bestTriangle = scanCursor;
+        }
+
+        const uint32* triangle = indices + bestTriangle * 3;
+        output[outputIdx * 3 + 0] = triangle[0];
+        output[outputIdx * 3 + 1] = triangle[1];
+        output[outputIdx * 3 + 2] = triangle[2];
+        triangleAdded[bestTriangle] = 1;
+
+        for(uint64 corner = 0; corner < 3; ++corner)
+        {
+            const uint32 vtxIdx = triangle[corner];
+            uint32* vtxTriangles = adjacency.Data() + adjacencyOffsets[vtxIdx];
+            const uint32 numVtxTriangles = numActiveTriangles[vtxIdx];
+            for(uint32 i = 0; i < numVtxTriangles; ++i)
+            {
+                if(vtxTriangles[i] == bestTriangle)
+                {
+                    vtxTriangles[i] = vtxTriangles[numVtxTriangles - 1];
+                    --numActiveTriangles[vtxIdx];
+                    break;
+                }
+            }
+        }
+
+        // The vertices of the new triangle go to the front of the LRU cache, and everything else shifts
+        // back. Anything that ends up past ForsythCacheSize falls out of the cache.
+        uint64 newCacheCount = 0;
+        for(uint64 corner = 0; corner < 3; ++corner)
+        {
+            const uint32 vtxIdx = triangle[corner];
+            bool alreadyAdded = false;
+            for(uint64 i = 0; i < newCacheCount; ++i)
+                alreadyAdded = alreadyAdded || newCache[i] == vtxIdx;
+            if(alreadyAdded == false)
+                newCache[newCacheCount++] = vtxIdx;
+        }
+
+        for(uint64 i = 0; i < cacheCount; ++i)
+        {
+            const uint32 vtxIdx = cache[i];
+            if(vtxIdx != triangle[0] && vtxIdx != triangle[1] && vtxIdx != triangle[2])
+                newCache[newCacheCount++] = vtxIdx;
+        }
+
+        for(uint64 i = 0; i < newCacheCount; ++i)
+        {
+            const uint32 vtxIdx = newCache[i];
+            cachePositions[vtxIdx] = i < ForsythCacheSize ? int32(i) : -1;
+            vertexScores[vtxIdx] = scores.VertexScore(cachePositions[vtxIdx], numActiveTriangles[vtxIdx]);
+        }
+
+        cacheCount = Min(newCacheCount, ForsythCacheSize);
+        memcpy(cache, newCache, cacheCount * sizeof(uint32));
+
+        // Only triangles that touch a vertex whose score changed need to be re-scored, and the next
+        // triangle is picked from among those
+        bestTriangle = InvalidTriangle;
+        bestScore = -1.0f;
+        for(uint64 i = 0; i < newCacheCount; ++i)
+        {
+            const uint32 vtxIdx = newCache[i];
+            const uint32* vtxTriangles = adjacency.Data() + adjacencyOffsets[vtxIdx];
+            for(uint32 j = 0; j < numActiveTriangles[vtxIdx]; ++j)
+            {
+                const uint32 triIdx = vtxTriangles[j];
+                const uint32* tri = indices + triIdx * 3;
+                const float score = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+                if(score > bestScore)
+                {
+                    bestTriangle = triIdx;
+                    bestScore = score;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.Data(), numIndices * sizeof(uint32));
+}
+
+// == Overdraw ====================================================================================
+
+void OptimizeOverdraw(uint32* indices, uint64 numIndices, const void* positionData, uint64 positionStride,
+                      uint64 numVertices, float cacheThreshold)
+{
+    Assert_(numIndices % 3 == 0);
+
+    const uint64 numTriangles = numIndices / 3;
+    if(numTriangles <= 1)
+        return;
+
+    // Cut a new cluster whenever the current one has gotten its ACMR close enough to the ACMR of the
+    // whole mesh. Every cluster is simulated as starting with an empty cache, since that's what'll
+    // happen once they've been sorted.
+    const uint64 cacheSize = DefaultAnalysisCacheSize;
+    const VertexCacheStats meshStats = AnalyzeVertexCache(indices, numIndices, numVertices, cacheSize);
+    const float maxClusterACMR = meshStats.ACMR() * cacheThreshold;
+
+    GrowableList<uint64> clusterStarts;
+    clusterStarts.Add(0);
+    {
+        Array<uint32> cacheTimestamps(numVertices, 0);
+        uint32 timestamp = uint32(cacheSize) + 1;
+        uint64 clusterStart = 0;
+        uint64 clusterTransforms = 0;
+        for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
+        {
+            for(uint64 corner = 0; corner < 3; ++corner)
+            {
+                const uint32 vtxIdx = indices[triIdx * 3 + corner];
+                if(timestamp - cacheTimestamps[vtxIdx] > cacheSize)
+                {
+                    cacheTimestamps[vtxIdx] = timestamp++;
+                    ++clusterTransforms;
+                }
+            }
+
+            const uint64 numClusterTriangles = triIdx - clusterStart + 1;
+            if(triIdx + 1 < numTriangles && float(clusterTransforms) <= maxClusterACMR * float(numClusterTriangles))
+            {
+                clusterStart = triIdx + 1;
+                clusterStarts.Add(clusterStart);
+                clusterTransforms = 0;
+                timestamp += uint32(cacheSize) + 1;
+            }
+        }
+    }
+
+    const uint64 numClusters = clusterStarts.Count();
+    if(numClusters <= 1)
+        return;
+
+    // Area-weighted centroids and normals for each cluster, and for the mesh as a whole
+    Array<Float3> clusterCentroids(numClusters);
+    Array<Float3> clusterNormals(numClusters);
+    Float3 meshCentroid;
+    float meshArea = 0.0f;
+    for(uint64 clusterIdx = 0; clusterIdx < numClusters; ++clusterIdx)
+    {
+        const uint64 start = clusterStarts[clusterIdx];
+        const uint64 end = clusterIdx + 1 < numClusters ? clusterStarts[clusterIdx + 1] : numTriangles;
+
+        Float3 centroidSum;
+        Float3 normalSum;
+        float areaSum = 0.0f;
+        for(uint64 triIdx = start; triIdx < end; ++triIdx)
+        {
+            const Float3 p0 = GetPosition(positionData, positionStride, indices[triIdx * 3 + 0]);
+            const Float3 p1 = GetPosition(positionData, positionStride, indices[triIdx * 3 + 1]);
+            const Float3 p2 = GetPosition(positionData, positionStride, indices[triIdx * 3 + 2]);
+
+            const Float3 normal = Float3::Cross(p1 - p0, p2 - p0);
+            const float area = Float3::Length(normal);
+            centroidSum += (p0 + p1 + p2) * (area / 3.0f);
+            normalSum += normal;
+            areaSum += area;
+        }
+
+        meshCentroid += centroidSum;
+        meshArea += areaSum;
+
+        clusterCentroids[clusterIdx] = areaSum > 0.0f ? centroidSum / areaSum : Float3();
+        const float normalLength = Float3::Length(normalSum);
+        clusterNormals[clusterIdx] = normalLength > 0.0f ? normalSum / normalLength : Float3();
+    }
+
+    if(meshArea > 0.0f)
+        meshCentroid = meshCentroid / meshArea;
+
+    Array<float> sortKeys(numClusters);
+    Array<uint64> clusterOrder(numClusters);
+    for(uint64 clusterIdx = 0; clusterIdx < numClusters; ++clusterIdx)
+    {
+        sortKeys[clusterIdx] = Float3::Dot(clusterCentroids[clusterIdx] - meshCentroid, clusterNormals[clusterIdx]);
+        clusterOrder[clusterIdx] = clusterIdx;
+    }
+
+    std::stable_sort(clusterOrder.Data(), clusterOrder.Data() + numClusters, [&](uint64 a, uint64 b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    Array<uint32> output(numIndices);
+    uint64 outputIdx = 0;
+    for(uint64 i = 0; i < numClusters; ++i)
+    {
+        const uint64 clusterIdx = clusterOrder[i];
+        const uint64 start = clusterStarts[clusterIdx];
+        const uint64 end = clusterIdx + 1 < numClusters ? clusterStarts[clusterIdx + 1] : numTriangles;
+        const uint64 numClusterIndices = (end - start) * 3;
+        memcpy(&output[outputIdx], indices + start * 3, numClusterIndices * sizeof(uint32));
+        outputIdx += numClusterIndices;
+    }
+
+    Assert_(outputIdx == numIndices);
+    memcpy(indices, output.Data(), numIndices * sizeof(uint32));
+}
+
+// == Vertex Fetch ================================================================================
+
+void OptimizeVertexFetch(void* vertexData, uint64 vertexStride, uint64 numVertices, uint32* indices, uint64 numIndices)
+{
+    if(numVertices == 0)
+        return;
+
+    Array<uint32> remap(numVertices, UnassignedVertex);
+    uint32 nextVertex = 0;
+    for(uint64 i = 0; i < numIndices; ++i)
+    {
+        Assert_(indices[i] < numVertices);
+        if(remap[indices[i]] == UnassignedVertex)
+            remap[indices[i]] = nextVertex++;
+        indices[i] = remap[indices[i]];
+    }
+
+    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+        if(remap[vtxIdx] == UnassignedVertex)
+            remap[vtxIdx] = nextVertex++;
+
+    Array<uint8> srcVertices(numVertices * vertexStride);
+    memcpy(srcVertices.Data(), vertexData, numVertices * vertexStride);
+
+    uint8* dstVertices = reinterpret_cast<uint8*>(vertexData);
+    for(uint64 vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+        memcpy(dstVertices + remap[vtxIdx] * vertexStride, &srcVertices[vtxIdx * vertexStride], vertexStride);
+}
+
+}
@@ -0,0 +1,70 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\SF12_Math.h"
+#include "..\\Serialization.h"
+
+namespace SampleFramework12
+{
+
+// Results of running an index list through a simulated FIFO post-transform cache. ACMR is the average
+// number of vertices transformed per triangle (0.5 is ideal for a big regular grid, 3.0 is the worst
+// case), and ATVR is the number of vertices transformed per unique vertex (1.0 is ideal).
+struct VertexCacheStats
+{
+    uint64 NumTriangles = 0;
+    uint64 NumVertices = 0;
+    uint64 NumTransforms = 0;
+
+    float ACMR() const { return NumTriangles > 0 ? float(NumTransforms) / float(NumTriangles) : 0.0f; }
+    float ATVR() const { return NumVertices > 0 ? float(NumTransforms) / float(NumVertices) : 0.0f; }
+
+    void Add(const VertexCacheStats& other)
+    {
+        NumTriangles += other.NumTriangles;
+        NumVertices += other.NumVertices;
+        NumTransforms += other.NumTransforms;
+    }
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, NumTriangles);
+        SerializeItem(serializer, NumVertices);
+        SerializeItem(serializer, NumTransforms);
+    }
+};
+
+static const uint64 DefaultAnalysisCacheSize = 16;
+
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint64 numIndices, uint64 numVertices,
+                                    uint64 cacheSize = DefaultAnalysisCacheSize);
+
+// Reorders triangles for the post-transform vertex cache, using Tom Forsyth's "Linear-Speed Vertex
+// Cache Optimisation". This is greedy, and picks the next triangle by scoring vertices on how
+// recently they were used and on how many triangles still need them.
+void OptimizeVertexCache(uint32* indices, uint64 numIndices, uint64 numVertices);
+
+// Reorders triangles to reduce overdraw, without giving back much of what OptimizeVertexCache()
+// gained. The triangles are split into clusters wherever the vertex cache would have to start over
+// anyway (or close to it, as determined by cacheThreshold), and then clusters that face away from the
+// center of the mesh are drawn first since they're the most likely to occlude the others.
+// This expects triangle normals from cross(p1 - p0, p2 - p0) to face outwards.
+void OptimizeOverdraw(uint32* indices, uint64 numIndices, const void* positionData, uint64 positionStride,
+                      uint64 numVertices, float cacheThreshold = 1.05f);
+
+// Reorders vertices in the order that they're first referenced by the indices, so that vertex fetches
+// walk through memory linearly. The indices are remapped to match, and any vertices that aren't
+// referenced at all end up at the back.
+void OptimizeVertexFetch(void* vertexData, uint64 vertexStride, uint64 numVertices, uint32* indices, uint64 numIndices);
+
+}
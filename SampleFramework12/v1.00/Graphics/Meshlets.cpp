@@ -0,0 +1,217 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Meshlets.h"
+
+namespace SampleFramework12
+{
+
+StaticAssert_(MaxMeshletVertices <= 255);
+
+static const uint8 UnassignedVertex = 0xFF;
+
+static Float3 GetPosition(const void* positionData, uint64 positionStride, uint64 idx)
+{
+    Float3 position;
+    memcpy(&position, reinterpret_cast<const uint8*>(positionData) + idx * positionStride, sizeof(Float3));
+    return position;
+}
+
+static uint32 TriangleVertex(uint32 packedTriangle, uint64 corner)
+{
+    return (packedTriangle >> (corner * 8)) & 0xFF;
+}
+
+// Ritter's bounding sphere: start with the most distant pair of axis-aligned extreme points, and then
+// grow the sphere to take in any points that are still outside. It's not the smallest sphere, but
+// it's usually within a few percent.
+static void ComputeBoundingSphere(const Float3* points, uint64 numPoints, Float3& center, float& radius)
+{
+    Assert_(numPoints > 0);
+
+    uint64 minIdx[3] = { };
+    uint64 maxIdx[3] = { };
+    for(uint64 i = 1; i < numPoints; ++i)
+    {
+        for(uint32 axis = 0; axis < 3; ++axis)
+        {
+            if(points[i][axis] < points[minIdx[axis]][axis])
+                minIdx[axis] = i;
+            if(points[i][axis] > points[maxIdx[axis]][axis])
+                maxIdx[axis] = i;
+        }
+    }
+
+    uint64 widestAxis = 0;
+    float widestDistSq = 0.0f;
+    for(uint64 axis = 0; axis < 3; ++axis)
+    {
+        const Float3 diff = points[maxIdx[axis]] - points[minIdx[axis]];
+        const float distSq = Float3::Dot(diff, diff);
+        if(distSq > widestDistSq)
+        {
+            widestAxis = axis;
+            widestDistSq = distSq;
+        }
+    }
+
+    center = (points[minIdx[widestAxis]] + points[maxIdx[widestAxis]]) * 0.5f;
+    radius = std::sqrt(widestDistSq) * 0.5f;
+
+    for(uint64 i = 0; i < numPoints; ++i)
+    {
+        const Float3 diff = points[i] - center;
+        const float distSq = Float3::Dot(diff, diff);
+        if(distSq > radius * radius)
+        {
+            const float dist = std::sqrt(distSq);
+            const float newRadius = (radius + dist) * 0.5f;
+            center += diff * ((newRadius - radius) / dist);
+            radius = newRadius;
+        }
+    }
+
+    // Leave a little slack for the accumulated rounding error
+    radius *= 1.0f + 1e-5f;
+}
+
+void ComputeMeshletBounds(const void* positionData, uint64 positionStride, const uint32* meshletVertices,
+                          const uint32* meshletTriangles, Meshlet& meshlet)
+{
+    Assert_(meshlet.VertexCount <= MaxMeshletVertices);
+    Assert_(meshlet.TriangleCount <= MaxMeshletTriangles);
+
+    Float3 positions[MaxMeshletVertices];
+    for(uint64 i = 0; i < meshlet.VertexCount; ++i)
+        positions[i] = GetPosition(positionData, positionStride, meshletVertices[meshlet.VertexStart + i]);
+
+    if(meshlet.VertexCount > 0)
+        ComputeBoundingSphere(positions, meshlet.VertexCount, meshlet.SphereCenter, meshlet.SphereRadius);
+
+    // Degenerate triangles don't have a facing, so they're left out of the cone
+    Float3 normals[MaxMeshletTriangles];
+    Float3 corners[MaxMeshletTriangles];
+    uint64 numNormals = 0;
+    Float3 normalSum;
+    for(uint64 i = 0; i < meshlet.TriangleCount; ++i)
+    {
+        const uint32 triangle = meshletTriangles[meshlet.TriangleStart + i];
+        const Float3& p0 = positions[TriangleVertex(triangle, 0)];
+        const Float3& p1 = positions[TriangleVertex(triangle, 1)];
+        const Float3& p2 = positions[TriangleVertex(triangle, 2)];
+
+        const Float3 normal = Float3::Cross(p1 - p0, p2 - p0);
+        const float length = Float3::Length(normal);
+        if(length <= 0.0f)
+            continue;
+
+        normals[numNormals] = normal / length;
+        corners[numNormals] = p0;
+        normalSum += normals[numNormals];
+        ++numNormals;
+    }
+
+    meshlet.ConeApex = meshlet.SphereCenter;
+    meshlet.ConeAxis = Float3(0.0f, 0.0f, 1.0f);
+    meshlet.ConeCutoff = 1.0f;
+
+    const float normalSumLength = Float3::Length(normalSum);
+    if(numNormals == 0 || normalSumLength <= 1e-6f)
+        return;
+
+    const Float3 axis = normalSum / normalSumLength;
+    float minDot = 1.0f;
+    for(uint64 i = 0; i < numNormals; ++i)
+        minDot = Min(minDot, Float3::Dot(normals[i], axis));
+
+    // Normals that are more than 90 degrees apart can face the viewer from anywhere
+    meshlet.ConeAxis = axis;
+    if(minDot <= 0.0f)
+        return;
+
+    // Move the apex back along the axis until it's behind the plane of every triangle, so that the
+    // cone test is conservative no matter where the viewer is
+    float maxT = 0.0f;
+    for(uint64 i = 0; i < numNormals; ++i)
+    {
+        const float t = Float3::Dot(meshlet.SphereCenter - corners[i], normals[i]) / Float3::Dot(axis, normals[i]);
+        maxT = Max(maxT, t);
+    }
+
+    meshlet.ConeApex = meshlet.SphereCenter - axis * maxT;
+    meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(const void* positionData, uint64 positionStride, uint64 numVertices,
+                   const uint32* indices, uint64 numIndices, MeshletData& output)
+{
+    Assert_(numIndices % 3 == 0);
+
+    // Maps vertices to their index within the current meshlet, and gets reset for just the vertices
+    // of each meshlet once it's finished
+    Array<uint8> localIndices(numVertices, UnassignedVertex);
+
+    Meshlet meshlet;
+    meshlet.VertexStart = uint32(output.Vertices.Count());
+    meshlet.TriangleStart = uint32(output.Triangles.Count());
+
+    auto finishMeshlet = [&]()
+    {
+        for(uint64 i = 0; i < meshlet.VertexCount; ++i)
+            localIndices[output.Vertices[meshlet.VertexStart + i]] = UnassignedVertex;
+
+        ComputeMeshletBounds(positionData, positionStride, output.Vertices.Data(), output.Triangles.Data(), meshlet);
+        output.Meshlets.Add(meshlet);
+
+        meshlet = Meshlet();
+        meshlet.VertexStart = uint32(output.Vertices.Count());
+        meshlet.TriangleStart = uint32(output.Triangles.Count());
+    };
+
+    const uint64 numTriangles = numIndices / 3;
+    for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
+    {
+        const uint32* triangle = indices + triIdx * 3;
+        Assert_(triangle[0] < numVertices && triangle[1] < numVertices && triangle[2] < numVertices);
+
+        uint64 numNewVertices = 0;
+        for(uint64 corner = 0; corner < 3; ++corner)
+        {
+            const bool repeated = (corner > 0 && triangle[corner] == triangle[0]) || (corner > 1 && triangle[corner] == triangle[1]);
+            if(localIndices[triangle[corner]] == UnassignedVertex && repeated == false)
+                ++numNewVertices;
+        }
+
+        if(meshlet.VertexCount + numNewVertices > MaxMeshletVertices || meshlet.TriangleCount == MaxMeshletTriangles)
+            finishMeshlet();
+
+        uint32 packedTriangle = 0;
+        for(uint64 corner = 0; corner < 3; ++corner)
+        {
+            uint8& localIdx = localIndices[triangle[corner]];
+            if(localIdx == UnassignedVertex)
+            {
+                localIdx = uint8(meshlet.VertexCount++);
+                output.Vertices.Add(triangle[corner]);
+            }
+
+            packedTriangle |= uint32(localIdx) << (corner * 8);
+        }
+
+        output.Triangles.Add(packedTriangle);
+        ++meshlet.TriangleCount;
+    }
+
+    if(meshlet.TriangleCount > 0)
+        finishMeshlet();
+}
+
+}
@@ -0,0 +1,74 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\SF12_Math.h"
+#include "..\\Containers.h"
+
+namespace SampleFramework12
+{
+
+static const uint64 MaxMeshletVertices = 64;
+static const uint64 MaxMeshletTriangles = 124;
+
+// A cluster of up to 64 vertices and 124 triangles, for culling at a coarser granularity than
+// single triangles. Each triangle is stored as 3 8-bit indices into the meshlet's list of vertices,
+// packed into the low 24 bits of a uint32.
+struct Meshlet
+{
+    uint32 VertexStart = 0;
+    uint32 VertexCount = 0;
+    uint32 TriangleStart = 0;
+    uint32 TriangleCount = 0;
+
+    Float3 SphereCenter;
+    float SphereRadius = 0.0f;
+
+    // Normal cone, built from the triangle normals (cross(p1 - p0, p2 - p0), which faces outwards
+    // for the clockwise front faces used by the framework). Every triangle in the meshlet faces
+    // away from a viewer at P if dot(normalize(ConeApex - P), ConeAxis) >= ConeCutoff, and a cutoff
+    // of 1 means that the normals are spread out too much to ever cull the meshlet this way.
+    Float3 ConeApex;
+    float ConeCutoff = 1.0f;
+    Float3 ConeAxis;
+    uint32 Padding = 0;
+};
+
+StaticAssert_(sizeof(Meshlet) == 64);
+
+// Range of meshlets that were built from a single MeshPart
+struct MeshletRange
+{
+    uint32 MeshletStart = 0;
+    uint32 MeshletCount = 0;
+};
+
+struct MeshletData
+{
+    GrowableList<Meshlet> Meshlets;
+    GrowableList<uint32> Vertices;
+    GrowableList<uint32> Triangles;
+};
+
+// Splits a list of triangles into meshlets, by walking through the triangles in order and starting a
+// new meshlet whenever the current one fills up. Meshlets come out tighter when the triangles have
+// been sorted for locality beforehand, which is also what the post-transform vertex cache wants.
+// Vertices are written out with the same values as the indices, so they're relative to positionData.
+void BuildMeshlets(const void* positionData, uint64 positionStride, uint64 numVertices,
+                   const uint32* indices, uint64 numIndices, MeshletData& output);
+
+// Fills in the bounding sphere and normal cone for a meshlet that's already had its vertices and
+// triangles assigned
+void ComputeMeshletBounds(const void* positionData, uint64 positionStride, const uint32* meshletVertices,
+                          const uint32* meshletTriangles, Meshlet& meshlet);
+
+}
@@ -16,7 +16,10 @@
 #include "GraphicsTypes.h"
 #include "..\\Serialization.h"
 #include "..\\FileIO.h"
+#include "..\\ChunkedFile.h"
 #include "Textures.h"
+#include "VertexCompression.h"
+#include "..\\EnkiTS\\TaskScheduler.h"
 
 using std::string;
 using std::wstring;
@@ -45,6 +48,23 @@ static const D3D12_INPUT_ELEMENT_DESC StandardInputElements[5] =
     { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 44, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 };
 
+// The bitangent sign is in POSITION.w, see CompactMeshVertex for how to decode the rest
+static const InputElementType CompactInputElementTypes[4] =
+{
+    InputElementType::Position,
+    InputElementType::Normal,
+    InputElementType::UV,
+    InputElementType::Tangent,
+};
+
+static const D3D12_INPUT_ELEMENT_DESC CompactInputElements[4] =
+{
+    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "UV", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
 static const wchar* DefaultTextures[] =
 {
     L"..\\Content\\Textures\\Default.dds",              // Albedo
@@ -125,18 +145,13 @@ void LoadMaterialResources(Array<MeshMaterial>& materials, const wstring& direct
     }
 }
 
-void Mesh::InitFromAssimpMesh(const aiMesh& assimpMesh, float sceneScale, MeshVertex* dstVertices, uint16* dstIndices)
+void Mesh::InitFromAssimpMesh(const aiMesh& assimpMesh, float sceneScale, MeshVertex* dstVertices, uint32* dstIndices)
 {
     numVertices = assimpMesh.mNumVertices;
     numIndices = assimpMesh.mNumFaces * 3;
 
-    indexType = IndexType::Index16Bit;
-    if(numVertices > 0xFFFF)
-    {
-        AssertMsg_(false, "32-bit indices not currently supported");
-        // indexSize = 4;
-        // indexType = IndexType::Index32Bit;
-    }
+    // The model switches its whole index buffer over to 32-bit if any of its meshes need it
+    indexType = numVertices > 0xFFFF ? IndexType::Index32Bit : IndexType::Index16Bit;
 
 
     if(assimpMesh.HasPositions())
@@ -185,9 +200,9 @@ void Mesh::InitFromAssimpMesh(const aiMesh& assimpMesh, float sceneScale, MeshVe
     const uint64 numTriangles = assimpMesh.mNumFaces;
     for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
     {
-        dstIndices[triIdx * 3 + 0] = uint16(assimpMesh.mFaces[triIdx].mIndices[0]);
-        dstIndices[triIdx * 3 + 1] = uint16(assimpMesh.mFaces[triIdx].mIndices[1]);
-        dstIndices[triIdx * 3 + 2] = uint16(assimpMesh.mFaces[triIdx].mIndices[2]);
+        dstIndices[triIdx * 3 + 0] = assimpMesh.mFaces[triIdx].mIndices[0];
+        dstIndices[triIdx * 3 + 1] = assimpMesh.mFaces[triIdx].mIndices[1];
+        dstIndices[triIdx * 3 + 2] = assimpMesh.mFaces[triIdx].mIndices[2];
     }
 
     const uint64 numSubsets = 1;
@@ -206,7 +221,7 @@ static const uint64 NumBoxIndices = 36;
 // Initializes the mesh as a box
 void Mesh::InitBox(const Float3& dimensions, const Float3& position,
                    const Quaternion& orientation, uint32 materialIdx,
-                   MeshVertex* dstVertices, uint16* dstIndices)
+                   MeshVertex* dstVertices, uint32* dstIndices)
 {
     uint64 vIdx = 0;
 
@@ -319,7 +334,7 @@ const uint64 NumPlaneIndices = 6;
 
 // Initializes the mesh as a plane
 void Mesh::InitPlane(const Float2& dimensions, const Float3& position, const Quaternion& orientation, uint32 materialIdx,
-                     MeshVertex* dstVertices, uint16* dstIndices)
+                     MeshVertex* dstVertices, uint32* dstIndices)
 {
     uint64 vIdx = 0;
 
@@ -354,18 +369,21 @@ void Mesh::InitPlane(const Float2& dimensions, const Float3& position, const Qua
     part.MaterialIdx = materialIdx;
 }
 
-void Mesh::InitCommon(const MeshVertex* vertices_, const uint16* indices_, uint64 vbAddress, uint64 ibAddress, uint64 vtxOffset_, uint64 idxOffset_)
+void Mesh::InitCommon(const MeshVertex* vertices_, const uint32* indices_, uint64 vbAddress, uint64 ibAddress, uint64 vtxOffset_, uint64 idxOffset_,
+                      uint64 vertexStride, IndexType indexType_)
 {
     Assert_(meshParts.Size() > 0);
+    Assert_(indexType_ == IndexType::Index32Bit || numVertices <= 0xFFFF);
 
     vertices = vertices_;
     indices = indices_;
     vtxOffset = uint32(vtxOffset_);
     idxOffset = uint32(idxOffset_);
+    indexType = indexType_;
 
     vbView.BufferLocation = vbAddress;
-    vbView.SizeInBytes = sizeof(MeshVertex) * numVertices;
-    vbView.StrideInBytes = sizeof(MeshVertex);
+    vbView.SizeInBytes = uint32(vertexStride * numVertices);
+    vbView.StrideInBytes = uint32(vertexStride);
 
     ibView.Format = IndexBufferFormat();
     ibView.SizeInBytes = IndexSize() * numIndices;
@@ -373,15 +391,6 @@ void Mesh::InitCommon(const MeshVertex* vertices_, const uint16* indices_, uint6
 }
 
 
-void Mesh::Shutdown()
-{
-    numVertices = 0;
-    numIndices = 0;
-    meshParts.Shutdown();
-    vertices = nullptr;
-    indices = nullptr;
-}
-
 const char* Mesh::InputElementTypeString(InputElementType elemType)
 {
     static const char* ElemStrings[] =
@@ -427,6 +436,7 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
 
     fileDirectory = GetDirectoryFromFilePath(filePath);
     forceSRGB = settings.ForceSRGB;
+    vertexFormat = settings.VertexFormat;
 
     // Grab the lights before we process the scene
     spotLights.Init(scene->mNumLights);
@@ -553,22 +563,34 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
         idxOffset += meshes[i].NumIndices();
     }
 
-    CreateBuffers();
+    if(settings.OptimizeMeshes)
+        OptimizeMeshes(settings.TaskScheduler);
+
+    CreateBuffers(settings.TaskScheduler);
 
     WriteLog("Finished loading scene '%ls'", filePath);
 }
 
-void Model::CreateFromMeshData(const wchar* filePath)
+void Model::CreateFromMeshData(const wchar* filePath, MeshVertexFormat vertexFormat_, enki::TaskScheduler* taskScheduler)
 {
     if(FileExists(filePath) == false)
         throw Exception(MakeString(L"Model file with path '%ls' does not exist", filePath));
 
     fileDirectory = GetDirectoryFromFilePath(filePath);
+    vertexFormat = vertexFormat_;
 
-    FileReadSerializer serializer(filePath);
-    Serialize(serializer);
+    if(ChunkedFileReader::IsChunkedFile(filePath))
+    {
+        LoadChunkedMeshData(filePath, taskScheduler);
+    }
+    else
+    {
+        MappedReadSerializer serializer(filePath);
+        Serialize(serializer);
+    }
 
-    CreateBuffers();
+    OptimizeMeshes(taskScheduler);
+    CreateBuffers(taskScheduler);
 
     LoadMaterialResources(meshMaterials, fileDirectory, forceSRGB, materialTextures, descriptorHeap);
 }
@@ -648,42 +670,117 @@ void Model::Shutdown()
     descriptorHeap.Shutdown();
     fileDirectory = L"";
     forceSRGB = false;
+    vertexFormat = MeshVertexFormat::Standard;
+    indexType = IndexType::Index16Bit;
+    meshesOptimized = false;
+    unoptimizedCacheStats = VertexCacheStats();
+    optimizedCacheStats = VertexCacheStats();
 
     vertexBuffer.Shutdown();
     indexBuffer.Shutdown();
     vertices.Shutdown();
     indices.Shutdown();
+
+    meshletBuffer.Shutdown();
+    meshletVertexBuffer.Shutdown();
+    meshletTriangleBuffer.Shutdown();
+    meshlets.Shutdown();
+    meshletVertices.Shutdown();
+    meshletTriangles.Shutdown();
 }
 
-const D3D12_INPUT_ELEMENT_DESC* Model::InputElements()
+const D3D12_INPUT_ELEMENT_DESC* Model::InputElements(MeshVertexFormat format)
 {
-    return StandardInputElements;
+    return format == MeshVertexFormat::Compact ? CompactInputElements : StandardInputElements;
 }
 
-const InputElementType* Model::InputElementTypes()
+const InputElementType* Model::InputElementTypes(MeshVertexFormat format)
 {
-    return StandardInputElementTypes;
+    return format == MeshVertexFormat::Compact ? CompactInputElementTypes : StandardInputElementTypes;
 }
 
-uint64 Model::NumInputElements()
+uint64 Model::NumInputElements(MeshVertexFormat format)
 {
-    return ArraySize_(StandardInputElements);
+    return format == MeshVertexFormat::Compact ? ArraySize_(CompactInputElements) : ArraySize_(StandardInputElements);
 }
 
-void Model::CreateBuffers()
+uint64 Model::VertexStride(MeshVertexFormat format)
+{
+    return format == MeshVertexFormat::Compact ? sizeof(CompactMeshVertex) : sizeof(MeshVertex);
+}
+
+void Model::CreateBuffers(enki::TaskScheduler* taskScheduler)
 {
     Assert_(meshes.Size() > 0);
 
+    if(meshlets.Size() == 0)
+        BuildMeshlets(taskScheduler);
+
+    const uint64 vertexStride = VertexStride(vertexFormat);
+
     StructuredBufferInit sbInit;
-    sbInit.Stride = sizeof(MeshVertex);
+    sbInit.Stride = vertexStride;
     sbInit.NumElements = vertices.Size();;
     sbInit.InitData = vertices.Data();
+
+    // Each mesh is quantized relative to its own AABB. The compact copy only needs to live long
+    // enough to get uploaded, since the CPU keeps working with the full-precision vertices.
+    Array<CompactMeshVertex> compactVertices;
+    if(vertexFormat == MeshVertexFormat::Compact)
+    {
+        compactVertices.Init(vertices.Size());
+
+        CompactVertexErrors maxErrors;
+        uint64 vtxOffset = 0;
+        for(uint64 i = 0; i < meshes.Size(); ++i)
+        {
+            const Mesh& mesh = meshes[i];
+            const MeshVertex* meshVertices = vertices.Data() + vtxOffset;
+            CompactMeshVertex* meshCompactVertices = compactVertices.Data() + vtxOffset;
+            EncodeCompactVertices(meshVertices, mesh.NumVertices(), mesh.AABBMin(), mesh.AABBMax(), meshCompactVertices);
+
+            CompactVertexErrors errors = MeasureCompactVertexErrors(meshVertices, meshCompactVertices, mesh.NumVertices(),
+                                                                    mesh.AABBMin(), mesh.AABBMax());
+            maxErrors.MaxPositionError = Max(maxErrors.MaxPositionError, errors.MaxPositionError);
+            maxErrors.MaxNormalError = Max(maxErrors.MaxNormalError, errors.MaxNormalError);
+            maxErrors.MaxTangentError = Max(maxErrors.MaxTangentError, errors.MaxTangentError);
+            maxErrors.MaxBitangentError = Max(maxErrors.MaxBitangentError, errors.MaxBitangentError);
+            maxErrors.MaxUVError = Max(maxErrors.MaxUVError, errors.MaxUVError);
+
+            vtxOffset += mesh.NumVertices();
+        }
+
+        WriteLog("Compact vertices: %.2f MB -> %.2f MB, max errors: position %f, normal %.4f deg, tangent %.4f deg, "
+                 "bitangent %.4f deg, UV %f", vertices.MemorySize() / (1024.0 * 1024.0),
+                 compactVertices.MemorySize() / (1024.0 * 1024.0), maxErrors.MaxPositionError, maxErrors.MaxNormalError,
+                 maxErrors.MaxTangentError, maxErrors.MaxBitangentError, maxErrors.MaxUVError);
+
+        sbInit.InitData = compactVertices.Data();
+    }
+
     vertexBuffer.Initialize(sbInit);
 
+    // Indices are only 32-bit on the GPU if one of the meshes has too many vertices for 16-bit
+    indexType = IndexType::Index16Bit;
+    for(uint64 i = 0; i < meshes.Size(); ++i)
+        if(meshes[i].NumVertices() > 0xFFFF)
+            indexType = IndexType::Index32Bit;
+    const uint64 indexSize = indexType == IndexType::Index32Bit ? sizeof(uint32) : sizeof(uint16);
+
     FormattedBufferInit fbInit;
-    fbInit.Format = DXGI_FORMAT_R16_UINT;
+    fbInit.Format = indexType == IndexType::Index32Bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
     fbInit.NumElements = indices.Size();
     fbInit.InitData = indices.Data();
+
+    Array<uint16> indices16;
+    if(indexType == IndexType::Index16Bit)
+    {
+        indices16.Init(indices.Size());
+        for(uint64 i = 0; i < indices.Size(); ++i)
+            indices16[i] = uint16(indices[i]);
+        fbInit.InitData = indices16.Data();
+    }
+
     indexBuffer.Initialize(fbInit);
 
     uint64 vtxOffset = 0;
@@ -691,13 +788,35 @@ void Model::CreateBuffers()
     const uint64 numMeshes = meshes.Size();
     for(uint64 i = 0; i < numMeshes; ++i)
     {
-        uint64 vbOffset = vtxOffset * sizeof(MeshVertex);
-        uint64 ibOffset = idxOffset * sizeof(uint16);
-        meshes[i].InitCommon(&vertices[vtxOffset], &indices[idxOffset], vertexBuffer.GPUAddress + vbOffset, indexBuffer.GPUAddress + ibOffset, vtxOffset, idxOffset);
+        uint64 vbOffset = vtxOffset * vertexStride;
+        uint64 ibOffset = idxOffset * indexSize;
+        meshes[i].InitCommon(&vertices[vtxOffset], &indices[idxOffset], vertexBuffer.GPUAddress + vbOffset, indexBuffer.GPUAddress + ibOffset, vtxOffset, idxOffset,
+                             vertexStride, indexType);
 
         vtxOffset += meshes[i].NumVertices();
         idxOffset += meshes[i].NumIndices();
     }
+
+    if(meshlets.Size() > 0)
+    {
+        StructuredBufferInit meshletInit;
+        meshletInit.Stride = sizeof(Meshlet);
+        meshletInit.NumElements = meshlets.Size();
+        meshletInit.InitData = meshlets.Data();
+        meshletBuffer.Initialize(meshletInit);
+
+        FormattedBufferInit meshletVtxInit;
+        meshletVtxInit.Format = DXGI_FORMAT_R32_UINT;
+        meshletVtxInit.NumElements = meshletVertices.Size();
+        meshletVtxInit.InitData = meshletVertices.Data();
+        meshletVertexBuffer.Initialize(meshletVtxInit);
+
+        FormattedBufferInit meshletTriInit;
+        meshletTriInit.Format = DXGI_FORMAT_R32_UINT;
+        meshletTriInit.NumElements = meshletTriangles.Size();
+        meshletTriInit.InitData = meshletTriangles.Data();
+        meshletTriangleBuffer.Initialize(meshletTriInit);
+    }
 }
 
 // == Geometry helpers ============================================================================
@@ -16,9 +16,16 @@
 #include "..\\Serialization.h"
 #include "..\\Containers.h"
 #include "GraphicsTypes.h"
+#include "Meshlets.h"
+#include "MeshOptimizer.h"
 
 struct aiMesh;
 
+namespace enki
+{
+    class TaskScheduler;
+}
+
 namespace SampleFramework12
 {
 
@@ -114,6 +121,16 @@ enum class IndexType
     Index32Bit = 1
 };
 
+// Compact vertices are described in VertexCompression.h. The full-precision vertices are still kept
+// on the CPU, only the GPU vertex buffer uses the compact layout. None of the samples use it yet: a
+// vertex shader that does has to decode it with the helpers in Conversion.hlsl, and needs the
+// mesh's AABB to get back to the original positions.
+enum class MeshVertexFormat
+{
+    Standard = 0,
+    Compact = 1,
+};
+
 enum class InputElementType : uint64
 {
     Position = 0,
@@ -159,18 +176,19 @@ public:
 
     // Init from loaded files
     void InitFromAssimpMesh(const aiMesh& assimpMesh, float sceneScale,
-                            MeshVertex* dstVertices, uint16* dstIndices);
+                            MeshVertex* dstVertices, uint32* dstIndices);
 
     // Procedural generation
     void InitBox(const Float3& dimensions, const Float3& position,
                  const Quaternion& orientation, uint32 materialIdx,
-                 MeshVertex* dstVertices, uint16* dstIndices);
+                 MeshVertex* dstVertices, uint32* dstIndices);
 
     void InitPlane(const Float2& dimensions, const Float3& position,
                    const Quaternion& orientation, uint32 materialIdx,
-                   MeshVertex* dstVertices, uint16* dstIndices);
+                   MeshVertex* dstVertices, uint32* dstIndices);
 
-    void InitCommon(const MeshVertex* vertices, const uint16* indices, uint64 vbAddress, uint64 ibAddress, uint64 vtxOffset, uint64 idxOffset);
+    void InitCommon(const MeshVertex* vertices, const uint32* indices, uint64 vbAddress, uint64 ibAddress, uint64 vtxOffset, uint64 idxOffset,
+                    uint64 vertexStride, IndexType indexType);
 
     void Shutdown();
 
@@ -183,12 +201,15 @@ public:
     uint32 VertexOffset() const { return vtxOffset; }
     uint32 IndexOffset() const { return idxOffset; }
 
-    IndexType IndexBufferType() const { return IndexType::Index16Bit; }
-    DXGI_FORMAT IndexBufferFormat() const { return DXGI_FORMAT_R16_UINT; }
-    uint32 IndexSize() const { return 2; }
+    IndexType IndexBufferType() const { return indexType; }
+    DXGI_FORMAT IndexBufferFormat() const { return indexType == IndexType::Index32Bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT; }
+    uint32 IndexSize() const { return indexType == IndexType::Index32Bit ? 4 : 2; }
 
     const MeshVertex* Vertices() const { return vertices; }
-    const uint16* Indices() const { return indices; }
+    const uint32* Indices() const { return indices; }
+
+    // One range per mesh part, into the model's list of meshlets
+    const Array<MeshletRange>& PartMeshlets() const { return partMeshlets; }
 
     const D3D12_VERTEX_BUFFER_VIEW* VBView() const { return &vbView; }
     const D3D12_INDEX_BUFFER_VIEW* IBView() const { return &ibView; }
@@ -224,13 +245,15 @@ protected:
     IndexType indexType = IndexType::Index16Bit;
 
     const MeshVertex* vertices = nullptr;
-    const uint16* indices = nullptr;
+    const uint32* indices = nullptr;
 
     D3D12_VERTEX_BUFFER_VIEW vbView = { };
     D3D12_INDEX_BUFFER_VIEW ibView = { };
 
     Float3 aabbMin;
     Float3 aabbMax;
+
+    Array<MeshletRange> partMeshlets;
 };
 
 struct ModelLoadSettings
@@ -239,6 +262,9 @@ struct ModelLoadSettings
     float SceneScale = 1.0f;
     bool ForceSRGB = false;
     bool MergeMeshes = true;
+    bool OptimizeMeshes = true;
+    MeshVertexFormat VertexFormat = MeshVertexFormat::Standard;
+    enki::TaskScheduler* TaskScheduler = nullptr;     // Optional, used for optimizing and building meshlets
 };
 
 class Model
@@ -253,7 +279,21 @@ public:
     // Loading from file formats
     void CreateWithAssimp(const ModelLoadSettings& settings);
 
-    void CreateFromMeshData(const wchar* filePath);
+    // Loads either the chunked mesh data format, or the older format that's written by Serialize()
+    void CreateFromMeshData(const wchar* filePath, MeshVertexFormat vertexFormat = MeshVertexFormat::Standard,
+                            enki::TaskScheduler* taskScheduler = nullptr);
+    void SaveMeshData(const wchar* filePath);
+
+    // Rewrites a file from the older format into the chunked format
+    static void ConvertMeshData(const wchar* srcPath, const wchar* dstPath, enki::TaskScheduler* taskScheduler = nullptr);
+
+    // Re-orders triangles for the vertex cache and overdraw, and then vertices for fetch locality.
+    // This only happens once, files written by SaveMeshData() remember that it's already been done.
+    void OptimizeMeshes(enki::TaskScheduler* taskScheduler = nullptr);
+
+    // Splits every mesh part into meshlets. This happens automatically when the GPU buffers are
+    // created, unless the meshlets were already loaded from a file.
+    void BuildMeshlets(enki::TaskScheduler* taskScheduler = nullptr);
 
     // Procedural generation
     void GenerateBoxScene(const Float3& dimensions = Float3(1.0f, 1.0f, 1.0f),
@@ -284,14 +324,28 @@ public:
     const Array<ModelSpotLight>& SpotLights() const { return spotLights; }
     const Array<PointLight>& PointLights() const { return pointLights; }
 
+    MeshVertexFormat VertexFormat() const { return vertexFormat; }
+    IndexType IndexBufferType() const { return indexType; }
+    bool32 MeshesOptimized() const { return meshesOptimized; }
+    const VertexCacheStats& UnoptimizedCacheStats() const { return unoptimizedCacheStats; }
+    const VertexCacheStats& OptimizedCacheStats() const { return optimizedCacheStats; }
     const StructuredBuffer& VertexBuffer() const { return vertexBuffer; }
     const FormattedBuffer& IndexBuffer() const { return indexBuffer; }
 
+    // Meshlet vertices are indices into the vertex buffer of the whole model
+    const Array<Meshlet>& Meshlets() const { return meshlets; }
+    const Array<uint32>& MeshletVertices() const { return meshletVertices; }
+    const Array<uint32>& MeshletTriangles() const { return meshletTriangles; }
+    const StructuredBuffer& MeshletBuffer() const { return meshletBuffer; }
+    const FormattedBuffer& MeshletVertexBuffer() const { return meshletVertexBuffer; }
+    const FormattedBuffer& MeshletTriangleBuffer() const { return meshletTriangleBuffer; }
+
     const std::wstring& FileDirectory() const { return fileDirectory; }
 
-    static const D3D12_INPUT_ELEMENT_DESC* InputElements();
-    static const InputElementType* InputElementTypes();
-    static uint64 NumInputElements();
+    static const D3D12_INPUT_ELEMENT_DESC* InputElements(MeshVertexFormat format = MeshVertexFormat::Standard);
+    static const InputElementType* InputElementTypes(MeshVertexFormat format = MeshVertexFormat::Standard);
+    static uint64 NumInputElements(MeshVertexFormat format = MeshVertexFormat::Standard);
+    static uint64 VertexStride(MeshVertexFormat format = MeshVertexFormat::Standard);
 
     // Serialization
     template<typename TSerializer>
@@ -305,12 +359,34 @@ public:
         SerializeItem(serializer, aabbMin);
         SerializeItem(serializer, aabbMax);
         BulkSerializeItem(serializer, vertices);
-        BulkSerializeItem(serializer, indices);
+
+        // This format only ever had 16-bit indices, newer data should go through SaveMeshData()
+        Array<uint16> indices16;
+        if(TSerializer::IsWriteSerializer())
+        {
+            indices16.Init(indices.Size());
+            for(uint64 i = 0; i < indices.Size(); ++i)
+            {
+                if(indices[i] > 0xFFFF)
+                    throw Exception(L"Meshes with 32-bit indices can only be saved in the chunked mesh data format");
+                indices16[i] = uint16(indices[i]);
+            }
+        }
+
+        BulkSerializeItem(serializer, indices16);
+
+        if(TSerializer::IsReadSerializer())
+        {
+            indices.Init(indices16.Size());
+            for(uint64 i = 0; i < indices16.Size(); ++i)
+                indices[i] = indices16[i];
+        }
     }
 
 protected:
 
-        void CreateBuffers();
+    void CreateBuffers(enki::TaskScheduler* taskScheduler = nullptr);
+    void LoadChunkedMeshData(const wchar* filePath, enki::TaskScheduler* taskScheduler);
 
     Array<Mesh> meshes;
     Array<MeshMaterial> meshMaterials;
@@ -320,11 +396,23 @@ protected:
     bool32 forceSRGB = false;
     Float3 aabbMin;
     Float3 aabbMax;
+    MeshVertexFormat vertexFormat = MeshVertexFormat::Standard;
+    IndexType indexType = IndexType::Index16Bit;
+    bool32 meshesOptimized = false;
+    VertexCacheStats unoptimizedCacheStats;
+    VertexCacheStats optimizedCacheStats;
 
     StructuredBuffer vertexBuffer;
     FormattedBuffer indexBuffer;
     Array<MeshVertex> vertices;
-    Array<uint16> indices;
+    Array<uint32> indices;
+
+    Array<Meshlet> meshlets;
+    Array<uint32> meshletVertices;
+    Array<uint32> meshletTriangles;
+    StructuredBuffer meshletBuffer;
+    FormattedBuffer meshletVertexBuffer;
+    FormattedBuffer meshletTriangleBuffer;
 
     GrowableList<MaterialTexture*> materialTextures;
     LinearDescriptorHeap descriptorHeap;
@@ -0,0 +1,484 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Model.h"
+
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+#include "..\\Serialization.h"
+#include "..\\FileIO.h"
+#include "..\\ChunkedFile.h"
+#include "..\\Compression.h"
+#include "Meshlets.h"
+#include "MeshOptimizer.h"
+#include "..\\EnkiTS\\TaskScheduler.h"
+
+// The parts of Model and Mesh that only work with the CPU-side copy of the meshes: the mesh data
+// file format, and the optimization and meshlet passes that happen before anything is uploaded.
+// None of this touches D3D12, so it can be used by tools and tests without a device.
+
+namespace SampleFramework12
+{
+
+// Chunked mesh data format. Version 1 files have 16-bit indices and no meshlets, and version 2 files
+// store the vertices and indices uncompressed.
+static const uint32 MeshDataContentType = MakeFourCC('M', 'E', 'S', 'H');
+static const uint32 MeshDataVersion = 3;
+static const uint32 MeshDataVersionUncompressed = 2;
+static const uint32 MeshDataVersion16BitIndices = 1;
+static const uint32 ModelSectionID = MakeFourCC('M', 'O', 'D', 'L');
+static const uint32 MeshesSectionID = MakeFourCC('M', 'S', 'H', 'S');
+static const uint32 MaterialsSectionID = MakeFourCC('M', 'A', 'T', 'L');
+static const uint32 LightsSectionID = MakeFourCC('L', 'G', 'H', 'T');
+static const uint32 VerticesSectionID = MakeFourCC('V', 'T', 'X', 'S');
+static const uint32 IndicesSectionID = MakeFourCC('I', 'D', 'X', 'S');
+static const uint32 MeshletsSectionID = MakeFourCC('M', 'L', 'T', 'S');
+static const uint32 OptimizationSectionID = MakeFourCC('O', 'P', 'T', 'M');
+
+void Mesh::Shutdown()
+{
+    numVertices = 0;
+    numIndices = 0;
+    meshParts.Shutdown();
+    partMeshlets.Shutdown();
+    vertices = nullptr;
+    indices = nullptr;
+}
+
+void Model::LoadChunkedMeshData(const wchar* filePath, enki::TaskScheduler* taskScheduler)
+{
+    ChunkedFileReader reader(filePath, MeshDataContentType);
+    const uint32 version = reader.ContentVersion();
+    if(version != MeshDataVersion && version != MeshDataVersionUncompressed && version != MeshDataVersion16BitIndices)
+        throw Exception(MakeString(L"Mesh data file '%ls' has version %u, expected version %u",
+                                   filePath, reader.ContentVersion(), MeshDataVersion));
+
+    {
+        const ChunkedFileSection& section = reader.GetSection(ModelSectionID);
+        reader.ValidateSection(section);
+        MemoryReadSerializer serializer = reader.SectionSerializer(section);
+        SerializeItem(serializer, forceSRGB);
+        SerializeItem(serializer, aabbMin);
+        SerializeItem(serializer, aabbMax);
+    }
+
+    {
+        const ChunkedFileSection& section = reader.GetSection(MeshesSectionID);
+        reader.ValidateSection(section);
+        MemoryReadSerializer serializer = reader.SectionSerializer(section);
+        SerializeItem(serializer, meshes);
+    }
+
+    {
+        const ChunkedFileSection& section = reader.GetSection(MaterialsSectionID);
+        reader.ValidateSection(section);
+        MemoryReadSerializer serializer = reader.SectionSerializer(section);
+        SerializeItem(serializer, meshMaterials);
+    }
+
+    // Lights are optional, since plenty of scenes don't have any
+    const ChunkedFileSection* lightsSection = reader.FindSection(LightsSectionID);
+    if(lightsSection != nullptr)
+    {
+        reader.ValidateSection(*lightsSection);
+        MemoryReadSerializer serializer = reader.SectionSerializer(*lightsSection);
+        BulkSerializeItem(serializer, spotLights);
+        BulkSerializeItem(serializer, pointLights);
+    }
+
+    const ChunkedFileSection& vtxSection = reader.GetSection(VerticesSectionID);
+    const ChunkedFileSection& idxSection = reader.GetSection(IndicesSectionID);
+    reader.ValidateSection(vtxSection);
+    reader.ValidateSection(idxSection);
+
+    if(version == MeshDataVersion)
+    {
+        // Vertices and indices are LZ-compressed streams, which get decompressed straight out of the mapping
+        const uint8* vtxData = reader.SectionData(vtxSection);
+        const uint8* idxData = reader.SectionData(idxSection);
+        const uint64 vtxSize = DecompressedStreamSize(vtxData, vtxSection.Size, filePath);
+        const uint64 idxSize = DecompressedStreamSize(idxData, idxSection.Size, filePath);
+        if(vtxSize % sizeof(MeshVertex) != 0 || idxSize % sizeof(uint32) != 0)
+            throw Exception(MakeString(L"Mesh data file '%ls' has a vertex or index section with an invalid size", filePath));
+
+        vertices.Init(vtxSize / sizeof(MeshVertex));
+        indices.Init(idxSize / sizeof(uint32));
+        DecompressStream(vtxData, vtxSection.Size, vertices.Data(), vtxSize, filePath, taskScheduler);
+        DecompressStream(idxData, idxSection.Size, indices.Data(), idxSize, filePath, taskScheduler);
+    }
+    else
+    {
+        // Older files store raw arrays, so that they can be copied straight out of the mapping
+        const bool has16BitIndices = version == MeshDataVersion16BitIndices;
+        const uint64 indexSize = has16BitIndices ? sizeof(uint16) : sizeof(uint32);
+        if(vtxSection.Size % sizeof(MeshVertex) != 0 || idxSection.Size % indexSize != 0)
+            throw Exception(MakeString(L"Mesh data file '%ls' has a vertex or index section with an invalid size", filePath));
+
+        vertices.Init(vtxSection.Size / sizeof(MeshVertex));
+        if(vtxSection.Size > 0)
+            memcpy(vertices.Data(), reader.SectionData(vtxSection), vtxSection.Size);
+
+        indices.Init(idxSection.Size / indexSize);
+        if(has16BitIndices)
+        {
+            const uint16* srcIndices = reinterpret_cast<const uint16*>(reader.SectionData(idxSection));
+            for(uint64 i = 0; i < indices.Size(); ++i)
+                indices[i] = srcIndices[i];
+        }
+        else if(idxSection.Size > 0)
+        {
+            memcpy(indices.Data(), reader.SectionData(idxSection), idxSection.Size);
+        }
+    }
+
+    // Meshlets get built when the buffers are created if they're not in the file
+    const ChunkedFileSection* meshletsSection = reader.FindSection(MeshletsSectionID);
+    if(meshletsSection != nullptr)
+    {
+        reader.ValidateSection(*meshletsSection);
+        MemoryReadSerializer serializer = reader.SectionSerializer(*meshletsSection);
+        for(uint64 i = 0; i < meshes.Size(); ++i)
+            BulkSerializeItem(serializer, meshes[i].partMeshlets);
+        BulkSerializeItem(serializer, meshlets);
+        BulkSerializeItem(serializer, meshletVertices);
+        BulkSerializeItem(serializer, meshletTriangles);
+    }
+
+    // The optimization section only marks that the vertices and indices have already been through
+    // OptimizeMeshes(), so that it doesn't need to happen again on load
+    const ChunkedFileSection* optimizationSection = reader.FindSection(OptimizationSectionID);
+    if(optimizationSection != nullptr)
+    {
+        reader.ValidateSection(*optimizationSection);
+        MemoryReadSerializer serializer = reader.SectionSerializer(*optimizationSection);
+        SerializeItem(serializer, unoptimizedCacheStats);
+        SerializeItem(serializer, optimizedCacheStats);
+        meshesOptimized = true;
+    }
+}
+
+void Model::SaveMeshData(const wchar* filePath)
+{
+    ChunkedFileWriter writer(filePath, MeshDataContentType, MeshDataVersion);
+
+    writer.BeginSection(ModelSectionID);
+    SerializeItem(writer, forceSRGB);
+    SerializeItem(writer, aabbMin);
+    SerializeItem(writer, aabbMax);
+    writer.EndSection();
+
+    writer.BeginSection(MeshesSectionID);
+    SerializeItem(writer, meshes);
+    writer.EndSection();
+
+    writer.BeginSection(MaterialsSectionID);
+    SerializeItem(writer, meshMaterials);
+    writer.EndSection();
+
+    if(spotLights.Size() > 0 || pointLights.Size() > 0)
+    {
+        writer.BeginSection(LightsSectionID);
+        BulkSerializeItem(writer, spotLights);
+        BulkSerializeItem(writer, pointLights);
+        writer.EndSection();
+    }
+
+    // LZ over deflate, since it decompresses several times faster and the files are only a bit bigger
+    GrowableList<uint8> compressed;
+    CompressStream(CompressionCodec::LZ, vertices.Data(), vertices.MemorySize(), compressed);
+    writer.BeginSection(VerticesSectionID);
+    writer.SerializeData(compressed.Count(), compressed.Data());
+    writer.EndSection();
+
+    compressed.RemoveAll();
+    CompressStream(CompressionCodec::LZ, indices.Data(), indices.MemorySize(), compressed);
+    writer.BeginSection(IndicesSectionID);
+    writer.SerializeData(compressed.Count(), compressed.Data());
+    writer.EndSection();
+
+    if(meshlets.Size() > 0)
+    {
+        writer.BeginSection(MeshletsSectionID);
+        for(uint64 i = 0; i < meshes.Size(); ++i)
+            BulkSerializeItem(writer, meshes[i].partMeshlets);
+        BulkSerializeItem(writer, meshlets);
+        BulkSerializeItem(writer, meshletVertices);
+        BulkSerializeItem(writer, meshletTriangles);
+        writer.EndSection();
+    }
+
+    if(meshesOptimized)
+    {
+        writer.BeginSection(OptimizationSectionID);
+        SerializeItem(writer, unoptimizedCacheStats);
+        SerializeItem(writer, optimizedCacheStats);
+        writer.EndSection();
+    }
+
+    writer.Finish();
+}
+
+void Model::ConvertMeshData(const wchar* srcPath, const wchar* dstPath, enki::TaskScheduler* taskScheduler)
+{
+    if(FileExists(srcPath) == false)
+        throw Exception(MakeString(L"Model file with path '%ls' does not exist", srcPath));
+
+    // Only the CPU-side data is needed, so this skips creating buffers and loading textures
+    Model model;
+    {
+        MappedReadSerializer serializer(srcPath);
+        model.Serialize(serializer);
+    }
+
+    model.OptimizeMeshes(taskScheduler);
+    model.BuildMeshlets(taskScheduler);
+    model.SaveMeshData(dstPath);
+
+    for(uint64 i = 0; i < model.meshes.Size(); ++i)
+        model.meshes[i].Shutdown();
+    model.meshes.Shutdown();
+}
+
+// Where a mesh part lives in the model's vertex and index arrays, before the meshes have been
+// initialized with their final offsets
+struct MeshPartInfo
+{
+    uint64 MeshIdx = 0;
+    uint64 PartIdx = 0;
+    uint64 VertexOffset = 0;
+    uint64 IndexOffset = 0;
+};
+
+static void GatherMeshParts(const Array<Mesh>& meshes, GrowableList<MeshPartInfo>& parts)
+{
+    uint64 vtxOffset = 0;
+    uint64 idxOffset = 0;
+    for(uint64 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+    {
+        const Mesh& mesh = meshes[meshIdx];
+        for(uint64 partIdx = 0; partIdx < mesh.NumMeshParts(); ++partIdx)
+        {
+            MeshPartInfo& info = parts.EmplaceBack();
+            info.MeshIdx = meshIdx;
+            info.PartIdx = partIdx;
+            info.VertexOffset = vtxOffset;
+            info.IndexOffset = idxOffset;
+        }
+
+        vtxOffset += mesh.NumVertices();
+        idxOffset += mesh.NumIndices();
+    }
+}
+
+// Runs func over [0, count) on the task scheduler, or serially if there isn't one
+static void ParallelFor(enki::TaskScheduler* taskScheduler, uint64 count, const std::function<void(uint64, uint64)>& func)
+{
+    if(taskScheduler != nullptr && count > 1)
+    {
+        enki::TaskSet task(uint32(count), [&](enki::TaskSetPartition range, uint32_t)
+        {
+            func(range.start, range.end);
+        });
+
+        taskScheduler->AddTaskSetToPipe(&task);
+        taskScheduler->WaitforTaskSet(&task);
+    }
+    else
+    {
+        func(0, count);
+    }
+}
+
+void Model::OptimizeMeshes(enki::TaskScheduler* taskScheduler)
+{
+    if(meshesOptimized)
+        return;
+
+    // Any meshlets were built from the old triangle order
+    for(uint64 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+        meshes[meshIdx].partMeshlets.Shutdown();
+    meshlets.Shutdown();
+    meshletVertices.Shutdown();
+    meshletTriangles.Shutdown();
+
+    GrowableList<MeshPartInfo> parts;
+    GatherMeshParts(meshes, parts);
+
+    // Triangles are re-ordered within each mesh part, since each part is its own draw
+    const uint64 numParts = parts.Count();
+    Array<VertexCacheStats> partStatsBefore(numParts);
+    Array<VertexCacheStats> partStatsAfter(numParts);
+    ParallelFor(taskScheduler, numParts, [&](uint64 start, uint64 end)
+    {
+        for(uint64 i = start; i < end; ++i)
+        {
+            const MeshPartInfo& info = parts[i];
+            const Mesh& mesh = meshes[info.MeshIdx];
+            const MeshPart& part = mesh.MeshParts()[info.PartIdx];
+            uint32* partIndices = indices.Data() + info.IndexOffset + part.IndexStart;
+            if(part.IndexCount == 0)
+                continue;
+
+            // The optimizers allocate per-vertex arrays, so they only get to see the range of vertices
+            // used by this part instead of every vertex in a merged mesh
+            uint32 minVertex = UINT32_MAX;
+            uint32 maxVertex = 0;
+            for(uint64 idx = 0; idx < part.IndexCount; ++idx)
+            {
+                minVertex = Min(minVertex, partIndices[idx]);
+                maxVertex = Max(maxVertex, partIndices[idx]);
+            }
+
+            Assert_(maxVertex < mesh.NumVertices());
+            const uint64 partNumVertices = maxVertex - minVertex + 1;
+            const MeshVertex* partVertices = vertices.Data() + info.VertexOffset + minVertex;
+            for(uint64 idx = 0; idx < part.IndexCount; ++idx)
+                partIndices[idx] -= minVertex;
+
+            partStatsBefore[i] = AnalyzeVertexCache(partIndices, part.IndexCount, partNumVertices);
+            OptimizeVertexCache(partIndices, part.IndexCount, partNumVertices);
+            OptimizeOverdraw(partIndices, part.IndexCount, &partVertices->Position, sizeof(MeshVertex), partNumVertices);
+            partStatsAfter[i] = AnalyzeVertexCache(partIndices, part.IndexCount, partNumVertices);
+
+            for(uint64 idx = 0; idx < part.IndexCount; ++idx)
+                partIndices[idx] += minVertex;
+        }
+    });
+
+    // Vertices are shared by all of the parts in a mesh, so those get re-ordered per mesh once all
+    // of its parts have their final triangle order
+    Array<uint64> meshVtxOffsets(meshes.Size());
+    Array<uint64> meshIdxOffsets(meshes.Size());
+    uint64 vtxOffset = 0;
+    uint64 idxOffset = 0;
+    for(uint64 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+    {
+        meshVtxOffsets[meshIdx] = vtxOffset;
+        meshIdxOffsets[meshIdx] = idxOffset;
+        vtxOffset += meshes[meshIdx].NumVertices();
+        idxOffset += meshes[meshIdx].NumIndices();
+    }
+
+    ParallelFor(taskScheduler, meshes.Size(), [&](uint64 start, uint64 end)
+    {
+        for(uint64 meshIdx = start; meshIdx < end; ++meshIdx)
+        {
+            Mesh& mesh = meshes[meshIdx];
+            uint32* meshIndices = indices.Data() + meshIdxOffsets[meshIdx];
+            OptimizeVertexFetch(vertices.Data() + meshVtxOffsets[meshIdx], sizeof(MeshVertex), mesh.NumVertices(),
+                                meshIndices, mesh.NumIndices());
+
+            // The parts might not cover the same range of vertices anymore
+            for(uint64 partIdx = 0; partIdx < mesh.NumMeshParts(); ++partIdx)
+            {
+                MeshPart& part = mesh.meshParts[partIdx];
+                if(part.IndexCount == 0)
+                    continue;
+
+                uint32 minVertex = UINT32_MAX;
+                uint32 maxVertex = 0;
+                for(uint64 i = 0; i < part.IndexCount; ++i)
+                {
+                    minVertex = Min(minVertex, meshIndices[part.IndexStart + i]);
+                    maxVertex = Max(maxVertex, meshIndices[part.IndexStart + i]);
+                }
+
+                part.VertexStart = minVertex;
+                part.VertexCount = maxVertex - minVertex + 1;
+            }
+        }
+    });
+
+    unoptimizedCacheStats = VertexCacheStats();
+    optimizedCacheStats = VertexCacheStats();
+    for(uint64 i = 0; i < numParts; ++i)
+    {
+        unoptimizedCacheStats.Add(partStatsBefore[i]);
+        optimizedCacheStats.Add(partStatsAfter[i]);
+    }
+
+    meshesOptimized = true;
+
+    WriteLog("Optimized %llu mesh parts for the vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", numParts,
+             unoptimizedCacheStats.ACMR(), optimizedCacheStats.ACMR(), unoptimizedCacheStats.ATVR(), optimizedCacheStats.ATVR());
+}
+
+void Model::BuildMeshlets(enki::TaskScheduler* taskScheduler)
+{
+    // Each mesh part is built on its own so that they can be spread across threads, and the results
+    // are stitched together in order afterwards
+    GrowableList<MeshPartInfo> parts;
+    GatherMeshParts(meshes, parts);
+
+    const uint64 numParts = parts.Count();
+    Array<MeshletData> partMeshletData(numParts);
+    ParallelFor(taskScheduler, numParts, [&](uint64 start, uint64 end)
+    {
+        for(uint64 i = start; i < end; ++i)
+        {
+            const MeshPartInfo& info = parts[i];
+            const Mesh& mesh = meshes[info.MeshIdx];
+            const MeshPart& part = mesh.MeshParts()[info.PartIdx];
+            SampleFramework12::BuildMeshlets(&vertices.Data()[info.VertexOffset].Position, sizeof(MeshVertex), mesh.NumVertices(),
+                                             indices.Data() + info.IndexOffset + part.IndexStart, part.IndexCount, partMeshletData[i]);
+        }
+    });
+
+    uint64 numMeshlets = 0;
+    uint64 numMeshletVertices = 0;
+    uint64 numMeshletTriangles = 0;
+    for(uint64 i = 0; i < numParts; ++i)
+    {
+        numMeshlets += partMeshletData[i].Meshlets.Count();
+        numMeshletVertices += partMeshletData[i].Vertices.Count();
+        numMeshletTriangles += partMeshletData[i].Triangles.Count();
+    }
+
+    meshlets.Init(numMeshlets);
+    meshletVertices.Init(numMeshletVertices);
+    meshletTriangles.Init(numMeshletTriangles);
+    for(uint64 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+        meshes[meshIdx].partMeshlets.Init(meshes[meshIdx].NumMeshParts());
+
+    uint64 meshletOffset = 0;
+    uint64 meshletVtxOffset = 0;
+    uint64 meshletTriOffset = 0;
+    for(uint64 i = 0; i < numParts; ++i)
+    {
+        const MeshPartInfo& info = parts[i];
+        const MeshletData& data = partMeshletData[i];
+
+        MeshletRange& range = meshes[info.MeshIdx].partMeshlets[info.PartIdx];
+        range.MeshletStart = uint32(meshletOffset);
+        range.MeshletCount = uint32(data.Meshlets.Count());
+
+        for(uint64 meshletIdx = 0; meshletIdx < data.Meshlets.Count(); ++meshletIdx)
+        {
+            Meshlet& meshlet = meshlets[meshletOffset + meshletIdx];
+            meshlet = data.Meshlets[meshletIdx];
+            meshlet.VertexStart += uint32(meshletVtxOffset);
+            meshlet.TriangleStart += uint32(meshletTriOffset);
+        }
+
+        // Meshlet vertices come out relative to the mesh, but they're stored relative to the model
+        for(uint64 vtxIdx = 0; vtxIdx < data.Vertices.Count(); ++vtxIdx)
+            meshletVertices[meshletVtxOffset + vtxIdx] = uint32(data.Vertices[vtxIdx] + info.VertexOffset);
+
+        if(data.Triangles.Count() > 0)
+            memcpy(&meshletTriangles[meshletTriOffset], data.Triangles.Data(), data.Triangles.Count() * sizeof(uint32));
+
+        meshletOffset += data.Meshlets.Count();
+        meshletVtxOffset += data.Vertices.Count();
+        meshletTriOffset += data.Triangles.Count();
+    }
+}
+
+}
@@ -0,0 +1,302 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "PSOCache.h"
+#include "DX12.h"
+#include "ShaderCompilation.h"
+#include "..\\Containers.h"
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+namespace DX12
+{
+
+// The cache keeps a reference to the root signature, since its address is part of the key and
+// can't be allowed to get reused by a different root signature while the entry is around
+struct PSOCacheEntry
+{
+    ID3D12PipelineState* PSO = nullptr;
+    ID3D12RootSignature* RootSignature = nullptr;
+    uint64 LastRequest = 0;
+};
+
+static HashMap<Hash, PSOCacheEntry> PSOCache;
+static uint64 PSOCacheGeneration = 0;
+static uint64 NumPSORequests = 0;
+static uint64 NumSharedPSORequests = 0;
+
+// Lays out a description one field at a time, in a fixed order, so that it can be hashed in one go
+class PSOKeyWriter
+{
+
+public:
+
+    explicit PSOKeyWriter(uint32 seed_) : seed(seed_)
+    {
+    }
+
+    template<typename T> void Write(const T& field)
+    {
+        StaticAssert_(std::is_scalar<T>::value);
+        key.Append(reinterpret_cast<const uint8*>(&field), sizeof(T));
+    }
+
+    void Write(Hash hash)
+    {
+        Write(hash.A);
+        Write(hash.B);
+    }
+
+    void WriteString(const char* str)
+    {
+        const uint64 length = str != nullptr ? strlen(str) : 0;
+        Write(length);
+        key.Append(reinterpret_cast<const uint8*>(str), length);
+    }
+
+    Hash Finish() const
+    {
+        return GenerateHash(key.Data(), int(key.Count()), seed);
+    }
+
+private:
+
+    SmallList<uint8, 1024> key;
+    uint32 seed = 0;
+};
+
+static void WriteByteCode(PSOKeyWriter& writer, const D3D12_SHADER_BYTECODE& byteCode)
+{
+    writer.Write(GetByteCodeHash(byteCode));
+}
+
+static void WriteStreamOutput(PSOKeyWriter& writer, const D3D12_STREAM_OUTPUT_DESC& streamOutput)
+{
+    writer.Write(streamOutput.NumEntries);
+    for(uint32 i = 0; i < streamOutput.NumEntries; ++i)
+    {
+        const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+        writer.Write(entry.Stream);
+        writer.WriteString(entry.SemanticName);
+        writer.Write(entry.SemanticIndex);
+        writer.Write(entry.StartComponent);
+        writer.Write(entry.ComponentCount);
+        writer.Write(entry.OutputSlot);
+    }
+
+    writer.Write(streamOutput.NumStrides);
+    for(uint32 i = 0; i < streamOutput.NumStrides; ++i)
+        writer.Write(streamOutput.pBufferStrides[i]);
+    writer.Write(streamOutput.RasterizedStream);
+}
+
+static void WriteBlendState(PSOKeyWriter& writer, const D3D12_BLEND_DESC& blendState)
+{
+    writer.Write(blendState.AlphaToCoverageEnable);
+    writer.Write(blendState.IndependentBlendEnable);
+    for(uint64 i = 0; i < ArraySize_(blendState.RenderTarget); ++i)
+    {
+        const D3D12_RENDER_TARGET_BLEND_DESC& rtBlend = blendState.RenderTarget[i];
+        writer.Write(rtBlend.BlendEnable);
+        writer.Write(rtBlend.LogicOpEnable);
+        writer.Write(rtBlend.SrcBlend);
+        writer.Write(rtBlend.DestBlend);
+        writer.Write(rtBlend.BlendOp);
+        writer.Write(rtBlend.SrcBlendAlpha);
+        writer.Write(rtBlend.DestBlendAlpha);
+        writer.Write(rtBlend.BlendOpAlpha);
+        writer.Write(rtBlend.LogicOp);
+        writer.Write(rtBlend.RenderTargetWriteMask);
+    }
+}
+
+static void WriteRasterizerState(PSOKeyWriter& writer, const D3D12_RASTERIZER_DESC& rasterizerState)
+{
+    writer.Write(rasterizerState.FillMode);
+    writer.Write(rasterizerState.CullMode);
+    writer.Write(rasterizerState.FrontCounterClockwise);
+    writer.Write(rasterizerState.DepthBias);
+    writer.Write(rasterizerState.DepthBiasClamp);
+    writer.Write(rasterizerState.SlopeScaledDepthBias);
+    writer.Write(rasterizerState.DepthClipEnable);
+    writer.Write(rasterizerState.MultisampleEnable);
+    writer.Write(rasterizerState.AntialiasedLineEnable);
+    writer.Write(rasterizerState.ForcedSampleCount);
+    writer.Write(rasterizerState.ConservativeRaster);
+}
+
+static void WriteStencilOp(PSOKeyWriter& writer, const D3D12_DEPTH_STENCILOP_DESC& stencilOp)
+{
+    writer.Write(stencilOp.StencilFailOp);
+    writer.Write(stencilOp.StencilDepthFailOp);
+    writer.Write(stencilOp.StencilPassOp);
+    writer.Write(stencilOp.StencilFunc);
+}
+
+static void WriteDepthStencilState(PSOKeyWriter& writer, const D3D12_DEPTH_STENCIL_DESC& depthState)
+{
+    writer.Write(depthState.DepthEnable);
+    writer.Write(depthState.DepthWriteMask);
+    writer.Write(depthState.DepthFunc);
+    writer.Write(depthState.StencilEnable);
+    writer.Write(depthState.StencilReadMask);
+    writer.Write(depthState.StencilWriteMask);
+    WriteStencilOp(writer, depthState.FrontFace);
+    WriteStencilOp(writer, depthState.BackFace);
+}
+
+static void WriteInputLayout(PSOKeyWriter& writer, const D3D12_INPUT_LAYOUT_DESC& inputLayout)
+{
+    writer.Write(inputLayout.NumElements);
+    for(uint32 i = 0; i < inputLayout.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[i];
+        writer.WriteString(element.SemanticName);
+        writer.Write(element.SemanticIndex);
+        writer.Write(element.Format);
+        writer.Write(element.InputSlot);
+        writer.Write(element.AlignedByteOffset);
+        writer.Write(element.InputSlotClass);
+        writer.Write(element.InstanceDataStepRate);
+    }
+}
+
+// CachedPSO is left out of both keys, since it doesn't change the PSO that gets created
+Hash HashPSODesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    PSOKeyWriter writer(0);
+    writer.Write(desc.pRootSignature);
+    WriteByteCode(writer, desc.VS);
+    WriteByteCode(writer, desc.PS);
+    WriteByteCode(writer, desc.DS);
+    WriteByteCode(writer, desc.HS);
+    WriteByteCode(writer, desc.GS);
+    WriteStreamOutput(writer, desc.StreamOutput);
+    WriteBlendState(writer, desc.BlendState);
+    writer.Write(desc.SampleMask);
+    WriteRasterizerState(writer, desc.RasterizerState);
+    WriteDepthStencilState(writer, desc.DepthStencilState);
+    WriteInputLayout(writer, desc.InputLayout);
+    writer.Write(desc.IBStripCutValue);
+    writer.Write(desc.PrimitiveTopologyType);
+    writer.Write(desc.NumRenderTargets);
+    for(uint64 i = 0; i < ArraySize_(desc.RTVFormats); ++i)
+        writer.Write(desc.RTVFormats[i]);
+    writer.Write(desc.DSVFormat);
+    writer.Write(desc.SampleDesc.Count);
+    writer.Write(desc.SampleDesc.Quality);
+    writer.Write(desc.NodeMask);
+    writer.Write(desc.Flags);
+    return writer.Finish();
+}
+
+Hash HashPSODesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    // The seed keeps compute PSOs apart from graphics PSOs
+    PSOKeyWriter writer(1);
+    writer.Write(desc.pRootSignature);
+    WriteByteCode(writer, desc.CS);
+    writer.Write(desc.NodeMask);
+    writer.Write(desc.Flags);
+    return writer.Finish();
+}
+
+template<typename T> static ID3D12PipelineState* GetCachedPSO(Hash hash, ID3D12RootSignature* rootSignature,
+                                                             const T& createPSO)
+{
+    ++NumPSORequests;
+
+    PSOCacheEntry* cachedPSO = PSOCache.Find(hash);
+    if(cachedPSO != nullptr)
+    {
+        ++NumSharedPSORequests;
+        cachedPSO->LastRequest = PSOCacheGeneration;
+        cachedPSO->PSO->AddRef();
+        return cachedPSO->PSO;
+    }
+
+    PSOCacheEntry entry;
+    createPSO(&entry.PSO);
+    entry.RootSignature = rootSignature;
+    if(entry.RootSignature != nullptr)
+        entry.RootSignature->AddRef();
+    entry.LastRequest = PSOCacheGeneration;
+    PSOCache.Insert(hash, entry);
+
+    entry.PSO->AddRef();
+    return entry.PSO;
+}
+
+ID3D12PipelineState* CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    return GetCachedPSO(HashPSODesc(desc), desc.pRootSignature, [&](ID3D12PipelineState** pso)
+    {
+        DXCall(Device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso)));
+    });
+}
+
+ID3D12PipelineState* CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    return GetCachedPSO(HashPSODesc(desc), desc.pRootSignature, [&](ID3D12PipelineState** pso)
+    {
+        DXCall(Device->CreateComputePipelineState(&desc, IID_PPV_ARGS(pso)));
+    });
+}
+
+void PurgePSOCache()
+{
+    GrowableList<Hash> unused;
+    PSOCache.ForEach([&](const Hash& hash, const PSOCacheEntry& entry)
+    {
+        if(entry.LastRequest != PSOCacheGeneration)
+            unused.Add(hash);
+    });
+
+    // Anything that's still holding on to one of these PSOs has its own reference
+    for(uint64 i = 0; i < unused.Count(); ++i)
+    {
+        PSOCacheEntry* entry = PSOCache.Find(unused[i]);
+        DeferredRelease(entry->PSO);
+        if(entry->RootSignature != nullptr)
+            DeferredRelease(entry->RootSignature);
+        PSOCache.Remove(unused[i]);
+    }
+
+    ++PSOCacheGeneration;
+}
+
+PSOCacheStats GetPSOCacheStats()
+{
+    PSOCacheStats stats;
+    stats.NumPSOs = PSOCache.Count();
+    stats.NumRequests = NumPSORequests;
+    stats.NumSharedRequests = NumSharedPSORequests;
+    return stats;
+}
+
+void Shutdown_PSOCache()
+{
+    // Everything else has let go of its PSOs by now
+    PSOCache.ForEach([](const Hash&, const PSOCacheEntry& entry)
+    {
+        entry.PSO->Release();
+        if(entry.RootSignature != nullptr)
+            entry.RootSignature->Release();
+    });
+    PSOCache.Shutdown();
+}
+
+} // namespace DX12
+
+} // namespace SampleFramework12
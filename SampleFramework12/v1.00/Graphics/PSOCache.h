@@ -0,0 +1,48 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+#include "..\\MurmurHash.h"
+
+namespace SampleFramework12
+{
+
+namespace DX12
+{
+
+// Pipeline states. PSOs are cached by their description, with the shaders identified by the hash of
+// their byte code, so shader permutations that compiled to the same byte code end up sharing a PSO.
+// The returned PSO has its own reference, and gets released with DeferredRelease like any other.
+// The cache holds on to its PSOs until PurgePSOCache() is called, which drops the ones that haven't
+// been requested since the previous purge. App calls it every time it's done re-creating PSOs.
+struct PSOCacheStats
+{
+    uint64 NumPSOs = 0;                 // PSOs currently in the cache
+    uint64 NumRequests = 0;             // Calls to Create*PSO() so far
+    uint64 NumSharedRequests = 0;       // Requests that got an existing PSO instead of creating one
+};
+
+ID3D12PipelineState* CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+ID3D12PipelineState* CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+void PurgePSOCache();
+PSOCacheStats GetPSOCacheStats();
+
+// The cache keys. Only the fields are hashed and never the padding between them, so two descriptions
+// that are equal field by field always get the same key.
+Hash HashPSODesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+Hash HashPSODesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+// Releases everything in the cache, once nothing else is using its PSOs
+void Shutdown_PSOCache();
+
+} // namespace DX12
+
+} // namespace SampleFramework12
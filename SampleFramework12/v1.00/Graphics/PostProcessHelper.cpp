@@ -229,7 +229,7 @@ void PostProcessHelper::PostProcess(CompiledShaderPtr pixelShader, const char* n
             psoDesc.RTVFormats[i] = hashSource.OutputFormats[i];
         psoDesc.DSVFormat = DXGI_FORMAT_UNKNOWN;
         psoDesc.SampleDesc.Count = uint32(hashSource.MSAASamples);
-        DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
+        pso = DX12::CreateGraphicsPSO(psoDesc);
 
         CachedPSO cachedPSO;
         cachedPSO.Hash = psoHash;
@@ -11,6 +11,7 @@
 #include "Profiler.h"
 #include "DX12.h"
 #include "..\\Utility.h"
+#include "..\\TimingStats.h"
 
 using std::wstring;
 using std::map;
@@ -36,9 +37,7 @@ struct ProfileData
     int64 StartTime = 0;
     int64 EndTime = 0;
 
-    static const uint64 FilterSize = 64;
-    double TimeSamples[FilterSize] = { };
-    uint64 CurrSample = 0;
+    TimingStats Stats;
 };
 
 void Profiler::Initialize()
@@ -61,6 +60,8 @@ void Profiler::Initialize()
 
     profiles.Init(MaxProfiles);
     cpuProfiles.Init(MaxProfiles);
+    profileIndices.Reserve(MaxProfiles);
+    cpuProfileIndices.Reserve(MaxProfiles);
 }
 
 void Profiler::Shutdown()
@@ -69,7 +70,10 @@ void Profiler::Shutdown()
     readbackBuffer.Shutdown();
     profiles.Shutdown();
     cpuProfiles.Shutdown();
+    profileIndices.Shutdown();
+    cpuProfileIndices.Shutdown();
     numProfiles = 0;
+    numCPUProfiles = 0;
 }
 
 uint64 Profiler::StartProfile(ID3D12GraphicsCommandList* cmdList, const char* name)
@@ -79,20 +83,17 @@ uint64 Profiler::StartProfile(ID3D12GraphicsCommandList* cmdList, const char* na
         return uint64(-1);
 
     uint64 profileIdx = uint64(-1);
-    for(uint64 i = 0; i < numProfiles; ++i)
+    const uint64* existingIdx = profileIndices.Find(name);
+    if(existingIdx != nullptr)
     {
-        if(profiles[i].Name == name)
-        {
-            profileIdx = i;
-            break;
-        }
+        profileIdx = *existingIdx;
     }
-
-    if(profileIdx == uint64(-1))
+    else
     {
         Assert_(numProfiles < MaxProfiles);
         profileIdx = numProfiles++;
         profiles[profileIdx].Name = name;
+        profileIndices.Insert(name, profileIdx);
     }
 
     ProfileData& profileData = profiles[profileIdx];
@@ -139,20 +140,17 @@ uint64 Profiler::StartCPUProfile(const char* name)
     Assert_(name != nullptr);
 
     uint64 profileIdx = uint64(-1);
-    for(uint64 i = 0; i < numCPUProfiles; ++i)
+    const uint64* existingIdx = cpuProfileIndices.Find(name);
+    if(existingIdx != nullptr)
     {
-        if(cpuProfiles[i].Name == name)
-        {
-            profileIdx = i;
-            break;
-        }
+        profileIdx = *existingIdx;
     }
-
-    if(profileIdx == uint64(-1))
+    else
     {
         Assert_(numCPUProfiles < MaxProfiles);
         profileIdx = numCPUProfiles++;
         cpuProfiles[profileIdx].Name = name;
+        cpuProfileIndices.Insert(name, profileIdx);
     }
 
     ProfileData& profileData = cpuProfiles[profileIdx];
@@ -209,26 +207,13 @@ static void UpdateProfile(ProfileData& profile, uint64 profileIdx, bool drawText
         }
     }
 
-    profile.TimeSamples[profile.CurrSample] = time;
-    profile.CurrSample = (profile.CurrSample + 1) % ProfileData::FilterSize;
-
-    double maxTime = 0.0;
-    double avgTime = 0.0;
-    uint64 avgTimeSamples = 0;
-    for(UINT i = 0; i < ProfileData::FilterSize; ++i)
-    {
-        if(profile.TimeSamples[i] <= 0.0)
-            continue;
-        maxTime = Max(profile.TimeSamples[i], maxTime);
-        avgTime += profile.TimeSamples[i];
-        ++avgTimeSamples;
-    }
-
-    if(avgTimeSamples > 0)
-        avgTime /= double(avgTimeSamples);
+    // Queries that didn't run this frame read back as 0
+    if(time > 0.0)
+        profile.Stats.AddSample(time);
 
     if(profile.Active && drawText)
-        ImGui::Text("%s: %.2fms (%.2fms max)", profile.Name, avgTime, maxTime);
+        ImGui::Text("%s: %.2fms (%.2fms p50, %.2fms p99, %.2fms max)", profile.Name, profile.Stats.Mean(),
+                    profile.Stats.Median(), profile.Stats.Percentile(0.99), profile.Stats.Maximum());
 
     profile.Active = false;
 }
@@ -42,6 +42,8 @@ protected:
 
     Array<ProfileData> profiles;
     Array<ProfileData> cpuProfiles;
+    HashMap<const char*, uint64> profileIndices;        // Profiles are identified by the address of their name
+    HashMap<const char*, uint64> cpuProfileIndices;
     uint64 numProfiles = 0;
     uint64 numCPUProfiles = 0;
     Timer timer;
@@ -0,0 +1,492 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ShaderCacheArchive.h"
+
+#include "..\\Utility.h"
+#include "..\\Exceptions.h"
+
+using std::wstring;
+
+namespace SampleFramework12
+{
+
+static const uint32 PackMagic = MakeFourCC('S', 'F', 'S', 'P');
+static const uint32 PackVersion = 1;
+static const uint32 IndexContentType = MakeFourCC('S', 'F', 'S', 'I');
+static const uint32 IndexVersion = 1;
+static const uint32 InfoSectionID = MakeFourCC('I', 'N', 'F', 'O');
+static const uint32 SlotsSectionID = MakeFourCC('S', 'L', 'O', 'T');
+static const uint64 MinIndexSlots = 16;
+
+struct PackHeader
+{
+    uint32 Magic = 0;
+    uint32 Version = 0;
+    Hash ArchiveID;         // Makes sure that the index was built from this pack, and not one that's since been replaced
+};
+
+struct RecordHeader
+{
+    Hash Key;
+    Hash DataHash;
+    uint64 DataSize = 0;
+};
+
+// Appending locks a byte way past the end of the pack, so that it doesn't get in the way of reads
+static const uint64 AppendLockOffset = UINT64_MAX - 1;
+
+static Hash MakeArchiveID(const wstring& packPath)
+{
+    LARGE_INTEGER counter = { };
+    QueryPerformanceCounter(&counter);
+    const Hash pathHash = GenerateHash(packPath.data(), int(packPath.length() * sizeof(wchar)));
+    return CombineHashes(pathHash, GenerateHash(&counter, sizeof(counter), GetCurrentProcessId()));
+}
+
+static void WritePackHeader(File& file, const wstring& packPath)
+{
+    PackHeader header;
+    header.Magic = PackMagic;
+    header.Version = PackVersion;
+    header.ArchiveID = MakeArchiveID(packPath);
+    file.Write(header);
+}
+
+// Other processes can have the same archive open, so new files are written under a name that's only
+// used by this process and then moved into place. Anything that still has the old file mapped keeps
+// seeing the old contents.
+static wstring TempFilePath(const wstring& path)
+{
+    return path + L"." + ToString(GetCurrentProcessId()) + L".tmp";
+}
+
+static bool MoveTempFile(const wstring& tempPath, const wstring& path, bool replaceExisting)
+{
+    const DWORD flags = replaceExisting ? MOVEFILE_REPLACE_EXISTING : 0;
+    if(MoveFileEx(tempPath.c_str(), path.c_str(), flags))
+        return true;
+
+    WriteLog(L"Failed to move '%ls' to '%ls': %ls", tempPath.c_str(), path.c_str(), GetWin32ErrorString(GetLastError()).c_str());
+    DeleteFile(tempPath.c_str());
+    return false;
+}
+
+static void CreatePack(const wstring& packPath, bool replaceExisting)
+{
+    const wstring tempPath = TempFilePath(packPath);
+    {
+        File newPack(tempPath.c_str(), FileOpenMode::Write);
+        WritePackHeader(newPack, packPath);
+    }
+
+    MoveTempFile(tempPath, packPath, replaceExisting);
+}
+
+static bool ReadPackHeader(const MappedFile& packFile, PackHeader& header)
+{
+    if(packFile.Size() < sizeof(PackHeader))
+        return false;
+
+    memcpy(&header, packFile.Data(), sizeof(PackHeader));
+    return header.Magic == PackMagic && header.Version == PackVersion;
+}
+
+ShaderCacheArchive::~ShaderCacheArchive()
+{
+    // Close() doesn't throw when the index can't be written, so this is safe to call from here
+    Close();
+}
+
+void ShaderCacheArchive::Open(const wchar* directory_)
+{
+    Close();
+
+    directory = directory_;
+    packPath = directory + L"ShaderCache.pack";
+    indexPath = directory + L"ShaderCache.index";
+
+    // Start over with an empty pack if there isn't one, or if it's not one we can read. Another process
+    // might be doing the same thing, in which case whichever pack ends up in place is the one that's used.
+    PackHeader header;
+    const bool packExists = FileExists(packPath.c_str());
+    if(packExists)
+    {
+        packFile.Open(packPath.c_str(), true);
+        if(ReadPackHeader(packFile, header) == false)
+            packFile.Close();
+    }
+
+    if(packFile.Data() == nullptr)
+    {
+        CreatePack(packPath, packExists);
+
+        packFile.Open(packPath.c_str(), true);
+        if(ReadPackHeader(packFile, header) == false)
+        {
+            packFile.Close();
+            throw Exception(MakeString(L"Failed to create shader cache pack '%ls'", packPath.c_str()));
+        }
+    }
+
+    archiveID = header.ArchiveID;
+
+    uint64 indexedSize = sizeof(PackHeader);
+    if(FileExists(indexPath.c_str()) && ChunkedFileReader::IsChunkedFile(indexPath.c_str()))
+    {
+        try
+        {
+            indexReader = new ChunkedFileReader(indexPath.c_str(), IndexContentType);
+            if(indexReader->ContentVersion() != IndexVersion)
+                throw Exception(L"Shader cache index is out of date");
+
+            const ChunkedFileSection& infoSection = indexReader->GetSection(InfoSectionID);
+            indexReader->ValidateSection(infoSection);
+            MemoryReadSerializer serializer = indexReader->SectionSerializer(infoSection);
+
+            Hash indexArchiveID;
+            uint64 coveredSize = 0;
+            uint64 numSlots = 0;
+            uint64 numRecords = 0;
+            SerializeItem(serializer, indexArchiveID.A);
+            SerializeItem(serializer, indexArchiveID.B);
+            SerializeItem(serializer, coveredSize);
+            SerializeItem(serializer, numSlots);
+            SerializeItem(serializer, numRecords);
+
+            const ChunkedFileSection& slotsSection = indexReader->GetSection(SlotsSectionID);
+            indexReader->ValidateSection(slotsSection);
+
+            if((indexArchiveID == archiveID) == false || coveredSize > packFile.Size() || coveredSize < sizeof(PackHeader) ||
+               numSlots == 0 || (numSlots & (numSlots - 1)) != 0 || slotsSection.Size != numSlots * sizeof(IndexSlot))
+                throw Exception(L"Shader cache index doesn't match the pack");
+
+            indexSlots = reinterpret_cast<const IndexSlot*>(indexReader->SectionData(slotsSection));
+            numIndexSlots = numSlots;
+            numIndexedRecords = numRecords;
+            indexedSize = coveredSize;
+        }
+        catch(Exception&)
+        {
+            // Without the index every record gets checked, which is slower but still works
+            WriteLog(L"Ignoring invalid shader cache index '%ls'", indexPath.c_str());
+            delete indexReader;
+            indexReader = nullptr;
+            indexSlots = nullptr;
+            numIndexSlots = 0;
+            numIndexedRecords = 0;
+        }
+    }
+
+    ScanRecords(indexedSize);
+
+    appendFile.Open(packPath.c_str(), FileOpenMode::Append);
+}
+
+void ShaderCacheArchive::Close()
+{
+    if(IsOpen() == false)
+        return;
+
+    // Not having an up-to-date index only makes the next Open() slower, so failing to write it isn't
+    // worth throwing over (especially from the destructor)
+    if(newRecords.Count() > 0)
+    {
+        try
+        {
+            WriteIndex();
+        }
+        catch(Exception& e)
+        {
+            WriteLog(L"Failed to write shader cache index '%ls': %ls", indexPath.c_str(), e.GetMessage().c_str());
+        }
+    }
+
+    appendFile.Close();
+    packFile.Close();
+    delete indexReader;
+    indexReader = nullptr;
+    indexSlots = nullptr;
+    numIndexSlots = 0;
+    numIndexedRecords = 0;
+    newRecords.Shutdown();
+    recordStorage.Reset();
+    appendOffset = 0;
+}
+
+const uint8* ShaderCacheArchive::Find(Hash key, uint64& size) const
+{
+    const IndexSlot* slot = FindSlot(key);
+    if(slot != nullptr)
+    {
+        size = slot->Size;
+        return packFile.Data() + slot->Offset;
+    }
+
+    AcquireSRWLockShared(&lock);
+    const Record* existing = newRecords.Find(key);
+    const Record record = existing != nullptr ? *existing : Record();
+    ReleaseSRWLockShared(&lock);
+
+    size = record.Size;
+    return record.Data;
+}
+
+void ShaderCacheArchive::Add(Hash key, const void* data, uint64 size)
+{
+    Assert_(IsOpen());
+    if(FindSlot(key) != nullptr)
+        return;
+
+    AcquireSRWLockExclusive(&appendLock);
+
+    // Someone else might have added it first. Records only get added while holding appendLock, so
+    // this can't change until it's released.
+    AcquireSRWLockShared(&lock);
+    const bool alreadyAdded = newRecords.Contains(key);
+    ReleaseSRWLockShared(&lock);
+    if(alreadyAdded)
+    {
+        ReleaseSRWLockExclusive(&appendLock);
+        return;
+    }
+
+    // The header goes in front of the data in memory too, so that the record can be written in one go
+    const uint64 recordSize = sizeof(RecordHeader) + size;
+    uint8* recordData = reinterpret_cast<uint8*>(recordStorage.Allocate(recordSize, 8));
+
+    RecordHeader header;
+    header.Key = key;
+    header.DataHash = GenerateHash(data, int(size));
+    header.DataSize = size;
+    memcpy(recordData, &header, sizeof(RecordHeader));
+    memcpy(recordData + sizeof(RecordHeader), data, size);
+
+    // Other processes can be appending to the same pack, so the end of the file is only read once the
+    // lock is held, and the record is written there before anyone else gets a turn
+    uint64 writeOffset = 0;
+    appendFile.Lock(AppendLockOffset, 1);
+    try
+    {
+        writeOffset = appendFile.Size();
+        appendFile.WriteAt(writeOffset, recordSize, recordData);
+    }
+    catch(...)
+    {
+        appendFile.Unlock(AppendLockOffset, 1);
+        ReleaseSRWLockExclusive(&appendLock);
+        throw;
+    }
+    appendFile.Unlock(AppendLockOffset, 1);
+
+    Record record;
+    record.Data = recordData + sizeof(RecordHeader);
+    record.Size = size;
+    record.Offset = writeOffset + sizeof(RecordHeader);
+
+    AcquireSRWLockExclusive(&lock);
+    newRecords.Insert(key, record);
+
+    // Anything in between came from another process (or from a record that was cut off), which means
+    // that the index can only say it covers the pack up to here
+    if(writeOffset == appendOffset)
+        appendOffset += recordSize;
+    ReleaseSRWLockExclusive(&lock);
+
+    ReleaseSRWLockExclusive(&appendLock);
+}
+
+void ShaderCacheArchive::Compact(const Hash* liveKeys, uint64 numLiveKeys)
+{
+    Assert_(IsOpen());
+
+    const wstring tempPath = TempFilePath(packPath);
+    {
+        File newPack(tempPath.c_str(), FileOpenMode::Write);
+        WritePackHeader(newPack, packPath);
+
+        HashMap<Hash, uint8> written;
+        for(uint64 i = 0; i < numLiveKeys; ++i)
+        {
+            uint64 size = 0;
+            const uint8* data = Find(liveKeys[i], size);
+            if(data == nullptr || written.Contains(liveKeys[i]))
+                continue;
+
+            newPack.Write(sizeof(RecordHeader) + size, data - sizeof(RecordHeader));
+            written.Insert(liveKeys[i], 1);
+        }
+    }
+
+    // The old pack is about to be replaced, so there's no point in writing an index for it. Opening the
+    // new one picks up all of its records, and closing it again writes out the index. The old index
+    // doesn't need to be deleted, since the new pack has a different ID. If the pack can't be replaced
+    // the old one is opened again, and the records that aren't in its index are found by scanning.
+    const wstring dir = directory;
+    newRecords.Shutdown();
+    Close();
+    if(MoveTempFile(tempPath, packPath, true) == false)
+    {
+        Open(dir.c_str());
+        return;
+    }
+
+    Open(dir.c_str());
+    if(newRecords.Count() > 0)
+    {
+        Close();
+        Open(dir.c_str());
+    }
+}
+
+uint64 ShaderCacheArchive::NumRecords() const
+{
+    AcquireSRWLockShared(&lock);
+    const uint64 numRecords = numIndexedRecords + newRecords.Count();
+    ReleaseSRWLockShared(&lock);
+    return numRecords;
+}
+
+const ShaderCacheArchive::IndexSlot* ShaderCacheArchive::FindSlot(Hash key) const
+{
+    if(numIndexSlots == 0)
+        return nullptr;
+
+    // The table is never more than half full, so this is almost always the first slot
+    const uint64 mask = numIndexSlots - 1;
+    for(uint64 idx = key.A & mask; ; idx = (idx + 1) & mask)
+    {
+        const IndexSlot& slot = indexSlots[idx];
+        if(slot.Offset == 0)
+            return nullptr;
+        if(slot.Key == key)
+            return SlotIsValid(slot) ? &slot : nullptr;
+    }
+}
+
+// The index is hashed, but it can still disagree with the pack if the pack was changed behind its back.
+// Checking the record header is cheap, since it's right in front of the data that's about to be used.
+bool ShaderCacheArchive::SlotIsValid(const IndexSlot& slot) const
+{
+    const uint64 packSize = packFile.Size();
+    if(slot.Offset < sizeof(PackHeader) + sizeof(RecordHeader) || slot.Offset > packSize ||
+       slot.Size > packSize - slot.Offset)
+        return false;
+
+    RecordHeader header;
+    memcpy(&header, packFile.Data() + slot.Offset - sizeof(RecordHeader), sizeof(RecordHeader));
+    return header.Key == slot.Key && header.DataSize == slot.Size;
+}
+
+// Picks up the records that come after the part of the pack that the index covers. The first one that
+// doesn't check out (most likely because the process writing it went away part of the way through) ends
+// the scan. New records still go at the end of the file after it, and are found through the index.
+void ShaderCacheArchive::ScanRecords(uint64 offset)
+{
+    const uint8* packData = packFile.Data();
+    const uint64 packSize = packFile.Size();
+    while(packSize - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader header;
+        memcpy(&header, packData + offset, sizeof(RecordHeader));
+
+        const uint64 dataOffset = offset + sizeof(RecordHeader);
+        if(header.DataSize > packSize - dataOffset || header.DataSize > uint64(INT32_MAX))
+            break;
+
+        if((GenerateHash(packData + dataOffset, int(header.DataSize)) == header.DataHash) == false)
+            break;
+
+        if(FindSlot(header.Key) == nullptr && newRecords.Contains(header.Key) == false)
+        {
+            Record record;
+            record.Data = packData + dataOffset;
+            record.Size = header.DataSize;
+            record.Offset = dataOffset;
+            newRecords.Insert(header.Key, record);
+        }
+
+        offset = dataOffset + header.DataSize;
+    }
+
+    appendOffset = offset;
+}
+
+void ShaderCacheArchive::WriteIndex()
+{
+    uint64 numSlots = MinIndexSlots;
+    while(numSlots < (numIndexedRecords + newRecords.Count()) * 2)
+        numSlots *= 2;
+
+    // Slots that no longer match the pack, or that were replaced by a new record, are dropped
+    Array<IndexSlot> slots(numSlots);
+    const uint64 mask = numSlots - 1;
+    uint64 numRecords = 0;
+    auto addSlot = [&](Hash key, uint64 offset, uint64 size)
+    {
+        uint64 idx = key.A & mask;
+        while(slots[idx].Offset != 0)
+            idx = (idx + 1) & mask;
+
+        slots[idx].Key = key;
+        slots[idx].Offset = offset;
+        slots[idx].Size = size;
+        ++numRecords;
+    };
+
+    for(uint64 i = 0; i < numIndexSlots; ++i)
+    {
+        const IndexSlot& slot = indexSlots[i];
+        if(slot.Offset != 0 && SlotIsValid(slot) && newRecords.Contains(slot.Key) == false)
+            addSlot(slot.Key, slot.Offset, slot.Size);
+    }
+
+    newRecords.ForEach([&](const Hash& key, const Record& record)
+    {
+        addSlot(key, record.Offset, record.Size);
+    });
+
+    // Another process might have replaced the pack since it was opened, and an index for the old one
+    // would only get thrown away by the next Open()
+    {
+        MappedFile currentPack(packPath.c_str(), true);
+        PackHeader header;
+        if(ReadPackHeader(currentPack, header) == false || (header.ArchiveID == archiveID) == false)
+        {
+            WriteLog(L"Not writing shader cache index '%ls', since the pack was replaced", indexPath.c_str());
+            return;
+        }
+    }
+
+    const wstring tempPath = TempFilePath(indexPath);
+    {
+        ChunkedFileWriter writer(tempPath.c_str(), IndexContentType, IndexVersion);
+
+        writer.BeginSection(InfoSectionID);
+        SerializeItem(writer, archiveID.A);
+        SerializeItem(writer, archiveID.B);
+        SerializeItem(writer, appendOffset);
+        SerializeItem(writer, numSlots);
+        SerializeItem(writer, numRecords);
+        writer.EndSection();
+
+        writer.BeginSection(SlotsSectionID);
+        writer.SerializeData(slots.MemorySize(), slots.Data());
+        writer.EndSection();
+
+        writer.Finish();
+    }
+
+    // The old index can stay mapped (here or in another process) while the new one is moved over it
+    MoveTempFile(tempPath, indexPath, true);
+}
+
+}
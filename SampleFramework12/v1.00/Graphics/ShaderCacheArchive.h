@@ -0,0 +1,113 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\FileIO.h"
+#include "..\\ChunkedFile.h"
+#include "..\\MurmurHash.h"
+#include "..\\Containers.h"
+#include "..\\Allocators.h"
+
+namespace SampleFramework12
+{
+
+// Keeps every cached shader in one append-only pack file, instead of a file per shader. Each record in
+// the pack is a header with the key, size and hash of the data, followed by the data itself. Next to
+// the pack is an index file with an open-addressed hash table of every record, and both of them are
+// memory-mapped when the archive is opened. Looking up a key is a probe into the mapped table, and the
+// returned data points straight into the mapped pack.
+//
+// Records added after the index was written (including ones added while the archive is open) are
+// found by checking the hashes of the records past the end of what the index covers, so a record
+// that was only partially written never gets used. The index is rewritten by Close() when there are
+// new records, and Compact() gets rid of anything in the pack that's no longer needed.
+//
+// Records are always appended at the current end of the pack while holding a lock on the file, so
+// multiple processes can share the same archive. The index and the pack are only ever replaced by moving
+// a finished file over them, and the ones that are already mapped keep their old contents until the
+// archive is closed. Find() and Add() can be called from multiple threads
+// at once. Records that are in the index are found without taking a lock, and are checked against the
+// record header in the pack before they're returned.
+class ShaderCacheArchive
+{
+
+public:
+
+    ~ShaderCacheArchive();
+
+    // Creates the pack and index in the directory if they don't exist yet
+    void Open(const wchar* directory);
+
+    // Failing to write the index is logged instead of thrown, since the archive still works without it
+    void Close();
+
+    // Returns null if the key isn't in the archive. The data stays valid until the archive is closed.
+    const uint8* Find(Hash key, uint64& size) const;
+
+    // Adding a key that's already in the archive does nothing
+    void Add(Hash key, const void* data, uint64 size);
+
+    // Rewrites the pack and index with only the records for the given keys, dropping everything else.
+    // This can't be called while anything else in this process is using the archive. Other processes
+    // keep using the old pack until they open the archive again.
+    void Compact(const Hash* liveKeys, uint64 numLiveKeys);
+
+    bool IsOpen() const { return packFile.Data() != nullptr; }
+    uint64 NumRecords() const;
+    uint64 PackSize() const { return appendOffset; }
+
+private:
+
+    struct IndexSlot
+    {
+        Hash Key;
+        uint64 Offset = 0;          // Where the data starts in the pack, 0 for an empty slot
+        uint64 Size = 0;
+    };
+
+    struct Record
+    {
+        const uint8* Data = nullptr;
+        uint64 Size = 0;
+        uint64 Offset = 0;
+    };
+
+    const IndexSlot* FindSlot(Hash key) const;
+    bool SlotIsValid(const IndexSlot& slot) const;
+    void ScanRecords(uint64 offset);
+    void WriteIndex();
+
+    std::wstring directory;
+    std::wstring packPath;
+    std::wstring indexPath;
+    Hash archiveID;
+
+    MappedFile packFile;
+    ChunkedFileReader* indexReader = nullptr;
+    const IndexSlot* indexSlots = nullptr;
+    uint64 numIndexSlots = 0;
+    uint64 numIndexedRecords = 0;
+
+    // Records that aren't in the index, either from past the end of what it covers or added since the
+    // archive was opened. The data for ones that were added is kept in recordStorage.
+    mutable SRWLOCK lock = SRWLOCK_INIT;
+    HashMap<Hash, Record> newRecords;
+
+    // Only one thread appends at a time, and appendOffset is the end of the part of the pack that every
+    // record is known for. Records appended by other processes aren't known until the next Open().
+    SRWLOCK appendLock = SRWLOCK_INIT;
+    LinearAllocator recordStorage;
+    File appendFile;
+    uint64 appendOffset = 0;
+};
+
+}
@@ -10,6 +10,8 @@
 #include "PCH.h"
 
 #include "ShaderCompilation.h"
+#include "ShaderFileIndex.h"
+#include "ShaderCacheArchive.h"
 
 #include "..\\Utility.h"
 #include "..\\Exceptions.h"
@@ -17,6 +19,8 @@
 #include "..\\FileIO.h"
 #include "..\\MurmurHash.h"
 #include "..\\Containers.h"
+#include "..\\FileWatcher.h"
+#include "..\\EnkiTS\\TaskScheduler.h"
 
 using std::vector;
 using std::wstring;
@@ -38,65 +42,6 @@ static const char* ProfileStrings[] =
 
 StaticAssert_(ArraySize_(ProfileStrings) == TotalNumProfiles);
 
-static string GetExpandedShaderCode(const wchar* path, GrowableList<wstring>& filePaths)
-{
-    for(uint64 i = 0; i < filePaths.Count(); ++i)
-        if(filePaths[i] == path)
-            return string();
-
-    filePaths.Add(path);
-
-    string fileContents = ReadFileAsString(path);
-
-    // Look for includes
-    size_t lineStart = 0;
-    while(true)
-    {
-        size_t lineEnd = fileContents.find('\n', lineStart);
-        size_t lineLength = 0;
-        if(lineEnd == string::npos)
-            lineLength = string::npos;
-        else
-            lineLength = lineEnd - lineStart;
-
-        string line = fileContents.substr(lineStart, lineLength);
-        if(line.find("#include") == 0)
-        {
-            wstring fullIncludePath;
-            size_t startQuote = line.find('\"');
-            if(startQuote != -1)
-            {
-                size_t endQuote = line.find('\"', startQuote + 1);
-                string includePath = line.substr(startQuote + 1, endQuote - startQuote - 1);
-                fullIncludePath = AnsiToWString(includePath.c_str());
-            }
-            else
-            {
-                startQuote = line.find('<');
-                if(startQuote == -1)
-                    throw Exception(L"Malformed include statement: \"" + AnsiToWString(line.c_str()) + L"\" in file " + path);
-                size_t endQuote = line.find('>', startQuote + 1);
-                string includePath = line.substr(startQuote + 1, endQuote - startQuote - 1);
-                fullIncludePath = SampleFrameworkDir() + L"Shaders\\" + AnsiToWString(includePath.c_str());
-            }
-
-            if(FileExists(fullIncludePath.c_str()) == false)
-                throw Exception(L"Couldn't find #included file \"" + fullIncludePath + L"\" in file " + path);
-
-            string includeCode = GetExpandedShaderCode(fullIncludePath.c_str(), filePaths);
-            fileContents.insert(lineEnd + 1, includeCode);
-            lineEnd += includeCode.length();
-        }
-
-        if(lineEnd == string::npos)
-            break;
-
-        lineStart = lineEnd + 1;
-    }
-
-    return fileContents;
-}
-
 static const wstring baseCacheDir = L"ShaderCache\\";
 
 #if _DEBUG
@@ -106,6 +51,40 @@ static const wstring baseCacheDir = L"ShaderCache\\";
 #endif
 
 static const wstring cacheDir = baseCacheDir + cacheSubDir;
+static const wstring fileIndexPath = cacheDir + L"FileIndex.dat";
+
+static ShaderFileIndex FileIndex;
+static bool FileIndexLoaded = false;
+static ShaderCacheArchive CacheArchive;
+
+// These get updated from task scheduler threads
+static std::atomic<uint64> NumCacheHits(0);
+static std::atomic<uint64> NumCacheMisses(0);
+static std::atomic<uint64> NumPendingJobs(0);
+static uint64 NumDuplicatePermutations = 0;
+
+// Another instance of the app might be starting up at the same time, so it's not an error if the
+// directory shows up in between checking for it and creating it
+static void CreateCacheDirectory()
+{
+    const wstring dirs[] = { baseCacheDir, cacheDir };
+    for(uint64 i = 0; i < ArraySize_(dirs); ++i)
+    {
+        if(DirectoryExists(dirs[i].c_str()) == false && CreateDirectory(dirs[i].c_str(), nullptr) == FALSE)
+        {
+            const DWORD error = GetLastError();
+            if(error != ERROR_ALREADY_EXISTS)
+                throw Win32Exception(error);
+        }
+    }
+}
+
+static const char* GetProfileString(ShaderType type, ShaderProfile profile)
+{
+    uint64 profileIdx = uint64(profile) * uint64(ShaderType::NumTypes) + uint64(type);
+    Assert_(profileIdx < TotalNumProfiles);
+    return ProfileStrings[profileIdx];
+}
 
 static string MakeDefinesString(const D3D_SHADER_MACRO* defines)
 {
@@ -123,10 +102,10 @@ static string MakeDefinesString(const D3D_SHADER_MACRO* defines)
     return definesString;
 }
 
-static wstring MakeShaderCacheName(const std::string& shaderCode, const char* functionName,
+static Hash MakeShaderCacheKey(Hash sourceHash, const char* compilerName, const char* functionName,
                                    const char* profile, const D3D_SHADER_MACRO* defines)
 {
-    string hashString = shaderCode;
+    string hashString = compilerName;
     hashString += "\n";
     hashString += functionName;
     hashString += "\n";
@@ -135,74 +114,201 @@ static wstring MakeShaderCacheName(const std::string& shaderCode, const char* fu
 
     hashString += MakeDefinesString(defines);
 
-    Hash codeHash = GenerateHash(hashString.data(), int(hashString.length()), 0);
+    return CombineHashes(sourceHash, GenerateHash(hashString.data(), int(hashString.length()), 0));
+}
 
-    return cacheDir + codeHash.ToString() + L".cache";
+// The files that a cache key was built from, along with the hash of each file's contents at that point
+struct ShaderSourceFiles
+{
+    ShaderFilePathList Paths;
+    SmallList<Hash, 16> Hashes;
+};
+
+// Resolves #includes the same way as the file index
+static wstring ResolveIncludePath(D3D_INCLUDE_TYPE includeType, const char* fileName)
+{
+    if(includeType == D3D_INCLUDE_LOCAL)
+        return AnsiToWString(fileName);
+    else if(includeType == D3D_INCLUDE_SYSTEM)
+        return SampleFrameworkDir() + L"Shaders\\" + AnsiToWString(fileName);
+    else
+        return wstring();
 }
 
-class FrameworkInclude : public ID3DInclude
+// Reads the shader file and everything that it includes in one go right before compiling, and serves
+// the includes to the compiler from that. This way the compiler sees exactly what gets checked against
+// the cache key, even if the files are being saved while the shader compiles. Includes that the file
+// index didn't find are read from disk as before.
+class ShaderSourceSnapshot : public ID3DInclude
 {
+
+public:
+
+    ShaderSourceSnapshot(const ShaderSourceFiles& sourceFiles) : paths(sourceFiles.Paths)
+    {
+        Assert_(sourceFiles.Paths.Count() > 0);
+        Assert_(sourceFiles.Paths.Count() == sourceFiles.Hashes.Count());
+
+        contents.Init(paths.Count());
+        for(uint64 i = 0; i < paths.Count(); ++i)
+        {
+            contents[i] = ReadFileAsString(paths[i].c_str());
+            const Hash hash = GenerateHash(contents[i].data(), int(contents[i].length()));
+            matchesCacheKey = matchesCacheKey && hash == sourceFiles.Hashes[i];
+        }
+    }
+
+    ~ShaderSourceSnapshot()
+    {
+        for(uint64 i = 0; i < otherContents.Count(); ++i)
+            delete otherContents[i];
+    }
+
+    const string& Source() const { return contents[0]; }
+    bool MatchesCacheKey() const { return matchesCacheKey; }
+
     HRESULT Open(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override
     {
-        std::wstring filePath;
-        if(IncludeType == D3D_INCLUDE_LOCAL)
-            filePath = AnsiToWString(pFileName);
-        else if(IncludeType == D3D_INCLUDE_SYSTEM)
-            filePath = SampleFrameworkDir() + L"Shaders\\" + AnsiToWString(pFileName);
-        else
+        const wstring filePath = ResolveIncludePath(IncludeType, pFileName);
+        if(filePath.length() == 0)
             return E_FAIL;
 
-        if(FileExists(filePath.c_str()) == false)
-            return E_FAIL;
-        File file(filePath.c_str(), FileOpenMode::Read);
-        *pBytes = UINT(file.Size());
-        uint8* data = reinterpret_cast<uint8*>(std::malloc(*pBytes));
-        file.Read(*pBytes, data);
-        *ppData = data;
+        const string* fileContents = nullptr;
+        for(uint64 i = 0; i < paths.Count() && fileContents == nullptr; ++i)
+            if(paths[i] == filePath)
+                fileContents = &contents[i];
+
+        if(fileContents == nullptr)
+        {
+            // Exceptions can't go back through the compiler
+            try
+            {
+                string* otherFile = new string(ReadFileAsString(filePath.c_str()));
+                otherContents.Add(otherFile);
+                fileContents = otherFile;
+            }
+            catch(Exception&)
+            {
+                return E_FAIL;
+            }
+        }
+
+        *ppData = fileContents->data();
+        *pBytes = UINT(fileContents->length());
         return S_OK;
     }
 
     HRESULT Close(LPCVOID pData) override
     {
-        std::free(const_cast<void*>(pData));
         return S_OK;
     }
+
+private:
+
+    const ShaderFilePathList& paths;
+    Array<string> contents;
+    GrowableList<string*> otherContents;
+    bool matchesCacheKey = true;
+
+    ShaderSourceSnapshot(const ShaderSourceSnapshot& other);
+    ShaderSourceSnapshot& operator=(const ShaderSourceSnapshot& other);
 };
 
-static ID3DBlob* CompileShader(const wchar* path, const char* functionName, ShaderType type, ShaderProfile profile,
-                              const D3D_SHADER_MACRO* defines, bool forceOptimization, GrowableList<wstring>& filePaths)
+class FxcShaderCompiler : public ShaderCompiler
 {
+    HRESULT Compile(const wchar* path, const void* source, uint64 sourceSize, ID3DInclude* include,
+                    const D3D_SHADER_MACRO* defines, const char* functionName, const char* profile,
+                    uint32 flags, ID3DBlob** byteCode, ID3DBlob** errorMessages) override
+    {
+        const string sourceName = WStringToAnsi(path);
+        return D3DCompile(source, sourceSize, sourceName.c_str(), defines, include, functionName, profile,
+                          flags, 0, byteCode, errorMessages);
+    }
+
+    const char* CacheName() const override
+    {
+        return "FXC " D3DCOMPILER_DLL_A;
+    }
+};
+
+static FxcShaderCompiler DefaultCompiler;
+static ShaderCompiler* ActiveCompiler = &DefaultCompiler;
+
+void SetShaderCompiler(ShaderCompiler* compiler)
+{
+    Assert_(NumPendingJobs == 0);
+    ActiveCompiler = compiler != nullptr ? compiler : &DefaultCompiler;
+}
+
+// Builds the cache key for a shader, and fills in the list of files that it depends on. This uses
+// the file index, so it needs to happen on the main thread.
+static Hash GetShaderCacheKey(const CompiledShader& shader, ShaderSourceFiles& sourceFiles)
+{
+    const wchar* path = shader.FilePath.c_str();
     if(FileExists(path) == false)
     {
         Assert_(false);
         throw Exception(L"Shader file " + std::wstring(path) + L" does not exist");
     }
 
-    uint64 profileIdx = uint64(profile) * uint64(ShaderType::NumTypes) + uint64(type);
-    Assert_(profileIdx < TotalNumProfiles);
-    const char* profileString = ProfileStrings[profileIdx];
-
-    // Make a hash off the expanded shader code
-    string shaderCode = GetExpandedShaderCode(path, filePaths);
-    wstring cacheName = MakeShaderCacheName(shaderCode, functionName, profileString, defines);
+    // The source part of the cache key comes from the hashes of the file and everything that it
+    // includes, which only needs the files to be read if they've changed since the index was built
+    if(FileIndexLoaded == false)
+    {
+        FileIndex.Load(fileIndexPath.c_str());
+        FileIndexLoaded = true;
+    }
 
-    if(FileExists(cacheName.c_str()))
+    if(CacheArchive.IsOpen() == false)
     {
-        File cacheFile(cacheName.c_str(), FileOpenMode::Read);
+        CreateCacheDirectory();
+        CacheArchive.Open(cacheDir.c_str());
+    }
+
+    D3D_SHADER_MACRO defines[CompileOptions::MaxDefines + 1];
+    shader.CompileOpts.MakeDefines(defines);
+
+    const char* compilerName = ActiveCompiler->CacheName();
+    Hash sourceHash = FileIndex.HashFileAndIncludes(path, sourceFiles.Paths);
+    for(uint64 i = 0; i < sourceFiles.Paths.Count(); ++i)
+        sourceFiles.Hashes.Add(FileIndex.FileHash(sourceFiles.Paths[i].c_str()));
+
+    return MakeShaderCacheKey(sourceHash, compilerName != nullptr ? compilerName : "", shader.FunctionName.c_str(),
+                              GetProfileString(shader.Type, shader.Profile), defines);
+}
+
+// Loads the shader from the cache if it's there, otherwise it's compiled and added to the cache. The
+// only shared state that this touches is the cache archive, so it can run on any thread.
+static ID3DBlob* LoadOrCompileShader(const CompiledShader& shader, Hash cacheKey, const ShaderSourceFiles& sourceFiles)
+{
+    const wchar* path = shader.FilePath.c_str();
+    const char* functionName = shader.FunctionName.c_str();
+    const ShaderType type = shader.Type;
+    const char* profileString = GetProfileString(type, shader.Profile);
+    const bool forceOptimization = shader.ForceOptimization;
 
-        const uint64 shaderSize = cacheFile.Size();
-        Array<uint8> compressedShader;
-        compressedShader.Init(shaderSize);
-        cacheFile.Read(shaderSize, compressedShader.Data());
+    D3D_SHADER_MACRO defines[CompileOptions::MaxDefines + 1];
+    shader.CompileOpts.MakeDefines(defines);
+
+    // Compilers without a cache name could produce anything, so they always compile
+    const bool useArchive = ActiveCompiler->CacheName() != nullptr;
+
+    uint64 shaderSize = 0;
+    const uint8* compressedShader = useArchive ? CacheArchive.Find(cacheKey, shaderSize) : nullptr;
+    if(compressedShader != nullptr)
+    {
+        ++NumCacheHits;
 
         ID3DBlob* decompressedShader[1] = { nullptr };
         uint32 indices[1] = { 0 };
-        DXCall(D3DDecompressShaders(compressedShader.Data(), shaderSize, 1, 0,
+        DXCall(D3DDecompressShaders(compressedShader, shaderSize, 1, 0,
                                     indices, 0, decompressedShader, nullptr));
 
         return decompressedShader[0];
     }
 
+    ++NumCacheMisses;
+
     WriteLog("Compiling %s shader %s_%s %s\n", TypeStrings[uint64(type)],
                 WStringToAnsi(GetFileName(path).c_str()).c_str(),
                 functionName, MakeDefinesString(defines).c_str());
@@ -218,11 +324,14 @@ static ID3DBlob* CompileShader(const wchar* path, const char* functionName, Shad
                 flags |= D3DCOMPILE_SKIP_OPTIMIZATION;*/
         #endif
 
+        // Read again on every retry, so that fixes to the file get picked up
+        ShaderSourceSnapshot snapshot(sourceFiles);
+
         ID3DBlob* compiledShader;
         ID3DBlobPtr errorMessages;
-        FrameworkInclude include;
-        HRESULT hr = D3DCompileFromFile(path, defines, &include, functionName,
-                                        profileString, flags, 0, &compiledShader, &errorMessages);
+        HRESULT hr = ActiveCompiler->Compile(path, snapshot.Source().data(), snapshot.Source().length(), &snapshot,
+                                             defines, functionName, profileString, flags,
+                                             &compiledShader, &errorMessages);
 
         if(FAILED(hr))
         {
@@ -250,25 +359,22 @@ static ID3DBlob* CompileShader(const wchar* path, const char* functionName, Shad
         }
         else
         {
-            // Compress the shader
-            D3D_SHADER_DATA shaderData;
-            shaderData.pBytecode = compiledShader->GetBufferPointer();
-            shaderData.BytecodeLength = compiledShader->GetBufferSize();
-            ID3DBlobPtr compressedShader;
-            DXCall(D3DCompressShaders(1, &shaderData, D3D_COMPRESS_SHADER_KEEP_ALL_PARTS, &compressedShader));
-
-            // Create the cache directory if it doesn't exist
-            if(DirectoryExists(baseCacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(baseCacheDir.c_str(), nullptr));
-
-            if(DirectoryExists(cacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(cacheDir.c_str(), nullptr));
+            // A file that changed after the key was built would put the wrong byte code under that key
+            if(useArchive && snapshot.MatchesCacheKey() == false)
+                WriteLog("Not caching shader %s_%s, its files changed while it was compiling\n",
+                         WStringToAnsi(GetFileName(path).c_str()).c_str(), functionName);
 
-            File cacheFile(cacheName.c_str(), FileOpenMode::Write);
-
-            // Write the compiled shader to disk
-            uint64 shaderSize = compressedShader->GetBufferSize();
-            cacheFile.Write(shaderSize, compressedShader->GetBufferPointer());
+            if(useArchive && snapshot.MatchesCacheKey())
+            {
+                // Compress the shader
+                D3D_SHADER_DATA shaderData;
+                shaderData.pBytecode = compiledShader->GetBufferPointer();
+                shaderData.BytecodeLength = compiledShader->GetBufferSize();
+                ID3DBlobPtr compressedShader;
+                DXCall(D3DCompressShaders(1, &shaderData, D3D_COMPRESS_SHADER_KEEP_ALL_PARTS, &compressedShader));
+
+                CacheArchive.Add(cacheKey, compressedShader->GetBufferPointer(), compressedShader->GetBufferSize());
+            }
 
             return compiledShader;
         }
@@ -278,59 +384,269 @@ static ID3DBlob* CompileShader(const wchar* path, const char* functionName, Shad
 struct ShaderFile
 {
     wstring FilePath;
-    uint64 TimeStamp;
     GrowableList<CompiledShader*> Shaders;
+    HashMap<const CompiledShader*, uint64> ShaderIndices;   // Index of each shader in Shaders
 
-    ShaderFile(const wstring& filePath) : TimeStamp(0), FilePath(filePath)
+    ShaderFile(const wstring& filePath) : FilePath(filePath)
     {
     }
 };
 
 static GrowableList<ShaderFile*> ShaderFiles;
+static HashMap<wstring, ShaderFile*> ShaderFileMap;
 static GrowableList<CompiledShader*> CompiledShaders;
+static FileWatcher* ShaderWatcher = nullptr;
 
-static void CompileShader(CompiledShader* shader)
+// == Byte code store =============================================================================
+
+// Shaders with identical byte code (for instance permutations whose defines don't make a difference)
+// share one blob, keyed by the hash of the byte code. Each entry counts the shaders that use it, and
+// goes away along with the last of them.
+struct StoredByteCode
 {
-    Assert_(shader != nullptr);
+    ID3DBlobPtr ByteCode;
+    uint64 NumShaders = 0;
+};
 
-    GrowableList<wstring> filePaths;
-    D3D_SHADER_MACRO defines[CompileOptions::MaxDefines + 1];
-    shader->CompileOpts.MakeDefines(defines);
-    shader->ByteCode = CompileShader(shader->FilePath.c_str(), shader->FunctionName.c_str(),
-                                     shader->Type, shader->Profile, defines,
-                                     shader->ForceOptimization, filePaths);
-    shader->ByteCodeHash = GenerateHash(shader->ByteCode->GetBufferPointer(), int(shader->ByteCode->GetBufferSize()));
+static SRWLOCK ByteCodeStoreLock = SRWLOCK_INIT;
+static HashMap<Hash, StoredByteCode> ByteCodeStore;
+static HashMap<const void*, Hash> ByteCodeHashes;       // Start of each stored blob -> its hash
+static uint64 NumSharedByteCodes = 0;
+static uint64 ByteCodeBytesSaved = 0;
+
+// Takes ownership of the byte code, and gives the shader either that or an identical blob from the store
+static void AcquireByteCode(CompiledShader* shader, ID3DBlob* byteCode)
+{
+    const uint64 byteCodeSize = byteCode->GetBufferSize();
+    const Hash hash = GenerateHash(byteCode->GetBufferPointer(), int(byteCodeSize));
+
+    AcquireSRWLockExclusive(&ByteCodeStoreLock);
+
+    StoredByteCode* stored = ByteCodeStore.Find(hash);
+    if(stored != nullptr)
+    {
+        Assert_(stored->ByteCode->GetBufferSize() == byteCodeSize);
+        byteCode->Release();
+        ++NumSharedByteCodes;
+        ByteCodeBytesSaved += byteCodeSize;
+    }
+    else
+    {
+        StoredByteCode newEntry;
+        newEntry.ByteCode.Attach(byteCode);
+        ByteCodeStore.Insert(hash, newEntry);
+        ByteCodeHashes.Insert(byteCode->GetBufferPointer(), hash);
+        stored = ByteCodeStore.Find(hash);
+    }
+
+    ++stored->NumShaders;
+    shader->ByteCode = stored->ByteCode;
+    shader->ByteCodeHash = hash;
+
+    ReleaseSRWLockExclusive(&ByteCodeStoreLock);
+}
+
+static void ReleaseByteCode(CompiledShader* shader)
+{
+    if(!shader->ByteCode)
+        return;
+
+    AcquireSRWLockExclusive(&ByteCodeStoreLock);
+
+    StoredByteCode* stored = ByteCodeStore.Find(shader->ByteCodeHash);
+    Assert_(stored != nullptr && stored->NumShaders > 0);
+    if(stored->NumShaders > 1)
+    {
+        --NumSharedByteCodes;
+        ByteCodeBytesSaved -= shader->ByteCode->GetBufferSize();
+    }
+
+    shader->ByteCode = nullptr;
+    if(--stored->NumShaders == 0)
+    {
+        ByteCodeHashes.Remove(stored->ByteCode->GetBufferPointer());
+        ByteCodeStore.Remove(shader->ByteCodeHash);
+    }
+
+    ReleaseSRWLockExclusive(&ByteCodeStoreLock);
+}
+
+Hash GetByteCodeHash(const D3D12_SHADER_BYTECODE& byteCode)
+{
+    if(byteCode.BytecodeLength == 0)
+        return Hash();
+
+    AcquireSRWLockShared(&ByteCodeStoreLock);
+    const Hash* storedHash = ByteCodeHashes.Find(byteCode.pShaderBytecode);
+    const bool isStored = storedHash != nullptr;
+    const Hash hash = isStored ? *storedHash : Hash();
+    ReleaseSRWLockShared(&ByteCodeStoreLock);
 
+    return isStored ? hash : GenerateHash(byteCode.pShaderBytecode, int(byteCode.BytecodeLength));
+}
+
+static void LoadOrCompileByteCode(CompiledShader* shader, Hash cacheKey, const ShaderSourceFiles& sourceFiles)
+{
+    AcquireByteCode(shader, LoadOrCompileShader(*shader, cacheKey, sourceFiles));
+}
+
+// Adds the shader to the list for each file that it depends on, for hot-reloading
+static void RegisterShaderFiles(CompiledShader* shader, const ShaderFilePathList& filePaths)
+{
     for(uint64 fileIdx = 0; fileIdx < filePaths.Count(); ++ fileIdx)
     {
         const wstring& filePath = filePaths[fileIdx];
         ShaderFile* shaderFile = nullptr;
-        for(uint64 shaderFileIdx = 0; shaderFileIdx < ShaderFiles.Count(); ++shaderFileIdx)
+        ShaderFile** existingFile = ShaderFileMap.Find(filePath);
+        if(existingFile != nullptr)
         {
-            if(ShaderFiles[shaderFileIdx]->FilePath == filePath)
-            {
-                shaderFile = ShaderFiles[shaderFileIdx];
-                break;
-            }
+            shaderFile = *existingFile;
         }
-        if(shaderFile == nullptr)
+        else
         {
             shaderFile = new ShaderFile(filePath);
             ShaderFiles.Add(shaderFile);
+            ShaderFileMap.Insert(filePath, shaderFile);
+
+            if(ShaderWatcher == nullptr)
+                ShaderWatcher = CreateFileWatcher();
+            ShaderWatcher->AddFile(filePath.c_str());
         }
 
-        bool containsShader = false;
-        for(uint64 shaderIdx = 0; shaderIdx < shaderFile->Shaders.Count(); ++shaderIdx)
+        if(shaderFile->ShaderIndices.Contains(shader) == false)
+            shaderFile->ShaderIndices.Insert(shader, shaderFile->Shaders.Add(shader));
+    }
+}
+
+static void CompileShader(CompiledShader* shader)
+{
+    Assert_(shader != nullptr);
+
+    ShaderSourceFiles sourceFiles;
+    const Hash cacheKey = GetShaderCacheKey(*shader, sourceFiles);
+    LoadOrCompileByteCode(shader, cacheKey, sourceFiles);
+    RegisterShaderFiles(shader, sourceFiles.Paths);
+}
+
+// == Batch compilation ===========================================================================
+
+class ShaderCompileJob
+{
+
+public:
+
+    CompiledShader* Shader = nullptr;
+    Hash CacheKey;
+    ShaderSourceFiles SourceFiles;
+    enki::TaskScheduler* TaskScheduler = nullptr;
+    enki::TaskSet Task;
+    std::exception_ptr Error;
+
+    ShaderCompileJob(CompiledShader* shader, Hash cacheKey, const ShaderSourceFiles& sourceFiles,
+                     enki::TaskScheduler* taskScheduler) :
+        Shader(shader), CacheKey(cacheKey), SourceFiles(sourceFiles), TaskScheduler(taskScheduler)
+    {
+        Task.m_Function = [this](enki::TaskSetPartition, uint32_t) { Execute(); };
+    }
+
+    // The scheduler still touches the task after Execute() returns, so it has to be waited on
+    // before the job goes away, even if the job looks like it's finished
+    ~ShaderCompileJob()
+    {
+        Wait();
+    }
+
+    void Execute()
+    {
+        // Exceptions can't escape a task, so they get passed along to whoever waits on the result
+        try
         {
-            if(shaderFile->Shaders[shaderIdx] == shader)
-            {
-                containsShader = true;
-                break;
-            }
+            LoadOrCompileByteCode(Shader, CacheKey, SourceFiles);
+        }
+        catch(...)
+        {
+            Error = std::current_exception();
+        }
+
+        --NumPendingJobs;
+    }
+
+    // Jobs that ran inline never went through the scheduler, and always count as complete
+    bool IsComplete() const
+    {
+        // GetIsComplete() is a relaxed load, so this makes sure that the results of Execute() are visible
+        const bool complete = Task.GetIsComplete();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return complete;
+    }
+
+    void Wait()
+    {
+        if(TaskScheduler != nullptr)
+            TaskScheduler->WaitforTaskSet(&Task);
+        Assert_(IsComplete());
+    }
+};
+
+static GrowableList<ShaderCompileJob*> CompileJobs;
+
+bool PendingShader::Ready() const
+{
+    Assert_(job != nullptr);
+    return job->IsComplete();
+}
+
+CompiledShaderPtr PendingShader::Wait() const
+{
+    Assert_(job != nullptr);
+    job->Wait();
+    if(job->Error)
+        std::rethrow_exception(job->Error);
+
+    return job->Shader;
+}
+
+void CompileShaders(const ShaderPermutation* permutations, uint64 numPermutations, PendingShader* results,
+                    enki::TaskScheduler* taskScheduler)
+{
+    Assert_(permutations != nullptr || numPermutations == 0);
+    Assert_(results != nullptr || numPermutations == 0);
+
+    HashMap<Hash, ShaderCompileJob*> batchJobs;
+    for(uint64 i = 0; i < numPermutations; ++i)
+    {
+        const ShaderPermutation& permutation = permutations[i];
+        CompiledShader shaderDesc(permutation.FilePath, permutation.FunctionName, permutation.Profile,
+                                  permutation.CompileOpts, permutation.ForceOptimization, permutation.Type);
+
+        ShaderSourceFiles sourceFiles;
+        const Hash cacheKey = GetShaderCacheKey(shaderDesc, sourceFiles);
+
+        ShaderCompileJob* job = nullptr;
+        ShaderCompileJob** existingJob = batchJobs.Find(cacheKey);
+        if(existingJob != nullptr)
+        {
+            job = *existingJob;
+            ++NumDuplicatePermutations;
+        }
+        else
+        {
+            CompiledShader* compiledShader = new CompiledShader(shaderDesc);
+            CompiledShaders.Add(compiledShader);
+
+            job = new ShaderCompileJob(compiledShader, cacheKey, sourceFiles, taskScheduler);
+            CompileJobs.Add(job);
+            batchJobs.Insert(cacheKey, job);
+
+            ++NumPendingJobs;
+            if(taskScheduler != nullptr)
+                taskScheduler->AddTaskSetToPipe(&job->Task);
+            else
+                job->Execute();
         }
 
-        if(containsShader == false)
-            shaderFile->Shaders.Add(shader);
+        RegisterShaderFiles(job->Shader, sourceFiles.Paths);
+        results[i] = PendingShader(job);
     }
 }
 
@@ -402,60 +718,227 @@ ComputeShaderPtr CompileCSFromFile(const wchar* path,
     return CompileFromFile(path, functionName, ShaderType::Compute, profile, compileOptions, forceOptimization);
 }
 
-bool UpdateShaders()
+// == Hot reloading ===============================================================================
+
+// A shader that's being recompiled because one of its files changed. The new byte code goes into a copy
+// of the shader, so that the one the app is using stays as it was until the whole batch is done.
+struct ShaderReload
 {
-    if(ShaderFiles.Count() == 0)
-        return false;
+    CompiledShader* Shader = nullptr;
+    CompiledShader* NewShader = nullptr;
+    ShaderSourceFiles SourceFiles;
+    Hash CacheKey;
+    ShaderCompileJob* Job = nullptr;
+};
 
-    static uint64 currFile = 0;
-    currFile = (currFile + 1) % uint64(ShaderFiles.Count());
+static const uint64 MaxReloadRetries = 10;
 
-    ShaderFile* file = ShaderFiles[currFile];
-    const uint64 newTimeStamp = GetFileTimestamp(file->FilePath.c_str());
-    if(file->TimeStamp == 0)
+static GrowableList<wstring> ChangedFiles;
+static GrowableList<ShaderReload*> PendingReloads;
+static uint64 NumReloadRetries = 0;
+
+static void DeleteReloads()
+{
+    for(uint64 i = 0; i < PendingReloads.Count(); ++i)
     {
-        file->TimeStamp = newTimeStamp;
-        return false;
+        ShaderReload* reload = PendingReloads[i];
+        delete reload->Job;
+        ReleaseByteCode(reload->NewShader);
+        delete reload->NewShader;
+        delete reload;
     }
+    PendingReloads.RemoveAll();
+}
+
+static void StartReloads(enki::TaskScheduler* taskScheduler)
+{
+    ShaderWatcher->GetChangedFiles(ChangedFiles);
+    if(ChangedFiles.Count() == 0)
+        return;
 
-    if(file->TimeStamp < newTimeStamp)
+    GrowableList<CompiledShader*> shaders;
+    HashMap<const CompiledShader*, uint64> shaderIndices;
+    for(uint64 fileIdx = 0; fileIdx < ChangedFiles.Count(); ++fileIdx)
     {
-        WriteLog("Hot-swapping shaders for %ls\n", file->FilePath.c_str());
-        file->TimeStamp = newTimeStamp;
-        for(uint64 i = 0; i < file->Shaders.Count(); ++i)
+        ShaderFile** file = ShaderFileMap.Find(ChangedFiles[fileIdx]);
+        if(file == nullptr)
+            continue;
+
+        if(NumReloadRetries == 0)
+            WriteLog("Hot-swapping shaders for %ls\n", (*file)->FilePath.c_str());
+        FileIndex.Invalidate((*file)->FilePath.c_str());
+
+        for(uint64 i = 0; i < (*file)->Shaders.Count(); ++i)
         {
-            // Retry a few times to avoid file conflicts with text editors
-            const uint64 NumRetries = 10;
-            for(uint64 retryCount = 0; retryCount < NumRetries; ++retryCount)
-            {
-                try
-                {
-                    CompiledShader* shader = file->Shaders[i];
-                    CompileShader(shader);
-                    break;
-                }
-                catch(Win32Exception& exception)
-                {
-                    if(retryCount == NumRetries - 1)
-                        throw exception;
-                    Sleep(15);
-                }
-            }
+            CompiledShader* shader = (*file)->Shaders[i];
+            if(shaderIndices.Contains(shader) == false)
+                shaderIndices.Insert(shader, shaders.Add(shader));
+        }
+    }
+
+    // Text editors can still have the file open, in which case it gets tried again on the next frame
+    try
+    {
+        for(uint64 i = 0; i < shaders.Count(); ++i)
+        {
+            ShaderReload* reload = new ShaderReload();
+            PendingReloads.Add(reload);
+            reload->Shader = shaders[i];
+            reload->NewShader = new CompiledShader(*shaders[i]);
+            reload->NewShader->ByteCode = nullptr;
+            reload->CacheKey = GetShaderCacheKey(*reload->NewShader, reload->SourceFiles);
+        }
+    }
+    catch(Win32Exception&)
+    {
+        DeleteReloads();
+        if(++NumReloadRetries < MaxReloadRetries)
+            return;
+
+        NumReloadRetries = 0;
+        ChangedFiles.RemoveAll();
+        throw;
+    }
+
+    NumReloadRetries = 0;
+    ChangedFiles.RemoveAll();
+
+    for(uint64 i = 0; i < PendingReloads.Count(); ++i)
+    {
+        ShaderReload* reload = PendingReloads[i];
+        reload->Job = new ShaderCompileJob(reload->NewShader, reload->CacheKey, reload->SourceFiles, taskScheduler);
+
+        ++NumPendingJobs;
+        if(taskScheduler != nullptr)
+            taskScheduler->AddTaskSetToPipe(&reload->Job->Task);
+        else
+            reload->Job->Execute();
+    }
+}
+
+// Swaps in the new byte code once every shader in the batch has finished, so that the app never
+// ends up with a mix of old and new shaders
+static bool FinishReloads()
+{
+    for(uint64 i = 0; i < PendingReloads.Count(); ++i)
+        if(PendingReloads[i]->Job->IsComplete() == false)
+            return false;
+
+    for(uint64 i = 0; i < PendingReloads.Count(); ++i)
+    {
+        if(PendingReloads[i]->Job->Error)
+        {
+            std::exception_ptr error = PendingReloads[i]->Job->Error;
+            DeleteReloads();
+            std::rethrow_exception(error);
         }
+    }
 
-        return true;
+    for(uint64 i = 0; i < PendingReloads.Count(); ++i)
+    {
+        ShaderReload* reload = PendingReloads[i];
+        ReleaseByteCode(reload->Shader);
+        reload->Shader->ByteCode = reload->NewShader->ByteCode;
+        reload->Shader->ByteCodeHash = reload->NewShader->ByteCodeHash;
+        reload->NewShader->ByteCode = nullptr;
+        RegisterShaderFiles(reload->Shader, reload->SourceFiles.Paths);
     }
 
-    return false;
+    DeleteReloads();
+
+    return true;
+}
+
+bool UpdateShaders(enki::TaskScheduler* taskScheduler)
+{
+    if(PendingReloads.Count() > 0)
+        return FinishReloads();
+
+    // Shaders that are still being compiled by CompileShaders() can't be swapped out from under it
+    if(ShaderWatcher == nullptr || NumPendingJobs > 0)
+        return false;
+
+    StartReloads(taskScheduler);
+
+    // Without a task scheduler, or if they all came from the cache, they might already be done
+    return PendingReloads.Count() > 0 && FinishReloads();
+}
+
+ShaderCacheStats GetShaderCacheStats()
+{
+    ShaderCacheStats stats;
+    stats.NumCacheHits = NumCacheHits;
+    stats.NumCacheMisses = NumCacheMisses;
+    stats.NumDuplicatePermutations = NumDuplicatePermutations;
+    stats.NumFilesChecked = FileIndex.NumFilesChecked();
+    stats.NumFilesHashed = FileIndex.NumFilesHashed();
+
+    AcquireSRWLockShared(&ByteCodeStoreLock);
+    stats.NumUniqueByteCodes = ByteCodeStore.Count();
+    stats.NumSharedByteCodes = NumSharedByteCodes;
+    stats.ByteCodeBytesSaved = ByteCodeBytesSaved;
+    ReleaseSRWLockShared(&ByteCodeStoreLock);
+
+    return stats;
+}
+
+void CompactShaderCache()
+{
+    Assert_(NumPendingJobs == 0);
+    if(CacheArchive.IsOpen() == false)
+        return;
+
+    // The file index only re-reads files that UpdateShaders() saw change, so these come out the same as
+    // the keys that the loaded shaders were last compiled with
+    Array<Hash> liveKeys(CompiledShaders.Count());
+    for(uint64 i = 0; i < CompiledShaders.Count(); ++i)
+    {
+        ShaderSourceFiles sourceFiles;
+        liveKeys[i] = GetShaderCacheKey(*CompiledShaders[i], sourceFiles);
+    }
+
+    CacheArchive.Compact(liveKeys.Data(), liveKeys.Size());
 }
 
 void ShutdownShaders()
 {
+    for(uint64 i = 0; i < CompileJobs.Count(); ++i)
+        delete CompileJobs[i];
+    CompileJobs.Shutdown();
+
+    DeleteReloads();
+    PendingReloads.Shutdown();
+    ChangedFiles.Shutdown();
+    NumReloadRetries = 0;
+
+    delete ShaderWatcher;
+    ShaderWatcher = nullptr;
+
+    if(FileIndex.Dirty())
+    {
+        CreateCacheDirectory();
+        FileIndex.Save(fileIndexPath.c_str());
+    }
+    FileIndex.Shutdown();
+    FileIndexLoaded = false;
+
+    CacheArchive.Close();
+
     for(uint64 i = 0; i < ShaderFiles.Count(); ++i)
         delete ShaderFiles[i];
+    ShaderFiles.Shutdown();
+    ShaderFileMap.Shutdown();
 
     for(uint64 i = 0; i < CompiledShaders.Count(); ++i)
+    {
+        ReleaseByteCode(CompiledShaders[i]);
         delete CompiledShaders[i];
+    }
+    CompiledShaders.Shutdown();
+
+    Assert_(ByteCodeStore.Count() == 0);
+    ByteCodeStore.Shutdown();
+    ByteCodeHashes.Shutdown();
 }
 
 // == CompileOptions ==============================================================================
@@ -15,6 +15,11 @@
 #include "..\\Assert.h"
 #include "..\\MurmurHash.h"
 
+namespace enki
+{
+    class TaskScheduler;
+}
+
 namespace SampleFramework12
 {
 
@@ -191,7 +196,115 @@ ComputeShaderPtr CompileCSFromFile(const wchar* path,
                                    const CompileOptions& compileOpts = CompileOptions(),
                                    bool forceOptimization = false);
 
-bool UpdateShaders();
+// Describes one shader to compile as part of a batch
+struct ShaderPermutation
+{
+    const wchar* FilePath = nullptr;
+    const char* FunctionName = nullptr;
+    ShaderType Type = ShaderType::Pixel;
+    ShaderProfile Profile = ShaderProfile::SM51;
+    CompileOptions CompileOpts;
+    bool ForceOptimization = false;
+};
+
+class ShaderCompileJob;
+
+// A shader from CompileShaders() that may still be compiling
+class PendingShader
+{
+public:
+
+    PendingShader() : job(nullptr)
+    {
+    }
+
+    explicit PendingShader(ShaderCompileJob* job_) : job(job_)
+    {
+    }
+
+    bool Valid() const
+    {
+        return job != nullptr;
+    }
+
+    bool Ready() const;
+
+    // Blocks until the shader is compiled, and re-throws anything that was thrown while compiling it
+    CompiledShaderPtr Wait() const;
+
+private:
+
+    ShaderCompileJob* job;
+};
+
+// Compiles a batch of shaders, with the cache misses getting compiled in parallel on the task
+// scheduler (or immediately when it's null). Permutations that end up with the same cache key are only
+// compiled once, and share the same CompiledShader. The cache keys are built from the shader files as
+// they are when this is called. If a file changes before its shaders get compiled they're compiled from
+// the new contents, but the results don't go into the cache since they no longer match their keys.
+void CompileShaders(const ShaderPermutation* permutations, uint64 numPermutations, PendingShader* results,
+                    enki::TaskScheduler* taskScheduler = nullptr);
+
+// Interface for the compiler that's invoked on a cache miss, which can be overridden to use a
+// different compiler or to stub out compilation. Compile() can be called from multiple threads at once.
+class ShaderCompiler
+{
+public:
+
+    virtual ~ShaderCompiler()
+    {
+    }
+
+    // The source is the contents of the file at path, and the include handler serves the files that it
+    // #includes. Both come from one read of the files that's checked against the cache key, so the
+    // compiler shouldn't go back to the files on disk.
+    virtual HRESULT Compile(const wchar* path, const void* source, uint64 sourceSize, ID3DInclude* include,
+                            const D3D_SHADER_MACRO* defines, const char* functionName, const char* profile,
+                            uint32 flags, ID3DBlob** byteCode, ID3DBlob** errorMessages) = 0;
+
+    // Goes into the cache key, so that byte code from different compilers (or versions of a compiler)
+    // never gets mixed up. Compilers that return null don't use the cache archive at all.
+    virtual const char* CacheName() const
+    {
+        return nullptr;
+    }
+};
+
+// Passing null goes back to using FXC. This can't be called while CompileShaders() or
+// UpdateShaders() still have shaders being compiled.
+void SetShaderCompiler(ShaderCompiler* compiler);
+
+// Counts for how well the shader cache is working. Files are "checked" when their timestamp is
+// compared against the file index, and "hashed" when they had to be read because it changed.
+struct ShaderCacheStats
+{
+    uint64 NumCacheHits = 0;
+    uint64 NumCacheMisses = 0;
+    uint64 NumDuplicatePermutations = 0;
+    uint64 NumFilesChecked = 0;
+    uint64 NumFilesHashed = 0;
+
+    // Shaders with identical byte code share one blob, these are for the shaders that are currently loaded
+    uint64 NumUniqueByteCodes = 0;
+    uint64 NumSharedByteCodes = 0;      // Shaders that are using another shader's blob
+    uint64 ByteCodeBytesSaved = 0;
+};
+
+ShaderCacheStats GetShaderCacheStats();
+
+// Returns the same hash as CompiledShader::ByteCodeHash for byte code that came from a compiled shader,
+// without having to hash it again. Anything else gets hashed.
+Hash GetByteCodeHash(const D3D12_SHADER_BYTECODE& byteCode);
+
+// Meant to be called once per frame. Shaders whose files have changed get recompiled on the task
+// scheduler (or right away without one), and the new byte code is swapped in for all of them at once
+// by a later call, which then returns true so that the app can re-create its PSOs.
+bool UpdateShaders(enki::TaskScheduler* taskScheduler = nullptr);
+
+// Drops everything from the shader cache that isn't used by a shader that's currently loaded. This
+// rewrites the whole cache, so it's meant for tools and for shutdown rather than for every frame.
+void CompactShaderCache();
+
 void ShutdownShaders();
 
 }
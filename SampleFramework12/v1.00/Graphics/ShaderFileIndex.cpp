@@ -0,0 +1,219 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ShaderFileIndex.h"
+
+#include "..\\Utility.h"
+#include "..\\Exceptions.h"
+#include "..\\FileIO.h"
+#include "..\\ChunkedFile.h"
+
+using std::wstring;
+using std::string;
+
+namespace SampleFramework12
+{
+
+static const uint32 ShaderFileIndexContentType = MakeFourCC('S', 'F', 'I', 'X');
+static const uint32 ShaderFileIndexVersion = 1;
+static const uint32 FilesSectionID = MakeFourCC('F', 'I', 'L', 'S');
+
+// Finds the #include statements at the start of a line, and resolves them the same way that the
+// include handler used for compiling does
+static void FindIncludes(const string& fileContents, const wchar* path, GrowableList<wstring>& includes)
+{
+    size_t lineStart = 0;
+    while(lineStart < fileContents.length())
+    {
+        size_t lineEnd = fileContents.find('\n', lineStart);
+        if(lineEnd == string::npos)
+            lineEnd = fileContents.length();
+
+        if(fileContents.compare(lineStart, 8, "#include") == 0)
+        {
+            const string line = fileContents.substr(lineStart, lineEnd - lineStart);
+
+            wstring fullIncludePath;
+            size_t startQuote = line.find('\"');
+            if(startQuote != string::npos)
+            {
+                size_t endQuote = line.find('\"', startQuote + 1);
+                string includePath = line.substr(startQuote + 1, endQuote - startQuote - 1);
+                fullIncludePath = AnsiToWString(includePath.c_str());
+            }
+            else
+            {
+                startQuote = line.find('<');
+                if(startQuote == string::npos)
+                    throw Exception(L"Malformed include statement: \"" + AnsiToWString(line.c_str()) + L"\" in file " + path);
+                size_t endQuote = line.find('>', startQuote + 1);
+                string includePath = line.substr(startQuote + 1, endQuote - startQuote - 1);
+                fullIncludePath = SampleFrameworkDir() + L"Shaders\\" + AnsiToWString(includePath.c_str());
+            }
+
+            if(FileExists(fullIncludePath.c_str()) == false)
+                throw Exception(L"Couldn't find #included file \"" + fullIncludePath + L"\" in file " + path);
+
+            includes.Add(fullIncludePath);
+        }
+
+        lineStart = lineEnd + 1;
+    }
+}
+
+ShaderFileIndex::~ShaderFileIndex()
+{
+    Shutdown();
+}
+
+void ShaderFileIndex::Load(const wchar* filePath)
+{
+    Shutdown();
+
+    if(FileExists(filePath) == false || ChunkedFileReader::IsChunkedFile(filePath) == false)
+        return;
+
+    try
+    {
+        ChunkedFileReader reader(filePath, ShaderFileIndexContentType);
+        if(reader.ContentVersion() != ShaderFileIndexVersion)
+            return;
+
+        const ChunkedFileSection& section = reader.GetSection(FilesSectionID);
+        reader.ValidateSection(section);
+        MemoryReadSerializer serializer = reader.SectionSerializer(section);
+
+        uint64 numEntries = 0;
+        SerializeItem(serializer, numEntries);
+        for(uint64 i = 0; i < numEntries; ++i)
+        {
+            Entry* entry = new Entry();
+            entries.Add(entry);
+            entry->Serialize(serializer);
+            entryMap.Insert(entry->FilePath, entry);
+        }
+    }
+    catch(Exception&)
+    {
+        // A broken index only costs re-hashing the shader files
+        WriteLog(L"Ignoring invalid shader file index '%ls'", filePath);
+        Shutdown();
+    }
+}
+
+void ShaderFileIndex::Save(const wchar* filePath)
+{
+    ChunkedFileWriter writer(filePath, ShaderFileIndexContentType, ShaderFileIndexVersion);
+
+    writer.BeginSection(FilesSectionID);
+    uint64 numEntries = entries.Count();
+    SerializeItem(writer, numEntries);
+    for(uint64 i = 0; i < numEntries; ++i)
+        entries[i]->Serialize(writer);
+    writer.EndSection();
+
+    writer.Finish();
+
+    dirty = false;
+}
+
+void ShaderFileIndex::Shutdown()
+{
+    for(uint64 i = 0; i < entries.Count(); ++i)
+        delete entries[i];
+    entries.Shutdown();
+    entryMap.Shutdown();
+    dirty = false;
+}
+
+Hash ShaderFileIndex::HashFileAndIncludes(const wchar* path, ShaderFilePathList& filePaths)
+{
+    for(uint64 i = 0; i < filePaths.Count(); ++i)
+        if(filePaths[i] == path)
+            return Hash();
+
+    filePaths.Add(path);
+
+    const Entry* entry = GetEntry(path);
+    Hash hash = entry->ContentsHash;
+    for(uint64 i = 0; i < entry->Includes.Size(); ++i)
+        hash = CombineHashes(hash, HashFileAndIncludes(entry->Includes[i].c_str(), filePaths));
+
+    return hash;
+}
+
+Hash ShaderFileIndex::FileHash(const wchar* path) const
+{
+    Entry* const* entry = entryMap.Find(path);
+    Assert_(entry != nullptr);
+    return (*entry)->ContentsHash;
+}
+
+void ShaderFileIndex::Invalidate(const wchar* path)
+{
+    Entry** entry = entryMap.Find(path);
+    if(entry != nullptr)
+        (*entry)->Checked = false;
+}
+
+ShaderFileIndex::Entry* ShaderFileIndex::GetEntry(const wchar* path)
+{
+    Entry* entry = nullptr;
+    Entry** existingEntry = entryMap.Find(path);
+    if(existingEntry != nullptr)
+    {
+        entry = *existingEntry;
+    }
+    else
+    {
+        entry = new Entry();
+        entry->FilePath = path;
+        entries.Add(entry);
+        entryMap.Insert(entry->FilePath, entry);
+    }
+
+    if(entry->Checked == false)
+    {
+        if(FileExists(path) == false)
+            throw Exception(L"Shader file " + wstring(path) + L" does not exist");
+
+        ++numFilesChecked;
+        const uint64 timeStamp = GetFileTimestamp(path);
+        if(timeStamp != entry->TimeStamp)
+        {
+            // The timestamp is only updated once the file was read successfully, so that a failed read
+            // (for instance while an editor still has it open) gets retried next time
+            UpdateEntry(*entry);
+            entry->TimeStamp = timeStamp;
+        }
+
+        entry->Checked = true;
+    }
+
+    return entry;
+}
+
+void ShaderFileIndex::UpdateEntry(Entry& entry)
+{
+    const string fileContents = ReadFileAsString(entry.FilePath.c_str());
+    entry.ContentsHash = GenerateHash(fileContents.data(), int(fileContents.length()));
+
+    GrowableList<wstring> includes;
+    FindIncludes(fileContents, entry.FilePath.c_str(), includes);
+    entry.Includes.Init(includes.Count());
+    for(uint64 i = 0; i < includes.Count(); ++i)
+        entry.Includes[i] = includes[i];
+
+    ++numFilesHashed;
+    dirty = true;
+}
+
+}
@@ -0,0 +1,83 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\MurmurHash.h"
+#include "..\\Containers.h"
+
+namespace SampleFramework12
+{
+
+// Most shaders only pull in a handful of files, so keep the paths inline in the list
+typedef SmallList<std::wstring, 16> ShaderFilePathList;
+
+// Remembers the contents hash and the #includes of every shader file that's been looked at, so that a
+// cache key for a shader can be built from the hashes of the file and everything that it includes
+// instead of from the fully-expanded source code. The index is saved alongside the shader cache, and a
+// file only gets read again if its timestamp changes. Each file is only checked once per run, call
+// Invalidate() when a file is known to have changed.
+class ShaderFileIndex
+{
+
+public:
+
+    ~ShaderFileIndex();
+
+    // Missing or out-of-date index files are ignored, the index just starts out empty
+    void Load(const wchar* filePath);
+    void Save(const wchar* filePath);
+    void Shutdown();
+
+    // Returns the combined contents hash of the file and all of the files that it includes, and appends
+    // each of those files to filePaths (depth-first, and skipping anything already in the list)
+    Hash HashFileAndIncludes(const wchar* path, ShaderFilePathList& filePaths);
+
+    // Contents hash of a single file that HashFileAndIncludes() has already looked at
+    Hash FileHash(const wchar* path) const;
+
+    void Invalidate(const wchar* path);
+
+    bool Dirty() const { return dirty; }
+    uint64 NumFilesHashed() const { return numFilesHashed; }
+    uint64 NumFilesChecked() const { return numFilesChecked; }
+
+private:
+
+    struct Entry
+    {
+        std::wstring FilePath;
+        uint64 TimeStamp = 0;
+        Hash ContentsHash;
+        Array<std::wstring> Includes;
+        bool Checked = false;
+
+        template<typename TSerializer> void Serialize(TSerializer& serializer)
+        {
+            SerializeItem(serializer, FilePath);
+            SerializeItem(serializer, TimeStamp);
+            SerializeItem(serializer, ContentsHash.A);
+            SerializeItem(serializer, ContentsHash.B);
+            SerializeItem(serializer, Includes);
+        }
+    };
+
+    Entry* GetEntry(const wchar* path);
+    void UpdateEntry(Entry& entry);
+
+    GrowableList<Entry*> entries;
+    HashMap<std::wstring, Entry*> entryMap;
+    bool dirty = false;
+    uint64 numFilesHashed = 0;
+    uint64 numFilesChecked = 0;
+};
+
+}
@@ -376,7 +376,7 @@ void Skybox::CreatePSOs(DXGI_FORMAT rtFormat, DXGI_FORMAT depthFormat, uint32 nu
     psoDesc.SampleDesc.Quality = numMSAASamples > 1 ? DX12::StandardMSAAPattern : 0;
     psoDesc.InputLayout.pInputElementDescs = inputElements;
     psoDesc.InputLayout.NumElements = ArraySize_(inputElements);
-    DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)));
+    pipelineState = DX12::CreateGraphicsPSO(psoDesc);
 }
 
 void Skybox::DestroyPSOs()
@@ -137,7 +137,7 @@ void SpriteRenderer::CreatePSOs(DXGI_FORMAT rtFormat)
         psoDesc.NumRenderTargets = 1;
         psoDesc.RTVFormats[0] = rtFormat;
         psoDesc.SampleDesc.Count = 1;
-        DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineStates[i])));
+        pipelineStates[i] = DX12::CreateGraphicsPSO(psoDesc);
     }
 }
 
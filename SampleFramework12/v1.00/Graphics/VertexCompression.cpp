@@ -0,0 +1,400 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "VertexCompression.h"
+
+#include <emmintrin.h>
+
+namespace SampleFramework12
+{
+
+// The kernels load and store each MeshVertex as 14 floats, and each CompactMeshVertex as 5 dwords
+StaticAssert_(sizeof(MeshVertex) == 14 * sizeof(float));
+StaticAssert_(sizeof(CompactMeshVertex) == 5 * sizeof(uint32));
+
+static const uint64 VertexBatchSize = 4;
+static const uint64 MeshVertexStride = sizeof(MeshVertex) / sizeof(float);
+static const uint64 CompactVertexStride = sizeof(CompactMeshVertex);
+
+// == SIMD helpers ================================================================================
+
+static __m128 Abs(__m128 v)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+// Returns a where the mask is set, and b everywhere else
+static __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Float to half with round-to-nearest-even, after Fabian Giesen's float_to_half_SSE2. Each lane ends
+// up with the half in its low 16 bits, and zeros in the high bits.
+static __m128i FloatToHalf(__m128 f)
+{
+    const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);        // Anything at or above this is inf
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);     // Smallest float that's a normal half
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+    const __m128 sign = _mm_and_ps(_mm_set1_ps(-0.0f), f);
+    const __m128 absF = _mm_xor_ps(f, sign);
+    const __m128i absBits = _mm_castps_si128(absF);
+
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+    const __m128i isRegular = _mm_cmpgt_epi32(f16Max, absBits);
+    const __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+    const __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    // Let the FPU do the rounding for results that are subnormal
+    const __m128 subnormalF = _mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic));
+    const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalF), subnormalMagic);
+
+    // Rebias the exponent and round the mantissa, biasing towards even
+    const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+    const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd);
+    const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+    __m128i result = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    result = _mm_or_si128(_mm_and_si128(isRegular, result), _mm_andnot_si128(isRegular, infOrNaN));
+    return _mm_or_si128(result, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+// Expects a half in the low 16 bits of each lane, after Fabian Giesen's half_to_float_SSE2
+static __m128 HalfToFloat(__m128i h)
+{
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128 infNaNExponent = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+    const __m128i exponentMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+    const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, exponentMantissa), 16);
+
+    // Scaling by the magic number rebiases the exponent, and also takes care of subnormals
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+    const __m128i wasInfNaN = _mm_cmpgt_epi32(exponentMantissa, _mm_set1_epi32(0x7BFF));
+    const __m128 infNaN = _mm_and_ps(_mm_castsi128_ps(wasInfNaN), infNaNExponent);
+
+    return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNaN));
+}
+
+static __m128i QuantizeUNorm16(__m128 v)
+{
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(65535.0f)));
+}
+
+static __m128i QuantizeSNorm16(__m128 v)
+{
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(32767.0f)));
+}
+
+// Same as the conversion for DXGI_FORMAT_R16G16_SNORM, where -32768 and -32767 both map to -1
+static __m128 DequantizeSNorm16(__m128i v)
+{
+    return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+}
+
+// Puts the low 16 bits of lo and hi into the low and high halves of each lane
+static __m128i Pack16(__m128i lo, __m128i hi)
+{
+    return _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(hi, 16));
+}
+
+static void UnpackUNorm16(__m128i packed, __m128i& lo, __m128i& hi)
+{
+    lo = _mm_and_si128(packed, _mm_set1_epi32(0xFFFF));
+    hi = _mm_srli_epi32(packed, 16);
+}
+
+static void UnpackSNorm16(__m128i packed, __m128i& lo, __m128i& hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(packed, 16), 16);
+    hi = _mm_srai_epi32(packed, 16);
+}
+
+// Projects a vector onto the octahedron |x| + |y| + |z| = 1, and folds the lower half over the upper
+// half so that it can be stored in 2 components. Zero vectors come out as (0, 0).
+static void EncodeOctahedral(__m128 x, __m128 y, __m128 z, __m128& ex, __m128& ey)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    const __m128 l1Norm = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+    const __m128 invL1Norm = _mm_div_ps(one, _mm_max_ps(l1Norm, _mm_set1_ps(1e-20f)));
+    const __m128 ox = _mm_mul_ps(x, invL1Norm);
+    const __m128 oy = _mm_mul_ps(y, invL1Norm);
+
+    const __m128 foldedX = _mm_or_ps(_mm_sub_ps(one, Abs(oy)), _mm_and_ps(ox, signMask));
+    const __m128 foldedY = _mm_or_ps(_mm_sub_ps(one, Abs(ox)), _mm_and_ps(oy, signMask));
+    const __m128 lowerHalf = _mm_cmplt_ps(z, _mm_setzero_ps());
+    ex = Select(lowerHalf, foldedX, ox);
+    ey = Select(lowerHalf, foldedY, oy);
+}
+
+// Matches DecodeOctahedral() in Conversion.hlsl
+static void DecodeOctahedral(__m128 ex, __m128 ey, __m128& x, __m128& y, __m128& z)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(ex)), Abs(ey));
+    const __m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+    const __m128 negT = _mm_sub_ps(zero, t);
+    x = _mm_add_ps(ex, Select(_mm_cmpge_ps(ex, zero), negT, t));
+    y = _mm_add_ps(ey, Select(_mm_cmpge_ps(ey, zero), negT, t));
+
+    const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+    x = _mm_mul_ps(x, invLength);
+    y = _mm_mul_ps(y, invLength);
+    z = _mm_mul_ps(z, invLength);
+}
+
+// Loads 4 floats starting at the same offset in 4 consecutive vertices, and transposes them so
+// that each register has one component for all 4 vertices
+static void LoadComponents(const float* vertices, uint64 offset, __m128& a, __m128& b, __m128& c, __m128& d)
+{
+    a = _mm_loadu_ps(vertices + offset);
+    b = _mm_loadu_ps(vertices + MeshVertexStride + offset);
+    c = _mm_loadu_ps(vertices + MeshVertexStride * 2 + offset);
+    d = _mm_loadu_ps(vertices + MeshVertexStride * 3 + offset);
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+
+// == Kernels =====================================================================================
+
+static void EncodeBatch(const MeshVertex* src, const __m128 posBias[3], const __m128 posScale[3], CompactMeshVertex* dst)
+{
+    const float* srcFloats = reinterpret_cast<const float*>(src);
+
+    // MeshVertex is laid out as P.xyz N.xyz UV.xy T.xyz B.xyz, so these 4 loads cover every component
+    // without reading past the end of the last vertex
+    __m128 px, py, pz, nx, ny, nz, u, v, tx, ty, tz, bx, by, bz, unused;
+    LoadComponents(srcFloats, 0, px, py, pz, unused);
+    LoadComponents(srcFloats, 3, nx, ny, nz, unused);
+    LoadComponents(srcFloats, 6, u, v, tx, ty);
+    LoadComponents(srcFloats, 10, tz, bx, by, bz);
+
+    const __m128i qx = QuantizeUNorm16(_mm_mul_ps(_mm_sub_ps(px, posBias[0]), posScale[0]));
+    const __m128i qy = QuantizeUNorm16(_mm_mul_ps(_mm_sub_ps(py, posBias[1]), posScale[1]));
+    const __m128i qz = QuantizeUNorm16(_mm_mul_ps(_mm_sub_ps(pz, posBias[2]), posScale[2]));
+
+    // The bitangent only needs a sign, which is whether it points along cross(normal, tangent)
+    const __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+    const __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+    const __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+    const __m128 handedness = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+    const __m128i bitangentSign = _mm_castps_si128(_mm_cmpge_ps(handedness, _mm_setzero_ps()));
+
+    __m128 enx, eny, etx, ety;
+    EncodeOctahedral(nx, ny, nz, enx, eny);
+    EncodeOctahedral(tx, ty, tz, etx, ety);
+
+    // Each dword of the output is a pair of 16-bit values, so build all of them in SoA form and then
+    // transpose the first 4 dwords of each vertex back to AoS
+    __m128i dwords0 = Pack16(qx, qy);
+    __m128i dwords1 = Pack16(qz, bitangentSign);
+    __m128i dwords2 = Pack16(QuantizeSNorm16(enx), QuantizeSNorm16(eny));
+    __m128i dwords3 = Pack16(FloatToHalf(u), FloatToHalf(v));
+    __m128i dwords4 = Pack16(QuantizeSNorm16(etx), QuantizeSNorm16(ety));
+
+    __m128 vtx0 = _mm_castsi128_ps(dwords0);
+    __m128 vtx1 = _mm_castsi128_ps(dwords1);
+    __m128 vtx2 = _mm_castsi128_ps(dwords2);
+    __m128 vtx3 = _mm_castsi128_ps(dwords3);
+    _MM_TRANSPOSE4_PS(vtx0, vtx1, vtx2, vtx3);
+
+    uint32 lastDwords[VertexBatchSize];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lastDwords), dwords4);
+
+    uint8* dstBytes = reinterpret_cast<uint8*>(dst);
+    _mm_storeu_ps(reinterpret_cast<float*>(dstBytes + CompactVertexStride * 0), vtx0);
+    _mm_storeu_ps(reinterpret_cast<float*>(dstBytes + CompactVertexStride * 1), vtx1);
+    _mm_storeu_ps(reinterpret_cast<float*>(dstBytes + CompactVertexStride * 2), vtx2);
+    _mm_storeu_ps(reinterpret_cast<float*>(dstBytes + CompactVertexStride * 3), vtx3);
+    for(uint64 i = 0; i < VertexBatchSize; ++i)
+        memcpy(dstBytes + CompactVertexStride * i + 16, &lastDwords[i], sizeof(uint32));
+}
+
+static void DecodeBatch(const CompactMeshVertex* src, const __m128 posBias[3], const __m128 posScale[3], MeshVertex* dst)
+{
+    const uint8* srcBytes = reinterpret_cast<const uint8*>(src);
+
+    __m128 vtx0 = _mm_loadu_ps(reinterpret_cast<const float*>(srcBytes + CompactVertexStride * 0));
+    __m128 vtx1 = _mm_loadu_ps(reinterpret_cast<const float*>(srcBytes + CompactVertexStride * 1));
+    __m128 vtx2 = _mm_loadu_ps(reinterpret_cast<const float*>(srcBytes + CompactVertexStride * 2));
+    __m128 vtx3 = _mm_loadu_ps(reinterpret_cast<const float*>(srcBytes + CompactVertexStride * 3));
+    _MM_TRANSPOSE4_PS(vtx0, vtx1, vtx2, vtx3);
+
+    uint32 lastDwords[VertexBatchSize];
+    for(uint64 i = 0; i < VertexBatchSize; ++i)
+        memcpy(&lastDwords[i], srcBytes + CompactVertexStride * i + 16, sizeof(uint32));
+
+    __m128i qx, qy, qz, qSign, qnx, qny, hu, hv, qtx, qty;
+    UnpackUNorm16(_mm_castps_si128(vtx0), qx, qy);
+    UnpackUNorm16(_mm_castps_si128(vtx1), qz, qSign);
+    UnpackSNorm16(_mm_castps_si128(vtx2), qnx, qny);
+    UnpackUNorm16(_mm_castps_si128(vtx3), hu, hv);
+    UnpackSNorm16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lastDwords)), qtx, qty);
+
+    __m128 px = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(qx), posScale[0]), posBias[0]);
+    __m128 py = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(qy), posScale[1]), posBias[1]);
+    __m128 pz = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(qz), posScale[2]), posBias[2]);
+
+    __m128 nx, ny, nz, tx, ty, tz;
+    DecodeOctahedral(DequantizeSNorm16(qnx), DequantizeSNorm16(qny), nx, ny, nz);
+    DecodeOctahedral(DequantizeSNorm16(qtx), DequantizeSNorm16(qty), tx, ty, tz);
+
+    const __m128 positiveSign = _mm_castsi128_ps(_mm_cmpgt_epi32(qSign, _mm_setzero_si128()));
+    const __m128 sign = Select(positiveSign, _mm_set1_ps(1.0f), _mm_set1_ps(-1.0f));
+    __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty)), sign);
+    __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz)), sign);
+    __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx)), sign);
+
+    __m128 u = HalfToFloat(hu);
+    __m128 v = HalfToFloat(hv);
+
+    // Transpose back to P.xyz N.x | N.yz UV.xy | T.xyz B.x | B.yz for each vertex
+    __m128 unused0 = _mm_setzero_ps();
+    __m128 unused1 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(px, py, pz, nx);
+    _MM_TRANSPOSE4_PS(ny, nz, u, v);
+    _MM_TRANSPOSE4_PS(tx, ty, tz, bx);
+    _MM_TRANSPOSE4_PS(by, bz, unused0, unused1);
+
+    const __m128 rows[VertexBatchSize][4] =
+    {
+        { px, ny, tx, by },
+        { py, nz, ty, bz },
+        { pz, u, tz, unused0 },
+        { nx, v, bx, unused1 },
+    };
+
+    float* dstFloats = reinterpret_cast<float*>(dst);
+    for(uint64 i = 0; i < VertexBatchSize; ++i)
+    {
+        float* vtx = dstFloats + MeshVertexStride * i;
+        _mm_storeu_ps(vtx + 0, rows[i][0]);
+        _mm_storeu_ps(vtx + 4, rows[i][1]);
+        _mm_storeu_ps(vtx + 8, rows[i][2]);
+        _mm_storel_pi(reinterpret_cast<__m64*>(vtx + 12), rows[i][3]);
+    }
+}
+
+void EncodeCompactVertices(const MeshVertex* src, uint64 numVertices, const Float3& aabbMin,
+                           const Float3& aabbMax, CompactMeshVertex* dst)
+{
+    Assert_(src != nullptr || numVertices == 0);
+    Assert_(dst != nullptr || numVertices == 0);
+
+    // Flat meshes have a zero-sized extent along one axis, which quantizes to 0
+    const Float3 extent = aabbMax - aabbMin;
+    const __m128 posBias[3] = { _mm_set1_ps(aabbMin.x), _mm_set1_ps(aabbMin.y), _mm_set1_ps(aabbMin.z) };
+    const __m128 posScale[3] =
+    {
+        _mm_set1_ps(extent.x > 0.0f ? 1.0f / extent.x : 0.0f),
+        _mm_set1_ps(extent.y > 0.0f ? 1.0f / extent.y : 0.0f),
+        _mm_set1_ps(extent.z > 0.0f ? 1.0f / extent.z : 0.0f),
+    };
+
+    const uint64 numBatches = numVertices / VertexBatchSize;
+    for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+        EncodeBatch(src + batchIdx * VertexBatchSize, posBias, posScale, dst + batchIdx * VertexBatchSize);
+
+    // Pad out the last few vertices to a full batch
+    const uint64 batchStart = numBatches * VertexBatchSize;
+    const uint64 numRemaining = numVertices - batchStart;
+    if(numRemaining > 0)
+    {
+        MeshVertex srcBatch[VertexBatchSize];
+        CompactMeshVertex dstBatch[VertexBatchSize];
+        memcpy(srcBatch, src + batchStart, numRemaining * sizeof(MeshVertex));
+        EncodeBatch(srcBatch, posBias, posScale, dstBatch);
+        memcpy(dst + batchStart, dstBatch, numRemaining * sizeof(CompactMeshVertex));
+    }
+}
+
+void DecodeCompactVertices(const CompactMeshVertex* src, uint64 numVertices, const Float3& aabbMin,
+                           const Float3& aabbMax, MeshVertex* dst)
+{
+    Assert_(src != nullptr || numVertices == 0);
+    Assert_(dst != nullptr || numVertices == 0);
+
+    const Float3 scale = (aabbMax - aabbMin) / 65535.0f;
+    const __m128 posBias[3] = { _mm_set1_ps(aabbMin.x), _mm_set1_ps(aabbMin.y), _mm_set1_ps(aabbMin.z) };
+    const __m128 posScale[3] = { _mm_set1_ps(scale.x), _mm_set1_ps(scale.y), _mm_set1_ps(scale.z) };
+
+    const uint64 numBatches = numVertices / VertexBatchSize;
+    for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+        DecodeBatch(src + batchIdx * VertexBatchSize, posBias, posScale, dst + batchIdx * VertexBatchSize);
+
+    const uint64 batchStart = numBatches * VertexBatchSize;
+    const uint64 numRemaining = numVertices - batchStart;
+    if(numRemaining > 0)
+    {
+        CompactMeshVertex srcBatch[VertexBatchSize];
+        MeshVertex dstBatch[VertexBatchSize];
+        memcpy(srcBatch, src + batchStart, numRemaining * sizeof(CompactMeshVertex));
+        DecodeBatch(srcBatch, posBias, posScale, dstBatch);
+        memcpy(dst + batchStart, dstBatch, numRemaining * sizeof(MeshVertex));
+    }
+}
+
+// == Error measurement ===========================================================================
+
+// Returns the angle in degrees, or 0 if the original vector is missing. atan2 is used instead of
+// acos, since acos can't resolve the tiny angles that come out of the octahedral encoding.
+static float AngleBetween(const Float3& original, const Float3& decoded)
+{
+    if(Float3::Dot(original, original) <= 0.0f)
+        return 0.0f;
+
+    const Float3 dir = Float3::Normalize(original);
+    return RadToDeg(std::atan2(Float3::Length(Float3::Cross(dir, decoded)), Float3::Dot(dir, decoded)));
+}
+
+CompactVertexErrors MeasureCompactVertexErrors(const MeshVertex* original, const CompactMeshVertex* encoded,
+                                               uint64 numVertices, const Float3& aabbMin, const Float3& aabbMax)
+{
+    CompactVertexErrors errors;
+
+    MeshVertex decoded[64];
+    for(uint64 start = 0; start < numVertices; start += ArraySize_(decoded))
+    {
+        const uint64 count = Min<uint64>(numVertices - start, ArraySize_(decoded));
+        DecodeCompactVertices(encoded + start, count, aabbMin, aabbMax, decoded);
+
+        for(uint64 i = 0; i < count; ++i)
+        {
+            const MeshVertex& src = original[start + i];
+            const MeshVertex& dst = decoded[i];
+
+            const Float3 posError = src.Position - dst.Position;
+            errors.MaxPositionError = Max(errors.MaxPositionError, std::abs(posError.x));
+            errors.MaxPositionError = Max(errors.MaxPositionError, std::abs(posError.y));
+            errors.MaxPositionError = Max(errors.MaxPositionError, std::abs(posError.z));
+
+            errors.MaxNormalError = Max(errors.MaxNormalError, AngleBetween(src.Normal, dst.Normal));
+            errors.MaxTangentError = Max(errors.MaxTangentError, AngleBetween(src.Tangent, dst.Tangent));
+
+            // This also picks up any error from assuming that the original tangent frame is orthogonal
+            errors.MaxBitangentError = Max(errors.MaxBitangentError, AngleBetween(src.Bitangent, dst.Bitangent));
+
+            errors.MaxUVError = Max(errors.MaxUVError, std::abs(src.UV.x - dst.UV.x));
+            errors.MaxUVError = Max(errors.MaxUVError, std::abs(src.UV.y - dst.UV.y));
+        }
+    }
+
+    return errors;
+}
+
+}
@@ -0,0 +1,62 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\SF12_Math.h"
+#include "Model.h"
+
+namespace SampleFramework12
+{
+
+// Vertex layout used for MeshVertexFormat::Compact, which is 20 bytes instead of 56:
+//  - Positions are quantized to 16 bits relative to the AABB of the mesh, so a shader needs the
+//    mesh's AABBMin() and AABBMax() to get back to the original positions
+//  - Normals and tangents are octahedral-encoded into a pair of 16-bit SNORM values
+//  - UVs are stored as halves
+//  - The bitangent is rebuilt from cross(normal, tangent), with its sign stored in Position[3]
+//    as 0 for -1 and 0xFFFF for +1
+struct CompactMeshVertex
+{
+    uint16 Position[4];
+    int16 Normal[2];
+    Half2 UV;
+    int16 Tangent[2];
+};
+
+StaticAssert_(sizeof(CompactMeshVertex) == 20);
+
+// Largest differences between a set of vertices and their encoded versions. Normal, tangent and
+// bitangent errors are in degrees, position errors are in the same units as the positions.
+// For unit-length normals and tangents (and an orthogonal tangent frame) the errors stay within:
+//  - Half a quantization step per axis for positions, which is (aabbMax - aabbMin) / 65535 / 2
+//  - 0.01 degrees for normals and tangents, and 0.02 degrees for the rebuilt bitangents
+//  - Half an ulp of a half for UVs, so |uv| / 2048 for UVs that are in the normal half range
+struct CompactVertexErrors
+{
+    float MaxPositionError = 0.0f;
+    float MaxNormalError = 0.0f;
+    float MaxTangentError = 0.0f;
+    float MaxBitangentError = 0.0f;
+    float MaxUVError = 0.0f;
+};
+
+// These work on 4 vertices at a time with SSE2. They don't touch any shared state, so separate parts
+// of a vertex array can be processed from multiple threads.
+void EncodeCompactVertices(const MeshVertex* src, uint64 numVertices, const Float3& aabbMin,
+                           const Float3& aabbMax, CompactMeshVertex* dst);
+void DecodeCompactVertices(const CompactMeshVertex* src, uint64 numVertices, const Float3& aabbMin,
+                           const Float3& aabbMax, MeshVertex* dst);
+
+CompactVertexErrors MeasureCompactVertexErrors(const MeshVertex* original, const CompactMeshVertex* encoded,
+                                               uint64 numVertices, const Float3& aabbMin, const Float3& aabbMax);
+
+}
@@ -192,7 +192,7 @@ void CreatePSOs(DXGI_FORMAT rtFormat)
     psoDesc.SampleDesc.Count = 1;
     psoDesc.InputLayout.pInputElementDescs = inputElements;
     psoDesc.InputLayout.NumElements = ArraySize_(inputElements);
-    DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&PSO)));
+    PSO = DX12::CreateGraphicsPSO(psoDesc);
 }
 
 void DestroyPSOs()
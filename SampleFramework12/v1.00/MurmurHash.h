@@ -24,7 +24,7 @@ struct Hash
 
     std::wstring ToString() const;
 
-    bool operator==(const Hash& other)
+    bool operator==(const Hash& other) const
     {
         return A == other.A && B == other.B;
     }
@@ -11,6 +11,8 @@
 
 #include "PCH.h"
 
+#include <exception>
+
 #include "Exceptions.h"
 #include "FileIO.h"
 #include "Containers.h"
@@ -46,28 +48,164 @@ public:
     static bool IsWriteSerializer() { return false; }
 };
 
+// Reads by memcpy'ing out of a memory-mapped view of the file, instead of making a ReadFile call for
+// every item. Bulk data can also be referenced directly in the mapping with ReferenceData(), in which
+// case the pointer is only valid for as long as the serializer is alive.
+class MappedReadSerializer
+{
+
+private:
+
+    MappedFile file;
+    uint64 offset = 0;
+
+    const uint8* Consume(uint64 size)
+    {
+        if(size > file.Size() - offset)
+            throw Exception(MakeString(L"Tried to read %llu bytes at offset %llu from a file that's only %llu bytes",
+                                       size, offset, file.Size()));
+
+        const uint8* data = file.Data() + offset;
+        offset += size;
+        return data;
+    }
+
+public:
+
+    explicit MappedReadSerializer(const wchar* path)
+    {
+        file.Open(path);
+    }
+
+    template<typename T> void SerializeItem(T& data)
+    {
+        memcpy(&data, Consume(sizeof(T)), sizeof(T));
+    }
+
+    void SerializeData(uint64 size, void* data)
+    {
+        if(size > 0)
+            memcpy(data, Consume(size), size);
+    }
+
+    const void* ReferenceData(uint64 size)
+    {
+        return Consume(size);
+    }
+
+    uint64 Offset() const { return offset; }
+    uint64 Size() const { return file.Size(); }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Reads from a block of memory that's owned by someone else, for instance one section of a mapped file
+class MemoryReadSerializer
+{
+
+private:
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    uint64 offset = 0;
+
+    const uint8* Consume(uint64 numBytes)
+    {
+        if(numBytes > size - offset)
+            throw Exception(MakeString(L"Tried to read %llu bytes at offset %llu from a block that's only %llu bytes",
+                                       numBytes, offset, size));
+
+        const uint8* ptr = data + offset;
+        offset += numBytes;
+        return ptr;
+    }
+
+public:
+
+    MemoryReadSerializer(const void* data_, uint64 size_) : data(reinterpret_cast<const uint8*>(data_)), size(size_)
+    {
+        Assert_(data != nullptr || size == 0);
+    }
+
+    template<typename T> void SerializeItem(T& item)
+    {
+        memcpy(&item, Consume(sizeof(T)), sizeof(T));
+    }
+
+    void SerializeData(uint64 numBytes, void* dst)
+    {
+        if(numBytes > 0)
+            memcpy(dst, Consume(numBytes), numBytes);
+    }
+
+    const void* ReferenceData(uint64 numBytes)
+    {
+        return Consume(numBytes);
+    }
+
+    uint64 Offset() const { return offset; }
+    uint64 Size() const { return size; }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Collects small items in a write-combining buffer, so that writing a file doesn't turn into one
+// WriteFile call per item. Data that's at least as big as the buffer gets written straight through.
+// Call Flush() once everything has been serialized: the destructor doesn't flush, since it can't throw,
+// so anything left in the buffer when an exception unwinds past the serializer is dropped.
 class FileWriteSerializer
 {
 
 private:
 
+    static const uint64 DefaultBufferSize = 1024 * 1024;
+
     File file;
+    Array<uint8> buffer;
+    uint64 bufferUsed = 0;
 
 public:
 
-    explicit FileWriteSerializer(const wchar* path)
+    explicit FileWriteSerializer(const wchar* path, uint64 bufferSize = DefaultBufferSize)
     {
+        Assert_(bufferSize > 0);
         file.Open(path, FileOpenMode::Write);
+        buffer.Init(bufferSize);
+    }
+
+    ~FileWriteSerializer()
+    {
+        Assert_(bufferUsed == 0 || std::uncaught_exceptions() > 0);
     }
 
     template<typename T> void SerializeItem(const T& data)
     {
-        file.Write(data);
+        SerializeData(sizeof(T), &data);
     }
 
     void SerializeData(uint64 size, const void* data)
     {
-        file.Write(size, data);
+        if(size > buffer.Size() - bufferUsed)
+        {
+            Flush();
+            if(size >= buffer.Size())
+            {
+                file.Write(size, data);
+                return;
+            }
+        }
+
+        memcpy(buffer.Data() + bufferUsed, data, size);
+        bufferUsed += size;
+    }
+
+    void Flush()
+    {
+        if(bufferUsed > 0)
+            file.Write(bufferUsed, buffer.Data());
+        bufferUsed = 0;
     }
 
     static bool IsReadSerializer() { return false; }
@@ -276,7 +414,7 @@ void BulkSerializeItem(TSerializer& serializer, Array<TValue>& array)
 template<typename T>
 void SerializeFromFile(const wchar* filePath, T& item)
 {
-    FileReadSerializer serializer(filePath);
+    MappedReadSerializer serializer(filePath);
     SerializeItem(serializer, item);
 }
 
@@ -285,6 +423,7 @@ void SerializeToFile(const wchar* filePath, const T& item)
 {
     FileWriteSerializer serializer(filePath);
     SerializeItem(serializer, item);
+    serializer.Flush();
 }
 
 }
\ No newline at end of file
@@ -865,17 +865,13 @@ void SettingsContainer::Update(uint32 displayWidth, uint32 displayHeight, const
 
 Setting* SettingsContainer::FindSetting(const char* name)
 {
-    for(uint64 groupIdx = 0; groupIdx < groups.Count(); ++groupIdx)
-    {
-        SettingsGroup& group = groups[groupIdx];
-        for(uint64 settingIdx = 0; settingIdx < group.Settings.Count(); ++settingIdx)
-        {
-            if(group.Settings[settingIdx]->Name() == name)
-                return group.Settings[settingIdx];
-        }
-    }
+    // A name that was never interned can't belong to a setting
+    const StringID nameID = StringID::Find(name);
+    if(nameID.Valid() == false)
+        return nullptr;
 
-    return nullptr;
+    Setting** setting = settingsByName.Find(nameID);
+    return setting != nullptr ? *setting : nullptr;
 }
 
 void SettingsContainer::AddGroup(const char* name, bool expanded)
@@ -901,6 +897,7 @@ void SettingsContainer::AddSetting(Setting* setting)
         if(group.Name == setting->Group())
         {
             group.Settings.Add(setting);
+            settingsByName.Insert(StringID(setting->Name()), setting);
             return;
         }
     }
@@ -13,6 +13,7 @@
 #include "SF12_Math.h"
 #include "Serialization.h"
 #include "Containers.h"
+#include "StringID.h"
 
 namespace SampleFramework12
 {
@@ -457,6 +458,7 @@ private:
     };
 
     FixedList<SettingsGroup> groups;
+    HashMap<StringID, Setting*> settingsByName;
     bool initialized = false;
     bool opened = true;
 
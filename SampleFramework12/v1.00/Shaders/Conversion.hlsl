@@ -68,4 +68,44 @@ float2 HalfToFloat2(in uint val)
 	result.y = f16tof32(val >> 16);
 
 	return result;
-}
\ No newline at end of file
+}
+
+//=================================================================================================
+// Octahedral encoding for unit vectors
+//=================================================================================================
+float2 EncodeOctahedral(in float3 v)
+{
+	v /= abs(v.x) + abs(v.y) + abs(v.z);
+	float2 result = v.xy;
+	if(v.z < 0.0f)
+		result = (1.0f - abs(v.yx)) * (v.xy >= 0.0f ? 1.0f : -1.0f);
+
+	return result;
+}
+
+float3 DecodeOctahedral(in float2 e)
+{
+	float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-v.z);
+	v.xy += v.xy >= 0.0f ? -t : t;
+
+	return normalize(v);
+}
+
+//=================================================================================================
+// Decoding for CompactMeshVertex, see VertexCompression.h
+//=================================================================================================
+float3 DecodeCompactPosition(in float4 quantizedPosition, in float3 meshAABBMin, in float3 meshAABBMax)
+{
+	return meshAABBMin + quantizedPosition.xyz * (meshAABBMax - meshAABBMin);
+}
+
+// The normal and tangent come in through R16G16_SNORM elements, and the bitangent sign is in the
+// w component of the R16G16B16A16_UNORM position
+void DecodeCompactTangentFrame(in float2 encodedNormal, in float2 encodedTangent, in float4 quantizedPosition,
+							   out float3 normal, out float3 tangent, out float3 bitangent)
+{
+	normal = DecodeOctahedral(encodedNormal);
+	tangent = DecodeOctahedral(encodedTangent);
+	bitangent = cross(normal, tangent) * (quantizedPosition.w > 0.5f ? 1.0f : -1.0f);
+}
@@ -0,0 +1,141 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "StringID.h"
+
+#include "Allocators.h"
+#include "MurmurHash.h"
+
+namespace SampleFramework12
+{
+
+// Interned strings are looked up by their contents, with the hash computed up-front
+struct InternedString
+{
+    const char* Chars = nullptr;
+    uint64 Length = 0;
+    uint64 HashValue = 0;
+
+    bool operator==(const InternedString& other) const
+    {
+        return HashValue == other.HashValue && Length == other.Length && memcmp(Chars, other.Chars, Length) == 0;
+    }
+};
+
+template<> struct HashMapHasher<InternedString>
+{
+    static uint64 HashKey(const InternedString& key)
+    {
+        return key.HashValue;
+    }
+};
+
+// What a StringID refers to
+struct InternedID
+{
+    uint32 ID = StringID::InvalidID;
+    const char* Chars = "";
+};
+
+struct StringTable
+{
+    SRWLOCK Lock = SRWLOCK_INIT;
+    HashMap<InternedString, InternedID> IDs;
+    LinearAllocator Storage;        // Never reset, so that the characters stay put
+};
+
+// Created on first use, since StringIDs can be made during static initialization
+static StringTable& GetStringTable()
+{
+    static StringTable table;
+    return table;
+}
+
+static InternedString MakeInternedString(const char* str, uint64 length)
+{
+    InternedString interned;
+    interned.Chars = str;
+    interned.Length = length;
+    interned.HashValue = GenerateHash(str, int(length)).A;
+    return interned;
+}
+
+static InternedID FindInterned(StringTable& table, const InternedString& key)
+{
+    AcquireSRWLockShared(&table.Lock);
+    const InternedID* existing = table.IDs.Find(key);
+    const InternedID interned = existing != nullptr ? *existing : InternedID();
+    ReleaseSRWLockShared(&table.Lock);
+    return interned;
+}
+
+static InternedID Intern(const char* str, uint64 length)
+{
+    StringTable& table = GetStringTable();
+    InternedString key = MakeInternedString(str, length);
+
+    // Most strings have already been interned, so try that first without blocking other readers
+    InternedID interned = FindInterned(table, key);
+    if(interned.ID != StringID::InvalidID)
+        return interned;
+
+    AcquireSRWLockExclusive(&table.Lock);
+
+    // Someone else might have added it while we didn't hold the lock
+    const InternedID* existing = table.IDs.Find(key);
+    if(existing != nullptr)
+    {
+        interned = *existing;
+    }
+    else
+    {
+        char* chars = reinterpret_cast<char*>(table.Storage.Allocate(length + 1, 1));
+        memcpy(chars, str, length);
+        chars[length] = 0;
+        key.Chars = chars;
+
+        Assert_(table.IDs.Count() < StringID::InvalidID);
+        interned.ID = uint32(table.IDs.Count());
+        interned.Chars = chars;
+        table.IDs.Insert(key, interned);
+    }
+
+    ReleaseSRWLockExclusive(&table.Lock);
+    return interned;
+}
+
+StringID::StringID(const char* str_)
+{
+    Assert_(str_ != nullptr);
+    const InternedID interned = Intern(str_, strlen(str_));
+    id = interned.ID;
+    str = interned.Chars;
+}
+
+StringID::StringID(const std::string& str_)
+{
+    const InternedID interned = Intern(str_.c_str(), str_.length());
+    id = interned.ID;
+    str = interned.Chars;
+}
+
+StringID StringID::Find(const char* str_)
+{
+    Assert_(str_ != nullptr);
+    const InternedID interned = FindInterned(GetStringTable(), MakeInternedString(str_, strlen(str_)));
+
+    StringID stringID;
+    stringID.id = interned.ID;
+    stringID.str = interned.Chars;
+    return stringID;
+}
+
+}
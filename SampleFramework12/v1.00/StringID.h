@@ -0,0 +1,78 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+#include "Containers.h"
+
+namespace SampleFramework12
+{
+
+// Interned string. The first time a string is seen its contents get copied into a global table, and
+// every StringID made from the same contents refers to that same entry. This makes comparing and
+// hashing StringIDs as cheap as comparing integers, and the string they point to stays around until
+// the app exits. Safe to use from multiple threads.
+class StringID
+{
+
+public:
+
+    static const uint32 InvalidID = uint32(-1);
+
+    StringID()
+    {
+    }
+
+    explicit StringID(const char* str);
+    explicit StringID(const std::string& str);
+
+    // Looks up a string without adding it to the table, returns an invalid StringID if it was never interned
+    static StringID Find(const char* str);
+
+    uint32 ID() const
+    {
+        return id;
+    }
+
+    const char* CString() const
+    {
+        return str;
+    }
+
+    bool Valid() const
+    {
+        return id != InvalidID;
+    }
+
+    bool operator==(const StringID& other) const
+    {
+        return id == other.id;
+    }
+
+    bool operator!=(const StringID& other) const
+    {
+        return id != other.id;
+    }
+
+protected:
+
+    uint32 id = InvalidID;
+    const char* str = "";
+};
+
+template<> struct HashMapHasher<StringID>
+{
+    static uint64 HashKey(const StringID& key)
+    {
+        return HashMapHasher<uint32>::HashKey(key.ID());
+    }
+};
+
+}
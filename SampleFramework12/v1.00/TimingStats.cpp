@@ -0,0 +1,265 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "TimingStats.h"
+#include "Assert.h"
+
+namespace SampleFramework12
+{
+
+// Buckets grow by a factor of (1 + a) / (1 - a) with a relative accuracy a of 2%
+static const double BucketGamma = 1.02 / 0.98;
+static const double LogBucketGamma = std::log(BucketGamma);
+
+const double QuantileSketch::MinValue = 0.0001;
+
+// == QuantileSketch ==============================================================================
+
+uint64 QuantileSketch::BucketIndex(double value)
+{
+    // Everything below the minimum (including 0) shares the first bucket
+    if(value <= MinValue)
+        return 0;
+
+    const double idx = std::ceil(std::log(value / MinValue) / LogBucketGamma);
+    return uint64(Min(idx, double(NumBuckets - 1)));
+}
+
+double QuantileSketch::BucketValue(uint64 bucketIdx)
+{
+    if(bucketIdx == 0)
+        return 0.0;
+
+    // Bucket i covers (MinValue * gamma^(i - 1), MinValue * gamma^i], this is the value with the
+    // same relative error to both ends
+    return MinValue * std::pow(BucketGamma, double(bucketIdx)) * 2.0 / (1.0 + BucketGamma);
+}
+
+void QuantileSketch::UpdateBucket(uint64 bucketIdx, int32 delta)
+{
+    for(uint64 i = bucketIdx + 1; i <= NumBuckets; i += i & (~i + 1))
+        tree[i] = uint32(int32(tree[i]) + delta);
+}
+
+void QuantileSketch::Add(double value)
+{
+    UpdateBucket(BucketIndex(value), 1);
+    ++count;
+}
+
+void QuantileSketch::Remove(double value)
+{
+    Assert_(count > 0);
+    UpdateBucket(BucketIndex(value), -1);
+    --count;
+}
+
+void QuantileSketch::Reset()
+{
+    for(uint64 i = 0; i <= NumBuckets; ++i)
+        tree[i] = 0;
+    count = 0;
+}
+
+double QuantileSketch::Quantile(double q) const
+{
+    StaticAssert_((NumBuckets & (NumBuckets - 1)) == 0);
+
+    if(count == 0)
+        return 0.0;
+
+    // Walk down the tree to find the first bucket where the running count reaches the target rank
+    const uint64 rank = Clamp(uint64(std::ceil(Saturate(q) * count)), uint64(1), count);
+    uint64 pos = 0;
+    uint64 remaining = rank;
+    for(uint64 step = NumBuckets; step > 0; step >>= 1)
+    {
+        if(pos + step <= NumBuckets && tree[pos + step] < remaining)
+        {
+            pos += step;
+            remaining -= tree[pos];
+        }
+    }
+
+    return BucketValue(pos);
+}
+
+// Exact median of the first n values, which get partially reordered
+static double SelectMedian(double* values, uint64 n)
+{
+    Assert_(n > 0);
+
+    // Same rank as QuantileSketch::Quantile(0.5)
+    double* median = values + (n - 1) / 2;
+    std::nth_element(values, median, values + n);
+    return *median;
+}
+
+// == TimingStats =================================================================================
+
+bool TimingStats::AddSample(double value)
+{
+    if(numSamples >= WindowSize)
+        RemoveOldestSample();
+
+    const uint64 idx = numSamples % WindowSize;
+
+    // Score the sample against the window before adding it
+    bool outlier = false;
+    if(valueSketch.Count() >= MinOutlierSamples)
+    {
+        double median = 0.0;
+        double mad = 0.0;
+        ComputeMedianAndMAD(idx, median, mad);
+        if(mad > 0.0)
+            outlier = (0.6745 * std::abs(value - median) / mad) > outlierThreshold;
+    }
+
+    samples[idx] = value;
+    accepted[idx] = !outlier;
+
+    valueSketch.Add(value);
+
+    if(outlier)
+    {
+        ++numOutliers;
+    }
+    else
+    {
+        acceptedSum += value;
+        acceptedSumSq += value * value;
+        ++numAccepted;
+    }
+
+    // Anything smaller than the new sample can never be the max again
+    while(maxQueueEnd > maxQueueStart && samples[maxQueue[(maxQueueEnd - 1) % WindowSize] % WindowSize] <= value)
+        --maxQueueEnd;
+    maxQueue[maxQueueEnd % WindowSize] = numSamples;
+    ++maxQueueEnd;
+
+    ++numSamples;
+
+    // Re-sum the window every time it wraps around so that error doesn't build up in the running sums
+    if(idx == WindowSize - 1)
+    {
+        acceptedSum = 0.0;
+        acceptedSumSq = 0.0;
+        for(uint64 i = 0; i < WindowSize; ++i)
+        {
+            if(accepted[i])
+            {
+                acceptedSum += samples[i];
+                acceptedSumSq += samples[i] * samples[i];
+            }
+        }
+    }
+
+    return !outlier;
+}
+
+void TimingStats::RemoveOldestSample()
+{
+    Assert_(numSamples >= WindowSize);
+
+    const uint64 oldest = numSamples - WindowSize;
+    const uint64 idx = oldest % WindowSize;
+
+    valueSketch.Remove(samples[idx]);
+
+    if(accepted[idx])
+    {
+        acceptedSum -= samples[idx];
+        acceptedSumSq -= samples[idx] * samples[idx];
+        --numAccepted;
+    }
+    else
+    {
+        --numOutliers;
+    }
+
+    if(maxQueueEnd > maxQueueStart && maxQueue[maxQueueStart % WindowSize] == oldest)
+        ++maxQueueStart;
+}
+
+// Computes the median and MAD of the samples in the window other than skipIdx. There's at most
+// WindowSize of them, so selecting on a copy is cheap enough to do for every new sample.
+void TimingStats::ComputeMedianAndMAD(uint64 skipIdx, double& median, double& mad) const
+{
+    double values[WindowSize];
+    uint64 numValues = 0;
+    const uint64 numInWindow = Min(numSamples, WindowSize);
+    for(uint64 i = 0; i < numInWindow; ++i)
+        if(i != skipIdx)
+            values[numValues++] = samples[i];
+
+    median = 0.0;
+    mad = 0.0;
+    if(numValues == 0)
+        return;
+
+    median = SelectMedian(values, numValues);
+
+    numValues = 0;
+    for(uint64 i = 0; i < numInWindow; ++i)
+        if(i != skipIdx)
+            values[numValues++] = std::abs(samples[i] - median);
+    mad = SelectMedian(values, numValues);
+}
+
+void TimingStats::Reset()
+{
+    const double threshold = outlierThreshold;
+    *this = TimingStats();
+    outlierThreshold = threshold;
+}
+
+double TimingStats::Mean() const
+{
+    return numAccepted > 0 ? acceptedSum / numAccepted : 0.0;
+}
+
+double TimingStats::Variance() const
+{
+    if(numAccepted < 2)
+        return 0.0;
+
+    const double mean = acceptedSum / numAccepted;
+    const double variance = (acceptedSumSq - acceptedSum * mean) / (numAccepted - 1);
+    return variance > 0.0 ? variance : 0.0;
+}
+
+double TimingStats::StdDev() const
+{
+    return std::sqrt(Variance());
+}
+
+double TimingStats::Percentile(double p) const
+{
+    // The sketch can overshoot by its relative error, so clamp to the exact max
+    return Min(valueSketch.Quantile(p), Maximum());
+}
+
+double TimingStats::Maximum() const
+{
+    if(maxQueueEnd == maxQueueStart)
+        return 0.0;
+    return samples[maxQueue[maxQueueStart % WindowSize] % WindowSize];
+}
+
+double TimingStats::MAD() const
+{
+    double median = 0.0;
+    double mad = 0.0;
+    ComputeMedianAndMAD(WindowSize, median, mad);
+    return mad;
+}
+
+}
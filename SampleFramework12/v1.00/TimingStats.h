@@ -0,0 +1,104 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "SF12_Math.h"
+
+namespace SampleFramework12
+{
+
+// Log-bucketed histogram with a fixed number of buckets, stored as a Fenwick tree so that adding
+// or removing a value and looking up a quantile are all O(log NumBuckets). Values are bucketed
+// with a relative accuracy of about 2%, from MinValue up to ~70 seconds when used for milliseconds.
+class QuantileSketch
+{
+
+public:
+
+    static const uint64 NumBuckets = 512;
+    static const double MinValue;
+
+    void Add(double value);
+    void Remove(double value);
+    void Reset();
+
+    // Returns the approximate value at quantile q (0-1)
+    double Quantile(double q) const;
+    uint64 Count() const { return count; }
+
+protected:
+
+    static uint64 BucketIndex(double value);
+    static double BucketValue(uint64 bucketIdx);
+    void UpdateBucket(uint64 bucketIdx, int32 delta);
+
+    uint32 tree[NumBuckets + 1] = { };      // 1-based
+    uint64 count = 0;
+};
+
+// Streaming statistics over a sliding window of samples, used for smoothing out noisy timings.
+// Every sample goes into the percentiles and the max, so that tail latency stays visible. Samples
+// that are outliers according to their modified z-score (computed from the median and the median
+// absolute deviation) are left out of the mean and variance, so that a single hitch doesn't skew them.
+// The median and MAD used for scoring are recomputed exactly from the window for every sample, so
+// that they follow the timings after a step change instead of lagging behind by a window.
+class TimingStats
+{
+
+public:
+
+    static const uint64 WindowSize = 64;
+    static const uint64 MinOutlierSamples = 8;
+
+    // Returns false if the sample was rejected as an outlier
+    bool AddSample(double value);
+    void Reset();
+
+    void SetOutlierThreshold(double threshold) { outlierThreshold = threshold; }
+
+    double Mean() const;
+    double Variance() const;
+    double StdDev() const;
+    double Percentile(double p) const;
+    double Median() const { return Percentile(0.5); }
+    double Maximum() const;
+    double MAD() const;
+
+    uint64 NumSamples() const { return Min(numSamples, WindowSize); }
+    uint64 NumOutliers() const { return numOutliers; }
+
+protected:
+
+    void RemoveOldestSample();
+    void ComputeMedianAndMAD(uint64 skipIdx, double& median, double& mad) const;
+
+    double samples[WindowSize] = { };
+    bool accepted[WindowSize] = { };
+    uint64 numSamples = 0;              // Total number of samples added since the last reset
+
+    // Running sums over the accepted samples in the window
+    double acceptedSum = 0.0;
+    double acceptedSumSq = 0.0;
+    uint64 numAccepted = 0;
+    uint64 numOutliers = 0;             // Number of outliers currently in the window
+
+    // Monotonic queue of sample indices for tracking the max of the window
+    uint64 maxQueue[WindowSize] = { };
+    uint64 maxQueueStart = 0;
+    uint64 maxQueueEnd = 0;
+
+    QuantileSketch valueSketch;
+
+    double outlierThreshold = 3.5;
+};
+
+}
@@ -8330,3 +8330,27 @@ int SaveDeepEXR(const DeepImage *deepImage, const char *filename,
 
   return 0; // OK
 }
+
+// == SF12 Changes START ==========================================================================
+// Exposes the embedded copy of miniz to the rest of the framework, see Compression.cpp
+namespace SampleFramework12
+{
+
+uint64 MinizCompress(const void* src, uint64 srcSize, void* dst, uint64 dstCapacity, int level)
+{
+    miniz::mz_ulong dstSize = miniz::mz_ulong(dstCapacity);
+    int result = miniz::mz_compress2(reinterpret_cast<unsigned char*>(dst), &dstSize,
+                                     reinterpret_cast<const unsigned char*>(src), miniz::mz_ulong(srcSize), level);
+    return result == miniz::MZ_OK ? dstSize : 0;
+}
+
+bool MinizDecompress(const void* src, uint64 srcSize, void* dst, uint64 dstSize)
+{
+    miniz::mz_ulong decompressedSize = miniz::mz_ulong(dstSize);
+    int result = miniz::mz_uncompress(reinterpret_cast<unsigned char*>(dst), &decompressedSize,
+                                      reinterpret_cast<const unsigned char*>(src), miniz::mz_ulong(srcSize));
+    return result == miniz::MZ_OK && decompressedSize == dstSize;
+}
+
+}
+// == SF12 Changes END ==========================================================================
@@ -0,0 +1,153 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Allocators.h>
+#include <Containers.h>
+#include <TimingStats.h>
+#include <Utility.h>
+#include "..\\OverlappedExecution\\WorkloadGraph.h"
+#include "..\\OverlappedExecution\\WorkloadSim.h"
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+typedef CountingAllocator<HeapAllocator> CountingHeap;
+
+Test_(CountingAllocatorCountsContainers)
+{
+    CountingHeap::ResetCounts();
+    {
+        Array<uint64, CountingHeap> array(16);
+        GrowableList<uint64, CountingHeap> list(4);
+        for(uint64 i = 0; i < 16; ++i)
+            list.Add(i);
+        Check_(CountingHeap::NumAllocations >= 3);
+        Check_(CountingHeap::NumBytesAllocated >= 32 * sizeof(uint64));
+    }
+    Check_(CountingHeap::NumFrees == CountingHeap::NumAllocations);
+}
+
+Test_(SmallListStaysInline)
+{
+    CountingHeap::ResetCounts();
+
+    SmallList<uint64, 8, CountingHeap> list;
+    for(uint64 i = 0; i < 8; ++i)
+        list.Add(i);
+    Check_(CountingHeap::NumAllocations == 0);
+
+    // Spilling allocates once, and the storage is kept after that
+    list.Add(8);
+    Check_(CountingHeap::NumAllocations == 1);
+    for(uint64 frame = 0; frame < 10; ++frame)
+    {
+        list.RemoveAll();
+        for(uint64 i = 0; i < 9; ++i)
+            list.Add(i);
+    }
+    Check_(CountingHeap::NumAllocations == 1);
+    Check_(list.Count() == 9 && list[8] == 8);
+
+    list.Shutdown();
+    Check_(CountingHeap::NumFrees == 1);
+}
+
+Test_(FrameAllocatorStopsGrowing)
+{
+    LinearAllocator& allocator = FrameAllocator::ThreadAllocator();
+
+    // Overflow the current block, then check that the reset leaves one block that fits everything
+    const uint64 allocSize = LinearAllocator::DefaultBlockSize / 4;
+    for(uint64 frame = 0; frame < 4; ++frame)
+    {
+        for(uint64 i = 0; i < 8; ++i)
+            Check_(allocator.Allocate(allocSize, 16) != nullptr);
+        FrameAllocator::Reset();
+    }
+    Check_(allocator.NumBlocks() == 1);
+
+    const uint64 startAllocations = Tests::NumHeapAllocations();
+    for(uint64 frame = 0; frame < 16; ++frame)
+    {
+        for(uint64 i = 0; i < 8; ++i)
+            allocator.Allocate(allocSize, 16);
+        FrameAllocator::Reset();
+    }
+    Check_(Tests::NumHeapAllocations() == startAllocations);
+}
+
+// Mirrors the CPU side of a frame in the sample: validate and schedule the workload graph, simulate
+// it, feed the timings into the stats, fill up per-frame and deferred lists, and then reset the frame
+// allocator the way DX12::EndFrame does. After a few frames of warm-up none of this should touch the heap.
+Test_(SteadyStateFrameDoesNotAllocate)
+{
+    const uint64 NumWorkloads = 8;
+    const uint64 RenderLatency = 2;
+
+    SimWorkload simWorkloads[NumWorkloads];
+    WorkloadNode nodes[NumWorkloads];
+    for(uint64 i = 0; i < NumWorkloads; ++i)
+    {
+        WorkloadNode& node = simWorkloads[i].Node;
+        node.Type = i % 3 == 2 ? WorkloadType::ComputeQueue : (i % 2 == 0 ? WorkloadType::Compute : WorkloadType::Graphics);
+        if(i > 0)
+            node.AddDependency(i - 1);
+        if(i > 2)
+            node.AddDependency(i - 3);
+        nodes[i] = node;
+    }
+
+    std::string graphError;
+    WorkloadSchedule schedule;
+    TimingStats durationStats[NumWorkloads];
+    SimTiming timings[NumWorkloads];
+    SmallList<void*, 64> deferredReleases[RenderLatency];
+    uint64 releaseTokens[100] = { };
+
+    auto runFrame = [&](uint64 frameIdx)
+    {
+        const bool useSplitBarriers = frameIdx % 2 == 1;
+        Check_(ValidateWorkloadGraph(nodes, NumWorkloads, graphError));
+        BuildWorkloadSchedule(nodes, NumWorkloads, useSplitBarriers, schedule);
+
+        SimSettings settings;
+        settings.UseSplitBarriers = useSplitBarriers;
+        SimulateWorkloads(simWorkloads, NumWorkloads, settings, SimGPUDesc(), timings);
+
+        for(uint64 i = 0; i < NumWorkloads; ++i)
+            durationStats[i].AddSample(timings[i].EndTime - timings[i].StartTime);
+
+        // Per-frame list on the main thread's frame allocator, which lives until the reset below
+        Array<uint64, FrameAllocator> frameList(schedule.Barriers.Count() + 1);
+        frameList[0] = frameIdx;
+
+        // Deferred releases that come back around RenderLatency frames later, with a burst every
+        // now and then that spills out of the inline storage
+        SmallList<void*, 64>& releases = deferredReleases[frameIdx % RenderLatency];
+        releases.RemoveAll();
+        const uint64 numReleases = frameIdx % 16 == 0 ? ArraySize_(releaseTokens) : 4;
+        for(uint64 i = 0; i < numReleases; ++i)
+            releases.Add(&releaseTokens[i]);
+
+        frameList.Shutdown();
+        FrameAllocator::Reset();
+    };
+
+    const uint64 NumWarmupFrames = 2 * 16;
+    for(uint64 frameIdx = 0; frameIdx < NumWarmupFrames; ++frameIdx)
+        runFrame(frameIdx);
+
+    const uint64 startAllocations = Tests::NumHeapAllocations();
+    for(uint64 frameIdx = NumWarmupFrames; frameIdx < NumWarmupFrames + 200; ++frameIdx)
+        runFrame(frameIdx);
+    Check_(Tests::NumHeapAllocations() == startAllocations);
+}
@@ -0,0 +1,11 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#define EnableSkyModel_ (0)
+#define EnableEmbree_ (0)
@@ -0,0 +1,180 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <ChunkedFile.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestFilePath = L"ChunkedFileTests.bin";
+static const uint32 TestContentType = MakeFourCC('T', 'E', 'S', 'T');
+static const uint32 SmallSectionID = MakeFourCC('S', 'M', 'L', 'L');
+static const uint32 LargeSectionID = MakeFourCC('L', 'A', 'R', 'G');
+
+// Big enough to span a few hash blocks, and not a multiple of the block size
+static const uint64 LargeSectionSize = ChunkedFileHashBlockSize * 2 + 1000;
+
+static uint8 TestByte(uint64 idx)
+{
+    return uint8((idx * 2654435761ull) >> 13);
+}
+
+static void WriteTestFile()
+{
+    ChunkedFileWriter writer(TestFilePath, TestContentType, 3);
+
+    writer.BeginSection(SmallSectionID);
+    writer.SerializeItem(uint32(42));
+    writer.SerializeItem(1.5f);
+    writer.EndSection();
+
+    // Written in uneven pieces, so that they straddle the writer's buffer
+    writer.BeginSection(LargeSectionID);
+    uint8 piece[777] = { };
+    for(uint64 offset = 0; offset < LargeSectionSize; offset += ArraySize_(piece))
+    {
+        const uint64 pieceSize = Min<uint64>(ArraySize_(piece), LargeSectionSize - offset);
+        for(uint64 i = 0; i < pieceSize; ++i)
+            piece[i] = TestByte(offset + i);
+        writer.SerializeData(pieceSize, piece);
+    }
+
+    writer.Finish();
+}
+
+static void CorruptTestFile(uint64 offset)
+{
+    Array<uint8> fileData;
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        fileData.Init(file.Size());
+        file.Read(fileData.Size(), fileData.Data());
+    }
+
+    fileData[offset] ^= 0xFF;
+    File file(TestFilePath, FileOpenMode::Write);
+    file.Write(fileData.Size(), fileData.Data());
+}
+
+Test_(ChunkedFileRoundTrip)
+{
+    WriteTestFile();
+
+    Check_(ChunkedFileReader::IsChunkedFile(TestFilePath));
+    ChunkedFileReader reader(TestFilePath, TestContentType);
+    Check_(reader.ContentVersion() == 3);
+    Check_(reader.NumSections() == 2);
+    Check_(reader.FindSection(MakeFourCC('N', 'O', 'N', 'E')) == nullptr);
+
+    const ChunkedFileSection& smallSection = reader.GetSection(SmallSectionID);
+    Check_(smallSection.Offset % ChunkedFileAlignment == 0);
+    Check_(smallSection.Size == sizeof(uint32) + sizeof(float));
+    reader.ValidateSection(smallSection);
+
+    MemoryReadSerializer serializer = reader.SectionSerializer(smallSection);
+    uint32 intValue = 0;
+    float floatValue = 0.0f;
+    serializer.SerializeItem(intValue);
+    serializer.SerializeItem(floatValue);
+    Check_(intValue == 42);
+    Check_(floatValue == 1.5f);
+
+    const ChunkedFileSection& largeSection = reader.GetSection(LargeSectionID);
+    Check_(largeSection.Offset % ChunkedFileAlignment == 0);
+    Check_(largeSection.Size == LargeSectionSize);
+    reader.ValidateSection(largeSection);
+
+    const uint8* largeData = reader.SectionData(largeSection);
+    uint64 numMismatches = 0;
+    for(uint64 i = 0; i < LargeSectionSize; ++i)
+        numMismatches += largeData[i] != TestByte(i) ? 1 : 0;
+    Check_(numMismatches == 0);
+    Check_(HashChunkedFileSection(largeData, LargeSectionSize) == largeSection.DataHash);
+
+    CheckThrows_(reader.GetSection(MakeFourCC('N', 'O', 'N', 'E')));
+}
+
+Test_(ChunkedFileChecksContentType)
+{
+    WriteTestFile();
+    CheckThrows_(ChunkedFileReader(TestFilePath, MakeFourCC('O', 'T', 'H', 'R')));
+}
+
+Test_(ChunkedFileDetectsCorruptSection)
+{
+    uint64 corruptOffset = 0;
+    WriteTestFile();
+    {
+        ChunkedFileReader reader(TestFilePath, TestContentType);
+        corruptOffset = reader.GetSection(LargeSectionID).Offset + ChunkedFileHashBlockSize + 10;
+    }
+
+    CorruptTestFile(corruptOffset);
+
+    // The table is still fine, so the file opens and only the damaged section fails
+    ChunkedFileReader reader(TestFilePath, TestContentType);
+    reader.ValidateSection(reader.GetSection(SmallSectionID));
+    CheckThrows_(reader.ValidateSection(reader.GetSection(LargeSectionID)));
+}
+
+Test_(ChunkedFileDetectsCorruptTable)
+{
+    uint64 tableOffset = 0;
+    WriteTestFile();
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        tableOffset = file.Size() - 2 * sizeof(ChunkedFileSection);
+    }
+
+    CorruptTestFile(tableOffset + offsetof(ChunkedFileSection, Size));
+    CheckThrows_(ChunkedFileReader(TestFilePath, TestContentType));
+}
+
+Test_(ChunkedFileAbandonedWrite)
+{
+    // A writer that goes away without Finish() while an exception is in flight
+    bool threw = false;
+    try
+    {
+        ChunkedFileWriter writer(TestFilePath, TestContentType, 3);
+        writer.BeginSection(SmallSectionID);
+        writer.SerializeItem(uint32(42));
+        throw Exception(L"Abandoned write");
+    }
+    catch(Exception&)
+    {
+        threw = true;
+    }
+
+    Check_(threw);
+    Check_(FileExists(TestFilePath) == false);
+}
+
+Test_(ChunkedFileRejectsUnfinishedHeader)
+{
+    // What a crash part of the way through writing leaves behind: the placeholder header and some data
+    ChunkedFileHeader placeholderHeader;
+    uint8 sectionData[256] = { };
+    {
+        File file(TestFilePath, FileOpenMode::Write);
+        file.Write(placeholderHeader);
+        file.Write(ArraySize_(sectionData), sectionData);
+    }
+
+    Check_(ChunkedFileReader::IsChunkedFile(TestFilePath) == false);
+    CheckThrows_(ChunkedFileReader(TestFilePath, TestContentType));
+
+    DeleteFile(TestFilePath);
+}
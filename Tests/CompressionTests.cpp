@@ -0,0 +1,327 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Compression.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Timer.h>
+#include <Utility.h>
+#include <EnkiTS/TaskScheduler.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestFilePath = L"CompressionTests.bin";
+static const uint64 TestBlockSize = 4096;
+
+// Runs of repeated bytes mixed with noise, so that some blocks compress and some are stored as-is
+static void MakeTestData(Array<uint8>& data, uint64 size)
+{
+    data.Init(size);
+    uint32 state = 12345;
+    for(uint64 i = 0; i < size; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        const bool noise = (i / TestBlockSize) % 3 == 2;
+        data[i] = noise ? uint8(state >> 24) : uint8((i / 37) & 0xF);
+    }
+}
+
+static void WriteTestFile(const Array<uint8>& data, CompressionCodec codec)
+{
+    CompressedWriteSerializer serializer(TestFilePath, codec, TestBlockSize);
+    serializer.SerializeData(data.Size(), data.Data());
+    serializer.Finish();
+}
+
+static void PatchTestFile(uint64 offset, uint64 size, const void* patchData)
+{
+    Array<uint8> fileData;
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        fileData.Init(file.Size());
+        file.Read(fileData.Size(), fileData.Data());
+    }
+
+    memcpy(fileData.Data() + offset, patchData, size);
+    File file(TestFilePath, FileOpenMode::Write);
+    file.Write(fileData.Size(), fileData.Data());
+}
+
+static void CheckRoundTrip(CompressionCodec codec)
+{
+    Array<uint8> data;
+    MakeTestData(data, TestBlockSize * 10 + 123);
+    WriteTestFile(data, codec);
+
+    Check_(IsCompressedFile(TestFilePath));
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        Check_(codec == CompressionCodec::None || file.Size() < data.Size());
+    }
+
+    CompressedReadSerializer serializer(TestFilePath);
+    Check_(serializer.Size() == data.Size());
+
+    Array<uint8> readData(data.Size());
+    serializer.SerializeData(readData.Size(), readData.Data());
+    Check_(memcmp(readData.Data(), data.Data(), data.Size()) == 0);
+
+    uint8 pastTheEnd = 0;
+    CheckThrows_(serializer.SerializeItem(pastTheEnd));
+}
+
+Test_(CompressionBlockRoundTrip)
+{
+    Array<uint8> data;
+    MakeTestData(data, TestBlockSize);
+    Array<uint8> compressed(data.Size());
+    Array<uint8> decompressed(data.Size());
+
+    for(uint32 codec = 0; codec < uint32(CompressionCodec::NumValues); ++codec)
+    {
+        const uint64 compressedSize = CompressBlock(CompressionCodec(codec), data.Data(), data.Size(),
+                                                    compressed.Data(), compressed.Size());
+        Check_(compressedSize > 0);
+        Check_(DecompressBlock(CompressionCodec(codec), compressed.Data(), compressedSize, decompressed.Data(), decompressed.Size()));
+        Check_(memcmp(decompressed.Data(), data.Data(), data.Size()) == 0);
+
+        // Asking for the wrong size has to fail instead of writing past the end
+        Check_(DecompressBlock(CompressionCodec(codec), compressed.Data(), compressedSize, decompressed.Data(), decompressed.Size() - 1) == false);
+    }
+}
+
+Test_(CompressedFileRoundTrip)
+{
+    CheckRoundTrip(CompressionCodec::None);
+    CheckRoundTrip(CompressionCodec::Deflate);
+    CheckRoundTrip(CompressionCodec::LZ);
+}
+
+Test_(CompressedFileRejectsOversizedHeader)
+{
+    Array<uint8> data;
+    MakeTestData(data, TestBlockSize * 4);
+    WriteTestFile(data, CompressionCodec::LZ);
+
+    CompressedFileHeader header;
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        file.Read(header);
+    }
+
+    // A block count that still matches, but a size that no amount of compression could reach
+    CompressedFileHeader badHeader = header;
+    badHeader.BlockSize = MaxCompressionBlockSize;
+    badHeader.UncompressedSize = MaxCompressionBlockSize * header.NumBlocks;
+    PatchTestFile(0, sizeof(badHeader), &badHeader);
+    CheckThrows_(CompressedReadSerializer(TestFilePath, nullptr));
+
+    badHeader = header;
+    badHeader.BlockSize = uint64(-1);
+    badHeader.UncompressedSize = uint64(-1);
+    badHeader.NumBlocks = 1;
+    PatchTestFile(0, sizeof(badHeader), &badHeader);
+    CheckThrows_(CompressedReadSerializer(TestFilePath, nullptr));
+
+    PatchTestFile(0, sizeof(header), &header);
+    CompressedReadSerializer serializer(TestFilePath);
+    Check_(serializer.Size() == data.Size());
+}
+
+Test_(CompressedFileAbandonedWrite)
+{
+    Array<uint8> data;
+    MakeTestData(data, TestBlockSize * 4);
+
+    bool threw = false;
+    try
+    {
+        CompressedWriteSerializer serializer(TestFilePath, CompressionCodec::LZ, TestBlockSize);
+        serializer.SerializeData(data.Size(), data.Data());
+        throw Exception(L"Abandoned write");
+    }
+    catch(Exception&)
+    {
+        threw = true;
+    }
+
+    Check_(threw);
+    Check_(FileExists(TestFilePath) == false);
+}
+
+// Streams have the same layout as files, and can be decompressed on one thread or on several
+Test_(CompressedStreamRoundTrip)
+{
+    Array<uint8> data;
+    MakeTestData(data, TestBlockSize * 10 + 123);
+
+    enki::TaskScheduler scheduler;
+    scheduler.Initialize(4);
+
+    for(uint32 codec = 0; codec < uint32(CompressionCodec::NumValues); ++codec)
+    {
+        // Streams get appended after whatever is already in the list
+        GrowableList<uint8> stream;
+        stream.Add(0xAB);
+        CompressStream(CompressionCodec(codec), data.Data(), data.Size(), stream, TestBlockSize);
+        Check_(stream[0] == 0xAB);
+        Check_(codec == uint32(CompressionCodec::None) || stream.Count() < data.Size());
+
+        const uint8* streamData = stream.Data() + 1;
+        const uint64 streamSize = stream.Count() - 1;
+        Check_(DecompressedStreamSize(streamData, streamSize, L"stream") == data.Size());
+
+        Array<uint8> decompressed(data.Size(), 0xCD);
+        DecompressStream(streamData, streamSize, decompressed.Data(), decompressed.Size(), L"stream");
+        Check_(memcmp(decompressed.Data(), data.Data(), data.Size()) == 0);
+
+        decompressed.Fill(0xCD);
+        DecompressStream(streamData, streamSize, decompressed.Data(), decompressed.Size(), L"stream", &scheduler);
+        Check_(memcmp(decompressed.Data(), data.Data(), data.Size()) == 0);
+
+        CheckThrows_(DecompressStream(streamData, streamSize, decompressed.Data(), decompressed.Size() - 1, L"stream"));
+        CheckThrows_(DecompressStream(streamData, streamSize - 1, decompressed.Data(), decompressed.Size(), L"stream"));
+    }
+
+    GrowableList<uint8> emptyStream;
+    CompressStream(CompressionCodec::LZ, nullptr, 0, emptyStream);
+    Check_(DecompressedStreamSize(emptyStream.Data(), emptyStream.Count(), L"stream") == 0);
+    DecompressStream(emptyStream.Data(), emptyStream.Count(), nullptr, 0, L"stream");
+}
+
+// Laid out like MeshVertex, without needing the math library
+struct BenchmarkVertex
+{
+    float Position[3];
+    float Normal[3];
+    float UV[2];
+    float Tangent[3];
+    float Bitangent[3];
+};
+
+// Only handles the range that the benchmark texels fall in, and truncates instead of rounding
+static uint16 FloatToHalf(float value)
+{
+    uint32 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    const int32 exponent = int32((bits >> 23) & 0xFF) - 127 + 15;
+    if(exponent <= 0)
+        return uint16((bits >> 16) & 0x8000);
+    return uint16(((bits >> 16) & 0x8000) | (exponent << 10) | ((bits >> 13) & 0x3FF));
+}
+
+// A 1024x1024 heightfield grid, which is about as well as real vertex data compresses
+static void MakeVertexData(Array<BenchmarkVertex>& vertices)
+{
+    const uint64 gridSize = 1024;
+    vertices.Init(gridSize * gridSize);
+    auto height = [](float x, float z) { return std::sin(x * 0.05f) * std::cos(z * 0.07f) * 8.0f; };
+    for(uint64 z = 0; z < gridSize; ++z)
+    {
+        for(uint64 x = 0; x < gridSize; ++x)
+        {
+            const float fx = float(x);
+            const float fz = float(z);
+            const float dx = height(fx + 1.0f, fz) - height(fx - 1.0f, fz);
+            const float dz = height(fx, fz + 1.0f) - height(fx, fz - 1.0f);
+            const float normalLength = std::sqrt(dx * dx + 4.0f + dz * dz);
+
+            BenchmarkVertex& vertex = vertices[z * gridSize + x];
+            vertex.Position[0] = fx;
+            vertex.Position[1] = height(fx, fz);
+            vertex.Position[2] = fz;
+            vertex.Normal[0] = -dx / normalLength;
+            vertex.Normal[1] = 2.0f / normalLength;
+            vertex.Normal[2] = -dz / normalLength;
+            vertex.UV[0] = fx / (gridSize - 1);
+            vertex.UV[1] = fz / (gridSize - 1);
+            vertex.Tangent[0] = 1.0f;
+            vertex.Tangent[1] = 0.0f;
+            vertex.Tangent[2] = 0.0f;
+            vertex.Bitangent[0] = 0.0f;
+            vertex.Bitangent[1] = 0.0f;
+            vertex.Bitangent[2] = 1.0f;
+        }
+    }
+}
+
+// A 2048x2048 Half4 HDR gradient with some noise on top, like a rendered or captured image
+static void MakeTexelData(Array<uint16>& texels)
+{
+    const uint64 textureSize = 2048;
+    texels.Init(textureSize * textureSize * 4);
+    uint32 state = 12345;
+    for(uint64 y = 0; y < textureSize; ++y)
+    {
+        for(uint64 x = 0; x < textureSize; ++x)
+        {
+            const float u = float(x) / textureSize;
+            const float v = float(y) / textureSize;
+            const float base[3] = { u * 16.0f, v * 4.0f, (1.0f - u) * (1.0f - v) * 64.0f };
+            for(uint64 c = 0; c < 3; ++c)
+            {
+                state = state * 1664525u + 1013904223u;
+                const float noise = 1.0f + ((state >> 8) & 0xFF) / 2550.0f;
+                texels[(y * textureSize + x) * 4 + c] = FloatToHalf(base[c] * noise + 0.001f);
+            }
+            texels[(y * textureSize + x) * 4 + 3] = FloatToHalf(1.0f);
+        }
+    }
+}
+
+static void BenchmarkCodecs(const char* dataName, const void* data, uint64 dataSize, enki::TaskScheduler& scheduler)
+{
+    const double mb = dataSize / (1024.0 * 1024.0);
+    Array<uint8> decompressed(dataSize);
+    for(uint32 codec = uint32(CompressionCodec::Deflate); codec < uint32(CompressionCodec::NumValues); ++codec)
+    {
+        GrowableList<uint8> stream;
+        Timer compressTimer;
+        CompressStream(CompressionCodec(codec), data, dataSize, stream);
+        compressTimer.Update();
+
+        decompressed.Fill(0);
+        Timer decompressTimer;
+        DecompressStream(stream.Data(), stream.Count(), decompressed.Data(), dataSize, L"benchmark");
+        decompressTimer.Update();
+        Check_(memcmp(decompressed.Data(), data, dataSize) == 0);
+
+        decompressed.Fill(0);
+        Timer threadedTimer;
+        DecompressStream(stream.Data(), stream.Count(), decompressed.Data(), dataSize, L"benchmark", &scheduler);
+        threadedTimer.Update();
+        Check_(memcmp(decompressed.Data(), data, dataSize) == 0);
+
+        Tests::ReportBenchmarkResult("%-10s %-7s ratio %.3f, compress %6.1f MB/s, decompress %6.1f MB/s (%u threads: %7.1f MB/s)",
+                                     dataName, codec == uint32(CompressionCodec::LZ) ? "LZ" : "Deflate",
+                                     double(stream.Count()) / dataSize, mb / compressTimer.ElapsedSecondsD(),
+                                     mb / decompressTimer.ElapsedSecondsD(), scheduler.GetNumTaskThreads(),
+                                     mb / threadedTimer.ElapsedSecondsD());
+    }
+}
+
+// Compresses vertex and texture data in 256 KB blocks with each codec, then decompresses it on one
+// thread and on every thread
+Benchmark_(CompressionThroughput)
+{
+    enki::TaskScheduler scheduler;
+    scheduler.Initialize();
+
+    Array<BenchmarkVertex> vertices;
+    MakeVertexData(vertices);
+    BenchmarkCodecs("MeshVertex", vertices.Data(), vertices.MemorySize(), scheduler);
+
+    Array<uint16> texels;
+    MakeTexelData(texels);
+    BenchmarkCodecs("Half4", texels.Data(), texels.MemorySize(), scheduler);
+}
@@ -0,0 +1,454 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Containers.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include <unordered_map>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// Keeps track of how many are alive, so that leaked or double-destroyed values show up
+struct CountedValue
+{
+    static int64 NumLive;
+
+    uint64 Value = 0;
+
+    explicit CountedValue(uint64 value = 0) : Value(value) { ++NumLive; }
+    CountedValue(const CountedValue& other) : Value(other.Value) { ++NumLive; }
+    CountedValue(CountedValue&& other) : Value(other.Value) { ++NumLive; }
+    ~CountedValue() { --NumLive; }
+
+    CountedValue& operator=(const CountedValue& other) { Value = other.Value; return *this; }
+    CountedValue& operator=(CountedValue&& other) { Value = other.Value; return *this; }
+};
+
+int64 CountedValue::NumLive = 0;
+
+// Gives runs of 8 keys the same hash, so that entries get displaced and shifted back a lot
+struct ClusteringHasher
+{
+    static uint64 HashKey(uint64 key)
+    {
+        return HashMapHasher<uint64>::HashKey(key / 8);
+    }
+};
+
+Test_(HashMapInsertFindRemove)
+{
+    const uint64 numKeys = 1000;
+    HashMap<uint64, uint64> map;
+    Check_(map.Find(0) == nullptr);
+    Check_(map.Remove(0) == false);
+
+    for(uint64 i = 0; i < numKeys; ++i)
+        map.Insert(i * 7, i);
+    Check_(map.Count() == numKeys);
+    Check_(map.Count() * 8 <= map.Capacity() * 7);
+    for(uint64 i = 0; i < numKeys; ++i)
+    {
+        const uint64* value = map.Find(i * 7);
+        Check_(value != nullptr && *value == i);
+        Check_(map.Contains(i * 7 + 1) == false);
+    }
+
+    // Inserting a key that's already there replaces the value
+    map.Insert(7, 1234);
+    Check_(map.Count() == numKeys);
+    Check_(*map.Find(7) == 1234);
+    map.Insert(7, 1);
+
+    for(uint64 i = 0; i < numKeys; i += 2)
+        Check_(map.Remove(i * 7));
+    Check_(map.Count() == numKeys / 2);
+    Check_(map.Remove(0) == false);
+    for(uint64 i = 0; i < numKeys; ++i)
+        Check_(map.Contains(i * 7) == (i % 2 == 1));
+
+    uint64 sum = 0;
+    uint64 numVisited = 0;
+    map.ForEach([&](uint64 key, uint64 value)
+    {
+        Check_(key == value * 7);
+        sum += value;
+        ++numVisited;
+    });
+    Check_(numVisited == numKeys / 2);
+    Check_(sum == (numKeys / 2) * (numKeys / 2));
+
+    // Moving takes the entries along and leaves an empty map behind
+    HashMap<uint64, uint64> moved(std::move(map));
+    Check_(map.Count() == 0);
+    Check_(map.Find(7) == nullptr);
+    Check_(moved.Count() == numKeys / 2);
+    Check_(*moved.Find(7) == 1);
+
+    moved.RemoveAll();
+    Check_(moved.Count() == 0);
+    Check_(moved.Find(7) == nullptr);
+    moved.Insert(7, 2);
+    Check_(*moved.Find(7) == 2);
+}
+
+// Runs a random mix of operations on long probe chains, and compares every result with std::unordered_map
+Test_(HashMapMatchesReference)
+{
+    HashMap<uint64, uint64, ClusteringHasher> map;
+    std::unordered_map<uint64, uint64> reference;
+
+    std::mt19937_64 random(0x5F3759DF);
+    const uint64 maxKey = 2048;
+    for(uint64 op = 0; op < 100000; ++op)
+    {
+        const uint64 key = random() % maxKey;
+        const uint64 choice = random() % 4;
+        if(choice < 2)
+        {
+            map.Insert(key, op);
+            reference[key] = op;
+        }
+        else if(choice == 2)
+        {
+            Check_(map.Remove(key) == (reference.erase(key) == 1));
+        }
+        else
+        {
+            const uint64* value = map.Find(key);
+            auto it = reference.find(key);
+            Check_((value != nullptr) == (it != reference.end()));
+            if(value != nullptr && it != reference.end())
+                Check_(*value == it->second);
+        }
+
+        Check_(map.Count() == reference.size());
+    }
+
+    for(uint64 key = 0; key < maxKey; ++key)
+    {
+        const uint64* value = map.Find(key);
+        auto it = reference.find(key);
+        Check_((value != nullptr) == (it != reference.end()));
+        if(value != nullptr && it != reference.end())
+            Check_(*value == it->second);
+    }
+}
+
+// Values are destroyed exactly once, whether they're replaced, removed, shifted back, or moved by a rehash
+Test_(HashMapDestroysValues)
+{
+    CountedValue::NumLive = 0;
+    {
+        HashMap<uint64, CountedValue, ClusteringHasher> map;
+        for(uint64 i = 0; i < 500; ++i)
+            map.Insert(i, CountedValue(i));
+        Check_(CountedValue::NumLive == 500);
+
+        for(uint64 i = 0; i < 500; i += 3)
+            map.Insert(i, CountedValue(i + 1));
+        Check_(CountedValue::NumLive == 500);
+
+        for(uint64 i = 0; i < 500; i += 2)
+            map.Remove(i);
+        Check_(CountedValue::NumLive == int64(map.Count()));
+
+        for(uint64 i = 1; i < 500; i += 2)
+        {
+            const CountedValue* value = map.Find(i);
+            Check_(value != nullptr && value->Value == (i % 3 == 0 ? i + 1 : i));
+        }
+
+        map.Reserve(4096);
+        Check_(CountedValue::NumLive == int64(map.Count()));
+        Check_(map.Find(499) != nullptr && map.Find(499)->Value == 499);
+    }
+    Check_(CountedValue::NumLive == 0);
+}
+
+// Runs the same random adds, inserts and removes on a list and on a std::vector, and checks that they
+// end up holding the same elements
+template<typename TList, typename T, typename MakeT> static void CheckListMatchesVector(TList& list, uint64 maxCount,
+                                                                                       MakeT makeValue)
+{
+    std::vector<T> reference;
+    std::mt19937_64 random(0xC0FFEE);
+    for(uint64 op = 0; op < 5000; ++op)
+    {
+        const uint64 choice = random() % 8;
+        if(reference.size() < maxCount && choice < 3)
+        {
+            const T value = makeValue(op);
+            list.Add(value);
+            reference.push_back(value);
+        }
+        else if(reference.size() < maxCount && choice < 5)
+        {
+            const uint64 idx = random() % (reference.size() + 1);
+            const T value = makeValue(op);
+            list.Insert(value, idx);
+            reference.insert(reference.begin() + idx, value);
+        }
+        else if(reference.size() > 0 && choice < 7)
+        {
+            const uint64 idx = random() % reference.size();
+            list.Remove(idx);
+            reference.erase(reference.begin() + idx);
+        }
+        else if(reference.size() > 4)
+        {
+            const uint64 idx = random() % (reference.size() - 4);
+            const uint64 numItems = 1 + random() % 4;
+            list.RemoveMultiple(idx, numItems);
+            reference.erase(reference.begin() + idx, reference.begin() + idx + numItems);
+        }
+
+        Check_(list.Count() == reference.size());
+    }
+
+    bool matches = list.Count() == reference.size();
+    for(uint64 i = 0; matches && i < reference.size(); ++i)
+        matches = list[i] == reference[i];
+    Check_(matches);
+}
+
+static uint64 MakeIntValue(uint64 op)
+{
+    return op * 31;
+}
+
+// Long enough that they don't fit in std::string's own storage
+static std::string MakeStringValue(uint64 op)
+{
+    return MakeString("ContainerTests value number %llu", op);
+}
+
+// Trivially copyable elements get moved with memmove, and everything else gets moved one at a time
+Test_(ListsMatchVector)
+{
+    {
+        FixedList<uint64> list(64);
+        CheckListMatchesVector<FixedList<uint64>, uint64>(list, 64, MakeIntValue);
+        FixedList<std::string> stringList(64);
+        CheckListMatchesVector<FixedList<std::string>, std::string>(stringList, 64, MakeStringValue);
+    }
+
+    {
+        GrowableList<uint64> list;
+        CheckListMatchesVector<GrowableList<uint64>, uint64>(list, 1000, MakeIntValue);
+        GrowableList<std::string> stringList;
+        CheckListMatchesVector<GrowableList<std::string>, std::string>(stringList, 1000, MakeStringValue);
+    }
+
+    {
+        SmallList<uint64, 8> list;
+        CheckListMatchesVector<SmallList<uint64, 8>, uint64>(list, 1000, MakeIntValue);
+        SmallList<std::string, 8> stringList;
+        CheckListMatchesVector<SmallList<std::string, 8>, std::string>(stringList, 1000, MakeStringValue);
+    }
+}
+
+// Every element that gets constructed is destroyed exactly once, through growth, removal, copies and moves
+Test_(ListsTrackLifetimes)
+{
+    CountedValue::NumLive = 0;
+    {
+        GrowableList<CountedValue> list;
+        for(uint64 i = 0; i < 100; ++i)
+            list.Add(CountedValue(i));
+        Check_(list.Count() == 100);
+        Check_(list.CurrentMaxCount() >= 100);
+        Check_(CountedValue::NumLive == 100);
+
+        list.Insert(CountedValue(1000), 0);
+        list.Insert(CountedValue(1001), 50);
+        list.Insert(CountedValue(1002), list.Count());
+        Check_(list[0].Value == 1000 && list[1].Value == 0);
+        Check_(list[50].Value == 1001 && list[51].Value == 49);
+        Check_(list[102].Value == 1002);
+        Check_(CountedValue::NumLive == 103);
+
+        list.Remove(0);
+        list.RemoveMultiple(49, 2);
+        Check_(list.Count() == 100);
+        Check_(list[49].Value == 50);
+        Check_(CountedValue::NumLive == 100);
+
+        // The new element is built before the old ones are moved, so it can be a copy of one of them
+        while(list.Count() < list.CurrentMaxCount())
+            list.EmplaceBack(uint64(0));
+        const uint64 count = list.Count();
+        list.EmplaceBack(list[1]);
+        Check_(list.Count() == count + 1);
+        Check_(list[count].Value == 1);
+
+        GrowableList<CountedValue> copy(list);
+        Check_(CountedValue::NumLive == int64(list.Count() * 2));
+        GrowableList<CountedValue> moved(std::move(copy));
+        Check_(copy.Count() == 0);
+        Check_(CountedValue::NumLive == int64(list.Count() * 2));
+
+        moved.RemoveAll();
+        Check_(CountedValue::NumLive == int64(list.Count()));
+
+        Array<CountedValue> array(4, CountedValue(7));
+        array.Resize(16);
+        Check_(array[3].Value == 7 && array[15].Value == 0);
+        array.Resize(2);
+        Check_(array.Size() == 2 && array[1].Value == 7);
+        Check_(CountedValue::NumLive == int64(list.Count() + 2));
+
+        // Moving out of inline storage moves the elements over, and the old ones are destroyed
+        SmallList<CountedValue, 4> small;
+        small.Add(CountedValue(1));
+        small.Add(CountedValue(2));
+        SmallList<CountedValue, 4> movedSmall(std::move(small));
+        Check_(movedSmall.Count() == 2 && movedSmall[1].Value == 2);
+        Check_(CountedValue::NumLive == int64(list.Count() + 4));
+    }
+    Check_(CountedValue::NumLive == 0);
+}
+
+Test_(SmallListSwitchesToHeap)
+{
+    typedef SmallList<std::string, 4> StringList;
+
+    StringList list;
+    auto isInline = [](const StringList& l)
+    {
+        const uint8* listStart = reinterpret_cast<const uint8*>(&l);
+        const uint8* data = reinterpret_cast<const uint8*>(l.Data());
+        return data >= listStart && data < listStart + sizeof(StringList);
+    };
+
+    for(uint64 i = 0; i < 4; ++i)
+        list.Add(MakeStringValue(i));
+    Check_(isInline(list));
+    Check_(list.CurrentMaxCount() == 4);
+
+    // Inline elements have to be moved one at a time, so the moved-from list is left empty and inline
+    StringList movedInline(std::move(list));
+    Check_(isInline(movedInline));
+    Check_(movedInline.Count() == 4 && movedInline[3] == MakeStringValue(3));
+    Check_(list.Count() == 0 && isInline(list));
+
+    movedInline.Insert(MakeStringValue(100), 2);
+    Check_(isInline(movedInline) == false);
+    Check_(movedInline.Count() == 5 && movedInline.CurrentMaxCount() > 4);
+    Check_(movedInline[1] == MakeStringValue(1) && movedInline[2] == MakeStringValue(100));
+    Check_(movedInline[4] == MakeStringValue(3));
+
+    // Heap storage gets taken over without moving the elements
+    const std::string* heapData = movedInline.Data();
+    StringList movedHeap(std::move(movedInline));
+    Check_(movedHeap.Data() == heapData);
+    Check_(movedInline.Count() == 0 && isInline(movedInline));
+
+    // Going back under N keeps the heap storage, until Shutdown() goes back to the inline storage
+    movedHeap.RemoveMultiple(0, 3);
+    Check_(movedHeap.Count() == 2 && isInline(movedHeap) == false);
+    Check_(movedHeap[0] == MakeStringValue(2) && movedHeap[1] == MakeStringValue(3));
+
+    StringList copy(movedHeap);
+    Check_(isInline(copy));
+    Check_(copy.Count() == 2 && copy[1] == MakeStringValue(3));
+
+    movedHeap.Shutdown();
+    Check_(isInline(movedHeap) && movedHeap.CurrentMaxCount() == 4);
+    movedHeap.EmplaceBack("emplaced");
+    Check_(movedHeap.Count() == 1 && movedHeap[0] == "emplaced");
+}
+
+// Compares GrowableList and SmallList against std::vector, for a trivially copyable element type and for
+// one that has to be moved one element at a time
+template<typename T, typename MakeT> static void BenchmarkAgainstVector(const char* typeName, uint64 numElements,
+                                                                       MakeT makeValue)
+{
+    const uint64 numInserts = numElements / 50;
+    Array<T> values(numElements);
+    for(uint64 i = 0; i < numElements; ++i)
+        values[i] = makeValue(i);
+
+    auto report = [&](const char* containerName, const char* opName, const Timer& timer, uint64 numOps)
+    {
+        Tests::ReportBenchmarkResult("%-12s %-16s %-22s %7.2f ns per element", typeName, containerName, opName,
+                                     timer.ElapsedMicrosecondsD() * 1000.0 / numOps);
+    };
+
+    auto runList = [&](auto& list, const char* containerName)
+    {
+        Timer timer;
+        for(uint64 i = 0; i < numElements; ++i)
+            list.Add(values[i]);
+        timer.Update();
+        report(containerName, "Add (copy)", timer, numElements);
+        list.RemoveAll();
+
+        timer = Timer();
+        for(uint64 i = 0; i < numElements; ++i)
+            list.EmplaceBack(values[i]);
+        timer.Update();
+        report(containerName, "EmplaceBack", timer, numElements);
+        list.Shutdown();
+
+        timer = Timer();
+        for(uint64 i = 0; i < numInserts; ++i)
+            list.Insert(values[i], list.Count() / 2);
+        while(list.Count() > 0)
+            list.Remove(list.Count() / 2);
+        timer.Update();
+        report(containerName, "Insert/Remove middle", timer, numInserts);
+        list.Shutdown();
+    };
+
+    {
+        std::vector<T> vec;
+        Timer timer;
+        for(uint64 i = 0; i < numElements; ++i)
+            vec.push_back(values[i]);
+        timer.Update();
+        report("std::vector", "Add (copy)", timer, numElements);
+        vec.clear();
+
+        timer = Timer();
+        for(uint64 i = 0; i < numElements; ++i)
+            vec.emplace_back(values[i]);
+        timer.Update();
+        report("std::vector", "EmplaceBack", timer, numElements);
+        vec = std::vector<T>();
+
+        timer = Timer();
+        for(uint64 i = 0; i < numInserts; ++i)
+            vec.insert(vec.begin() + vec.size() / 2, values[i]);
+        while(vec.size() > 0)
+            vec.erase(vec.begin() + vec.size() / 2);
+        timer.Update();
+        report("std::vector", "Insert/Remove middle", timer, numInserts);
+    }
+
+    {
+        GrowableList<T> list;
+        runList(list, "GrowableList");
+    }
+
+    {
+        SmallList<T, 16> list;
+        runList(list, "SmallList<16>");
+    }
+}
+
+Benchmark_(ListsVsStdVector)
+{
+    BenchmarkAgainstVector<uint64>("uint64", 1000000, MakeIntValue);
+    BenchmarkAgainstVector<std::string>("std::string", 200000, MakeStringValue);
+}
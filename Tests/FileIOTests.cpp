@@ -0,0 +1,252 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <FileIO.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestFilePath = L"FileIOTests.bin";
+
+// Every 4 bytes of the file hold their own offset, so any range can be checked without keeping a copy
+static void WriteTestFile(uint64 fileSize)
+{
+    Array<uint32> words(fileSize / sizeof(uint32));
+    for(uint64 i = 0; i < words.Size(); ++i)
+        words[i] = uint32(i * sizeof(uint32));
+
+    File file(TestFilePath, FileOpenMode::Write);
+    file.Write(words.MemorySize(), words.Data());
+}
+
+static bool MatchesFile(uint64 offset, uint64 size, const void* data)
+{
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    for(uint64 i = 0; i < size; ++i)
+    {
+        const uint64 fileOffset = offset + i;
+        const uint32 word = uint32(fileOffset & ~uint64(3));
+        if(bytes[i] != reinterpret_cast<const uint8*>(&word)[fileOffset & 3])
+            return false;
+    }
+
+    return true;
+}
+
+static bool RangeMatchesFile(const FileReadRange& range)
+{
+    return MatchesFile(range.Offset, range.Size, range.Data);
+}
+
+// Starts a read and waits for it
+static void ReadAsync(const AsyncFile& file, uint64 offset, uint64 size, void* data)
+{
+    AsyncRead read;
+    file.BeginRead(read, offset, size, data);
+    read.Wait();
+}
+
+// Ranges of all sizes (including empty ones), at unaligned offsets, overlapping each other, and in no
+// particular order. There are more of them than AsyncFile keeps in flight at once.
+static void MakeTestRanges(Array<FileReadRange>& ranges, Array<uint8>& buffer, uint64 fileSize)
+{
+    const uint64 numRanges = AsyncFile::MaxReadsInFlight * 8 + 3;
+    ranges.Init(numRanges);
+
+    std::mt19937_64 random(0xF11E);
+    uint64 bufferSize = 0;
+    for(uint64 i = 0; i < numRanges; ++i)
+    {
+        ranges[i].Size = i % 17 == 0 ? 0 : random() % 9000;
+        ranges[i].Offset = random() % (fileSize - ranges[i].Size + 1);
+        bufferSize += ranges[i].Size;
+    }
+
+    // The last one goes right up to the end of the file
+    ranges[numRanges - 1].Offset = fileSize - ranges[numRanges - 1].Size;
+
+    buffer.Init(bufferSize);
+    uint64 bufferOffset = 0;
+    for(uint64 i = 0; i < numRanges; ++i)
+    {
+        ranges[i].Data = buffer.Data() + bufferOffset;
+        bufferOffset += ranges[i].Size;
+    }
+}
+
+Test_(ReadRangesOutOfOrder)
+{
+    const uint64 fileSize = 1024 * 1024;
+    WriteTestFile(fileSize);
+
+    Array<FileReadRange> ranges;
+    Array<uint8> buffer;
+    MakeTestRanges(ranges, buffer, fileSize);
+
+    {
+        buffer.Fill(0xCD);
+        File file(TestFilePath, FileOpenMode::Read, FileAccessHint::Random);
+        file.ReadRanges(ranges.Data(), ranges.Size());
+
+        bool matches = true;
+        for(uint64 i = 0; i < ranges.Size(); ++i)
+            matches = matches && RangeMatchesFile(ranges[i]);
+        Check_(matches);
+    }
+
+    {
+        buffer.Fill(0xCD);
+        AsyncFile file(TestFilePath, FileAccessHint::Random);
+        Check_(file.Size() == fileSize);
+        file.ReadRanges(ranges.Data(), ranges.Size());
+
+        bool matches = true;
+        for(uint64 i = 0; i < ranges.Size(); ++i)
+            matches = matches && RangeMatchesFile(ranges[i]);
+        Check_(matches);
+    }
+}
+
+// Reads are issued back to front and finished in a different order than they were issued
+Test_(AsyncReadsFinishInAnyOrder)
+{
+    const uint64 fileSize = 256 * 1024;
+    WriteTestFile(fileSize);
+
+    const uint64 numReads = 8;
+    const uint64 readSize = fileSize / numReads;
+    Array<uint8> buffer(fileSize, 0xCD);
+    AsyncRead reads[numReads];
+    FileReadRange ranges[numReads];
+
+    AsyncFile file(TestFilePath);
+    for(uint64 i = 0; i < numReads; ++i)
+    {
+        const uint64 readIdx = numReads - 1 - i;
+        ranges[readIdx].Offset = readIdx * readSize;
+        ranges[readIdx].Size = readSize;
+        ranges[readIdx].Data = buffer.Data() + readIdx * readSize;
+        file.BeginRead(reads[readIdx], ranges[readIdx].Offset, ranges[readIdx].Size, ranges[readIdx].Data);
+    }
+
+    // Poll the even ones, and block on the odd ones
+    for(uint64 i = 0; i < numReads; i += 2)
+    {
+        while(reads[i].IsDone() == false)
+            Sleep(0);
+    }
+
+    for(uint64 i = 1; i < numReads; i += 2)
+        reads[i].Wait();
+
+    bool matches = true;
+    for(uint64 i = 0; i < numReads; ++i)
+        matches = matches && reads[i].IsDone() && RangeMatchesFile(ranges[i]);
+    Check_(matches);
+
+    // A read can be reused once it's done, and an empty read is done right away
+    file.BeginRead(reads[0], fileSize - 4, 4, buffer.Data());
+    reads[0].Wait();
+    Check_(MatchesFile(fileSize - 4, 4, buffer.Data()));
+    file.BeginRead(reads[1], 0, 0, nullptr);
+    Check_(reads[1].IsDone());
+}
+
+Test_(ReadsPastTheEndThrow)
+{
+    const uint64 fileSize = 4096;
+    WriteTestFile(fileSize);
+    uint8 data[64] = { };
+
+    {
+        File file(TestFilePath, FileOpenMode::Read);
+        CheckThrows_(file.ReadAt(fileSize - 32, 64, data));
+        CheckThrows_(file.ReadAt(fileSize + 32, 1, data));
+    }
+
+    {
+        AsyncFile file(TestFilePath);
+        CheckThrows_(ReadAsync(file, fileSize - 32, 64, data));
+        CheckThrows_(ReadAsync(file, fileSize + 32, 1, data));
+    }
+}
+
+// Reads a 64 MB file that's already in the OS file cache: all at once, then as scattered ranges of a few
+// different sizes through File and AsyncFile. The ranges cover the whole file in a shuffled order.
+Benchmark_(FileReadThroughput)
+{
+    const uint64 fileSize = 64 * 1024 * 1024;
+    WriteTestFile(fileSize);
+
+    Array<uint8> buffer(fileSize);
+    const double mb = fileSize / (1024.0 * 1024.0);
+
+    {
+        // Read it once first, so that every run starts out cached
+        File file(TestFilePath, FileOpenMode::Read, FileAccessHint::Sequential);
+        file.Read(fileSize, buffer.Data());
+    }
+
+    {
+        Timer timer;
+        File file(TestFilePath, FileOpenMode::Read, FileAccessHint::Sequential);
+        file.Read(fileSize, buffer.Data());
+        timer.Update();
+        Tests::ReportBenchmarkResult("File::Read, whole file: %.1f MB/s", mb / timer.ElapsedSecondsD());
+    }
+
+    const uint64 rangeSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+    for(uint64 sizeIdx = 0; sizeIdx < ArraySize_(rangeSizes); ++sizeIdx)
+    {
+        const uint64 rangeSize = rangeSizes[sizeIdx];
+        const uint64 numRanges = fileSize / rangeSize;
+
+        Array<uint64> order(numRanges);
+        for(uint64 i = 0; i < numRanges; ++i)
+            order[i] = i;
+        std::shuffle(order.Data(), order.Data() + numRanges, std::mt19937_64(rangeSize));
+
+        Array<FileReadRange> ranges(numRanges);
+        for(uint64 i = 0; i < numRanges; ++i)
+        {
+            ranges[i].Offset = order[i] * rangeSize;
+            ranges[i].Size = rangeSize;
+            ranges[i].Data = buffer.Data() + order[i] * rangeSize;
+        }
+
+        {
+            buffer.Fill(0);
+            Timer timer;
+            File file(TestFilePath, FileOpenMode::Read, FileAccessHint::Random);
+            file.ReadRanges(ranges.Data(), numRanges);
+            timer.Update();
+            Tests::ReportBenchmarkResult("File::ReadRanges, %4llu KB ranges: %.1f MB/s", rangeSize / 1024,
+                                         mb / timer.ElapsedSecondsD());
+            Check_(MatchesFile(0, fileSize, buffer.Data()));
+        }
+
+        {
+            buffer.Fill(0);
+            Timer timer;
+            AsyncFile file(TestFilePath, FileAccessHint::Random);
+            file.ReadRanges(ranges.Data(), numRanges);
+            timer.Update();
+            Tests::ReportBenchmarkResult("AsyncFile::ReadRanges, %4llu KB ranges: %.1f MB/s", rangeSize / 1024,
+                                         mb / timer.ElapsedSecondsD());
+            Check_(MatchesFile(0, fileSize, buffer.Data()));
+        }
+    }
+}
@@ -0,0 +1,198 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <FileWatcher.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestDirectory = L"FileWatcherTests\\";
+
+static std::wstring TestFilePath(const wchar* fileName)
+{
+    return std::wstring(TestDirectory) + fileName;
+}
+
+static void WriteTestFile(const wchar* fileName, const char* contents, FileOpenMode openMode = FileOpenMode::Write)
+{
+    if(DirectoryExists(TestDirectory) == false)
+        Win32Call(CreateDirectory(TestDirectory, nullptr));
+
+    File file(TestFilePath(fileName).c_str(), openMode);
+    file.Write(strlen(contents), contents);
+}
+
+// Rewrites the file until its timestamp moves, since two writes can land within the same tick of the
+// file system's clock
+static void ChangeTestFile(const wchar* fileName, const char* contents)
+{
+    const std::wstring path = TestFilePath(fileName);
+    const uint64 timeStamp = GetFileTimestamp(path.c_str());
+    do
+    {
+        Sleep(1);
+        WriteTestFile(fileName, contents);
+    }
+    while(GetFileTimestamp(path.c_str()) == timeStamp);
+}
+
+static uint64 CountOf(const GrowableList<std::wstring>& files, const std::wstring& file)
+{
+    uint64 count = 0;
+    for(uint64 i = 0; i < files.Count(); ++i)
+        count += files[i] == file ? 1 : 0;
+    return count;
+}
+
+// A file that keeps changing is only reported once it's been left alone for the debounce time, and
+// then only once
+Test_(FileChangeQueueReportsBurstOnce)
+{
+    FileChangeQueue queue;
+    queue.Init(100);
+
+    for(uint64 t = 0; t < 100; t += 10)
+        queue.MarkChanged(L"Burst.hlsl", 1000 + t);
+    queue.MarkChanged(L"Other.hlsl", 1000);
+    Check_(queue.Count() == 2);
+
+    GrowableList<std::wstring> changedFiles;
+    queue.PopSettledFiles(1150, changedFiles);
+    Check_(changedFiles.Count() == 1);
+    Check_(CountOf(changedFiles, L"Other.hlsl") == 1);
+
+    queue.PopSettledFiles(1189, changedFiles);
+    Check_(CountOf(changedFiles, L"Burst.hlsl") == 0);
+
+    queue.PopSettledFiles(1190, changedFiles);
+    Check_(CountOf(changedFiles, L"Burst.hlsl") == 1);
+    Check_(queue.Count() == 0);
+
+    queue.PopSettledFiles(5000, changedFiles);
+    Check_(changedFiles.Count() == 2);
+
+    queue.Shutdown();
+}
+
+// Nothing settles before the debounce time is up, and with no debounce time changes come out right away
+Test_(FileChangeQueueSettlesAfterDebounce)
+{
+    const uint64 debounceTimes[] = { 0, 1, 50, DefaultFileChangeDebounceMS };
+    for(uint64 i = 0; i < ArraySize_(debounceTimes); ++i)
+    {
+        const uint64 debounceMS = debounceTimes[i];
+        FileChangeQueue queue;
+        queue.Init(debounceMS);
+        queue.MarkChanged(L"Settle.hlsl", 2000);
+
+        GrowableList<std::wstring> changedFiles;
+        if(debounceMS > 0)
+        {
+            queue.PopSettledFiles(2000, changedFiles);
+            queue.PopSettledFiles(2000 + debounceMS - 1, changedFiles);
+            Check_(changedFiles.Count() == 0);
+        }
+
+        queue.PopSettledFiles(2000 + debounceMS, changedFiles);
+        Check_(changedFiles.Count() == 1);
+        Check_(queue.Count() == 0);
+
+        queue.Shutdown();
+    }
+}
+
+// The polling watcher only checks a few files per call, but gets around to all of them, and reports
+// each change once
+Test_(PollingFileWatcherDetectsChanges)
+{
+    const wchar* fileNames[] = { L"PollA.txt", L"PollB.txt", L"PollC.txt" };
+    const uint64 numFiles = ArraySize_(fileNames);
+    for(uint64 i = 0; i < numFiles; ++i)
+        WriteTestFile(fileNames[i], "original");
+
+    PollingFileWatcher watcher(1, 0);
+    for(uint64 i = 0; i < numFiles; ++i)
+        watcher.AddFile(TestFilePath(fileNames[i]).c_str());
+
+    GrowableList<std::wstring> changedFiles;
+    for(uint64 i = 0; i < numFiles * 2; ++i)
+        watcher.GetChangedFiles(changedFiles);
+    Check_(changedFiles.Count() == 0);
+
+    for(uint64 changedIdx = 0; changedIdx < numFiles; ++changedIdx)
+    {
+        ChangeTestFile(fileNames[changedIdx], "changed");
+
+        // One file per call means it takes at most one pass over the files to get to it
+        changedFiles.RemoveAll();
+        for(uint64 i = 0; i < numFiles; ++i)
+            watcher.GetChangedFiles(changedFiles);
+        Check_(changedFiles.Count() == 1);
+        Check_(CountOf(changedFiles, TestFilePath(fileNames[changedIdx])) == 1);
+
+        for(uint64 i = 0; i < numFiles * 2; ++i)
+            watcher.GetChangedFiles(changedFiles);
+        Check_(changedFiles.Count() == 1);
+    }
+}
+
+// Saving a file with several writes in a row, like an editor does, comes out of the OS watcher as a
+// single change, no earlier than the debounce time after the last write
+Test_(DirectoryFileWatcherReportsBurstOnce)
+{
+    const uint64 debounceMS = 50;
+    WriteTestFile(L"Burst.txt", "original");
+    WriteTestFile(L"Untouched.txt", "original");
+
+    FileWatcher* watcher = CreateFileWatcher(debounceMS);
+    watcher->AddFile(TestFilePath(L"Burst.txt").c_str());
+    watcher->AddFile(TestFilePath(L"Untouched.txt").c_str());
+
+    GrowableList<std::wstring> changedFiles;
+    watcher->GetChangedFiles(changedFiles);
+    Check_(changedFiles.Count() == 0);
+
+    WriteTestFile(L"Burst.txt", "first ");
+    for(uint64 i = 0; i < 5; ++i)
+        WriteTestFile(L"Burst.txt", "more ", FileOpenMode::Append);
+    Timer timer;
+
+    // GetTickCount64 only moves every 10-16ms, which the watcher's idea of time can be off by
+    const double tickResolutionMS = 16.0;
+    double reportTimeMS = 0.0;
+    while(changedFiles.Count() == 0 && timer.ElapsedSecondsD() < 5.0)
+    {
+        Sleep(1);
+        watcher->GetChangedFiles(changedFiles);
+        timer.Update();
+        reportTimeMS = timer.ElapsedMillisecondsD();
+    }
+
+    // Keep going for a while to make sure that nothing else comes out of the burst
+    while(timer.ElapsedMillisecondsD() < reportTimeMS + debounceMS * 4)
+    {
+        Sleep(1);
+        watcher->GetChangedFiles(changedFiles);
+        timer.Update();
+    }
+
+    Check_(changedFiles.Count() == 1);
+    Check_(CountOf(changedFiles, TestFilePath(L"Burst.txt")) == 1);
+    Check_(reportTimeMS >= debounceMS - tickResolutionMS);
+
+    delete watcher;
+}
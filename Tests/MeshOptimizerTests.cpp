@@ -0,0 +1,225 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/MeshOptimizer.h>
+#include <Containers.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// Every vertex remembers where it started out, so that moved vertices can be tracked
+struct TestVertex
+{
+    Float3 Position;
+    uint32 ID = 0;
+};
+
+// A flat grid in the XZ plane, with clockwise triangles when viewed from above. The triangles are
+// emitted row by row, which is too wide for the cache to hold onto the previous row.
+static void MakeGrid(Array<TestVertex>& vertices, Array<uint32>& indices, uint32 numQuadsX, uint32 numQuadsZ)
+{
+    const uint32 numVerticesX = numQuadsX + 1;
+    vertices.Init(numVerticesX * (numQuadsZ + 1));
+    for(uint32 z = 0; z <= numQuadsZ; ++z)
+    {
+        for(uint32 x = 0; x <= numQuadsX; ++x)
+        {
+            TestVertex& vertex = vertices[z * numVerticesX + x];
+            vertex.Position = Float3(float(x), 0.0f, float(z));
+            vertex.ID = z * numVerticesX + x;
+        }
+    }
+
+    indices.Init(numQuadsX * numQuadsZ * 6);
+    uint32* index = indices.Data();
+    for(uint32 z = 0; z < numQuadsZ; ++z)
+    {
+        for(uint32 x = 0; x < numQuadsX; ++x)
+        {
+            const uint32 v0 = z * numVerticesX + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + numVerticesX;
+            const uint32 v3 = v2 + 1;
+            *index++ = v0; *index++ = v2; *index++ = v1;
+            *index++ = v1; *index++ = v2; *index++ = v3;
+        }
+    }
+}
+
+static void ShuffleTriangles(Array<uint32>& indices, uint32 seed)
+{
+    const uint64 numTriangles = indices.Size() / 3;
+    std::mt19937 random(seed);
+    for(uint64 i = numTriangles - 1; i > 0; --i)
+    {
+        const uint64 j = random() % (i + 1);
+        for(uint64 corner = 0; corner < 3; ++corner)
+            std::swap(indices[i * 3 + corner], indices[j * 3 + corner]);
+    }
+}
+
+// Triangles sorted by their vertices, after rotating each one to start at its smallest index so that
+// the winding is part of the comparison
+static void SortedTriangles(const Array<uint32>& indices, Array<uint64>& triangles)
+{
+    triangles.Init(indices.Size() / 3);
+    for(uint64 triIdx = 0; triIdx < triangles.Size(); ++triIdx)
+    {
+        const uint32* tri = &indices[triIdx * 3];
+        uint64 first = 0;
+        if(tri[1] < tri[first])
+            first = 1;
+        if(tri[2] < tri[first])
+            first = 2;
+        triangles[triIdx] = uint64(tri[first]) | (uint64(tri[(first + 1) % 3]) << 21) | (uint64(tri[(first + 2) % 3]) << 42);
+    }
+
+    std::sort(triangles.Data(), triangles.Data() + triangles.Size());
+}
+
+static bool SameTriangles(const Array<uint32>& a, const Array<uint32>& b)
+{
+    if(a.Size() != b.Size())
+        return false;
+
+    Array<uint64> trianglesA;
+    Array<uint64> trianglesB;
+    SortedTriangles(a, trianglesA);
+    SortedTriangles(b, trianglesB);
+    return memcmp(trianglesA.Data(), trianglesB.Data(), trianglesA.MemorySize()) == 0;
+}
+
+Test_(OptimizeVertexCacheLowersACMR)
+{
+    Array<TestVertex> vertices;
+    Array<uint32> gridIndices;
+    MakeGrid(vertices, gridIndices, 64, 64);
+    const uint64 numVertices = vertices.Size();
+
+    // Rows of 64 quads, and the same grid with its triangles shuffled
+    for(uint64 shuffle = 0; shuffle < 2; ++shuffle)
+    {
+        Array<uint32> indices = gridIndices;
+        if(shuffle)
+            ShuffleTriangles(indices, 20);
+
+        const VertexCacheStats before = AnalyzeVertexCache(indices.Data(), indices.Size(), numVertices);
+        Check_(before.NumTriangles == 64 * 64 * 2);
+        Check_(before.NumVertices == numVertices);
+
+        Array<uint32> optimized = indices;
+        OptimizeVertexCache(optimized.Data(), optimized.Size(), numVertices);
+        Check_(SameTriangles(indices, optimized));
+
+        // A regular grid can get down to ~0.5 with a big enough cache, and a 16 entry cache should get
+        // well under the ~1.0 that the rows give
+        const VertexCacheStats after = AnalyzeVertexCache(optimized.Data(), optimized.Size(), numVertices);
+        Check_(after.NumVertices == numVertices);
+        Check_(after.ACMR() < before.ACMR());
+        Check_(after.ACMR() < 0.75f);
+        Check_(after.ATVR() < 1.5f);
+
+        // Sorting for overdraw keeps the triangles, and stays within its default 5% of the optimized ACMR
+        Array<uint32> overdraw = optimized;
+        OptimizeOverdraw(overdraw.Data(), overdraw.Size(), &vertices[0].Position, sizeof(TestVertex), numVertices);
+        Check_(SameTriangles(indices, overdraw));
+        Check_(AnalyzeVertexCache(overdraw.Data(), overdraw.Size(), numVertices).ACMR() <= after.ACMR() * 1.05f);
+    }
+
+    // A cache that can hold a couple of rows makes the rows close to ideal already
+    const VertexCacheStats bigCache = AnalyzeVertexCache(gridIndices.Data(), gridIndices.Size(), numVertices, 256);
+    Check_(bigCache.ACMR() < 0.55f);
+    Check_(bigCache.ATVR() == 1.0f);
+
+    // With 2 entries, the last 2 vertices are still in the FIFO and the one before them isn't
+    const uint32 fifoIndices[] = { 0, 1, 2, 1, 2, 0 };
+    Check_(AnalyzeVertexCache(fifoIndices, ArraySize_(fifoIndices), 3, 2).NumTransforms == 4);
+
+    // Nothing to do for an empty list or a single triangle
+    uint32 triangle[3] = { 2, 0, 1 };
+    OptimizeVertexCache(triangle, 0, 3);
+    OptimizeVertexCache(triangle, 3, 3);
+    Check_(triangle[0] == 2 && triangle[1] == 0 && triangle[2] == 1);
+    Check_(AnalyzeVertexCache(triangle, 0, 3).ACMR() == 0.0f);
+}
+
+Test_(OptimizeVertexFetchPreservesTopology)
+{
+    Array<TestVertex> gridVertices;
+    Array<uint32> gridIndices;
+    MakeGrid(gridVertices, gridIndices, 32, 32);
+    ShuffleTriangles(gridIndices, 2020);
+
+    // Scatter the vertices, and leave a few of them out of the index list entirely
+    const uint64 numUnused = 7;
+    const uint64 numVertices = gridVertices.Size() + numUnused;
+    Array<TestVertex> vertices(numVertices);
+    Array<uint32> order(numVertices);
+    for(uint32 i = 0; i < numVertices; ++i)
+        order[i] = i;
+    std::shuffle(order.Data(), order.Data() + numVertices, std::mt19937(20));
+
+    Array<uint32> newIndexOf(numVertices);
+    for(uint32 i = 0; i < numVertices; ++i)
+    {
+        if(order[i] < gridVertices.Size())
+            vertices[i] = gridVertices[order[i]];
+        else
+            vertices[i].ID = order[i];
+        newIndexOf[order[i]] = i;
+    }
+
+    Array<uint32> indices(gridIndices.Size());
+    for(uint64 i = 0; i < indices.Size(); ++i)
+        indices[i] = newIndexOf[gridIndices[i]];
+
+    const VertexCacheStats before = AnalyzeVertexCache(indices.Data(), indices.Size(), numVertices);
+    OptimizeVertexFetch(vertices.Data(), sizeof(TestVertex), numVertices, indices.Data(), indices.Size());
+
+    // Same triangles with the same corners in the same order, just pointing at different slots
+    bool sameTopology = true;
+    for(uint64 i = 0; i < indices.Size(); ++i)
+        sameTopology = sameTopology && indices[i] < numVertices && vertices[indices[i]].ID == gridIndices[i];
+    Check_(sameTopology);
+
+    // Vertices are in the order that they're first used, with the unused ones at the back
+    bool firstUseOrder = true;
+    uint32 nextVertex = 0;
+    for(uint64 i = 0; i < indices.Size(); ++i)
+    {
+        if(indices[i] == nextVertex)
+            ++nextVertex;
+        else
+            firstUseOrder = firstUseOrder && indices[i] < nextVertex;
+    }
+    Check_(firstUseOrder);
+    Check_(nextVertex == gridVertices.Size());
+
+    // Every vertex is still there exactly once
+    Array<uint32> counts(numVertices, 0);
+    for(uint64 i = 0; i < numVertices; ++i)
+        ++counts[vertices[i].ID];
+    bool permutation = true;
+    for(uint64 i = 0; i < numVertices; ++i)
+        permutation = permutation && counts[i] == 1;
+    Check_(permutation);
+
+    bool unusedAtBack = true;
+    for(uint64 i = gridVertices.Size(); i < numVertices; ++i)
+        unusedAtBack = unusedAtBack && vertices[i].ID >= gridVertices.Size();
+    Check_(unusedAtBack);
+
+    // Moving vertices around doesn't change anything for the post-transform cache
+    const VertexCacheStats after = AnalyzeVertexCache(indices.Data(), indices.Size(), numVertices);
+    Check_(after.NumTransforms == before.NumTransforms);
+}
@@ -0,0 +1,424 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/Meshlets.h>
+#include <Containers.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// Positions are read with a stride, the same way that they're pulled out of MeshVertex
+struct TestVertex
+{
+    Float3 Position;
+    float Other[11] = { };
+};
+
+struct TestMesh
+{
+    GrowableList<TestVertex> Vertices;
+    GrowableList<uint32> Indices;
+
+    uint64 NumTriangles() const { return Indices.Count() / 3; }
+
+    void AddVertex(const Float3& position)
+    {
+        TestVertex vertex;
+        vertex.Position = position;
+        Vertices.Add(vertex);
+    }
+
+    void AddTriangle(uint32 a, uint32 b, uint32 c)
+    {
+        Indices.Add(a);
+        Indices.Add(b);
+        Indices.Add(c);
+    }
+
+    void BuildMeshlets(MeshletData& data) const
+    {
+        SampleFramework12::BuildMeshlets(&Vertices[0].Position, sizeof(TestVertex), Vertices.Count(),
+                                         Indices.Data(), Indices.Count(), data);
+    }
+};
+
+// A lumpy sphere with outward-facing triangles (clockwise from the outside), which gives the meshlets
+// normal cones that are narrow enough to cull with
+static void MakeSphere(TestMesh& mesh, uint32 numRings, uint32 numSegments)
+{
+    std::mt19937 random(19);
+    std::uniform_real_distribution<float> noise(0.98f, 1.02f);
+    for(uint32 ring = 0; ring <= numRings; ++ring)
+    {
+        for(uint32 segment = 0; segment < numSegments; ++segment)
+        {
+            const float theta = Pi * ring / numRings;
+            const float phi = 2.0f * Pi * segment / numSegments;
+            const Float3 dir(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            mesh.AddVertex(dir * noise(random));
+        }
+    }
+
+    for(uint32 ring = 0; ring < numRings; ++ring)
+    {
+        for(uint32 segment = 0; segment < numSegments; ++segment)
+        {
+            const uint32 a = ring * numSegments + segment;
+            const uint32 b = ring * numSegments + (segment + 1) % numSegments;
+            const uint32 c = (ring + 1) * numSegments + segment;
+            const uint32 d = (ring + 1) * numSegments + (segment + 1) % numSegments;
+            mesh.AddTriangle(a, b, c);
+            mesh.AddTriangle(b, d, c);
+        }
+    }
+}
+
+// Every triangle has its own 3 vertices, so meshlets fill up on vertices first
+static void MakeTriangleSoup(TestMesh& mesh, uint32 numTriangles)
+{
+    std::mt19937 random(1919);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    for(uint32 i = 0; i < numTriangles * 3; ++i)
+        mesh.AddVertex(Float3(position(random), position(random), position(random)));
+    for(uint32 i = 0; i < numTriangles; ++i)
+        mesh.AddTriangle(i * 3, i * 3 + 1, i * 3 + 2);
+}
+
+// Lots of triangles over fewer vertices than fit in a meshlet, so meshlets fill up on triangles first.
+// This also throws in some triangles that repeat a vertex.
+static void MakeDenseMesh(TestMesh& mesh, uint32 numVertices, uint32 numTriangles)
+{
+    std::mt19937 random(191919);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    for(uint32 i = 0; i < numVertices; ++i)
+        mesh.AddVertex(Float3(position(random), position(random), position(random)));
+    for(uint32 i = 0; i < numTriangles; ++i)
+    {
+        const uint32 a = random() % numVertices;
+        const uint32 b = i % 50 == 0 ? a : random() % numVertices;
+        mesh.AddTriangle(a, b, random() % numVertices);
+    }
+}
+
+static uint32 MeshletTriangleVertex(const MeshletData& data, const Meshlet& meshlet, uint32 triangleIdx, uint32 corner)
+{
+    const uint32 packedTriangle = data.Triangles[meshlet.TriangleStart + triangleIdx];
+    const uint32 localIdx = (packedTriangle >> (corner * 8)) & 0xFF;
+    return localIdx < meshlet.VertexCount ? data.Vertices[meshlet.VertexStart + localIdx] : uint32(-1);
+}
+
+static uint64 TriangleKey(uint32 a, uint32 b, uint32 c)
+{
+    return uint64(a) | (uint64(b) << 21) | (uint64(c) << 42);
+}
+
+static void CheckLimits(const MeshletData& data, uint64& maxVertexCount, uint64& maxTriangleCount)
+{
+    maxVertexCount = 0;
+    maxTriangleCount = 0;
+    bool withinLimits = true;
+    bool localIndicesValid = true;
+    bool verticesUnique = true;
+    uint32 nextVertexStart = 0;
+    uint32 nextTriangleStart = 0;
+    for(uint64 meshletIdx = 0; meshletIdx < data.Meshlets.Count(); ++meshletIdx)
+    {
+        const Meshlet& meshlet = data.Meshlets[meshletIdx];
+        withinLimits = withinLimits && meshlet.VertexCount <= MaxMeshletVertices && meshlet.TriangleCount <= MaxMeshletTriangles;
+        withinLimits = withinLimits && meshlet.VertexCount > 0 && meshlet.TriangleCount > 0;
+        maxVertexCount = Max<uint64>(maxVertexCount, meshlet.VertexCount);
+        maxTriangleCount = Max<uint64>(maxTriangleCount, meshlet.TriangleCount);
+
+        // Meshlets are packed back to back in the vertex and triangle lists
+        withinLimits = withinLimits && meshlet.VertexStart == nextVertexStart && meshlet.TriangleStart == nextTriangleStart;
+        nextVertexStart += meshlet.VertexCount;
+        nextTriangleStart += meshlet.TriangleCount;
+
+        for(uint32 triIdx = 0; triIdx < meshlet.TriangleCount; ++triIdx)
+        {
+            const uint32 packedTriangle = data.Triangles[meshlet.TriangleStart + triIdx];
+            localIndicesValid = localIndicesValid && (packedTriangle >> 24) == 0;
+            for(uint32 corner = 0; corner < 3; ++corner)
+                localIndicesValid = localIndicesValid && ((packedTriangle >> (corner * 8)) & 0xFF) < meshlet.VertexCount;
+        }
+
+        for(uint32 i = 0; i < meshlet.VertexCount; ++i)
+            for(uint32 j = i + 1; j < meshlet.VertexCount; ++j)
+                verticesUnique = verticesUnique && data.Vertices[meshlet.VertexStart + i] != data.Vertices[meshlet.VertexStart + j];
+    }
+
+    Check_(withinLimits);
+    Check_(localIndicesValid);
+    Check_(verticesUnique);
+    Check_(nextVertexStart == data.Vertices.Count());
+    Check_(nextTriangleStart == data.Triangles.Count());
+}
+
+static void CheckCoverage(const TestMesh& mesh, const MeshletData& data)
+{
+    // Counts go up for every triangle in the mesh, and back down for every triangle in a meshlet,
+    // with the winding kept as part of the key
+    HashMap<uint64, int64> counts;
+    for(uint64 triIdx = 0; triIdx < mesh.NumTriangles(); ++triIdx)
+    {
+        const uint32* triangle = &mesh.Indices[triIdx * 3];
+        const uint64 key = TriangleKey(triangle[0], triangle[1], triangle[2]);
+        int64* count = counts.Find(key);
+        if(count != nullptr)
+            ++(*count);
+        else
+            counts.Insert(key, 1);
+    }
+
+    uint64 numMeshletTriangles = 0;
+    bool allFound = true;
+    for(uint64 meshletIdx = 0; meshletIdx < data.Meshlets.Count(); ++meshletIdx)
+    {
+        const Meshlet& meshlet = data.Meshlets[meshletIdx];
+        for(uint32 triIdx = 0; triIdx < meshlet.TriangleCount; ++triIdx)
+        {
+            const uint64 key = TriangleKey(MeshletTriangleVertex(data, meshlet, triIdx, 0),
+                                           MeshletTriangleVertex(data, meshlet, triIdx, 1),
+                                           MeshletTriangleVertex(data, meshlet, triIdx, 2));
+            int64* count = counts.Find(key);
+            allFound = allFound && count != nullptr;
+            if(count != nullptr)
+                --(*count);
+            ++numMeshletTriangles;
+        }
+    }
+
+    Check_(allFound);
+    Check_(numMeshletTriangles == mesh.NumTriangles());
+
+    bool allZero = true;
+    for(uint64 triIdx = 0; triIdx < mesh.NumTriangles(); ++triIdx)
+    {
+        const uint32* triangle = &mesh.Indices[triIdx * 3];
+        allZero = allZero && *counts.Find(TriangleKey(triangle[0], triangle[1], triangle[2])) == 0;
+    }
+    Check_(allZero);
+}
+
+// The sphere has to contain every vertex, and the cone must never cull a meshlet from somewhere that
+// can see the front of any of its triangles. Returns how many of the sampled viewers were culled.
+static uint64 CheckBounds(const TestMesh& mesh, const MeshletData& data, float viewerRange)
+{
+    std::mt19937 random(1999);
+    std::uniform_real_distribution<float> viewerPosition(-viewerRange, viewerRange);
+    std::uniform_real_distribution<float> nearDistance(0.0f, 1.5f);
+
+    bool spheresContainVertices = true;
+    bool conesConservative = true;
+    uint64 numCulled = 0;
+    for(uint64 meshletIdx = 0; meshletIdx < data.Meshlets.Count(); ++meshletIdx)
+    {
+        const Meshlet& meshlet = data.Meshlets[meshletIdx];
+        for(uint32 i = 0; i < meshlet.VertexCount; ++i)
+        {
+            const Float3& position = mesh.Vertices[data.Vertices[meshlet.VertexStart + i]].Position;
+            spheresContainVertices = spheresContainVertices && Float3::Length(position - meshlet.SphereCenter) <= meshlet.SphereRadius;
+        }
+
+        // Half of the viewers are right up against the meshlet, where a cone apex that's too far forward
+        // would let triangles face them
+        for(uint64 viewerIdx = 0; viewerIdx < 128; ++viewerIdx)
+        {
+            Float3 viewer(viewerPosition(random), viewerPosition(random), viewerPosition(random));
+            if(viewerIdx % 2 == 1)
+                viewer = meshlet.SphereCenter + Float3::Normalize(viewer) * meshlet.SphereRadius * nearDistance(random);
+
+            const Float3 toApex = meshlet.ConeApex - viewer;
+            if(Float3::Length(toApex) <= 0.0f || Float3::Dot(Float3::Normalize(toApex), meshlet.ConeAxis) < meshlet.ConeCutoff)
+                continue;
+
+            ++numCulled;
+            for(uint32 triIdx = 0; triIdx < meshlet.TriangleCount; ++triIdx)
+            {
+                const Float3& p0 = mesh.Vertices[MeshletTriangleVertex(data, meshlet, triIdx, 0)].Position;
+                const Float3& p1 = mesh.Vertices[MeshletTriangleVertex(data, meshlet, triIdx, 1)].Position;
+                const Float3& p2 = mesh.Vertices[MeshletTriangleVertex(data, meshlet, triIdx, 2)].Position;
+                const Float3 normal = Float3::Cross(p1 - p0, p2 - p0);
+                conesConservative = conesConservative && Float3::Dot(normal, viewer - p0) <= 1e-5f * Float3::Length(normal);
+            }
+        }
+    }
+
+    Check_(spheresContainVertices);
+    Check_(conesConservative);
+    return numCulled;
+}
+
+// Meshes that run into the vertex limit, the triangle limit, and a mix of both
+Test_(MeshletsRespectLimits)
+{
+    uint64 maxVertexCount = 0;
+    uint64 maxTriangleCount = 0;
+
+    {
+        TestMesh mesh;
+        MakeTriangleSoup(mesh, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckLimits(data, maxVertexCount, maxTriangleCount);
+        Check_(maxVertexCount == 63);
+        Check_(data.Meshlets[0].TriangleCount == MaxMeshletVertices / 3);
+    }
+
+    {
+        TestMesh mesh;
+        MakeDenseMesh(mesh, 60, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckLimits(data, maxVertexCount, maxTriangleCount);
+        Check_(maxTriangleCount == MaxMeshletTriangles);
+        Check_(data.Meshlets.Count() == (1000 + MaxMeshletTriangles - 1) / MaxMeshletTriangles);
+    }
+
+    {
+        TestMesh mesh;
+        MakeSphere(mesh, 60, 120);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckLimits(data, maxVertexCount, maxTriangleCount);
+        Check_(maxVertexCount == MaxMeshletVertices);
+    }
+
+    // A triangle that repeats a vertex only needs one slot for it, so it still fits in a meshlet that has
+    // one slot left
+    {
+        TestMesh mesh;
+        MakeTriangleSoup(mesh, MaxMeshletVertices / 3);
+        mesh.AddVertex(Float3(0.0f, 0.0f, 0.0f));
+        mesh.AddTriangle(MaxMeshletVertices - 1, MaxMeshletVertices - 1, 0);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckLimits(data, maxVertexCount, maxTriangleCount);
+        Check_(data.Meshlets.Count() == 1);
+        Check_(data.Meshlets[0].VertexCount == MaxMeshletVertices);
+    }
+
+    // Meshlets get appended after whatever is already in the output
+    {
+        TestMesh mesh;
+        MakeDenseMesh(mesh, 60, 300);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        const uint64 numMeshlets = data.Meshlets.Count();
+        mesh.BuildMeshlets(data);
+        Check_(data.Meshlets.Count() == numMeshlets * 2);
+        Check_(data.Meshlets[numMeshlets].VertexStart == data.Meshlets[numMeshlets - 1].VertexStart + data.Meshlets[numMeshlets - 1].VertexCount);
+        Check_(data.Meshlets[numMeshlets].TriangleStart == data.Meshlets[numMeshlets - 1].TriangleStart + data.Meshlets[numMeshlets - 1].TriangleCount);
+    }
+
+    // Nothing in, nothing out
+    {
+        TestMesh mesh;
+        mesh.AddVertex(Float3(0.0f, 0.0f, 0.0f));
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        Check_(data.Meshlets.Count() == 0);
+    }
+}
+
+Test_(MeshletsCoverEveryTriangleOnce)
+{
+    {
+        TestMesh mesh;
+        MakeSphere(mesh, 60, 120);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckCoverage(mesh, data);
+    }
+
+    {
+        TestMesh mesh;
+        MakeTriangleSoup(mesh, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckCoverage(mesh, data);
+    }
+
+    {
+        TestMesh mesh;
+        MakeDenseMesh(mesh, 60, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckCoverage(mesh, data);
+    }
+
+    // Shuffled triangles spread every meshlet out over the whole mesh
+    {
+        TestMesh mesh;
+        MakeSphere(mesh, 30, 60);
+        Array<uint32> order(mesh.NumTriangles());
+        for(uint32 i = 0; i < order.Size(); ++i)
+            order[i] = i;
+        std::shuffle(order.Data(), order.Data() + order.Size(), std::mt19937(119));
+
+        TestMesh shuffled;
+        shuffled.Vertices = mesh.Vertices;
+        for(uint64 i = 0; i < order.Size(); ++i)
+            shuffled.AddTriangle(mesh.Indices[order[i] * 3], mesh.Indices[order[i] * 3 + 1], mesh.Indices[order[i] * 3 + 2]);
+
+        MeshletData data;
+        shuffled.BuildMeshlets(data);
+        CheckCoverage(shuffled, data);
+
+        uint64 maxVertexCount = 0;
+        uint64 maxTriangleCount = 0;
+        CheckLimits(data, maxVertexCount, maxTriangleCount);
+    }
+}
+
+Test_(MeshletBoundsContainVertices)
+{
+    {
+        TestMesh mesh;
+        MakeSphere(mesh, 60, 120);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+
+        // Plenty of the viewers around a sphere are behind some of its meshlets
+        Check_(CheckBounds(mesh, data, 3.0f) > 0);
+    }
+
+    {
+        TestMesh mesh;
+        MakeTriangleSoup(mesh, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckBounds(mesh, data, 20.0f);
+    }
+
+    {
+        TestMesh mesh;
+        MakeDenseMesh(mesh, 60, 1000);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        CheckBounds(mesh, data, 2.0f);
+    }
+
+    // A single point still gets a sphere around it
+    {
+        TestMesh mesh;
+        mesh.AddVertex(Float3(1.0f, 2.0f, 3.0f));
+        mesh.AddTriangle(0, 0, 0);
+        MeshletData data;
+        mesh.BuildMeshlets(data);
+        Check_(data.Meshlets.Count() == 1);
+        Check_(data.Meshlets[0].VertexCount == 1);
+        CheckBounds(mesh, data, 5.0f);
+        Check_(data.Meshlets[0].ConeCutoff == 1.0f);
+    }
+}
@@ -0,0 +1,400 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/Model.h>
+#include <Graphics/GraphicsTypes.h>
+#include <ChunkedFile.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Serialization.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// A Model only needs these from GraphicsTypes so that it can be constructed and destroyed. Nothing
+// here ever creates any GPU resources.
+namespace SampleFramework12
+{
+
+Buffer::Buffer() { }
+Buffer::~Buffer() { }
+StructuredBuffer::StructuredBuffer() { }
+StructuredBuffer::~StructuredBuffer() { }
+FormattedBuffer::FormattedBuffer() { }
+FormattedBuffer::~FormattedBuffer() { }
+LinearDescriptorHeap::~LinearDescriptorHeap() { }
+
+}
+
+static const wchar* LegacyFilePath = L"ModelDataTests.legacy";
+static const wchar* ChunkedFilePath = L"ModelDataTests.meshdata";
+static const wchar* ResavedFilePath = L"ModelDataTests.resaved.meshdata";
+
+// The older format that Model::Serialize() reads, written out field by field so that the test doesn't
+// depend on the code that it's checking
+struct LegacyMesh
+{
+    Array<MeshPart> Parts;
+    uint32 NumVertices = 0;
+    uint32 NumIndices = 0;
+    uint32 VertexOffset = 0;
+    uint32 IndexOffset = 0;
+    uint32 IndexType = 0;
+    Float3 AABBMin;
+    Float3 AABBMax;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        BulkSerializeItem(serializer, Parts);
+        SerializeItem(serializer, NumVertices);
+        SerializeItem(serializer, NumIndices);
+        SerializeItem(serializer, VertexOffset);
+        SerializeItem(serializer, IndexOffset);
+        SerializeItem(serializer, IndexType);
+        SerializeItem(serializer, AABBMin);
+        SerializeItem(serializer, AABBMax);
+    }
+};
+
+struct LegacyModel
+{
+    Array<LegacyMesh> Meshes;
+    Array<MeshMaterial> Materials;
+    Array<ModelSpotLight> SpotLights;
+    Array<PointLight> PointLights;
+    bool32 ForceSRGB = true;
+    Float3 AABBMin;
+    Float3 AABBMax;
+    Array<MeshVertex> Vertices;
+    Array<uint16> Indices;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, Meshes);
+        SerializeItem(serializer, Materials);
+        BulkSerializeItem(serializer, SpotLights);
+        BulkSerializeItem(serializer, PointLights);
+        SerializeItem(serializer, ForceSRGB);
+        SerializeItem(serializer, AABBMin);
+        SerializeItem(serializer, AABBMax);
+        BulkSerializeItem(serializer, Vertices);
+        BulkSerializeItem(serializer, Indices);
+    }
+};
+
+// Gets at the CPU-side data that Model keeps to itself, and cleans up without going through
+// Model::Shutdown() (which would also release GPU resources)
+class TestModel : public Model
+{
+public:
+
+    ~TestModel()
+    {
+        for(uint64 i = 0; i < meshes.Size(); ++i)
+            meshes[i].Shutdown();
+        meshes.Shutdown();
+    }
+
+    void LoadLegacy(const wchar* filePath)
+    {
+        MappedReadSerializer serializer(filePath);
+        Serialize(serializer);
+    }
+
+    void LoadChunked(const wchar* filePath)
+    {
+        LoadChunkedMeshData(filePath, nullptr);
+    }
+
+    void SaveLegacy(const wchar* filePath)
+    {
+        FileWriteSerializer serializer(filePath);
+        Serialize(serializer);
+        serializer.Flush();
+    }
+
+    Array<MeshVertex>& Vertices() { return vertices; }
+    Array<uint32>& Indices() { return indices; }
+};
+
+// Every vertex gets a unique UV, which identifies it after the optimizer has moved it around
+static MeshVertex MakeVertex(const Float3& position, uint32 id)
+{
+    return MeshVertex(position, Float3(0.0f, 1.0f, 0.0f), Float2(float(id), 0.0f), Float3(1.0f, 0.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f));
+}
+
+// A grid of quads with its triangles in a shuffled order, as its own mesh part
+static void AddGridPart(LegacyModel& model, GrowableList<MeshVertex>& vertices, GrowableList<uint16>& indices,
+                        LegacyMesh& mesh, uint32 materialIdx, uint32 gridSize, float height, uint32 seed)
+{
+    const uint32 vtxStart = uint32(vertices.Count()) - mesh.VertexOffset;
+    const uint32 idxStart = uint32(indices.Count()) - mesh.IndexOffset;
+    for(uint32 z = 0; z <= gridSize; ++z)
+        for(uint32 x = 0; x <= gridSize; ++x)
+            vertices.Add(MakeVertex(Float3(float(x), height, float(z)), uint32(vertices.Count())));
+
+    const uint32 numQuads = gridSize * gridSize;
+    Array<uint32> quadOrder(numQuads);
+    for(uint32 i = 0; i < numQuads; ++i)
+        quadOrder[i] = i;
+    std::shuffle(quadOrder.Data(), quadOrder.Data() + numQuads, std::mt19937(seed));
+
+    for(uint32 i = 0; i < numQuads; ++i)
+    {
+        const uint32 x = quadOrder[i] % gridSize;
+        const uint32 z = quadOrder[i] / gridSize;
+        const uint32 v0 = vtxStart + z * (gridSize + 1) + x;
+        const uint32 v1 = v0 + 1;
+        const uint32 v2 = v0 + gridSize + 1;
+        const uint32 v3 = v2 + 1;
+        const uint32 quad[6] = { v0, v2, v1, v1, v2, v3 };
+        for(uint32 corner = 0; corner < 6; ++corner)
+            indices.Add(uint16(quad[corner]));
+    }
+
+    MeshPart part;
+    part.VertexStart = vtxStart;
+    part.VertexCount = (gridSize + 1) * (gridSize + 1);
+    part.IndexStart = idxStart;
+    part.IndexCount = numQuads * 6;
+    part.MaterialIdx = materialIdx;
+
+    Array<MeshPart> parts(mesh.Parts.Size() + 1);
+    for(uint64 i = 0; i < mesh.Parts.Size(); ++i)
+        parts[i] = mesh.Parts[i];
+    parts[mesh.Parts.Size()] = part;
+    mesh.Parts = parts;
+
+    mesh.NumVertices = uint32(vertices.Count()) - mesh.VertexOffset;
+    mesh.NumIndices = uint32(indices.Count()) - mesh.IndexOffset;
+    mesh.AABBMax = Float3(float(gridSize), Max(mesh.AABBMax.y, height), float(gridSize));
+    model.AABBMax = Float3(Max(model.AABBMax.x, mesh.AABBMax.x), Max(model.AABBMax.y, mesh.AABBMax.y), Max(model.AABBMax.z, mesh.AABBMax.z));
+}
+
+// A merged mesh with two parts, and a second mesh that's too big for one meshlet per part
+static void MakeLegacyModel(LegacyModel& model)
+{
+    model.Materials.Init(2);
+    model.Materials[0].TextureNames[uint64(MaterialTextures::Albedo)] = L"Albedo.png";
+    model.Materials[1].TextureNames[uint64(MaterialTextures::Normal)] = L"Normal.png";
+
+    model.PointLights.Init(1);
+    model.PointLights[0].Position = Float3(1.0f, 2.0f, 3.0f);
+    model.PointLights[0].Intensity = Float3(4.0f, 5.0f, 6.0f);
+
+    GrowableList<MeshVertex> vertices;
+    GrowableList<uint16> indices;
+    model.Meshes.Init(2);
+
+    AddGridPart(model, vertices, indices, model.Meshes[0], 0, 12, 0.0f, 16);
+    AddGridPart(model, vertices, indices, model.Meshes[0], 1, 9, 1.0f, 1616);
+
+    model.Meshes[1].VertexOffset = uint32(vertices.Count());
+    model.Meshes[1].IndexOffset = uint32(indices.Count());
+    AddGridPart(model, vertices, indices, model.Meshes[1], 1, 40, 2.0f, 161616);
+
+    model.Vertices.Init(vertices.Count());
+    memcpy(model.Vertices.Data(), vertices.Data(), model.Vertices.MemorySize());
+    model.Indices.Init(indices.Count());
+    memcpy(model.Indices.Data(), indices.Data(), model.Indices.MemorySize());
+}
+
+// Triangles by the IDs of their vertices, rotated to start at the smallest one and sorted, so that
+// they can be compared no matter how the optimizer re-ordered the triangles and vertices
+static void GetMeshTriangles(const Array<MeshVertex>& vertices, uint64 vtxOffset, const uint32* indices,
+                             uint64 numIndices, Array<uint64>& triangles)
+{
+    triangles.Init(numIndices / 3);
+    for(uint64 triIdx = 0; triIdx < triangles.Size(); ++triIdx)
+    {
+        uint32 ids[3] = { };
+        for(uint64 corner = 0; corner < 3; ++corner)
+            ids[corner] = uint32(vertices[vtxOffset + indices[triIdx * 3 + corner]].UV.x);
+
+        uint64 first = 0;
+        if(ids[1] < ids[first])
+            first = 1;
+        if(ids[2] < ids[first])
+            first = 2;
+        triangles[triIdx] = uint64(ids[first]) | (uint64(ids[(first + 1) % 3]) << 21) | (uint64(ids[(first + 2) % 3]) << 42);
+    }
+
+    std::sort(triangles.Data(), triangles.Data() + triangles.Size());
+}
+
+template<typename T> static bool SameArrays(const Array<T>& a, const Array<T>& b)
+{
+    return a.Size() == b.Size() && (a.Size() == 0 || memcmp(a.Data(), b.Data(), a.MemorySize()) == 0);
+}
+
+static bool SameMeshlets(const Model& a, const Model& b)
+{
+    bool same = SameArrays(a.Meshlets(), b.Meshlets()) && SameArrays(a.MeshletVertices(), b.MeshletVertices());
+    same = same && SameArrays(a.MeshletTriangles(), b.MeshletTriangles()) && a.NumMeshes() == b.NumMeshes();
+    for(uint64 meshIdx = 0; same && meshIdx < a.NumMeshes(); ++meshIdx)
+        same = SameArrays(a.Meshes()[meshIdx].PartMeshlets(), b.Meshes()[meshIdx].PartMeshlets());
+    return same;
+}
+
+static bool SameMeshes(const Model& a, const Model& b)
+{
+    bool same = a.NumMeshes() == b.NumMeshes();
+    for(uint64 meshIdx = 0; same && meshIdx < a.NumMeshes(); ++meshIdx)
+    {
+        const Mesh& meshA = a.Meshes()[meshIdx];
+        const Mesh& meshB = b.Meshes()[meshIdx];
+        same = meshA.NumVertices() == meshB.NumVertices() && meshA.NumIndices() == meshB.NumIndices();
+        same = same && meshA.NumMeshParts() == meshB.NumMeshParts();
+        for(uint64 partIdx = 0; same && partIdx < meshA.NumMeshParts(); ++partIdx)
+            same = memcmp(&meshA.MeshParts()[partIdx], &meshB.MeshParts()[partIdx], sizeof(MeshPart)) == 0;
+    }
+
+    return same;
+}
+
+// Converts a file in the older format, and checks that loading the chunked file gives back exactly
+// what the conversion produced, which still has all of the original triangles
+Test_(ConvertedMeshDataRoundTrip)
+{
+    LegacyModel legacy;
+    MakeLegacyModel(legacy);
+    {
+        FileWriteSerializer serializer(LegacyFilePath);
+        SerializeItem(serializer, legacy);
+        serializer.Flush();
+    }
+
+    Model::ConvertMeshData(LegacyFilePath, ChunkedFilePath);
+    Check_(ChunkedFileReader::IsChunkedFile(ChunkedFilePath));
+    Check_(ChunkedFileReader::IsChunkedFile(LegacyFilePath) == false);
+
+    // The same steps as the conversion, done in memory
+    TestModel expected;
+    expected.LoadLegacy(LegacyFilePath);
+    expected.OptimizeMeshes();
+    expected.BuildMeshlets();
+
+    TestModel loaded;
+    loaded.LoadChunked(ChunkedFilePath);
+
+    Check_(SameArrays(loaded.Vertices(), expected.Vertices()));
+    Check_(SameArrays(loaded.Indices(), expected.Indices()));
+    Check_(SameMeshes(loaded, expected));
+    Check_(SameMeshlets(loaded, expected));
+    Check_(loaded.Meshlets().Size() > legacy.Meshes.Size());
+    Check_(loaded.MeshesOptimized());
+    Check_(loaded.OptimizedCacheStats().NumTransforms == expected.OptimizedCacheStats().NumTransforms);
+    Check_(loaded.OptimizedCacheStats().ACMR() < loaded.UnoptimizedCacheStats().ACMR());
+
+    // Everything that isn't vertices, indices or meshlets comes through as-is
+    Check_(loaded.Materials().Size() == 2);
+    Check_(loaded.Materials()[0].TextureNames[uint64(MaterialTextures::Albedo)] == L"Albedo.png");
+    Check_(loaded.Materials()[1].TextureNames[uint64(MaterialTextures::Normal)] == L"Normal.png");
+    Check_(loaded.PointLights().Size() == 1 && loaded.SpotLights().Size() == 0);
+    Check_(loaded.PointLights().Size() == 1 && memcmp(&loaded.PointLights()[0], &legacy.PointLights[0], sizeof(PointLight)) == 0);
+    Check_(loaded.AABBMax().y == 2.0f && loaded.AABBMax().x == 40.0f);
+
+    // Each mesh still has all of its original triangles with the same winding, even though both the
+    // triangles and the vertices have been re-ordered
+    bool sameTriangles = loaded.NumMeshes() == legacy.Meshes.Size();
+    uint64 vtxOffset = 0;
+    uint64 idxOffset = 0;
+    for(uint64 meshIdx = 0; sameTriangles && meshIdx < legacy.Meshes.Size(); ++meshIdx)
+    {
+        const LegacyMesh& legacyMesh = legacy.Meshes[meshIdx];
+        Array<uint32> legacyIndices(legacyMesh.NumIndices);
+        for(uint64 i = 0; i < legacyIndices.Size(); ++i)
+            legacyIndices[i] = legacy.Indices[legacyMesh.IndexOffset + i];
+
+        Array<uint64> legacyTriangles;
+        Array<uint64> loadedTriangles;
+        GetMeshTriangles(legacy.Vertices, legacyMesh.VertexOffset, legacyIndices.Data(), legacyIndices.Size(), legacyTriangles);
+        GetMeshTriangles(loaded.Vertices(), vtxOffset, loaded.Indices().Data() + idxOffset, loaded.Meshes()[meshIdx].NumIndices(), loadedTriangles);
+        sameTriangles = sameTriangles && SameArrays(legacyTriangles, loadedTriangles);
+
+        vtxOffset += loaded.Meshes()[meshIdx].NumVertices();
+        idxOffset += loaded.Meshes()[meshIdx].NumIndices();
+    }
+    Check_(sameTriangles);
+
+    // Meshlet vertices are relative to the whole model, and their triangles have to match the index
+    // buffer's triangles in the same order. This bails out before reading past anything that's missing.
+    bool meshletsMatch = true;
+    vtxOffset = 0;
+    idxOffset = 0;
+    for(uint64 meshIdx = 0; meshletsMatch && meshIdx < loaded.NumMeshes(); ++meshIdx)
+    {
+        const Mesh& mesh = loaded.Meshes()[meshIdx];
+        meshletsMatch = mesh.PartMeshlets().Size() == mesh.NumMeshParts();
+        for(uint64 partIdx = 0; meshletsMatch && partIdx < mesh.NumMeshParts(); ++partIdx)
+        {
+            const MeshPart& part = mesh.MeshParts()[partIdx];
+            const MeshletRange& range = mesh.PartMeshlets()[partIdx];
+            uint64 partIdxPos = idxOffset + part.IndexStart;
+            meshletsMatch = uint64(range.MeshletStart) + range.MeshletCount <= loaded.Meshlets().Size();
+            for(uint32 meshletIdx = range.MeshletStart; meshletsMatch && meshletIdx < range.MeshletStart + range.MeshletCount; ++meshletIdx)
+            {
+                const Meshlet& meshlet = loaded.Meshlets()[meshletIdx];
+                meshletsMatch = uint64(meshlet.TriangleStart) + meshlet.TriangleCount <= loaded.MeshletTriangles().Size();
+                for(uint32 triIdx = 0; meshletsMatch && triIdx < meshlet.TriangleCount; ++triIdx)
+                {
+                    const uint32 packedTriangle = loaded.MeshletTriangles()[meshlet.TriangleStart + triIdx];
+                    for(uint32 corner = 0; corner < 3; ++corner)
+                    {
+                        const uint32 localIdx = (packedTriangle >> (corner * 8)) & 0xFF;
+                        meshletsMatch = meshletsMatch && meshlet.VertexStart + localIdx < loaded.MeshletVertices().Size();
+                        meshletsMatch = meshletsMatch && partIdxPos < idxOffset + part.IndexStart + part.IndexCount;
+                        meshletsMatch = meshletsMatch && loaded.MeshletVertices()[meshlet.VertexStart + localIdx] == vtxOffset + loaded.Indices()[partIdxPos++];
+                    }
+                }
+            }
+            meshletsMatch = meshletsMatch && partIdxPos == idxOffset + part.IndexStart + part.IndexCount;
+        }
+
+        vtxOffset += mesh.NumVertices();
+        idxOffset += mesh.NumIndices();
+    }
+    Check_(meshletsMatch);
+}
+
+// Indices above 0xFFFF only fit in the chunked format, and have to come back as-is when it's re-saved.
+// The older format refuses to write them instead of cutting them down to 16 bits.
+Test_(ChunkedMeshDataKeeps32BitIndices)
+{
+    LegacyModel legacy;
+    MakeLegacyModel(legacy);
+    {
+        FileWriteSerializer serializer(LegacyFilePath);
+        SerializeItem(serializer, legacy);
+        serializer.Flush();
+    }
+
+    Model::ConvertMeshData(LegacyFilePath, ChunkedFilePath);
+
+    TestModel model;
+    model.LoadChunked(ChunkedFilePath);
+    const uint64 lastIdx = model.Indices().Size() - 1;
+    model.Indices()[lastIdx] = 0x12345;
+    model.SaveMeshData(ResavedFilePath);
+    CheckThrows_(model.SaveLegacy(LegacyFilePath));
+
+    TestModel resaved;
+    resaved.LoadChunked(ResavedFilePath);
+    Check_(SameArrays(resaved.Indices(), model.Indices()));
+    Check_(resaved.Indices().Size() == model.Indices().Size() && resaved.Indices()[lastIdx] == 0x12345);
+    Check_(SameArrays(resaved.Vertices(), model.Vertices()));
+    Check_(SameMeshes(resaved, model));
+    Check_(SameMeshlets(resaved, model));
+    Check_(resaved.MeshesOptimized());
+}
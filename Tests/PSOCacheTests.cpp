@@ -0,0 +1,377 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/PSOCache.h>
+#include <Graphics/DX12.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <InterfacePointers.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static uint64 NumDeferredReleases = 0;
+
+// The PSO cache only needs these two from the DX12 module. Nothing is ever in flight on the GPU
+// here, so deferred releases happen right away.
+namespace SampleFramework12
+{
+
+namespace DX12
+{
+
+ID3D12Device* Device = nullptr;
+
+void DeferredRelease_(IUnknown* resource)
+{
+    ++NumDeferredReleases;
+    resource->Release();
+}
+
+}
+
+}
+
+static const char TestShaderSource[] =
+    "float4 VS(in uint VertexID : SV_VertexID) : SV_Position { return float4(VertexID, 0.0f, 0.0f, 1.0f); }\n"
+    "float4 PS() : SV_Target0 { return 1.0f; }\n"
+    "float4 OtherPS() : SV_Target0 { return 0.5f; }\n"
+    "[numthreads(64, 1, 1)] void CS() { }\n";
+
+// Everything that a test needs to create PSOs. WARP works without a GPU, and the cache doesn't care
+// what kind of device it's using.
+struct TestPipeline
+{
+    ID3DBlobPtr VS;
+    ID3DBlobPtr PS;
+    ID3DBlobPtr OtherPS;
+    ID3DBlobPtr CS;
+    ID3D12RootSignature* RootSignature = nullptr;
+    ID3D12RootSignature* OtherRootSignature = nullptr;
+
+    TestPipeline()
+    {
+        IDXGIFactory4Ptr factory;
+        DXCall(CreateDXGIFactory1(IID_PPV_ARGS(&factory)));
+        IDXGIAdapterPtr warpAdapter;
+        DXCall(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
+        DXCall(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&DX12::Device)));
+
+        VS = CompileTestShader("VS", "vs_5_0");
+        PS = CompileTestShader("PS", "ps_5_0");
+        OtherPS = CompileTestShader("OtherPS", "ps_5_0");
+        CS = CompileTestShader("CS", "cs_5_0");
+        RootSignature = CreateTestRootSignature();
+        OtherRootSignature = CreateTestRootSignature();
+    }
+
+    ~TestPipeline()
+    {
+        DX12::Shutdown_PSOCache();
+        DX12::Release(RootSignature);
+        DX12::Release(OtherRootSignature);
+        DX12::Release(DX12::Device);
+    }
+
+    static ID3DBlobPtr CompileTestShader(const char* functionName, const char* profile)
+    {
+        ID3DBlobPtr byteCode;
+        ID3DBlobPtr errors;
+        DXCall(D3DCompile(TestShaderSource, ArraySize_(TestShaderSource) - 1, "TestShader", nullptr, nullptr,
+                          functionName, profile, 0, 0, &byteCode, &errors));
+        return byteCode;
+    }
+
+    static ID3D12RootSignature* CreateTestRootSignature()
+    {
+        D3D12_ROOT_SIGNATURE_DESC desc = { };
+        desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+        ID3DBlobPtr signature;
+        ID3DBlobPtr errors;
+        DXCall(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &errors));
+
+        ID3D12RootSignature* rootSignature = nullptr;
+        DXCall(DX12::Device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                                 IID_PPV_ARGS(&rootSignature)));
+        return rootSignature;
+    }
+
+    static D3D12_SHADER_BYTECODE ByteCode(ID3DBlob* blob)
+    {
+        D3D12_SHADER_BYTECODE byteCode = { };
+        byteCode.pShaderBytecode = blob->GetBufferPointer();
+        byteCode.BytecodeLength = blob->GetBufferSize();
+        return byteCode;
+    }
+
+    // Sets every field one at a time, so that whatever was in the padding between them stays there
+    void FillGraphicsDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint8 padding,
+                          const D3D12_INPUT_ELEMENT_DESC* inputElements, uint32 numInputElements) const
+    {
+        memset(&desc, padding, sizeof(desc));
+
+        desc.pRootSignature = RootSignature;
+        desc.VS = ByteCode(VS.Get());
+        desc.PS = ByteCode(PS.Get());
+        desc.DS.pShaderBytecode = desc.HS.pShaderBytecode = desc.GS.pShaderBytecode = nullptr;
+        desc.DS.BytecodeLength = desc.HS.BytecodeLength = desc.GS.BytecodeLength = 0;
+
+        desc.StreamOutput.pSODeclaration = nullptr;
+        desc.StreamOutput.NumEntries = 0;
+        desc.StreamOutput.pBufferStrides = nullptr;
+        desc.StreamOutput.NumStrides = 0;
+        desc.StreamOutput.RasterizedStream = 0;
+
+        desc.BlendState.AlphaToCoverageEnable = false;
+        desc.BlendState.IndependentBlendEnable = false;
+        for(uint64 i = 0; i < ArraySize_(desc.BlendState.RenderTarget); ++i)
+        {
+            D3D12_RENDER_TARGET_BLEND_DESC& rtBlend = desc.BlendState.RenderTarget[i];
+            rtBlend.BlendEnable = false;
+            rtBlend.LogicOpEnable = false;
+            rtBlend.SrcBlend = D3D12_BLEND_ONE;
+            rtBlend.DestBlend = D3D12_BLEND_ZERO;
+            rtBlend.BlendOp = D3D12_BLEND_OP_ADD;
+            rtBlend.SrcBlendAlpha = D3D12_BLEND_ONE;
+            rtBlend.DestBlendAlpha = D3D12_BLEND_ZERO;
+            rtBlend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+            rtBlend.LogicOp = D3D12_LOGIC_OP_NOOP;
+            rtBlend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        }
+
+        desc.SampleMask = UINT_MAX;
+
+        desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+        desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+        desc.RasterizerState.FrontCounterClockwise = false;
+        desc.RasterizerState.DepthBias = 0;
+        desc.RasterizerState.DepthBiasClamp = 0.0f;
+        desc.RasterizerState.SlopeScaledDepthBias = 0.0f;
+        desc.RasterizerState.DepthClipEnable = true;
+        desc.RasterizerState.MultisampleEnable = false;
+        desc.RasterizerState.AntialiasedLineEnable = false;
+        desc.RasterizerState.ForcedSampleCount = 0;
+        desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+        desc.DepthStencilState.DepthEnable = false;
+        desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+        desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+        desc.DepthStencilState.StencilEnable = false;
+        desc.DepthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+        desc.DepthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+        D3D12_DEPTH_STENCILOP_DESC* stencilOps[] = { &desc.DepthStencilState.FrontFace, &desc.DepthStencilState.BackFace };
+        for(uint64 i = 0; i < ArraySize_(stencilOps); ++i)
+        {
+            stencilOps[i]->StencilFailOp = D3D12_STENCIL_OP_KEEP;
+            stencilOps[i]->StencilDepthFailOp = D3D12_STENCIL_OP_KEEP;
+            stencilOps[i]->StencilPassOp = D3D12_STENCIL_OP_KEEP;
+            stencilOps[i]->StencilFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+        }
+
+        desc.InputLayout.pInputElementDescs = inputElements;
+        desc.InputLayout.NumElements = numInputElements;
+        desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+        desc.NumRenderTargets = 2;
+        for(uint64 i = 0; i < ArraySize_(desc.RTVFormats); ++i)
+            desc.RTVFormats[i] = DXGI_FORMAT_UNKNOWN;
+        desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.RTVFormats[1] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        desc.DSVFormat = DXGI_FORMAT_UNKNOWN;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.NodeMask = 0;
+        desc.CachedPSO.pCachedBlob = nullptr;
+        desc.CachedPSO.CachedBlobSizeInBytes = 0;
+        desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC ComputeDesc() const
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = { };
+        desc.pRootSignature = RootSignature;
+        desc.CS = ByteCode(CS.Get());
+        return desc;
+    }
+};
+
+static const D3D12_INPUT_ELEMENT_DESC TestInputElements[] =
+{
+    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
+static ULONG RefCount(IUnknown* object)
+{
+    object->AddRef();
+    return object->Release();
+}
+
+// Descriptions that only differ in their padding, or that point at separate copies of the same
+// byte code and input layout, are the same PSO
+Test_(PSOCacheSharesEqualDescs)
+{
+    TestPipeline pipeline;
+    const DX12::PSOCacheStats startStats = DX12::GetPSOCacheStats();
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC zeroedDesc;
+    pipeline.FillGraphicsDesc(zeroedDesc, 0x00, TestInputElements, ArraySize_(TestInputElements));
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC paddedDesc;
+    pipeline.FillGraphicsDesc(paddedDesc, 0xCD, TestInputElements, ArraySize_(TestInputElements));
+    Check_(DX12::HashPSODesc(zeroedDesc) == DX12::HashPSODesc(paddedDesc));
+
+    ID3D12PipelineState* pso = DX12::CreateGraphicsPSO(zeroedDesc);
+    ID3D12PipelineState* paddedPSO = DX12::CreateGraphicsPSO(paddedDesc);
+    Check_(pso == paddedPSO);
+
+    Array<uint8> psCopy(pipeline.PS->GetBufferSize());
+    memcpy(psCopy.Data(), pipeline.PS->GetBufferPointer(), psCopy.Size());
+    D3D12_INPUT_ELEMENT_DESC inputElementsCopy[ArraySize_(TestInputElements)];
+    memcpy(inputElementsCopy, TestInputElements, sizeof(TestInputElements));
+    std::string semanticNames[ArraySize_(TestInputElements)];
+    for(uint64 i = 0; i < ArraySize_(TestInputElements); ++i)
+    {
+        semanticNames[i] = TestInputElements[i].SemanticName;
+        inputElementsCopy[i].SemanticName = semanticNames[i].c_str();
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC copiedDesc;
+    pipeline.FillGraphicsDesc(copiedDesc, 0x00, inputElementsCopy, ArraySize_(inputElementsCopy));
+    copiedDesc.PS.pShaderBytecode = psCopy.Data();
+    ID3D12PipelineState* copiedPSO = DX12::CreateGraphicsPSO(copiedDesc);
+    Check_(copiedPSO == pso);
+
+    const DX12::PSOCacheStats stats = DX12::GetPSOCacheStats();
+    Check_(stats.NumPSOs == startStats.NumPSOs + 1);
+    Check_(stats.NumRequests == startStats.NumRequests + 3);
+    Check_(stats.NumSharedRequests == startStats.NumSharedRequests + 2);
+
+    DX12::Release(pso);
+    DX12::Release(paddedPSO);
+    DX12::Release(copiedPSO);
+}
+
+// Changing any one part of the description makes a different PSO, including swapping two values
+// around between fields
+Test_(PSOCacheKeysOnEveryField)
+{
+    TestPipeline pipeline;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC baseDesc;
+    pipeline.FillGraphicsDesc(baseDesc, 0x00, TestInputElements, ArraySize_(TestInputElements));
+
+    D3D12_INPUT_ELEMENT_DESC renamedElements[ArraySize_(TestInputElements)];
+    memcpy(renamedElements, TestInputElements, sizeof(TestInputElements));
+    renamedElements[1].SemanticName = "COLOR";
+
+    const uint64 numVariations = 8;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC descs[numVariations];
+    for(uint64 i = 0; i < numVariations; ++i)
+        pipeline.FillGraphicsDesc(descs[i], 0x00, TestInputElements, ArraySize_(TestInputElements));
+    descs[1].PS = TestPipeline::ByteCode(pipeline.OtherPS.Get());
+    descs[2].pRootSignature = pipeline.OtherRootSignature;
+    descs[3].RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+    descs[4].BlendState.RenderTarget[1].BlendEnable = true;
+    descs[5].InputLayout.pInputElementDescs = renamedElements;
+    std::swap(descs[6].RTVFormats[0], descs[6].RTVFormats[1]);
+    descs[7].DepthStencilState.BackFace.StencilFunc = D3D12_COMPARISON_FUNC_NEVER;
+
+    Hash hashes[numVariations];
+    for(uint64 i = 0; i < numVariations; ++i)
+    {
+        hashes[i] = DX12::HashPSODesc(descs[i]);
+        for(uint64 j = 0; j < i; ++j)
+            Check_((hashes[i] == hashes[j]) == false);
+    }
+
+    const DX12::PSOCacheStats startStats = DX12::GetPSOCacheStats();
+    ID3D12PipelineState* psos[numVariations] = { };
+    for(uint64 i = 0; i < numVariations; ++i)
+        psos[i] = DX12::CreateGraphicsPSO(descs[i]);
+    Check_(DX12::GetPSOCacheStats().NumPSOs == startStats.NumPSOs + numVariations);
+    Check_(DX12::GetPSOCacheStats().NumSharedRequests == startStats.NumSharedRequests);
+
+    for(uint64 i = 0; i < numVariations; ++i)
+        DX12::Release(psos[i]);
+}
+
+Test_(PSOCacheSharesComputePSOs)
+{
+    TestPipeline pipeline;
+    const DX12::PSOCacheStats startStats = DX12::GetPSOCacheStats();
+
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC desc = pipeline.ComputeDesc();
+    ID3D12PipelineState* pso = DX12::CreateComputePSO(desc);
+    ID3D12PipelineState* sharedPSO = DX12::CreateComputePSO(desc);
+    Check_(pso == sharedPSO);
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC otherDesc = pipeline.ComputeDesc();
+    otherDesc.pRootSignature = pipeline.OtherRootSignature;
+    Check_((DX12::HashPSODesc(otherDesc) == DX12::HashPSODesc(desc)) == false);
+    ID3D12PipelineState* otherPSO = DX12::CreateComputePSO(otherDesc);
+    Check_(otherPSO != pso);
+
+    const DX12::PSOCacheStats stats = DX12::GetPSOCacheStats();
+    Check_(stats.NumPSOs == startStats.NumPSOs + 2);
+    Check_(stats.NumSharedRequests == startStats.NumSharedRequests + 1);
+
+    DX12::Release(pso);
+    DX12::Release(sharedPSO);
+    DX12::Release(otherPSO);
+}
+
+// Entries hold on to their root signature, so that its address can't be reused while it's part of a
+// key. A purge only drops what wasn't requested since the previous one, and leaves the PSOs alive
+// for anyone that's still using them.
+Test_(PSOCachePurgesUnrequestedPSOs)
+{
+    TestPipeline pipeline;
+
+    const ULONG startRootSignatureRefs = RefCount(pipeline.RootSignature);
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC desc = pipeline.ComputeDesc();
+    ID3D12PipelineState* pso = DX12::CreateComputePSO(desc);
+    const ULONG rootSignatureRefs = RefCount(pipeline.RootSignature);
+    Check_(rootSignatureRefs > startRootSignatureRefs);
+    const ULONG psoRefs = RefCount(pso);
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc;
+    pipeline.FillGraphicsDesc(graphicsDesc, 0x00, TestInputElements, ArraySize_(TestInputElements));
+    graphicsDesc.pRootSignature = pipeline.OtherRootSignature;
+    ID3D12PipelineState* graphicsPSO = DX12::CreateGraphicsPSO(graphicsDesc);
+
+    // Both were requested since the last purge
+    const uint64 startReleases = NumDeferredReleases;
+    DX12::PurgePSOCache();
+    Check_(NumDeferredReleases == startReleases);
+    Check_(DX12::GetPSOCacheStats().NumPSOs == 2);
+
+    // Only the graphics PSO gets requested again
+    ID3D12PipelineState* requestedPSO = DX12::CreateGraphicsPSO(graphicsDesc);
+    Check_(requestedPSO == graphicsPSO);
+    DX12::PurgePSOCache();
+    Check_(NumDeferredReleases == startReleases + 2);
+    Check_(DX12::GetPSOCacheStats().NumPSOs == 1);
+    Check_(RefCount(pso) == psoRefs - 1);
+    Check_(RefCount(pipeline.RootSignature) == rootSignatureRefs - 1);
+
+    // Requesting it again makes a new entry
+    ID3D12PipelineState* recreatedPSO = DX12::CreateComputePSO(desc);
+    Check_(DX12::GetPSOCacheStats().NumPSOs == 2);
+
+    DX12::Release(pso);
+    DX12::Release(graphicsPSO);
+    DX12::Release(requestedPSO);
+    DX12::Release(recreatedPSO);
+}
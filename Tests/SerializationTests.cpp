@@ -0,0 +1,206 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Serialization.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestFilePath = L"SerializationTests.bin";
+
+// Laid out like MeshVertex, without needing the math library
+struct TestVertex
+{
+    float Position[3];
+    float Normal[3];
+    float UV[2];
+    float Tangent[3];
+    float Bitangent[3];
+};
+
+// Goes one float at a time, the same way that SerializeItem() handles the vector types
+template<typename TSerializer> void SerializeItem(TSerializer& serializer, TestVertex& vertex)
+{
+    SerializeArray(serializer, vertex.Position, ArraySize_(vertex.Position));
+    SerializeArray(serializer, vertex.Normal, ArraySize_(vertex.Normal));
+    SerializeArray(serializer, vertex.UV, ArraySize_(vertex.UV));
+    SerializeArray(serializer, vertex.Tangent, ArraySize_(vertex.Tangent));
+    SerializeArray(serializer, vertex.Bitangent, ArraySize_(vertex.Bitangent));
+}
+
+static void MakeTestVertices(Array<TestVertex>& vertices, uint64 numVertices)
+{
+    vertices.Init(numVertices);
+    for(uint64 i = 0; i < numVertices; ++i)
+    {
+        float* floats = reinterpret_cast<float*>(&vertices[i]);
+        for(uint64 j = 0; j < sizeof(TestVertex) / sizeof(float); ++j)
+            floats[j] = float(i * 16 + j);
+    }
+}
+
+// The file holds the vertices twice: once serialized one item at a time, and once as a bulk array
+static void WriteTestFile(Array<TestVertex>& vertices, uint64 bufferSize)
+{
+    FileWriteSerializer serializer(TestFilePath, bufferSize);
+    SerializeItem(serializer, vertices);
+    BulkSerializeItem(serializer, vertices);
+    serializer.Flush();
+}
+
+template<typename TSerializer> static void CheckReadBack(TSerializer& serializer, const Array<TestVertex>& vertices)
+{
+    Array<TestVertex> itemVertices;
+    SerializeItem(serializer, itemVertices);
+    Array<TestVertex> bulkVertices;
+    BulkSerializeItem(serializer, bulkVertices);
+
+    Check_(itemVertices.Size() == vertices.Size());
+    Check_(bulkVertices.Size() == vertices.Size());
+    if(itemVertices.Size() == vertices.Size())
+        Check_(memcmp(itemVertices.Data(), vertices.Data(), vertices.MemorySize()) == 0);
+    if(bulkVertices.Size() == vertices.Size())
+        Check_(memcmp(bulkVertices.Data(), vertices.Data(), vertices.MemorySize()) == 0);
+}
+
+// Small buffers get flushed over and over, and anything bigger than the buffer is written straight
+// through, with both ending up in the file in order
+Test_(SerializersReadBackWhatWasWritten)
+{
+    Array<TestVertex> vertices;
+    MakeTestVertices(vertices, 1000);
+
+    const uint64 bufferSizes[] = { 1, sizeof(TestVertex) - 4, 4096, 1024 * 1024 };
+    for(uint64 i = 0; i < ArraySize_(bufferSizes); ++i)
+    {
+        WriteTestFile(vertices, bufferSizes[i]);
+
+        {
+            FileReadSerializer serializer(TestFilePath);
+            CheckReadBack(serializer, vertices);
+        }
+
+        {
+            MappedReadSerializer serializer(TestFilePath);
+            CheckReadBack(serializer, vertices);
+            Check_(serializer.Offset() == serializer.Size());
+        }
+    }
+}
+
+// Referenced data points into the mapping instead of getting copied, and reads can't go past the end
+Test_(MappedReadSerializerReferencesData)
+{
+    Array<TestVertex> vertices;
+    MakeTestVertices(vertices, 1000);
+    WriteTestFile(vertices, 4096);
+
+    MappedReadSerializer serializer(TestFilePath);
+    Array<TestVertex> itemVertices;
+    SerializeItem(serializer, itemVertices);
+
+    uint64 numVertices = 0;
+    SerializeItem(serializer, numVertices);
+    Check_(numVertices == vertices.Size());
+    const void* referenced = serializer.ReferenceData(vertices.MemorySize());
+    Check_(memcmp(referenced, vertices.Data(), vertices.MemorySize()) == 0);
+    Check_(serializer.Offset() == serializer.Size());
+
+    uint8 pastEnd = 0;
+    CheckThrows_(SerializeItem(serializer, pastEnd));
+    CheckThrows_(serializer.ReferenceData(1));
+}
+
+// Reads a multi-million vertex mesh blob through each serializer, one item at a time and in bulk.
+// Item-by-item reads through a File make a ReadFile call per float, so they only read the first part
+// of the mesh to keep the run short.
+Benchmark_(SerializationReadThroughput)
+{
+    const uint64 numVertices = 2 * 1024 * 1024;
+    const uint64 numFileItemVertices = numVertices / 16;
+
+    Array<TestVertex> vertices;
+    MakeTestVertices(vertices, numVertices);
+
+    {
+        Timer timer;
+        FileWriteSerializer serializer(TestFilePath);
+        SerializeArray(serializer, vertices.Data(), vertices.Size());
+        serializer.Flush();
+        timer.Update();
+
+        const double mb = vertices.MemorySize() / (1024.0 * 1024.0);
+        Tests::ReportBenchmarkResult("FileWriteSerializer, per item: %.1f MB/s", mb / timer.ElapsedSecondsD());
+    }
+
+    Array<TestVertex> readVertices(numVertices);
+    auto reportRead = [&](const char* name, uint64 numRead, const Timer& timer)
+    {
+        const double mb = numRead * sizeof(TestVertex) / (1024.0 * 1024.0);
+        Tests::ReportBenchmarkResult("%s: %.1f MB/s (%llu vertices)", name, mb / timer.ElapsedSecondsD(), numRead);
+        Check_(memcmp(readVertices.Data(), vertices.Data(), numRead * sizeof(TestVertex)) == 0);
+        readVertices.Fill(TestVertex());
+    };
+
+    {
+        Timer timer;
+        FileReadSerializer serializer(TestFilePath);
+        SerializeArray(serializer, readVertices.Data(), numFileItemVertices);
+        timer.Update();
+        reportRead("FileReadSerializer, per item", numFileItemVertices, timer);
+    }
+
+    {
+        Timer timer;
+        FileReadSerializer serializer(TestFilePath);
+        BulkSerializeArray(serializer, readVertices.Data(), numVertices);
+        timer.Update();
+        reportRead("FileReadSerializer, bulk", numVertices, timer);
+    }
+
+    {
+        Timer timer;
+        MappedReadSerializer serializer(TestFilePath);
+        SerializeArray(serializer, readVertices.Data(), numVertices);
+        timer.Update();
+        reportRead("MappedReadSerializer, per item", numVertices, timer);
+    }
+
+    {
+        Timer timer;
+        MappedReadSerializer serializer(TestFilePath);
+        BulkSerializeArray(serializer, readVertices.Data(), numVertices);
+        timer.Update();
+        reportRead("MappedReadSerializer, bulk", numVertices, timer);
+    }
+
+    {
+        // Referencing skips the copy, but the pages still have to be faulted in by whoever uses them
+        Timer timer;
+        MappedReadSerializer serializer(TestFilePath);
+        const float* floats = reinterpret_cast<const float*>(serializer.ReferenceData(vertices.MemorySize()));
+        float sum = 0.0f;
+        for(uint64 i = 0; i < vertices.MemorySize() / sizeof(float); i += 1024)
+            sum += floats[i];
+        timer.Update();
+
+        const double mb = vertices.MemorySize() / (1024.0 * 1024.0);
+        Tests::ReportBenchmarkResult("MappedReadSerializer, referenced: %.1f MB/s (%llu vertices)",
+                                     mb / timer.ElapsedSecondsD(), numVertices);
+        Check_(sum > 0.0f);
+    }
+}
@@ -0,0 +1,361 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/ShaderCacheArchive.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestDirectory = L"ShaderCacheArchiveTests\\";
+
+// Every test starts from an empty directory
+static void ResetTestDirectory()
+{
+    if(DirectoryExists(TestDirectory) == false)
+        Win32Call(CreateDirectory(TestDirectory, nullptr));
+
+    const wchar* fileNames[] = { L"ShaderCache.pack", L"ShaderCache.index" };
+    for(uint64 i = 0; i < ArraySize_(fileNames); ++i)
+    {
+        const std::wstring path = std::wstring(TestDirectory) + fileNames[i];
+        if(FileExists(path.c_str()))
+            Win32Call(DeleteFile(path.c_str()));
+    }
+}
+
+static Hash TestKey(uint64 idx)
+{
+    return GenerateHash(&idx, sizeof(idx), 0x5CA);
+}
+
+static Array<uint8> MakeRecordData(uint64 idx, uint64 size)
+{
+    Array<uint8> data(size);
+    for(uint64 i = 0; i < data.Size(); ++i)
+        data[i] = uint8((i + idx * 31) * 2654435761ull >> 13);
+    return data;
+}
+
+// Each record's data is different, and has a different size
+static Array<uint8> TestData(uint64 idx)
+{
+    return MakeRecordData(idx, 64 + idx * 13);
+}
+
+static void AddTestRecord(ShaderCacheArchive& archive, uint64 idx)
+{
+    const Array<uint8> data = TestData(idx);
+    archive.Add(TestKey(idx), data.Data(), data.Size());
+}
+
+static bool HasTestRecord(const ShaderCacheArchive& archive, uint64 idx)
+{
+    const Array<uint8> data = TestData(idx);
+    uint64 size = 0;
+    const uint8* found = archive.Find(TestKey(idx), size);
+    return found != nullptr && size == data.Size() && memcmp(found, data.Data(), size) == 0;
+}
+
+static std::string ReadPack()
+{
+    return ReadFileAsString((std::wstring(TestDirectory) + L"ShaderCache.pack").c_str());
+}
+
+Test_(ShaderCacheArchiveFindAddCompact)
+{
+    ResetTestDirectory();
+
+    ShaderCacheArchive archive;
+    archive.Open(TestDirectory);
+    Check_(archive.NumRecords() == 0);
+
+    uint64 size = 0;
+    Check_(archive.Find(TestKey(0), size) == nullptr);
+
+    const uint64 numRecords = 8;
+    for(uint64 i = 0; i < numRecords; ++i)
+        AddTestRecord(archive, i);
+    Check_(archive.NumRecords() == numRecords);
+    for(uint64 i = 0; i < numRecords; ++i)
+        Check_(HasTestRecord(archive, i));
+
+    // Adding a key that's already there keeps the data that was added first
+    const uint64 packSize = archive.PackSize();
+    const Array<uint8> otherData = TestData(numRecords);
+    archive.Add(TestKey(2), otherData.Data(), otherData.Size());
+    Check_(archive.NumRecords() == numRecords);
+    Check_(archive.PackSize() == packSize);
+    Check_(HasTestRecord(archive, 2));
+
+    // Everything is found through the index after reopening, and new records are found alongside it
+    archive.Close();
+    archive.Open(TestDirectory);
+    Check_(archive.NumRecords() == numRecords);
+    for(uint64 i = 0; i < numRecords; ++i)
+        Check_(HasTestRecord(archive, i));
+    Check_(archive.Find(TestKey(numRecords), size) == nullptr);
+
+    AddTestRecord(archive, numRecords);
+    Check_(HasTestRecord(archive, numRecords));
+    Check_(archive.NumRecords() == numRecords + 1);
+
+    // Keys that aren't in the archive, or that show up more than once, don't end up in the new pack
+    const Hash liveKeys[] = { TestKey(1), TestKey(4), TestKey(numRecords), TestKey(numRecords + 1), TestKey(4) };
+    archive.Compact(liveKeys, ArraySize_(liveKeys));
+    Check_(archive.NumRecords() == 3);
+    Check_(archive.PackSize() < packSize);
+    Check_(HasTestRecord(archive, 1));
+    Check_(HasTestRecord(archive, 4));
+    Check_(HasTestRecord(archive, numRecords));
+    Check_(archive.Find(TestKey(0), size) == nullptr);
+    Check_(archive.Find(TestKey(numRecords + 1), size) == nullptr);
+
+    archive.Close();
+    archive.Open(TestDirectory);
+    Check_(archive.NumRecords() == 3);
+    Check_(HasTestRecord(archive, 1));
+    Check_(HasTestRecord(archive, 4));
+    Check_(HasTestRecord(archive, numRecords));
+}
+
+// A process that goes away while appending leaves the last record cut off. Everything in front of it
+// is still found, with or without an index, and new records go after it.
+Test_(ShaderCacheArchiveTruncatedRecord)
+{
+    const uint64 numRecords = 4;
+    const uint64 lastDataSize = TestData(numRecords - 1).Size();
+
+    // Cut off the end of the data, or part of the way into the record header
+    const uint64 cutSizes[] = { 1, lastDataSize + 8 };
+    for(uint64 cutIdx = 0; cutIdx < ArraySize_(cutSizes); ++cutIdx)
+    {
+        for(uint64 keepIndex = 0; keepIndex < 2; ++keepIndex)
+        {
+            ResetTestDirectory();
+
+            {
+                ShaderCacheArchive archive;
+                archive.Open(TestDirectory);
+                for(uint64 i = 0; i < numRecords; ++i)
+                    AddTestRecord(archive, i);
+            }
+
+            if(keepIndex == 0)
+                Win32Call(DeleteFile((std::wstring(TestDirectory) + L"ShaderCache.index").c_str()));
+
+            const std::string pack = ReadPack();
+            WriteStringAsFile((std::wstring(TestDirectory) + L"ShaderCache.pack").c_str(),
+                              pack.substr(0, pack.length() - cutSizes[cutIdx]));
+
+            ShaderCacheArchive archive;
+            archive.Open(TestDirectory);
+            Check_(archive.NumRecords() == numRecords - 1);
+            for(uint64 i = 0; i < numRecords - 1; ++i)
+                Check_(HasTestRecord(archive, i));
+            uint64 size = 0;
+            Check_(archive.Find(TestKey(numRecords - 1), size) == nullptr);
+
+            AddTestRecord(archive, numRecords - 1);
+            AddTestRecord(archive, numRecords);
+            Check_(HasTestRecord(archive, numRecords - 1));
+            Check_(HasTestRecord(archive, numRecords));
+
+            archive.Close();
+            archive.Open(TestDirectory);
+            Check_(archive.NumRecords() == numRecords + 1);
+            for(uint64 i = 0; i <= numRecords; ++i)
+                Check_(HasTestRecord(archive, i));
+        }
+    }
+}
+
+// Two processes running the same sample end up with two archives open on the same directory, which
+// both append to the pack and both rewrite the index when they're closed
+Test_(ShaderCacheArchiveSharedDirectory)
+{
+    ResetTestDirectory();
+
+    {
+        ShaderCacheArchive seed;
+        seed.Open(TestDirectory);
+        AddTestRecord(seed, 0);
+    }
+
+    ShaderCacheArchive first;
+    ShaderCacheArchive second;
+    first.Open(TestDirectory);
+    second.Open(TestDirectory);
+    Check_(HasTestRecord(first, 0));
+    Check_(HasTestRecord(second, 0));
+
+    AddTestRecord(first, 1);
+    AddTestRecord(second, 2);
+    AddTestRecord(first, 3);
+    Check_(HasTestRecord(first, 1));
+    Check_(HasTestRecord(second, 2));
+
+    // Both of these replace the index while the other one still has it mapped
+    first.Close();
+    second.Close();
+
+    ShaderCacheArchive reopened;
+    reopened.Open(TestDirectory);
+    Check_(reopened.NumRecords() == 4);
+    for(uint64 i = 0; i < 4; ++i)
+        Check_(HasTestRecord(reopened, i));
+
+    // Opening an archive that already has the pack mapped elsewhere doesn't need to replace anything
+    ShaderCacheArchive another;
+    another.Open(TestDirectory);
+    Check_(another.NumRecords() == 4);
+}
+
+Test_(ShaderCacheArchiveCompactWhileShared)
+{
+    ResetTestDirectory();
+
+    ShaderCacheArchive first;
+    ShaderCacheArchive second;
+    first.Open(TestDirectory);
+    second.Open(TestDirectory);
+    for(uint64 i = 0; i < 4; ++i)
+        AddTestRecord(first, i);
+
+    const Hash liveKeys[] = { TestKey(1), TestKey(3) };
+    first.Compact(liveKeys, ArraySize_(liveKeys));
+    Check_(first.NumRecords() == 2);
+    Check_(HasTestRecord(first, 1));
+    Check_(HasTestRecord(first, 3));
+    Check_(HasTestRecord(first, 0) == false);
+
+    // The other archive keeps working with the pack it already had. It can't write an index for it
+    // any more, and skips that instead of throwing.
+    AddTestRecord(second, 4);
+    Check_(HasTestRecord(second, 4));
+    second.Close();
+    first.Close();
+
+    ShaderCacheArchive reopened;
+    reopened.Open(TestDirectory);
+    Check_(reopened.NumRecords() == 2);
+    Check_(HasTestRecord(reopened, 1));
+    Check_(HasTestRecord(reopened, 3));
+}
+
+// Compares the archive against the one-file-per-shader layout that it replaced, where every shader was
+// written to its own file (through a temporary file that's moved into place) and looked up with a
+// FileExists() followed by opening and reading the file. The files were just written, so the reads are
+// from the OS file cache for both of them.
+Benchmark_(ShaderCacheArchiveVsLooseFiles)
+{
+    const std::wstring looseDirectory = std::wstring(TestDirectory) + L"Loose\\";
+    if(DirectoryExists(TestDirectory) == false)
+        Win32Call(CreateDirectory(TestDirectory, nullptr));
+    if(DirectoryExists(looseDirectory.c_str()) == false)
+        Win32Call(CreateDirectory(looseDirectory.c_str(), nullptr));
+
+    const uint64 numShaderCounts[] = { 500, 2000 };
+    for(uint64 countIdx = 0; countIdx < ArraySize_(numShaderCounts); ++countIdx)
+    {
+        const uint64 numShaders = numShaderCounts[countIdx];
+
+        // Compressed shaders are mostly a few KB
+        Array<Array<uint8>> shaders(numShaders);
+        Array<std::wstring> loosePaths(numShaders);
+        for(uint64 i = 0; i < numShaders; ++i)
+        {
+            shaders[i] = MakeRecordData(i, 2048 + (i * 2654435761ull) % 6144);
+            loosePaths[i] = looseDirectory + TestKey(i).ToString() + L".cache";
+        }
+
+        auto checksum = [](const uint8* data, uint64 size)
+        {
+            return data[0] + data[size / 2] + data[size - 1] + size;
+        };
+
+        uint64 expectedChecksum = 0;
+        for(uint64 i = 0; i < numShaders; ++i)
+            expectedChecksum += checksum(shaders[i].Data(), shaders[i].Size());
+
+        {
+            Timer timer;
+            for(uint64 i = 0; i < numShaders; ++i)
+            {
+                const std::wstring tempPath = loosePaths[i] + L".tmp";
+                {
+                    File file(tempPath.c_str(), FileOpenMode::Write);
+                    file.Write(shaders[i].Size(), shaders[i].Data());
+                }
+                Win32Call(MoveFileEx(tempPath.c_str(), loosePaths[i].c_str(), MOVEFILE_REPLACE_EXISTING));
+            }
+            timer.Update();
+            const double writeMS = timer.ElapsedMillisecondsD();
+
+            uint64 readChecksum = 0;
+            for(uint64 i = 0; i < numShaders; ++i)
+            {
+                if(FileExists(loosePaths[i].c_str()) == false)
+                    continue;
+
+                File file(loosePaths[i].c_str(), FileOpenMode::Read);
+                Array<uint8> data(file.Size());
+                file.Read(data.Size(), data.Data());
+                readChecksum += checksum(data.Data(), data.Size());
+            }
+            timer.Update();
+            const double readMS = timer.ElapsedMillisecondsD() - writeMS;
+
+            Tests::ReportBenchmarkResult("%llu shaders, one file per shader: %.2f ms to add, %.2f ms to read",
+                                         numShaders, writeMS, readMS);
+            Check_(readChecksum == expectedChecksum);
+
+            for(uint64 i = 0; i < numShaders; ++i)
+                Win32Call(DeleteFile(loosePaths[i].c_str()));
+        }
+
+        {
+            ResetTestDirectory();
+
+            // Adding includes closing the archive, which writes the index. Reading includes opening it.
+            Timer timer;
+            {
+                ShaderCacheArchive archive;
+                archive.Open(TestDirectory);
+                for(uint64 i = 0; i < numShaders; ++i)
+                    archive.Add(TestKey(i), shaders[i].Data(), shaders[i].Size());
+            }
+            timer.Update();
+            const double writeMS = timer.ElapsedMillisecondsD();
+
+            uint64 readChecksum = 0;
+            ShaderCacheArchive archive;
+            archive.Open(TestDirectory);
+            for(uint64 i = 0; i < numShaders; ++i)
+            {
+                uint64 size = 0;
+                const uint8* data = archive.Find(TestKey(i), size);
+                if(data != nullptr)
+                    readChecksum += checksum(data, size);
+            }
+            timer.Update();
+            const double readMS = timer.ElapsedMillisecondsD() - writeMS;
+
+            Tests::ReportBenchmarkResult("%llu shaders, archive: %.2f ms to add, %.2f ms to read (%.2f MB pack)",
+                                         numShaders, writeMS, readMS, archive.PackSize() / (1024.0 * 1024.0));
+            Check_(readChecksum == expectedChecksum);
+        }
+    }
+}
@@ -0,0 +1,357 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/ShaderCompilation.h>
+#include <EnkiTS/TaskScheduler.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <InterfacePointers.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestDirectory = L"ShaderCompilationTests\\";
+static const uint64 TestByteCodeSize = 256;
+
+static std::wstring TestShaderPath(const wchar* fileName)
+{
+    return std::wstring(TestDirectory) + fileName;
+}
+
+static void WriteTestShader(const wchar* fileName, const char* contents)
+{
+    if(DirectoryExists(TestDirectory) == false)
+        Win32Call(CreateDirectory(TestDirectory, nullptr));
+
+    File file(TestShaderPath(fileName).c_str(), FileOpenMode::Write);
+    file.Write(strlen(contents), contents);
+}
+
+// Stands in for FXC. The byte code only depends on the function name and the USED define, like a
+// shader that never looks at any of its other defines.
+class TestShaderCompiler : public ShaderCompiler
+{
+
+public:
+
+    virtual HRESULT Compile(const wchar*, const void*, uint64, ID3DInclude*, const D3D_SHADER_MACRO* defines,
+                            const char* functionName, const char*, uint32, ID3DBlob** byteCode,
+                            ID3DBlob**) override
+    {
+        std::string output = functionName;
+        for(const D3D_SHADER_MACRO* define = defines; define->Name != nullptr; ++define)
+        {
+            if(strcmp(define->Name, "USED") == 0)
+                output += define->Definition;
+        }
+        output.resize(TestByteCodeSize, '.');
+
+        HRESULT hr = D3DCreateBlob(output.size(), byteCode);
+        if(SUCCEEDED(hr))
+            memcpy((*byteCode)->GetBufferPointer(), output.data(), output.size());
+        return hr;
+    }
+};
+
+// Permutations that compile to the same byte code share one blob, and the store empties out along
+// with the last shader that uses it
+Test_(ByteCodeStoreSharesIdenticalByteCode)
+{
+    WriteTestShader(L"Store.hlsl", "float4 PS() : SV_Target0 { return USED; }\n");
+    const std::wstring path = TestShaderPath(L"Store.hlsl");
+
+    TestShaderCompiler compiler;
+    SetShaderCompiler(&compiler);
+
+    const uint64 numPermutations = 8;
+    ShaderPermutation permutations[numPermutations];
+    for(uint64 i = 0; i < numPermutations; ++i)
+    {
+        permutations[i].FilePath = path.c_str();
+        permutations[i].FunctionName = "PS";
+        permutations[i].CompileOpts.Add("USED", uint32(i % 2));
+        permutations[i].CompileOpts.Add("UNUSED", uint32(i));
+    }
+
+    PendingShader results[numPermutations];
+    CompileShaders(permutations, numPermutations, results);
+
+    CompiledShaderPtr shaders[numPermutations];
+    for(uint64 i = 0; i < numPermutations; ++i)
+        shaders[i] = results[i].Wait();
+
+    Check_(shaders[0]->ByteCode.Get() != shaders[1]->ByteCode.Get());
+    for(uint64 i = 2; i < numPermutations; ++i)
+    {
+        Check_(shaders[i].Valid() && shaders[i - 2].Valid());
+        Check_(shaders[i]->ByteCode.Get() == shaders[i - 2]->ByteCode.Get());
+        Check_(shaders[i]->ByteCodeHash == shaders[i - 2]->ByteCodeHash);
+    }
+
+    ShaderCacheStats stats = GetShaderCacheStats();
+    Check_(stats.NumUniqueByteCodes == 2);
+    Check_(stats.NumSharedByteCodes == numPermutations - 2);
+    Check_(stats.ByteCodeBytesSaved == (numPermutations - 2) * TestByteCodeSize);
+
+    // Stored byte code has its hash looked up, and a copy of it has to hash to the same value
+    for(uint64 i = 0; i < numPermutations; ++i)
+        Check_(GetByteCodeHash(shaders[i].ByteCode()) == shaders[i]->ByteCodeHash);
+
+    const D3D12_SHADER_BYTECODE storedByteCode = shaders[1].ByteCode();
+    Array<uint8> byteCodeCopy(storedByteCode.BytecodeLength);
+    memcpy(byteCodeCopy.Data(), storedByteCode.pShaderBytecode, byteCodeCopy.Size());
+    D3D12_SHADER_BYTECODE copiedByteCode = { };
+    copiedByteCode.pShaderBytecode = byteCodeCopy.Data();
+    copiedByteCode.BytecodeLength = byteCodeCopy.Size();
+    Check_(GetByteCodeHash(copiedByteCode) == shaders[1]->ByteCodeHash);
+
+    ShutdownShaders();
+    SetShaderCompiler(nullptr);
+
+    stats = GetShaderCacheStats();
+    Check_(stats.NumUniqueByteCodes == 0);
+    Check_(stats.NumSharedByteCodes == 0);
+    Check_(stats.ByteCodeBytesSaved == 0);
+}
+
+// Compiles with FXC, but with a COMPILER_ID define of its own added to the shader's defines, so that
+// byte code from different compilers can be told apart. It counts how often it actually gets invoked,
+// and can be held up to keep jobs from finishing.
+class CountingShaderCompiler : public ShaderCompiler
+{
+
+public:
+
+    const char* Name = nullptr;
+    uint32 ID = 0;
+    std::atomic<uint64> NumCompiles;
+    std::atomic<bool> Blocked;
+
+    CountingShaderCompiler(const char* name, uint32 id) : Name(name), ID(id), NumCompiles(0), Blocked(false)
+    {
+    }
+
+    virtual HRESULT Compile(const wchar* path, const void* source, uint64 sourceSize, ID3DInclude* include,
+                            const D3D_SHADER_MACRO* defines, const char* functionName, const char* profile,
+                            uint32 flags, ID3DBlob** byteCode, ID3DBlob** errorMessages) override
+    {
+        ++NumCompiles;
+        while(Blocked)
+            Sleep(1);
+
+        const std::string idString = ToAnsiString(ID);
+        D3D_SHADER_MACRO compilerDefines[CompileOptions::MaxDefines + 2] = { };
+        uint64 numDefines = 0;
+        for(; defines[numDefines].Name != nullptr; ++numDefines)
+            compilerDefines[numDefines] = defines[numDefines];
+        compilerDefines[numDefines].Name = "COMPILER_ID";
+        compilerDefines[numDefines].Definition = idString.c_str();
+
+        return D3DCompile(source, sourceSize, WStringToAnsi(path).c_str(), compilerDefines, include,
+                          functionName, profile, flags, 0, byteCode, errorMessages);
+    }
+
+    virtual const char* CacheName() const override
+    {
+        return Name;
+    }
+};
+
+static const char* CountingShaderSource = "float4 PS() : SV_Target0 { return float4(VALUE, COMPILER_ID, 0.0f, 1.0f); }\n";
+
+// The cache archive outlives the test run, so every run gets a source file that the archive hasn't seen
+static void WriteUniqueTestShader(const wchar* fileName)
+{
+    LARGE_INTEGER counter = { };
+    QueryPerformanceCounter(&counter);
+    const std::string source = std::string("// ") + ToAnsiString(uint64(counter.QuadPart)) + "\n" + CountingShaderSource;
+    WriteTestShader(fileName, source.c_str());
+}
+
+static void MakeTestPermutations(ShaderPermutation* permutations, uint64 numPermutations, const wchar* path)
+{
+    for(uint64 i = 0; i < numPermutations; ++i)
+    {
+        permutations[i].FilePath = path;
+        permutations[i].FunctionName = "PS";
+        permutations[i].CompileOpts.Add("VALUE", uint32(i));
+    }
+}
+
+static void WaitForAll(const PendingShader* results, CompiledShaderPtr* shaders, uint64 numShaders)
+{
+    for(uint64 i = 0; i < numShaders; ++i)
+    {
+        Check_(results[i].Valid());
+        shaders[i] = results[i].Wait();
+        Check_(shaders[i].Valid());
+    }
+}
+
+static bool SameByteCode(const CompiledShaderPtr& a, const CompiledShaderPtr& b)
+{
+    const D3D12_SHADER_BYTECODE aByteCode = a.ByteCode();
+    const D3D12_SHADER_BYTECODE bByteCode = b.ByteCode();
+    return aByteCode.BytecodeLength == bByteCode.BytecodeLength &&
+           memcmp(aByteCode.pShaderBytecode, bByteCode.pShaderBytecode, aByteCode.BytecodeLength) == 0;
+}
+
+// Permutations in a batch that end up with the same cache key share one job and one shader, and
+// only get compiled once
+Test_(CompileShadersDeduplicatesPermutations)
+{
+    WriteUniqueTestShader(L"Dedup.hlsl");
+    const std::wstring path = TestShaderPath(L"Dedup.hlsl");
+
+    CountingShaderCompiler compiler("TestCompiler", 1);
+    SetShaderCompiler(&compiler);
+    const ShaderCacheStats startStats = GetShaderCacheStats();
+
+    const uint64 numPermutations = 6;
+    ShaderPermutation permutations[numPermutations];
+    MakeTestPermutations(permutations, 3, path.c_str());
+    MakeTestPermutations(permutations + 3, 3, path.c_str());
+
+    PendingShader results[numPermutations];
+    CompileShaders(permutations, numPermutations, results);
+    CompiledShaderPtr shaders[numPermutations];
+    WaitForAll(results, shaders, numPermutations);
+
+    Check_(compiler.NumCompiles == 3);
+    for(uint64 i = 0; i < 3; ++i)
+        Check_(&*shaders[i] == &*shaders[i + 3]);
+    Check_(SameByteCode(shaders[0], shaders[1]) == false);
+
+    const ShaderCacheStats stats = GetShaderCacheStats();
+    Check_(stats.NumDuplicatePermutations == startStats.NumDuplicatePermutations + 3);
+    Check_(stats.NumCacheMisses == startStats.NumCacheMisses + 3);
+    Check_(stats.NumCacheHits == startStats.NumCacheHits);
+
+    ShutdownShaders();
+    SetShaderCompiler(nullptr);
+}
+
+// The compiler is part of the cache key: switching compilers misses the cache instead of loading the
+// other compiler's byte code, and switching back hits the entries that were cached the first time
+Test_(CompileShadersCachesPerCompiler)
+{
+    WriteUniqueTestShader(L"PerCompiler.hlsl");
+    const std::wstring path = TestShaderPath(L"PerCompiler.hlsl");
+
+    const uint64 numPermutations = 4;
+    ShaderPermutation permutations[numPermutations];
+    MakeTestPermutations(permutations, numPermutations, path.c_str());
+
+    CountingShaderCompiler compilerA("TestCompilerA", 1);
+    CountingShaderCompiler compilerB("TestCompilerB", 2);
+
+    // Each pass starts from scratch, like a new run of the app, so that byte code can only come from
+    // the compiler or the archive
+    auto compilePass = [&](CountingShaderCompiler& compiler, uint64 expectedCompiles, Array<uint8>* byteCodes)
+    {
+        SetShaderCompiler(&compiler);
+        const ShaderCacheStats startStats = GetShaderCacheStats();
+        const uint64 startCompiles = compiler.NumCompiles;
+
+        PendingShader results[numPermutations];
+        CompileShaders(permutations, numPermutations, results);
+        CompiledShaderPtr shaders[numPermutations];
+        WaitForAll(results, shaders, numPermutations);
+
+        const ShaderCacheStats stats = GetShaderCacheStats();
+        Check_(compiler.NumCompiles - startCompiles == expectedCompiles);
+        Check_(stats.NumCacheMisses - startStats.NumCacheMisses == expectedCompiles);
+        Check_(stats.NumCacheHits - startStats.NumCacheHits == numPermutations - expectedCompiles);
+
+        for(uint64 i = 0; i < numPermutations; ++i)
+        {
+            const D3D12_SHADER_BYTECODE byteCode = shaders[i].ByteCode();
+            byteCodes[i].Init(byteCode.BytecodeLength);
+            memcpy(byteCodes[i].Data(), byteCode.pShaderBytecode, byteCode.BytecodeLength);
+        }
+
+        ShutdownShaders();
+        SetShaderCompiler(nullptr);
+    };
+
+    auto sameByteCodes = [&](const Array<uint8>* a, const Array<uint8>* b)
+    {
+        for(uint64 i = 0; i < numPermutations; ++i)
+        {
+            if(a[i].Size() != b[i].Size() || memcmp(a[i].Data(), b[i].Data(), a[i].Size()) != 0)
+                return false;
+        }
+        return true;
+    };
+
+    Array<uint8> compiledA[numPermutations];
+    compilePass(compilerA, numPermutations, compiledA);
+
+    Array<uint8> cachedA[numPermutations];
+    compilePass(compilerA, 0, cachedA);
+    Check_(sameByteCodes(cachedA, compiledA));
+
+    Array<uint8> compiledB[numPermutations];
+    compilePass(compilerB, numPermutations, compiledB);
+    Check_(sameByteCodes(compiledB, compiledA) == false);
+
+    Array<uint8> cachedAgainA[numPermutations];
+    compilePass(compilerA, 0, cachedAgainA);
+    Check_(sameByteCodes(cachedAgainA, compiledA));
+}
+
+// Jobs on the task scheduler aren't ready while the compiler is still busy with them, and waiting on
+// them blocks until they are
+Test_(CompileShadersWaitsForJobs)
+{
+    WriteUniqueTestShader(L"Wait.hlsl");
+    const std::wstring path = TestShaderPath(L"Wait.hlsl");
+
+    enki::TaskScheduler scheduler;
+    scheduler.Initialize(4);
+
+    CountingShaderCompiler compiler("TestCompiler", 1);
+    compiler.Blocked = true;
+    SetShaderCompiler(&compiler);
+
+    const uint64 numPermutations = 8;
+    ShaderPermutation permutations[numPermutations];
+    MakeTestPermutations(permutations, numPermutations, path.c_str());
+
+    PendingShader results[numPermutations];
+    CompileShaders(permutations, numPermutations, results, &scheduler);
+
+    // Give the workers a chance to pick up the jobs, which can't finish until the compiler is unblocked
+    Timer timer;
+    while(compiler.NumCompiles == 0 && timer.ElapsedSecondsD() < 5.0)
+    {
+        Sleep(1);
+        timer.Update();
+    }
+    Check_(compiler.NumCompiles > 0);
+    for(uint64 i = 0; i < numPermutations; ++i)
+        Check_(results[i].Ready() == false);
+
+    compiler.Blocked = false;
+    CompiledShaderPtr shaders[numPermutations];
+    WaitForAll(results, shaders, numPermutations);
+    for(uint64 i = 0; i < numPermutations; ++i)
+        Check_(results[i].Ready());
+    Check_(compiler.NumCompiles == numPermutations);
+
+    ShutdownShaders();
+    SetShaderCompiler(nullptr);
+    scheduler.WaitforAllAndShutdown();
+}
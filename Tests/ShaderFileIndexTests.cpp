@@ -0,0 +1,353 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/ShaderFileIndex.h>
+#include <Containers.h>
+#include <Exceptions.h>
+#include <FileIO.h>
+#include <MurmurHash.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+static const wchar* TestDirectory = L"ShaderFileIndexTests\\";
+static const wchar* TestIndexPath = L"ShaderFileIndexTests\\FileIndex.dat";
+
+static std::wstring TestShaderPath(const wchar* fileName)
+{
+    return std::wstring(TestDirectory) + fileName;
+}
+
+static void WriteTestShader(const wchar* fileName, const std::string& contents)
+{
+    if(DirectoryExists(TestDirectory) == false)
+        Win32Call(CreateDirectory(TestDirectory, nullptr));
+
+    File file(TestShaderPath(fileName).c_str(), FileOpenMode::Write);
+    file.Write(contents.length(), contents.data());
+}
+
+// Rewrites the file until its timestamp moves, since two writes can land within the same tick of the
+// file system's clock
+static void ChangeTestShader(const wchar* fileName, const std::string& contents)
+{
+    const std::wstring path = TestShaderPath(fileName);
+    const uint64 timeStamp = GetFileTimestamp(path.c_str());
+    do
+    {
+        Sleep(1);
+        WriteTestShader(fileName, contents);
+    }
+    while(GetFileTimestamp(path.c_str()) == timeStamp);
+}
+
+static Hash HashShader(ShaderFileIndex& index, const wchar* fileName)
+{
+    ShaderFilePathList filePaths;
+    return index.HashFileAndIncludes(TestShaderPath(fileName).c_str(), filePaths);
+}
+
+static bool ListContains(const ShaderFilePathList& filePaths, const wchar* fileName)
+{
+    for(uint64 i = 0; i < filePaths.Count(); ++i)
+        if(filePaths[i] == TestShaderPath(fileName))
+            return true;
+    return false;
+}
+
+// Main.hlsl -> Lighting.hlsl -> Common.hlsl, and Main.hlsl -> Common.hlsl directly. Other.hlsl only
+// includes Lighting.hlsl, and Unrelated.hlsl includes nothing.
+static void WriteIncludeGraph()
+{
+    WriteTestShader(L"Common.hlsl", "static const float Pi = 3.14159f;\n");
+    WriteTestShader(L"Lighting.hlsl", "#include \"ShaderFileIndexTests\\Common.hlsl\"\nfloat Lambert() { return 1.0f / Pi; }\n");
+    WriteTestShader(L"Main.hlsl", "#include \"ShaderFileIndexTests\\Lighting.hlsl\"\n"
+                                  "#include \"ShaderFileIndexTests\\Common.hlsl\"\n"
+                                  "float4 PS() : SV_Target0 { return Lambert(); }\n");
+    WriteTestShader(L"Other.hlsl", "#include \"ShaderFileIndexTests\\Lighting.hlsl\"\nfloat4 PS() : SV_Target0 { return 0.0f; }\n");
+    WriteTestShader(L"Unrelated.hlsl", "float4 PS() : SV_Target0 { return 1.0f; }\n");
+}
+
+// Every file in the graph shows up once, depth-first, and a shared include doesn't get hashed twice
+Test_(ShaderFileIndexHashesIncludes)
+{
+    WriteIncludeGraph();
+
+    ShaderFileIndex index;
+    ShaderFilePathList filePaths;
+    const Hash mainHash = index.HashFileAndIncludes(TestShaderPath(L"Main.hlsl").c_str(), filePaths);
+    Check_(filePaths.Count() == 3);
+    Check_(filePaths[0] == TestShaderPath(L"Main.hlsl"));
+    Check_(filePaths[1] == TestShaderPath(L"Lighting.hlsl"));
+    Check_(filePaths[2] == TestShaderPath(L"Common.hlsl"));
+    Check_(index.NumFilesHashed() == 3);
+    Check_(index.Dirty());
+
+    // Looking at it again doesn't touch the disk
+    Check_(HashShader(index, L"Main.hlsl") == mainHash);
+    Check_(index.NumFilesHashed() == 3);
+    Check_(index.NumFilesChecked() == 3);
+
+    // Different include graphs and contents give different hashes
+    Check_((HashShader(index, L"Other.hlsl") == mainHash) == false);
+    Check_((HashShader(index, L"Unrelated.hlsl") == mainHash) == false);
+    Check_((HashShader(index, L"Other.hlsl") == HashShader(index, L"Lighting.hlsl")) == false);
+    Check_(index.NumFilesHashed() == 5);
+
+    const std::string common = ReadFileAsString(TestShaderPath(L"Common.hlsl").c_str());
+    Check_(index.FileHash(TestShaderPath(L"Common.hlsl").c_str()) == GenerateHash(common.data(), int(common.length())));
+
+    filePaths.RemoveAll();
+    WriteTestShader(L"Missing.hlsl", "#include \"ShaderFileIndexTests\\DoesNotExist.hlsl\"\n");
+    CheckThrows_(index.HashFileAndIncludes(TestShaderPath(L"Missing.hlsl").c_str(), filePaths));
+}
+
+// Changing a file that's included a couple of levels down changes the hash of everything that
+// includes it, and nothing else. Only the changed file gets read again.
+Test_(ShaderFileIndexIncludeInvalidation)
+{
+    WriteIncludeGraph();
+
+    ShaderFileIndex index;
+    const Hash mainHash = HashShader(index, L"Main.hlsl");
+    const Hash otherHash = HashShader(index, L"Other.hlsl");
+    const Hash unrelatedHash = HashShader(index, L"Unrelated.hlsl");
+    const uint64 numHashed = index.NumFilesHashed();
+
+    // Files are only checked once per run, until they're invalidated
+    ChangeTestShader(L"Common.hlsl", "static const float Pi = 3.0f;\n");
+    Check_(HashShader(index, L"Main.hlsl") == mainHash);
+
+    index.Invalidate(TestShaderPath(L"Common.hlsl").c_str());
+    const Hash newMainHash = HashShader(index, L"Main.hlsl");
+    const Hash newOtherHash = HashShader(index, L"Other.hlsl");
+    Check_((newMainHash == mainHash) == false);
+    Check_((newOtherHash == otherHash) == false);
+    Check_(HashShader(index, L"Unrelated.hlsl") == unrelatedHash);
+    Check_(index.NumFilesHashed() == numHashed + 1);
+
+    // Touching a file without changing it reads it again, but leaves every hash alone
+    ChangeTestShader(L"Lighting.hlsl", ReadFileAsString(TestShaderPath(L"Lighting.hlsl").c_str()));
+    index.Invalidate(TestShaderPath(L"Lighting.hlsl").c_str());
+    Check_(HashShader(index, L"Main.hlsl") == newMainHash);
+    Check_(HashShader(index, L"Other.hlsl") == newOtherHash);
+    Check_(index.NumFilesHashed() == numHashed + 2);
+
+    // Adding an include to a file in the middle of the graph pulls it in for everything above it
+    WriteTestShader(L"Shadows.hlsl", "float Shadow() { return 1.0f; }\n");
+    ChangeTestShader(L"Lighting.hlsl", "#include \"ShaderFileIndexTests\\Common.hlsl\"\n"
+                                       "#include \"ShaderFileIndexTests\\Shadows.hlsl\"\n"
+                                       "float Lambert() { return Shadow() / Pi; }\n");
+    index.Invalidate(TestShaderPath(L"Lighting.hlsl").c_str());
+    ShaderFilePathList filePaths;
+    Check_((index.HashFileAndIncludes(TestShaderPath(L"Other.hlsl").c_str(), filePaths) == newOtherHash) == false);
+    Check_(filePaths.Count() == 4);
+    Check_(ListContains(filePaths, L"Shadows.hlsl"));
+
+    // Then changing the new include changes both shaders that reach it
+    const Hash shadowsMainHash = HashShader(index, L"Main.hlsl");
+    const Hash shadowsOtherHash = HashShader(index, L"Other.hlsl");
+    ChangeTestShader(L"Shadows.hlsl", "float Shadow() { return 0.5f; }\n");
+    index.Invalidate(TestShaderPath(L"Shadows.hlsl").c_str());
+    Check_((HashShader(index, L"Main.hlsl") == shadowsMainHash) == false);
+    Check_((HashShader(index, L"Other.hlsl") == shadowsOtherHash) == false);
+    Check_(HashShader(index, L"Unrelated.hlsl") == unrelatedHash);
+}
+
+// A saved index only stats files on the next run, and re-reads the ones whose timestamp moved
+Test_(ShaderFileIndexSaveLoad)
+{
+    WriteIncludeGraph();
+
+    if(FileExists(TestIndexPath))
+        DeleteFile(TestIndexPath);
+
+    Hash mainHash;
+    {
+        ShaderFileIndex index;
+        index.Load(TestIndexPath);
+        mainHash = HashShader(index, L"Main.hlsl");
+        HashShader(index, L"Other.hlsl");
+        index.Save(TestIndexPath);
+        Check_(index.Dirty() == false);
+    }
+
+    {
+        ShaderFileIndex index;
+        index.Load(TestIndexPath);
+        Check_(HashShader(index, L"Main.hlsl") == mainHash);
+        Check_(index.NumFilesHashed() == 0);
+        Check_(index.NumFilesChecked() == 3);
+        Check_(index.Dirty() == false);
+    }
+
+    // An include that changed between runs gets picked up from its timestamp, without an Invalidate()
+    ChangeTestShader(L"Common.hlsl", "static const float Pi = 3.0f;\n");
+    Hash newMainHash;
+    {
+        ShaderFileIndex index;
+        index.Load(TestIndexPath);
+        newMainHash = HashShader(index, L"Main.hlsl");
+        Check_((newMainHash == mainHash) == false);
+        Check_(index.NumFilesHashed() == 1);
+        Check_(index.Dirty());
+        index.Save(TestIndexPath);
+    }
+
+    // A broken index is ignored, and everything just gets hashed again
+    {
+        std::string indexData = ReadFileAsString(TestIndexPath);
+        indexData[indexData.length() / 2] ^= 0xFF;
+        WriteStringAsFile(TestIndexPath, indexData);
+
+        ShaderFileIndex index;
+        index.Load(TestIndexPath);
+        Check_(HashShader(index, L"Main.hlsl") == newMainHash);
+        Check_(index.NumFilesHashed() == 3);
+    }
+}
+
+// The way cache keys were built before the index: every #include spliced into one string, which then
+// gets hashed. This is what CompileShader() used to do for every permutation.
+static std::string ExpandShaderCode(const wchar* path, ShaderFilePathList& filePaths)
+{
+    for(uint64 i = 0; i < filePaths.Count(); ++i)
+        if(filePaths[i] == path)
+            return std::string();
+
+    filePaths.Add(path);
+
+    std::string fileContents = ReadFileAsString(path);
+    size_t lineStart = 0;
+    while(true)
+    {
+        size_t lineEnd = fileContents.find('\n', lineStart);
+        if(fileContents.compare(lineStart, 8, "#include") == 0)
+        {
+            const size_t startQuote = fileContents.find('\"', lineStart);
+            const size_t endQuote = fileContents.find('\"', startQuote + 1);
+            const std::string includePath = fileContents.substr(startQuote + 1, endQuote - startQuote - 1);
+            const std::string includeCode = ExpandShaderCode(AnsiToWString(includePath.c_str()).c_str(), filePaths);
+            fileContents.insert(lineEnd + 1, includeCode);
+            lineEnd += includeCode.length();
+        }
+
+        if(lineEnd == std::string::npos)
+            break;
+
+        lineStart = lineEnd + 1;
+    }
+
+    return fileContents;
+}
+
+// 25 shaders that each include a chain of 4 out of 16 headers, compiled as 12 permutations each. Keys
+// are built by expanding the source, by a fresh index, and by an index that was saved by an earlier
+// run (which is what a normal startup looks like).
+Benchmark_(ShaderFileIndexStartup)
+{
+    const uint64 numHeaders = 16;
+    const uint64 numShaders = 25;
+    const uint64 numPermutations = 12;
+    const uint64 headerSize = 48 * 1024;
+    const uint64 headersPerShader = 4;
+
+    std::string filler;
+    while(filler.length() < headerSize)
+        filler += "float Filler(float x) { return x * 0.5f + 1.0f; }  // Padding out the header\n";
+
+    for(uint64 i = 0; i < numHeaders; ++i)
+    {
+        std::string contents;
+        // Headers are split into chains of 4, where each one includes the next
+        if((i + 1) % headersPerShader != 0)
+            contents += MakeString("#include \"ShaderFileIndexTests\\Header%llu.hlsl\"\n", i + 1);
+        contents += MakeString("// Header %llu\n", i);
+        contents += filler;
+        WriteTestShader(MakeString(L"Header%llu.hlsl", i).c_str(), contents);
+    }
+
+    Array<std::wstring> shaderNames(numShaders);
+    for(uint64 i = 0; i < numShaders; ++i)
+    {
+        const uint64 firstHeader = (i % (numHeaders / headersPerShader)) * headersPerShader;
+        shaderNames[i] = MakeString(L"Shader%llu.hlsl", i);
+        WriteTestShader(shaderNames[i].c_str(), MakeString("#include \"ShaderFileIndexTests\\Header%llu.hlsl\"\n"
+                                                           "float4 PS() : SV_Target0 { return %llu; }\n",
+                                                           firstHeader, i));
+    }
+
+    auto defineHash = [](uint64 permutation)
+    {
+        const std::string defines = MakeString("PERMUTATION=%llu", permutation);
+        return GenerateHash(defines.data(), int(defines.length()));
+    };
+
+    Array<Hash> expandedKeys(numShaders * numPermutations);
+    {
+        uint64 expandedSize = 0;
+        Timer timer;
+        for(uint64 shaderIdx = 0; shaderIdx < numShaders; ++shaderIdx)
+        {
+            for(uint64 permutation = 0; permutation < numPermutations; ++permutation)
+            {
+                ShaderFilePathList filePaths;
+                const std::string code = ExpandShaderCode(TestShaderPath(shaderNames[shaderIdx].c_str()).c_str(), filePaths);
+                expandedKeys[shaderIdx * numPermutations + permutation] = CombineHashes(GenerateHash(code.data(), int(code.length())), defineHash(permutation));
+                expandedSize += code.length();
+            }
+        }
+        timer.Update();
+        Tests::ReportBenchmarkResult("Expanded source: %7.2f ms (%.1f MB of source)", timer.ElapsedMillisecondsD(),
+                                     expandedSize / (1024.0 * 1024.0));
+    }
+
+    Array<Hash> indexKeys(numShaders * numPermutations);
+    auto buildIndexKeys = [&](const char* name)
+    {
+        Timer timer;
+        ShaderFileIndex index;
+        index.Load(TestIndexPath);
+        for(uint64 shaderIdx = 0; shaderIdx < numShaders; ++shaderIdx)
+        {
+            for(uint64 permutation = 0; permutation < numPermutations; ++permutation)
+            {
+                ShaderFilePathList filePaths;
+                const Hash sourceHash = index.HashFileAndIncludes(TestShaderPath(shaderNames[shaderIdx].c_str()).c_str(), filePaths);
+                indexKeys[shaderIdx * numPermutations + permutation] = CombineHashes(sourceHash, defineHash(permutation));
+            }
+        }
+        timer.Update();
+        Tests::ReportBenchmarkResult("%-15s  %7.2f ms (%llu files hashed, %llu checked)", name, timer.ElapsedMillisecondsD(),
+                                     index.NumFilesHashed(), index.NumFilesChecked());
+        if(index.Dirty())
+            index.Save(TestIndexPath);
+    };
+
+    if(FileExists(TestIndexPath))
+        DeleteFile(TestIndexPath);
+    buildIndexKeys("Index, cold:");
+    buildIndexKeys("Index, warm:");
+
+    // Every permutation gets its own key either way
+    HashMap<Hash, uint64> uniqueKeys;
+    for(uint64 i = 0; i < indexKeys.Size(); ++i)
+        uniqueKeys.Insert(indexKeys[i], i);
+    Check_(uniqueKeys.Count() == indexKeys.Size());
+
+    uniqueKeys.Shutdown();
+    for(uint64 i = 0; i < expandedKeys.Size(); ++i)
+        uniqueKeys.Insert(expandedKeys[i], i);
+    Check_(uniqueKeys.Count() == expandedKeys.Size());
+}
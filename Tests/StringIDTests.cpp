@@ -0,0 +1,193 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <StringID.h>
+#include <Containers.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include <thread>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+Test_(StringIDInternsContents)
+{
+    const std::string copy = "StringIDTests.Interned";
+    const StringID a("StringIDTests.Interned");
+    const StringID b(copy);
+    Check_(a.Valid());
+    Check_(a == b);
+    Check_(a.CString() == b.CString());
+    Check_(strcmp(a.CString(), "StringIDTests.Interned") == 0);
+    Check_(a.CString() != copy.c_str());
+
+    const StringID other("StringIDTests.Other");
+    Check_(other != a);
+
+    // A prefix is its own string, not a match
+    Check_(StringID("StringIDTests.Inter") != a);
+
+    const StringID empty("");
+    Check_(empty.Valid());
+    Check_(empty == StringID(std::string()));
+    Check_(empty.CString()[0] == 0);
+
+    Check_(StringID::Find("StringIDTests.Interned") == a);
+    Check_(StringID::Find("StringIDTests.NeverInterned").Valid() == false);
+    Check_(StringID().Valid() == false);
+
+    HashMap<StringID, uint64> map;
+    map.Insert(a, 1);
+    map.Insert(other, 2);
+    Check_(*map.Find(StringID(copy)) == 1);
+    Check_(*map.Find(StringID::Find("StringIDTests.Other")) == 2);
+}
+
+// Threads interning overlapping sets of strings all end up with the same IDs
+Test_(StringIDInternsFromThreads)
+{
+    const uint64 numThreads = 4;
+    const uint64 numStrings = 1000;
+    Array<Array<StringID>> threadIDs(numThreads);
+    Array<std::thread> threads(numThreads);
+    for(uint64 threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+    {
+        threads[threadIdx] = std::thread([&, threadIdx]()
+        {
+            Array<StringID>& ids = threadIDs[threadIdx];
+            ids.Init(numStrings);
+            for(uint64 i = 0; i < numStrings; ++i)
+            {
+                const uint64 idx = (i + threadIdx * 97) % numStrings;
+                ids[idx] = StringID(MakeString("StringIDTests.Thread%llu", idx));
+            }
+        });
+    }
+
+    for(uint64 threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+        threads[threadIdx].join();
+
+    HashMap<uint32, uint64> seen;
+    for(uint64 i = 0; i < numStrings; ++i)
+    {
+        const StringID id = threadIDs[0][i];
+        Check_(strcmp(id.CString(), MakeString("StringIDTests.Thread%llu", i).c_str()) == 0);
+        Check_(seen.Contains(id.ID()) == false);
+        seen.Insert(id.ID(), i);
+        for(uint64 threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+            Check_(threadIDs[threadIdx][i] == id);
+    }
+}
+
+// Looks up names the ways that settings, profiles and shader files used to be found (comparing the
+// string against every entry, or comparing pointers against every entry), and the ways that they're
+// found now (StringID::Find() followed by a HashMap lookup, or a HashMap keyed on the pointer)
+Benchmark_(StringIDLookup)
+{
+    const uint64 entryCounts[] = { 10, 100, 1000, 10000 };
+    for(uint64 countIdx = 0; countIdx < ArraySize_(entryCounts); ++countIdx)
+    {
+        const uint64 numEntries = entryCounts[countIdx];
+        const uint64 numLookups = std::max<uint64>(2000000 / numEntries, 1000);
+
+        // Lookups go through separate copies of the names, the way a caller's string literal would
+        Array<std::string> names(numEntries);
+        Array<std::string> lookupNames(numEntries);
+        HashMap<StringID, uint64> idMap;
+        HashMap<const char*, uint64> pointerMap;
+        for(uint64 i = 0; i < numEntries; ++i)
+        {
+            names[i] = MakeString("StringIDLookup.Group%llu.Setting%llu", i % 7, i);
+            lookupNames[i] = names[i];
+            idMap.Insert(StringID(names[i]), i);
+            pointerMap.Insert(names[i].c_str(), i);
+        }
+
+        auto lookupIdx = [&](uint64 lookup)
+        {
+            return (lookup * 2654435761ull) % numEntries;
+        };
+
+        auto report = [&](const char* name, const Timer& timer, uint64 sum)
+        {
+            Tests::ReportBenchmarkResult("%5llu entries, %-18s %8.1f ns per lookup", numEntries, name,
+                                         timer.ElapsedMicrosecondsD() * 1000.0 / numLookups);
+            uint64 expectedSum = 0;
+            for(uint64 i = 0; i < numLookups; ++i)
+                expectedSum += lookupIdx(i);
+            Check_(sum == expectedSum);
+        };
+
+        {
+            Timer timer;
+            uint64 sum = 0;
+            for(uint64 i = 0; i < numLookups; ++i)
+            {
+                const char* name = lookupNames[lookupIdx(i)].c_str();
+                for(uint64 entryIdx = 0; entryIdx < numEntries; ++entryIdx)
+                {
+                    if(strcmp(names[entryIdx].c_str(), name) == 0)
+                    {
+                        sum += entryIdx;
+                        break;
+                    }
+                }
+            }
+            timer.Update();
+            report("string scan:", timer, sum);
+        }
+
+        {
+            Timer timer;
+            uint64 sum = 0;
+            for(uint64 i = 0; i < numLookups; ++i)
+            {
+                const uint64* entryIdx = idMap.Find(StringID::Find(lookupNames[lookupIdx(i)].c_str()));
+                sum += entryIdx != nullptr ? *entryIdx : 0;
+            }
+            timer.Update();
+            report("StringID + map:", timer, sum);
+        }
+
+        {
+            Timer timer;
+            uint64 sum = 0;
+            for(uint64 i = 0; i < numLookups; ++i)
+            {
+                const char* name = names[lookupIdx(i)].c_str();
+                for(uint64 entryIdx = 0; entryIdx < numEntries; ++entryIdx)
+                {
+                    if(names[entryIdx].c_str() == name)
+                    {
+                        sum += entryIdx;
+                        break;
+                    }
+                }
+            }
+            timer.Update();
+            report("pointer scan:", timer, sum);
+        }
+
+        {
+            Timer timer;
+            uint64 sum = 0;
+            for(uint64 i = 0; i < numLookups; ++i)
+            {
+                const uint64* entryIdx = pointerMap.Find(names[lookupIdx(i)].c_str());
+                sum += entryIdx != nullptr ? *entryIdx : 0;
+            }
+            timer.Update();
+            report("pointer map:", timer, sum);
+        }
+    }
+}
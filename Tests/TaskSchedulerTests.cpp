@@ -0,0 +1,779 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <EnkiTS/TaskScheduler.h>
+#include <Containers.h>
+#include <Timer.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+#include <atomic>
+
+using namespace SampleFramework12;
+
+static const uint32 NumTestThreads = 4;
+
+static const enki::SchedulingMode SchedulingModes[] = { enki::SCHEDULING_MODE_PIPES, enki::SCHEDULING_MODE_WORK_STEALING };
+static const char* SchedulingModeNames[] = { "Pipes", "Work stealing" };
+
+// Stands in for real work, without touching memory that other threads are using
+static void Spin(uint32 numIterations)
+{
+    volatile uint32 counter = 0;
+    for(uint32 i = 0; i < numIterations; ++i)
+        counter = counter + 1;
+}
+
+// User and kernel time used by every thread in the process so far
+static double ProcessCPUTimeMS()
+{
+    FILETIME creationTime = { };
+    FILETIME exitTime = { };
+    FILETIME kernelTime = { };
+    FILETIME userTime = { };
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+
+    const uint64 kernel = (uint64(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    const uint64 user = (uint64(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return (kernel + user) / 10000.0;
+}
+
+// Waits for the set without running any of it on this thread, so that it only completes if the
+// scheduler's own threads pick it up
+static bool WaitWithoutHelping(const enki::ITaskSet& taskSet, double timeoutSeconds)
+{
+    Timer timer;
+    while(taskSet.GetIsComplete() == false && timer.ElapsedSecondsD() < timeoutSeconds)
+    {
+        YieldProcessor();
+        timer.Update();
+    }
+    return taskSet.GetIsComplete();
+}
+
+// Records how many times each index of the set was run, and which threads ran them
+class CountingTaskSet : public enki::ITaskSet
+{
+
+public:
+
+    Array<std::atomic<uint32>> RunCounts;
+    std::atomic<uint32> ThreadMask;
+    uint32 SpinsPerIndex = 0;
+
+    CountingTaskSet(uint32 setSize, uint32 minRange, uint32 spinsPerIndex) : ITaskSet(setSize), RunCounts(setSize),
+                                                                             ThreadMask(0), SpinsPerIndex(spinsPerIndex)
+    {
+        m_MinRange = minRange;
+        Reset();
+    }
+
+    void Reset()
+    {
+        for(uint64 i = 0; i < RunCounts.Size(); ++i)
+            RunCounts[i].store(0);
+        ThreadMask.store(0);
+    }
+
+    virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t threadnum) override
+    {
+        Assert_(range.start < range.end && range.end <= m_SetSize);
+        for(uint32 i = range.start; i < range.end; ++i)
+        {
+            RunCounts[i].fetch_add(1, std::memory_order_relaxed);
+            Spin(SpinsPerIndex);
+        }
+        ThreadMask.fetch_or(1u << (threadnum % 32), std::memory_order_relaxed);
+    }
+
+    bool RanEveryIndexOnce() const
+    {
+        for(uint64 i = 0; i < RunCounts.Size(); ++i)
+            if(RunCounts[i].load() != 1)
+                return false;
+        return true;
+    }
+};
+
+static uint32 NumThreadsInMask(uint32 mask)
+{
+    uint32 numThreads = 0;
+    for(; mask != 0; mask &= mask - 1)
+        ++numThreads;
+    return numThreads;
+}
+
+// Adds a child set for every index, and waits for it from inside the task. Every thread ends up adding
+// work to its own deque while the others are trying to steal from it.
+class NestedTaskSet : public enki::ITaskSet
+{
+
+public:
+
+    enki::TaskScheduler* Scheduler = nullptr;
+    GrowableList<CountingTaskSet*> Children;
+
+    NestedTaskSet(enki::TaskScheduler* scheduler, uint32 numChildren, uint32 childSize, uint32 spinsPerIndex) : ITaskSet(numChildren),
+                                                                                                                Scheduler(scheduler)
+    {
+        for(uint32 i = 0; i < numChildren; ++i)
+            Children.Add(new CountingTaskSet(childSize, 1, spinsPerIndex));
+    }
+
+    ~NestedTaskSet()
+    {
+        for(uint64 i = 0; i < Children.Count(); ++i)
+            delete Children[i];
+    }
+
+    virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t) override
+    {
+        for(uint32 i = range.start; i < range.end; ++i)
+        {
+            Scheduler->AddTaskSetToPipe(Children[i]);
+            Scheduler->WaitforTaskSet(Children[i]);
+        }
+    }
+
+    bool ChildrenRanEveryIndexOnce() const
+    {
+        for(uint64 i = 0; i < Children.Count(); ++i)
+            if(Children[i]->GetIsComplete() == false || Children[i]->RanEveryIndexOnce() == false)
+                return false;
+        return true;
+    }
+
+    uint32 ChildThreadMask() const
+    {
+        uint32 mask = 0;
+        for(uint64 i = 0; i < Children.Count(); ++i)
+            mask |= Children[i]->ThreadMask.load();
+        return mask;
+    }
+};
+
+// Records when the set's first range started and its last one finished, in the order that every
+// OrderedTaskSet's ranges started and finished
+static std::atomic<uint32> ExecutionSequence;
+
+class OrderedTaskSet : public CountingTaskSet
+{
+
+public:
+
+    std::atomic<uint32> FirstStart;
+    std::atomic<uint32> LastFinish;
+
+    explicit OrderedTaskSet(uint32 setSize) : CountingTaskSet(setSize, 1, 100), FirstStart(UINT32_MAX), LastFinish(0)
+    {
+    }
+
+    void Reset()
+    {
+        CountingTaskSet::Reset();
+        FirstStart.store(UINT32_MAX);
+        LastFinish.store(0);
+    }
+
+    virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t threadnum) override
+    {
+        const uint32 start = ExecutionSequence.fetch_add(1);
+        uint32 firstStart = FirstStart.load();
+        while(start < firstStart && FirstStart.compare_exchange_weak(firstStart, start) == false);
+
+        CountingTaskSet::ExecuteRange(range, threadnum);
+
+        const uint32 finish = ExecutionSequence.fetch_add(1);
+        uint32 lastFinish = LastFinish.load();
+        while(finish > lastFinish && LastFinish.compare_exchange_weak(lastFinish, finish) == false);
+    }
+
+    bool RanAfter(const OrderedTaskSet& other) const
+    {
+        return other.LastFinish.load() < FirstStart.load();
+    }
+};
+
+Test_(TaskSchedulerRunsEveryIndexOnce)
+{
+    // Odd sizes and minimum ranges, so that the last partition is never a full one
+    const uint32 setSizes[] = { 1, 7, 1000, 100003 };
+    const uint32 minRanges[] = { 1, 3, 64 };
+
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.Initialize(NumTestThreads);
+
+        for(uint64 sizeIdx = 0; sizeIdx < ArraySize_(setSizes); ++sizeIdx)
+        {
+            for(uint64 rangeIdx = 0; rangeIdx < ArraySize_(minRanges); ++rangeIdx)
+            {
+                CountingTaskSet taskSet(setSizes[sizeIdx], minRanges[rangeIdx], 0);
+
+                // Running the same set again has to start from scratch
+                for(uint32 run = 0; run < 2; ++run)
+                {
+                    taskSet.Reset();
+                    scheduler.AddTaskSetToPipe(&taskSet);
+                    scheduler.WaitforTaskSet(&taskSet);
+                    Check_(taskSet.GetIsComplete());
+                    Check_(taskSet.RanEveryIndexOnce());
+                }
+            }
+        }
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// A set added by one thread only gets run by the others if they steal it
+Test_(WorkStealingSpreadsWork)
+{
+    enki::TaskScheduler scheduler;
+    scheduler.SetSchedulingMode(enki::SCHEDULING_MODE_WORK_STEALING);
+    scheduler.Initialize(NumTestThreads);
+
+    CountingTaskSet taskSet(4096, 1, 20000);
+    scheduler.AddTaskSetToPipe(&taskSet);
+    scheduler.WaitforTaskSet(&taskSet);
+    Check_(taskSet.RanEveryIndexOnce());
+    Check_(NumThreadsInMask(taskSet.ThreadMask.load()) > 1);
+
+    scheduler.WaitforAllAndShutdown();
+}
+
+Test_(WorkStealingUnderContention)
+{
+    enki::TaskScheduler scheduler;
+    scheduler.SetSchedulingMode(enki::SCHEDULING_MODE_WORK_STEALING);
+    scheduler.Initialize(NumTestThreads);
+
+    // The main thread keeps adding sets of its own while the nested ones are being added and stolen
+    for(uint32 round = 0; round < 8; ++round)
+    {
+        NestedTaskSet nested(&scheduler, 64, 257, 200);
+        CountingTaskSet sideSets[] = { { 1000, 1, 50 }, { 33, 1, 500 }, { 5000, 16, 10 } };
+
+        scheduler.AddTaskSetToPipe(&nested);
+        for(uint64 i = 0; i < ArraySize_(sideSets); ++i)
+            scheduler.AddTaskSetToPipe(&sideSets[i]);
+
+        scheduler.WaitforTaskSet(&nested);
+        for(uint64 i = 0; i < ArraySize_(sideSets); ++i)
+        {
+            scheduler.WaitforTaskSet(&sideSets[i]);
+            Check_(sideSets[i].RanEveryIndexOnce());
+        }
+
+        Check_(nested.GetIsComplete());
+        Check_(nested.ChildrenRanEveryIndexOnce());
+        Check_(NumThreadsInMask(nested.ChildThreadMask()) > 1);
+    }
+
+    scheduler.WaitforAllAndShutdown();
+}
+
+Test_(TaskDependenciesRunInOrder)
+{
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.Initialize(NumTestThreads);
+
+        OrderedTaskSet first(100);
+        OrderedTaskSet second(100);
+        OrderedTaskSet third(100);
+        enki::Dependency secondOnFirst;
+        enki::Dependency thirdOnSecond;
+        second.SetDependency(secondOnFirst, &first);
+        third.SetDependency(thirdOnSecond, &second);
+
+        // The dependencies stay in place, so the chain can be run again
+        for(uint32 run = 0; run < 4; ++run)
+        {
+            first.Reset();
+            second.Reset();
+            third.Reset();
+
+            scheduler.AddTaskSetToPipe(&first);
+            scheduler.WaitforTaskSet(&third);
+            Check_(first.GetIsComplete() && second.GetIsComplete());
+            Check_(first.RanEveryIndexOnce() && second.RanEveryIndexOnce() && third.RanEveryIndexOnce());
+            Check_(second.RanAfter(first));
+            Check_(third.RanAfter(second));
+        }
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+Test_(TaskDependenciesDiamond)
+{
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.Initialize(NumTestThreads);
+
+        // The two sides take different amounts of time, so they finish in either order
+        OrderedTaskSet top(10);
+        OrderedTaskSet left(1000);
+        OrderedTaskSet right(3);
+        OrderedTaskSet bottom(50);
+        enki::Dependency leftOnTop;
+        enki::Dependency rightOnTop;
+        enki::Dependency bottomOnLeft;
+        enki::Dependency bottomOnRight;
+        left.SetDependency(leftOnTop, &top);
+        right.SetDependency(rightOnTop, &top);
+        bottom.SetDependency(bottomOnLeft, &left);
+        bottom.SetDependency(bottomOnRight, &right);
+
+        for(uint32 run = 0; run < 16; ++run)
+        {
+            top.Reset();
+            left.Reset();
+            right.Reset();
+            bottom.Reset();
+
+            scheduler.AddTaskSetToPipe(&top);
+            scheduler.WaitforTaskSet(&bottom);
+            Check_(top.RanEveryIndexOnce() && left.RanEveryIndexOnce() && right.RanEveryIndexOnce());
+            Check_(bottom.RanEveryIndexOnce());
+            Check_(left.RanAfter(top) && right.RanAfter(top));
+            Check_(bottom.RanAfter(left) && bottom.RanAfter(right));
+        }
+
+        // Nothing else gets added once the bottom has run
+        scheduler.WaitforAll();
+        Check_(bottom.RanEveryIndexOnce());
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// A dependency set up after its parent has already run waits for the parent's next run, and one
+// that's been cleared doesn't run at all
+Test_(TaskDependencyAddedAfterParentCompleted)
+{
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.Initialize(NumTestThreads);
+
+        OrderedTaskSet parent(100);
+        OrderedTaskSet child(100);
+        scheduler.AddTaskSetToPipe(&parent);
+        scheduler.WaitforTaskSet(&parent);
+        Check_(parent.RanEveryIndexOnce());
+
+        enki::Dependency childOnParent;
+        child.SetDependency(childOnParent, &parent);
+        scheduler.WaitforAll();
+        Check_(child.GetIsComplete());
+        Check_(child.RunCounts[0].load() == 0);
+
+        parent.Reset();
+        scheduler.AddTaskSetToPipe(&parent);
+        scheduler.WaitforTaskSet(&child);
+        Check_(parent.RanEveryIndexOnce() && child.RanEveryIndexOnce());
+        Check_(child.RanAfter(parent));
+
+        child.ClearDependency(childOnParent);
+        parent.Reset();
+        child.Reset();
+        scheduler.AddTaskSetToPipe(&parent);
+        scheduler.WaitforTaskSet(&parent);
+        scheduler.WaitforAll();
+        Check_(parent.RanEveryIndexOnce());
+        Check_(child.RunCounts[0].load() == 0);
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// Records the affinity of every thread that runs part of the set. Each range waits until every enkiTS
+// thread has run one, so that one thread can't run the whole set by itself.
+class AffinityTaskSet : public enki::ITaskSet
+{
+
+public:
+
+    Array<GROUP_AFFINITY> Affinities;
+    Array<std::atomic<bool>> Recorded;
+    std::atomic<uint32> NumRecorded;
+    uint32 NumEnkiThreads = 0;
+
+    AffinityTaskSet(uint32 numThreads) : ITaskSet(1024), Affinities(numThreads), Recorded(numThreads), NumRecorded(0),
+                                         NumEnkiThreads(numThreads - 1)
+    {
+        for(uint64 i = 0; i < Recorded.Size(); ++i)
+            Recorded[i].store(false);
+    }
+
+    virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t threadnum) override
+    {
+        if(threadnum < NumEnkiThreads && Recorded[threadnum].load() == false)
+        {
+            GetThreadGroupAffinity(GetCurrentThread(), &Affinities[threadnum]);
+            Recorded[threadnum].store(true);
+            ++NumRecorded;
+        }
+
+        Timer timer;
+        while(NumRecorded.load() < NumEnkiThreads && timer.ElapsedSecondsD() < 5.0)
+        {
+            YieldProcessor();
+            timer.Update();
+        }
+    }
+};
+
+// There are usually more threads than physical cores, and none of them should end up pinned to a core
+// that another thread is pinned to (including the first one, which is left for the main thread)
+Test_(ThreadAffinityNeverSharesCores)
+{
+    GROUP_AFFINITY mainAffinity = { };
+    GetThreadGroupAffinity(GetCurrentThread(), &mainAffinity);
+
+    const enki::ThreadAffinityMode affinityModes[] = { enki::THREAD_AFFINITY_SPREAD, enki::THREAD_AFFINITY_COMPACT };
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(affinityModes); ++modeIdx)
+    {
+        const uint32 numThreads = std::thread::hardware_concurrency() * 2 + 1;
+        enki::TaskScheduler scheduler;
+        scheduler.SetThreadAffinityMode(affinityModes[modeIdx]);
+        scheduler.Initialize(numThreads);
+
+        AffinityTaskSet taskSet(numThreads);
+        scheduler.AddTaskSetToPipe(&taskSet);
+        scheduler.WaitforTaskSet(&taskSet);
+        Check_(taskSet.NumRecorded.load() == taskSet.NumEnkiThreads);
+
+        uint32 numPinned = 0;
+        for(uint32 i = 0; i < taskSet.NumEnkiThreads; ++i)
+        {
+            const GROUP_AFFINITY& affinity = taskSet.Affinities[i];
+            if(affinity.Group == mainAffinity.Group && affinity.Mask == mainAffinity.Mask)
+                continue;
+
+            ++numPinned;
+            for(uint32 j = 0; j < i; ++j)
+                Check_(affinity.Group != taskSet.Affinities[j].Group || (affinity.Mask & taskSet.Affinities[j].Mask) == 0);
+        }
+        Check_(numPinned < numThreads - 1);
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// With no spinning, threads park as soon as they run out of tasks. Every set added afterwards has to
+// wake one of them up, since the main thread doesn't help.
+Test_(ParkedThreadsWakeForNewTasks)
+{
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.SetSpinCount(0);
+        scheduler.Initialize(NumTestThreads);
+
+        for(uint32 i = 0; i < 200; ++i)
+        {
+            // Adding right away races with threads that are about to park, waiting lets them finish parking
+            if(i % 4 == 0)
+                Sleep(1);
+
+            CountingTaskSet taskSet(16, 1, 100);
+            scheduler.AddTaskSetToPipe(&taskSet);
+            const bool completed = WaitWithoutHelping(taskSet, 5.0);
+            Check_(completed);
+            if(completed == false)
+                break;
+            Check_(taskSet.RanEveryIndexOnce());
+        }
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// Parked threads shouldn't use any CPU time, and parked user threads have to come back out when
+// they're told to stop
+Test_(ParkedThreadsStayIdle)
+{
+    enki::TaskScheduler scheduler;
+    scheduler.InitializeWithUserThreads(2, NumTestThreads - 1);
+
+    std::atomic<bool> userThreadDone(false);
+    scheduler.PreUserThreadRunTasks();
+    std::thread userThread([&]()
+    {
+        scheduler.UserThreadRunTasks();
+        userThreadDone = true;
+    });
+
+    CountingTaskSet taskSet(1000, 1, 100);
+    scheduler.AddTaskSetToPipe(&taskSet);
+    scheduler.WaitforTaskSet(&taskSet);
+    Check_(taskSet.RanEveryIndexOnce());
+
+    // Long enough for every thread to run out of spins and park
+    Sleep(50);
+    const double startCPUTime = ProcessCPUTimeMS();
+    Sleep(200);
+    const double idleCPUTime = ProcessCPUTimeMS() - startCPUTime;
+    Check_(idleCPUTime < 100.0);
+
+    scheduler.StopUserThreadRunTasks();
+    Timer timer;
+    while(userThreadDone == false && timer.ElapsedSecondsD() < 5.0)
+    {
+        Sleep(1);
+        timer.Update();
+    }
+    Check_(userThreadDone);
+    userThread.join();
+
+    scheduler.WaitforAllAndShutdown();
+}
+
+// Compares the two scheduling modes on evenly sized work, on work where the cost of an index grows
+// along the set (so the fixed partitions in pipe mode end up unbalanced), and on nested sets
+Benchmark_(TaskSchedulerModes)
+{
+    const uint32 numThreads = std::thread::hardware_concurrency();
+    const uint32 numRuns = 50;
+
+    class SkewedTaskSet : public enki::ITaskSet
+    {
+
+    public:
+
+        SkewedTaskSet() : ITaskSet(4096)
+        {
+        }
+
+        virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t) override
+        {
+            for(uint32 i = range.start; i < range.end; ++i)
+                Spin(i * 4);
+        }
+    };
+
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(SchedulingModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSchedulingMode(SchedulingModes[modeIdx]);
+        scheduler.Initialize(numThreads);
+
+        CountingTaskSet uniform(1 << 16, 1, 50);
+        SkewedTaskSet skewed;
+        NestedTaskSet nested(&scheduler, 64, 1024, 50);
+        enki::ITaskSet* taskSets[] = { &uniform, &skewed, &nested };
+        const char* taskSetNames[] = { "uniform", "skewed", "nested" };
+
+        for(uint64 setIdx = 0; setIdx < ArraySize_(taskSets); ++setIdx)
+        {
+            Timer timer;
+            for(uint32 run = 0; run < numRuns; ++run)
+            {
+                scheduler.AddTaskSetToPipe(taskSets[setIdx]);
+                scheduler.WaitforTaskSet(taskSets[setIdx]);
+            }
+            timer.Update();
+
+            Tests::ReportBenchmarkResult("%s, %s: %.3f ms per run (%u threads)", SchedulingModeNames[modeIdx], taskSetNames[setIdx],
+                                         timer.ElapsedMillisecondsD() / numRuns, numThreads);
+        }
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// Measures how long it takes for small high priority sets to complete while the threads are busy with
+// long running low priority work, with and without a thread reserved for high priority work
+Benchmark_(TaskSchedulerPriorities)
+{
+    const uint32 numThreads = std::thread::hardware_concurrency();
+    const uint32 numHighPrioritySets = 100;
+
+    class BackgroundTaskSet : public enki::ITaskSet
+    {
+
+    public:
+
+        BackgroundTaskSet() : ITaskSet(256)
+        {
+            m_Priority = enki::TASK_PRIORITY_LOW;
+        }
+
+        virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t) override
+        {
+            for(uint32 i = range.start; i < range.end; ++i)
+                Spin(2000000);
+        }
+    };
+
+    for(uint32 numReserved = 0; numReserved < 2; ++numReserved)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetNumHighPriorityOnlyThreads(numReserved);
+        scheduler.Initialize(numThreads);
+
+        BackgroundTaskSet background;
+        scheduler.AddTaskSetToPipe(&background);
+
+        double totalMS = 0.0;
+        double maxMS = 0.0;
+        uint32 numMeasured = 0;
+        for(uint32 i = 0; i < numHighPrioritySets && background.GetIsComplete() == false; ++i)
+        {
+            CountingTaskSet highPriority(64, 1, 1000);
+            Timer timer;
+            scheduler.AddTaskSetToPipe(&highPriority);
+            scheduler.WaitforTaskSet(&highPriority);
+            timer.Update();
+
+            totalMS += timer.ElapsedMillisecondsD();
+            maxMS = timer.ElapsedMillisecondsD() > maxMS ? timer.ElapsedMillisecondsD() : maxMS;
+            ++numMeasured;
+        }
+
+        scheduler.WaitforTaskSet(&background);
+        Tests::ReportBenchmarkResult("%u reserved threads: %.3f ms average, %.3f ms max high priority latency (%u sets)",
+                                     numReserved, numMeasured > 0 ? totalMS / numMeasured : 0.0, maxMS, numMeasured);
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// Runs the same memory-heavy set with each of the affinity modes
+Benchmark_(TaskSchedulerAffinity)
+{
+    const uint32 numThreads = std::thread::hardware_concurrency();
+    const uint32 numRuns = 20;
+    const uint64 numElements = 16 * 1024 * 1024;
+    Array<uint32> data(numElements, 1);
+    std::atomic<uint64> total(0);
+
+    enki::TaskSet sumTask(uint32(numElements / 1024), [&](enki::TaskSetPartition range, uint32_t)
+    {
+        uint64 sum = 0;
+        for(uint64 i = range.start * 1024ull; i < range.end * 1024ull; ++i)
+            sum += data[i];
+        total += sum;
+    });
+
+    const enki::ThreadAffinityMode affinityModes[] = { enki::THREAD_AFFINITY_NONE, enki::THREAD_AFFINITY_SPREAD, enki::THREAD_AFFINITY_COMPACT };
+    const char* affinityModeNames[] = { "None", "Spread", "Compact" };
+    for(uint64 modeIdx = 0; modeIdx < ArraySize_(affinityModes); ++modeIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetThreadAffinityMode(affinityModes[modeIdx]);
+        scheduler.Initialize(numThreads);
+
+        total = 0;
+        Timer timer;
+        for(uint32 run = 0; run < numRuns; ++run)
+        {
+            scheduler.AddTaskSetToPipe(&sumTask);
+            scheduler.WaitforTaskSet(&sumTask);
+        }
+        timer.Update();
+        Check_(total.load() == numElements * numRuns);
+
+        const double ms = timer.ElapsedMillisecondsD() / numRuns;
+        Tests::ReportBenchmarkResult("%s: %.3f ms per run, %.2f GB/s", affinityModeNames[modeIdx], ms,
+                                     (numElements * sizeof(uint32)) / (ms * 1000000.0));
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
+
+// How long a parked thread takes to start running a set after it's added, and how much CPU time the
+// threads use while there's nothing to do, for a few spin counts
+Benchmark_(TaskSchedulerIdle)
+{
+    // The main thread doesn't help, so there has to be at least one other thread to wake up
+    const uint32 numThreads = std::max(std::thread::hardware_concurrency(), 2u);
+    const uint32 numWakes = 100;
+    const uint32 spinCounts[] = { 0, 100, 10000 };
+
+    class TimestampTaskSet : public enki::ITaskSet
+    {
+
+    public:
+
+        std::atomic<int64> StartTime;
+
+        TimestampTaskSet() : StartTime(0)
+        {
+        }
+
+        virtual void ExecuteRange(enki::TaskSetPartition, uint32_t) override
+        {
+            LARGE_INTEGER counter = { };
+            QueryPerformanceCounter(&counter);
+            int64 expected = 0;
+            StartTime.compare_exchange_strong(expected, counter.QuadPart);
+        }
+    };
+
+    LARGE_INTEGER frequency = { };
+    QueryPerformanceFrequency(&frequency);
+
+    for(uint64 spinIdx = 0; spinIdx < ArraySize_(spinCounts); ++spinIdx)
+    {
+        enki::TaskScheduler scheduler;
+        scheduler.SetSpinCount(spinCounts[spinIdx]);
+        scheduler.Initialize(numThreads);
+
+        double totalWakeMS = 0.0;
+        double maxWakeMS = 0.0;
+        uint32 numMissedWakes = 0;
+        for(uint32 i = 0; i < numWakes; ++i)
+        {
+            Sleep(5);
+
+            TimestampTaskSet taskSet;
+            LARGE_INTEGER addTime = { };
+            QueryPerformanceCounter(&addTime);
+            scheduler.AddTaskSetToPipe(&taskSet);
+            if(WaitWithoutHelping(taskSet, 1.0) == false)
+            {
+                // Let the main thread finish it off, or the set would go out of scope while it's queued
+                ++numMissedWakes;
+                scheduler.WaitforTaskSet(&taskSet);
+                continue;
+            }
+
+            const double wakeMS = (taskSet.StartTime.load() - addTime.QuadPart) * 1000.0 / frequency.QuadPart;
+            totalWakeMS += wakeMS;
+            maxWakeMS = wakeMS > maxWakeMS ? wakeMS : maxWakeMS;
+        }
+
+        Sleep(50);
+        const double startCPUTime = ProcessCPUTimeMS();
+        Sleep(500);
+        const double idleCPUTime = ProcessCPUTimeMS() - startCPUTime;
+
+        const uint32 numWoken = numWakes - numMissedWakes;
+        Tests::ReportBenchmarkResult("Spin count %u: %.3f ms average, %.3f ms max wake latency, %u missed wakes, %.1f ms CPU time per second idle",
+                                     spinCounts[spinIdx], numWoken > 0 ? totalWakeMS / numWoken : 0.0, maxWakeMS,
+                                     numMissedWakes, idleCPUTime * 2.0);
+
+        scheduler.WaitforAllAndShutdown();
+    }
+}
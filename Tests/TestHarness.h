@@ -0,0 +1,78 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+namespace SampleFramework12
+{
+
+namespace Tests
+{
+
+typedef void (*TestFunction)();
+
+// Adds a test to the list that TestMain runs, used through Test_()
+struct TestRegistration
+{
+    TestRegistration(const char* name, TestFunction function);
+};
+
+// Adds a benchmark to the list that TestMain runs with -benchmark, used through Benchmark_()
+struct BenchmarkRegistration
+{
+    BenchmarkRegistration(const char* name, TestFunction function);
+};
+
+void ReportCheckFailure(const char* file, int line, const char* condition);
+
+// Prints one line of a benchmark's results, formatted like printf
+void ReportBenchmarkResult(const char* format, ...);
+
+// Number of calls to the global operator new so far, which TestMain replaces with a counting version
+uint64 NumHeapAllocations();
+
+}
+
+}
+
+// Defines a test function that gets run automatically by TestMain
+#define Test_(name) \
+    static void name(); \
+    static SampleFramework12::Tests::TestRegistration name##Registration(#name, name); \
+    static void name()
+
+// Defines a benchmark, which is only run when the executable is started with -benchmark. Benchmarks
+// print their own results with ReportBenchmarkResult(), and can also use Check_().
+#define Benchmark_(name) \
+    static void name(); \
+    static SampleFramework12::Tests::BenchmarkRegistration name##Registration(#name, name); \
+    static void name()
+
+// Failed checks are reported and the test keeps going, so that one run shows every failure
+#define Check_(x) \
+    do \
+    { \
+        if(!(x)) \
+            SampleFramework12::Tests::ReportCheckFailure(__FILE__, __LINE__, #x); \
+    } while(0)
+
+#define CheckNear_(x, y, tolerance) Check_(std::abs(double(x) - double(y)) <= double(tolerance))
+
+// Checks that the expression throws one of the framework's exceptions
+#define CheckThrows_(x) \
+    do \
+    { \
+        bool threw_ = false; \
+        try { x; } \
+        catch(SampleFramework12::Exception&) { threw_ = true; } \
+        if(threw_ == false) \
+            SampleFramework12::Tests::ReportCheckFailure(__FILE__, __LINE__, "throws: " #x); \
+    } while(0)
@@ -0,0 +1,190 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <App.h>
+#include <Exceptions.h>
+#include <Assert.h>
+
+#include "TestHarness.h"
+
+#include <atomic>
+#include <new>
+
+namespace SampleFramework12
+{
+
+// The tests don't link App.cpp, this stands in for the part of it that WriteLog() uses
+App* GlobalApp = nullptr;
+
+void App::AddToLog(const char*)
+{
+}
+
+namespace Tests
+{
+
+struct RegisteredTest
+{
+    const char* Name = nullptr;
+    TestFunction Function = nullptr;
+};
+
+static const uint64 MaxTests = 256;
+static RegisteredTest RegisteredTests[MaxTests];
+static uint64 NumRegisteredTests = 0;
+
+static const uint64 MaxBenchmarks = 64;
+static RegisteredTest RegisteredBenchmarks[MaxBenchmarks];
+static uint64 NumRegisteredBenchmarks = 0;
+static uint64 NumCheckFailures = 0;
+static std::atomic<uint64> HeapAllocationCount;
+
+TestRegistration::TestRegistration(const char* name, TestFunction function)
+{
+    if(NumRegisteredTests < MaxTests)
+    {
+        RegisteredTests[NumRegisteredTests].Name = name;
+        RegisteredTests[NumRegisteredTests].Function = function;
+    }
+    ++NumRegisteredTests;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name, TestFunction function)
+{
+    if(NumRegisteredBenchmarks < MaxBenchmarks)
+    {
+        RegisteredBenchmarks[NumRegisteredBenchmarks].Name = name;
+        RegisteredBenchmarks[NumRegisteredBenchmarks].Function = function;
+    }
+    ++NumRegisteredBenchmarks;
+}
+
+void ReportCheckFailure(const char* file, int line, const char* condition)
+{
+    printf("%s(%d): Check failed: %s\n", file, line, condition);
+    ++NumCheckFailures;
+}
+
+void ReportBenchmarkResult(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    printf("    ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+uint64 NumHeapAllocations()
+{
+    return HeapAllocationCount;
+}
+
+// Asserts count as check failures instead of breaking into the debugger
+static pow2::Assert::FailBehavior TestAssertHandler(const char* condition, const char* msg, const char* file, int line)
+{
+    printf("%s(%d): Assert failed: %s %s\n", file, line, condition ? condition : "", msg ? msg : "");
+    ++NumCheckFailures;
+    return pow2::Assert::Continue;
+}
+
+}
+
+}
+
+// Everything in the test executable that uses the heap goes through these, so that tests can check
+// for code that allocates when it shouldn't. The array forms end up here by default.
+void* operator new(size_t size)
+{
+    ++SampleFramework12::Tests::HeapAllocationCount;
+    void* memory = malloc(size > 0 ? size : 1);
+    if(memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+// Some standard library code (such as std::stable_sort) uses the nothrow form
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++SampleFramework12::Tests::HeapAllocationCount;
+    return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+using namespace SampleFramework12;
+using namespace SampleFramework12::Tests;
+
+int main(int argc, char** argv)
+{
+    if(NumRegisteredTests > MaxTests || NumRegisteredBenchmarks > MaxBenchmarks)
+    {
+        printf("Too many tests, increase MaxTests or MaxBenchmarks\n");
+        return 1;
+    }
+
+    pow2::Assert::SetHandler(TestAssertHandler);
+
+    // Benchmarks take too long to run after every build, so they're only run when asked for
+    int firstFilterArg = 1;
+    const RegisteredTest* tests = RegisteredTests;
+    uint64 numTests = NumRegisteredTests;
+    if(argc > 1 && strcmp(argv[1], "-benchmark") == 0)
+    {
+        firstFilterArg = 2;
+        tests = RegisteredBenchmarks;
+        numTests = NumRegisteredBenchmarks;
+    }
+
+    // Any other arguments are used as a filter on the test names
+    uint64 numFailedTests = 0;
+    uint64 numRunTests = 0;
+    for(uint64 testIdx = 0; testIdx < numTests; ++testIdx)
+    {
+        const RegisteredTest& test = tests[testIdx];
+        bool run = argc <= firstFilterArg;
+        for(int argIdx = firstFilterArg; argIdx < argc; ++argIdx)
+            run = run || strstr(test.Name, argv[argIdx]) != nullptr;
+        if(run == false)
+            continue;
+
+        // Benchmark results go underneath their name
+        if(tests == RegisteredBenchmarks)
+            printf("%s\n", test.Name);
+
+        const uint64 prevFailures = NumCheckFailures;
+        try
+        {
+            test.Function();
+        }
+        catch(Exception& e)
+        {
+            printf("%s: Unhandled exception: %ls\n", test.Name, e.GetMessage().c_str());
+            ++NumCheckFailures;
+        }
+
+        const bool passed = NumCheckFailures == prevFailures;
+        printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.Name);
+        numFailedTests += passed ? 0 : 1;
+        ++numRunTests;
+    }
+
+    printf("%llu of %llu tests passed\n", numRunTests - numFailedTests, numRunTests);
+    return numFailedTests == 0 ? 0 : 1;
+}
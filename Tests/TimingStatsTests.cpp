@@ -0,0 +1,166 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <TimingStats.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// The sketch buckets values with ~2% relative error, leave a little room on top of that
+static const double SketchTolerance = 0.025;
+
+// Reference implementations that just sort the window
+static double ExactPercentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    const uint64 rank = Clamp(uint64(std::ceil(p * values.size())), uint64(1), uint64(values.size()));
+    return values[rank - 1];
+}
+
+static double ExactMAD(const std::vector<double>& values)
+{
+    const double median = ExactPercentile(values, 0.5);
+    std::vector<double> deviations;
+    for(double value : values)
+        deviations.push_back(std::abs(value - median));
+    return ExactPercentile(deviations, 0.5);
+}
+
+static void AddToWindow(std::vector<double>& window, double value)
+{
+    window.push_back(value);
+    if(window.size() > TimingStats::WindowSize)
+        window.erase(window.begin());
+}
+
+Test_(QuantileSketchMatchesExactQuantiles)
+{
+    std::mt19937 rng(1234);
+    std::lognormal_distribution<double> timings(0.5, 0.4);
+
+    QuantileSketch sketch;
+    std::vector<double> values;
+    for(uint64 i = 0; i < 1000; ++i)
+    {
+        const double value = timings(rng);
+        sketch.Add(value);
+        values.push_back(value);
+    }
+
+    const double quantiles[] = { 0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0 };
+    for(double q : quantiles)
+    {
+        const double exact = ExactPercentile(values, q);
+        CheckNear_(sketch.Quantile(q), exact, exact * SketchTolerance);
+    }
+
+    // Removing values has to leave the same sketch as never adding them
+    for(uint64 i = 0; i < 500; ++i)
+        sketch.Remove(values[i]);
+    values.erase(values.begin(), values.begin() + 500);
+    Check_(sketch.Count() == 500);
+    for(double q : quantiles)
+    {
+        const double exact = ExactPercentile(values, q);
+        CheckNear_(sketch.Quantile(q), exact, exact * SketchTolerance);
+    }
+}
+
+Test_(TimingStatsMatchesExactWindow)
+{
+    std::mt19937 rng(5678);
+    std::lognormal_distribution<double> timings(1.0, 0.25);
+
+    TimingStats stats;
+    std::vector<double> window;
+    for(uint64 i = 0; i < TimingStats::WindowSize * 4 + 17; ++i)
+    {
+        const double value = timings(rng);
+        stats.AddSample(value);
+        AddToWindow(window, value);
+
+        Check_(stats.NumSamples() == window.size());
+        Check_(stats.Maximum() == *std::max_element(window.begin(), window.end()));
+        Check_(stats.MAD() == ExactMAD(window));
+
+        const double percentiles[] = { 0.05, 0.5, 0.95, 0.99 };
+        for(double p : percentiles)
+        {
+            const double exact = ExactPercentile(window, p);
+            CheckNear_(stats.Percentile(p), exact, exact * SketchTolerance);
+        }
+    }
+}
+
+Test_(TimingStatsRejectsOutliers)
+{
+    TimingStats stats;
+    for(uint64 i = 0; i < TimingStats::WindowSize; ++i)
+        Check_(stats.AddSample(1.0 + (i % 5) * 0.01));
+
+    // The oldest sample drops out too, so the mean moves a little
+    const double mean = stats.Mean();
+    Check_(stats.AddSample(10.0) == false);
+    Check_(stats.NumOutliers() == 1);
+    CheckNear_(stats.Mean(), mean, 0.001);
+    Check_(stats.Maximum() == 10.0);
+
+    // The outlier drops out once it leaves the window
+    for(uint64 i = 0; i < TimingStats::WindowSize; ++i)
+        stats.AddSample(1.0 + (i % 5) * 0.01);
+    Check_(stats.NumOutliers() == 0);
+    Check_(stats.Maximum() < 10.0);
+}
+
+Test_(TimingStatsFollowsStepChange)
+{
+    TimingStats stats;
+    std::vector<double> window;
+    for(uint64 i = 0; i < TimingStats::WindowSize; ++i)
+    {
+        const double value = 1.0 + (i % 5) * 0.01;
+        stats.AddSample(value);
+        AddToWindow(window, value);
+    }
+
+    // Until more than half of the window has the new timing the median doesn't move, so those
+    // samples can be rejected. Past that point, everything has to be accepted.
+    const uint64 numToMoveMedian = TimingStats::WindowSize / 2 + 1;
+    for(uint64 i = 0; i < TimingStats::WindowSize * 2; ++i)
+    {
+        const double value = 2.0 + (i % 5) * 0.01;
+        const bool accepted = stats.AddSample(value);
+        AddToWindow(window, value);
+
+        if(i >= numToMoveMedian)
+            Check_(accepted);
+        Check_(stats.MAD() == ExactMAD(window));
+    }
+
+    Check_(stats.NumOutliers() == 0);
+    CheckNear_(stats.Mean(), 2.02, 0.001);
+    CheckNear_(stats.Median(), 2.02, 2.02 * SketchTolerance);
+}
+
+Test_(TimingStatsReset)
+{
+    TimingStats stats;
+    stats.SetOutlierThreshold(2.0);
+    for(uint64 i = 0; i < 10; ++i)
+        stats.AddSample(double(i));
+    stats.Reset();
+
+    Check_(stats.NumSamples() == 0);
+    Check_(stats.Mean() == 0.0);
+    Check_(stats.Maximum() == 0.0);
+    Check_(stats.MAD() == 0.0);
+}
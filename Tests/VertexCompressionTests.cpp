@@ -0,0 +1,206 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Graphics/VertexCompression.h>
+#include <Containers.h>
+#include <Utility.h>
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// The bounds documented alongside CompactVertexErrors, with a little slack for float rounding
+static const float MaxDirectionError = 0.01f;
+static const float MaxBitangentError = 0.02f;
+
+static Float3 RandomDirection(std::mt19937& random)
+{
+    std::normal_distribution<float> normal;
+    Float3 dir;
+    do
+    {
+        dir = Float3(normal(random), normal(random), normal(random));
+    }
+    while(Float3::Length(dir) < 0.001f);
+
+    return Float3::Normalize(dir);
+}
+
+// Orthogonal tangent frame with a random handedness
+static void SetTangentFrame(MeshVertex& vertex, const Float3& normal, const Float3& tangentDir, bool flipBitangent)
+{
+    vertex.Normal = normal;
+    vertex.Tangent = Float3::Normalize(Float3::Cross(normal, tangentDir));
+    vertex.Bitangent = Float3::Cross(normal, vertex.Tangent);
+    if(flipBitangent)
+        vertex.Bitangent = vertex.Bitangent * -1.0f;
+}
+
+static void ComputeAABB(const Array<MeshVertex>& vertices, Float3& aabbMin, Float3& aabbMax)
+{
+    aabbMin = Float3(FloatMax, FloatMax, FloatMax);
+    aabbMax = Float3(-FloatMax, -FloatMax, -FloatMax);
+    for(uint64 i = 0; i < vertices.Size(); ++i)
+    {
+        const Float3& position = vertices[i].Position;
+        aabbMin = Float3(Min(aabbMin.x, position.x), Min(aabbMin.y, position.y), Min(aabbMin.z, position.z));
+        aabbMax = Float3(Max(aabbMax.x, position.x), Max(aabbMax.y, position.y), Max(aabbMax.z, position.z));
+    }
+}
+
+// A cosine can't resolve angles this small in single precision, so this goes through atan2
+static float AngleInDegrees(const Float3& a, const Float3& b)
+{
+    return RadToDeg(std::atan2(Float3::Length(Float3::Cross(a, b)), Float3::Dot(a, b)));
+}
+
+static float PositionBound(float aabbMin, float aabbMax)
+{
+    return (aabbMax - aabbMin) / 65535.0f * 0.5f + Max(std::abs(aabbMin), std::abs(aabbMax)) * 1e-6f;
+}
+
+// Checks against the documented bounds, both through MeasureCompactVertexErrors() and by decoding the
+// vertices directly, so that a bug in the measuring can't hide a bug in the encoding
+static void CheckErrorBounds(const Array<MeshVertex>& vertices, const Float3& aabbMin, const Float3& aabbMax)
+{
+    const uint64 numVertices = vertices.Size();
+    Array<CompactMeshVertex> encoded(numVertices);
+    EncodeCompactVertices(vertices.Data(), numVertices, aabbMin, aabbMax, encoded.Data());
+
+    const float positionBound = Max(PositionBound(aabbMin.x, aabbMax.x),
+                                    Max(PositionBound(aabbMin.y, aabbMax.y), PositionBound(aabbMin.z, aabbMax.z)));
+
+    const CompactVertexErrors errors = MeasureCompactVertexErrors(vertices.Data(), encoded.Data(), numVertices, aabbMin, aabbMax);
+    Check_(errors.MaxPositionError <= positionBound);
+    Check_(errors.MaxNormalError <= MaxDirectionError);
+    Check_(errors.MaxTangentError <= MaxDirectionError);
+    Check_(errors.MaxBitangentError <= MaxBitangentError);
+
+    Array<MeshVertex> decoded(numVertices);
+    DecodeCompactVertices(encoded.Data(), numVertices, aabbMin, aabbMax, decoded.Data());
+
+    bool positionsInBounds = true;
+    bool directionsInBounds = true;
+    bool uvsInBounds = true;
+    for(uint64 i = 0; i < numVertices; ++i)
+    {
+        const MeshVertex& src = vertices[i];
+        const MeshVertex& dst = decoded[i];
+        positionsInBounds = positionsInBounds && std::abs(src.Position.x - dst.Position.x) <= PositionBound(aabbMin.x, aabbMax.x);
+        positionsInBounds = positionsInBounds && std::abs(src.Position.y - dst.Position.y) <= PositionBound(aabbMin.y, aabbMax.y);
+        positionsInBounds = positionsInBounds && std::abs(src.Position.z - dst.Position.z) <= PositionBound(aabbMin.z, aabbMax.z);
+
+        // The bitangent also has to keep its handedness
+        directionsInBounds = directionsInBounds && AngleInDegrees(src.Normal, dst.Normal) <= MaxDirectionError;
+        directionsInBounds = directionsInBounds && AngleInDegrees(src.Tangent, dst.Tangent) <= MaxDirectionError;
+        directionsInBounds = directionsInBounds && AngleInDegrees(src.Bitangent, dst.Bitangent) <= MaxBitangentError;
+
+        uvsInBounds = uvsInBounds && std::abs(src.UV.x - dst.UV.x) <= std::abs(src.UV.x) / 2048.0f;
+        uvsInBounds = uvsInBounds && std::abs(src.UV.y - dst.UV.y) <= std::abs(src.UV.y) / 2048.0f;
+    }
+
+    Check_(positionsInBounds);
+    Check_(directionsInBounds);
+    Check_(uvsInBounds);
+}
+
+// Random vertices in a wide, flat box, with an odd count so that the last batch is a partial one
+Test_(CompactVerticesStayWithinErrorBounds)
+{
+    std::mt19937 random(18);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> uv(-4.0f, 4.0f);
+
+    Array<MeshVertex> vertices(10007);
+    for(uint64 i = 0; i < vertices.Size(); ++i)
+    {
+        MeshVertex& vertex = vertices[i];
+        vertex.Position = Float3(position(random), position(random) * 0.1f, position(random));
+        SetTangentFrame(vertex, RandomDirection(random), RandomDirection(random), (random() & 1) != 0);
+        vertex.UV = Float2(uv(random), uv(random));
+    }
+
+    Float3 aabbMin, aabbMax;
+    ComputeAABB(vertices, aabbMin, aabbMax);
+    CheckErrorBounds(vertices, aabbMin, aabbMax);
+
+    // 20 bytes instead of 56, for 64% less vertex memory
+    Check_(sizeof(CompactMeshVertex) * vertices.Size() * 100 <= sizeof(MeshVertex) * vertices.Size() * 36);
+}
+
+// Directions along the axes and the octahedron's edges (where the lower hemisphere gets folded over),
+// a flat mesh, and every size of partial batch
+Test_(CompactVerticesEdgeCases)
+{
+    const float s = 0.70710678f;
+    const Float3 directions[] =
+    {
+        Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f),
+        Float3(0.0f, -1.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f),
+        Float3(s, s, 0.0f), Float3(-s, 0.0f, -s), Float3(0.0f, -s, -s), Float3(s, -s, 0.0f),
+    };
+    const uint64 numDirections = ArraySize_(directions);
+
+    Array<MeshVertex> vertices(numDirections * numDirections);
+    for(uint64 i = 0; i < numDirections; ++i)
+    {
+        for(uint64 j = 0; j < numDirections; ++j)
+        {
+            MeshVertex& vertex = vertices[i * numDirections + j];
+            vertex.Position = Float3(float(i), 0.0f, float(j) * 0.25f);
+            vertex.UV = Float2(float(i) / numDirections, -float(j));
+
+            // Skip tangents that are parallel to the normal
+            const Float3 tangentDir = std::abs(Float3::Dot(directions[i], directions[j])) > 0.9f ? directions[(j + 2) % numDirections] : directions[j];
+            SetTangentFrame(vertex, directions[i], tangentDir, (i + j) % 2 == 0);
+        }
+    }
+
+    // The y extent is zero, and has to come back exactly instead of dividing by zero
+    Float3 aabbMin, aabbMax;
+    ComputeAABB(vertices, aabbMin, aabbMax);
+    Check_(aabbMin.y == aabbMax.y);
+    CheckErrorBounds(vertices, aabbMin, aabbMax);
+
+    Array<CompactMeshVertex> encoded(vertices.Size());
+    Array<MeshVertex> decoded(vertices.Size());
+    EncodeCompactVertices(vertices.Data(), vertices.Size(), aabbMin, aabbMax, encoded.Data());
+    DecodeCompactVertices(encoded.Data(), vertices.Size(), aabbMin, aabbMax, decoded.Data());
+    bool flatMatches = true;
+    for(uint64 i = 0; i < decoded.Size(); ++i)
+        flatMatches = flatMatches && decoded[i].Position.y == aabbMin.y;
+    Check_(flatMatches);
+
+    // Partial batches can't write past the end of either array
+    for(uint64 count = 0; count < 8; ++count)
+    {
+        CompactMeshVertex compact[9];
+        MeshVertex expanded[9];
+        memset(compact, 0xAB, sizeof(compact));
+        memset(expanded, 0xAB, sizeof(expanded));
+        EncodeCompactVertices(vertices.Data(), count, aabbMin, aabbMax, compact);
+        DecodeCompactVertices(compact, count, aabbMin, aabbMax, expanded);
+
+        const uint8* compactEnd = reinterpret_cast<const uint8*>(compact + count);
+        const uint8* expandedEnd = reinterpret_cast<const uint8*>(expanded + count);
+        bool untouched = true;
+        for(uint64 i = 0; i < sizeof(CompactMeshVertex); ++i)
+            untouched = untouched && compactEnd[i] == 0xAB;
+        for(uint64 i = 0; i < sizeof(MeshVertex); ++i)
+            untouched = untouched && expandedEnd[i] == 0xAB;
+        Check_(untouched);
+
+        bool matches = true;
+        for(uint64 i = 0; i < count; ++i)
+            matches = matches && memcmp(&compact[i], &encoded[i], sizeof(CompactMeshVertex)) == 0;
+        Check_(matches);
+    }
+}
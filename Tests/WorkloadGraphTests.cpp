@@ -0,0 +1,231 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Allocators.h>
+#include <Utility.h>
+#include "..\\OverlappedExecution\\WorkloadGraph.h"
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// Writes out a queue's steps in a compact form, like "W0 B[F0 E1] W2 S1 WD1", so that whole
+// schedules can be checked against what they should look like
+static std::string DescribeSteps(const WorkloadSchedule& schedule, WorkloadQueue queue)
+{
+    static const char* BarrierTypes[] = { "F", "B", "E" };
+    static const char* QueueNames[] = { "D", "C" };
+
+    std::string desc;
+    const GrowableList<ScheduleStep>& steps = schedule.Steps[uint64(queue)];
+    for(uint64 i = 0; i < steps.Count(); ++i)
+    {
+        const ScheduleStep& step = steps[i];
+        if(desc.length() > 0)
+            desc += " ";
+
+        if(step.Type == ScheduleStepType::Workload)
+        {
+            desc += "W" + std::to_string(step.WorkloadIdx);
+        }
+        else if(step.Type == ScheduleStepType::Barriers)
+        {
+            desc += "B[";
+            for(uint64 b = 0; b < step.NumBarriers; ++b)
+            {
+                const ScheduledBarrier& barrier = schedule.Barriers[step.BarrierStart + b];
+                desc += (b > 0 ? " " : "") + std::string(BarrierTypes[uint64(barrier.Type)]) + std::to_string(barrier.WorkloadIdx);
+            }
+            desc += "]";
+        }
+        else if(step.Type == ScheduleStepType::Signal)
+        {
+            desc += "S" + std::to_string(step.FenceValue);
+        }
+        else
+        {
+            desc += "W" + std::string(QueueNames[uint64(step.FenceQueue)]) + std::to_string(step.FenceValue);
+        }
+    }
+
+    return desc;
+}
+
+static WorkloadNode MakeNode(WorkloadType type, std::initializer_list<uint64> dependencies)
+{
+    WorkloadNode node;
+    node.Type = type;
+    for(uint64 dependency : dependencies)
+        node.AddDependency(dependency);
+    return node;
+}
+
+static std::string BuildAndDescribe(const WorkloadNode* nodes, uint64 numNodes, bool useSplitBarriers,
+                                    WorkloadSchedule& schedule, WorkloadQueue queue)
+{
+    BuildWorkloadSchedule(nodes, numNodes, useSplitBarriers, schedule);
+    return DescribeSteps(schedule, queue);
+}
+
+Test_(WorkloadNodeDependencies)
+{
+    WorkloadNode node = MakeNode(WorkloadType::Compute, { 3, 1, 4 });
+    Check_(node.NumDependencies == 3);
+    Check_(node.AddDependency(1));
+    Check_(node.NumDependencies == 3);
+
+    node.RemoveDependencyAt(0);
+    Check_(node.NumDependencies == 2);
+    Check_(node.Dependencies[0] == 1 && node.Dependencies[1] == 4);
+
+    node.RemoveDependency(4);
+    Check_(node.NumDependencies == 1);
+    Check_(node.DependsOn(1) && node.DependsOn(4) == false);
+
+    for(uint64 i = 0; i < MaxWorkloadDependencies * 2; ++i)
+        node.AddDependency(10 + i);
+    Check_(node.NumDependencies == MaxWorkloadDependencies);
+}
+
+Test_(WorkloadGraphValidation)
+{
+    std::string error;
+
+    WorkloadNode chain[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Graphics, { 0 }),
+        MakeNode(WorkloadType::ComputeQueue, { 0, 1 }),
+    };
+    Check_(ValidateWorkloadGraph(chain, ArraySize_(chain), error));
+    Check_(error.empty());
+
+    WorkloadNode outOfRange[] = { MakeNode(WorkloadType::Compute, { 1 }) };
+    Check_(ValidateWorkloadGraph(outOfRange, ArraySize_(outOfRange), error) == false);
+    Check_(error.empty() == false);
+
+    WorkloadNode self[] = { MakeNode(WorkloadType::Compute, { }), MakeNode(WorkloadType::Compute, { 1 }) };
+    Check_(ValidateWorkloadGraph(self, ArraySize_(self), error) == false);
+
+    WorkloadNode cycle[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { 0, 3 }),
+        MakeNode(WorkloadType::Compute, { 1 }),
+        MakeNode(WorkloadType::Compute, { 2 }),
+    };
+    Check_(ValidateWorkloadGraph(cycle, ArraySize_(cycle), error) == false);
+
+    // Disabled workloads still count, so that enabling one can't break the graph
+    cycle[2].Enabled = false;
+    Check_(ValidateWorkloadGraph(cycle, ArraySize_(cycle), error) == false);
+
+    cycle[1].RemoveDependency(3);
+    Check_(ValidateWorkloadGraph(cycle, ArraySize_(cycle), error));
+}
+
+Test_(ScheduleSingleQueueChain)
+{
+    FrameAllocatorScope frameAllocatorScope;
+
+    WorkloadNode nodes[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Graphics, { 0 }),
+        MakeNode(WorkloadType::Compute, { 1 }),
+    };
+
+    WorkloadSchedule schedule;
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), false, schedule, WorkloadQueue::Direct) == "W0 B[F0] W1 B[F1] W2");
+    Check_(DescribeSteps(schedule, WorkloadQueue::Compute) == "");
+    Check_(schedule.NumLevels == 3);
+    Check_(schedule.Levels[0] == 0 && schedule.Levels[1] == 1 && schedule.Levels[2] == 2);
+    Check_(schedule.NumSignals[0] == 0 && schedule.NumSignals[1] == 0);
+}
+
+Test_(ScheduleCoalescesBarriersPerLevel)
+{
+    FrameAllocatorScope frameAllocatorScope;
+
+    // Two independent producers feeding two consumers: one batch of barriers between the levels
+    WorkloadNode nodes[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { 0, 1 }),
+        MakeNode(WorkloadType::Graphics, { 1 }),
+    };
+
+    WorkloadSchedule schedule;
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), false, schedule, WorkloadQueue::Direct) == "W0 W1 B[F0 F1] W2 W3");
+    Check_(schedule.NumLevels == 2);
+}
+
+Test_(ScheduleSkipsDisabledWorkloads)
+{
+    FrameAllocatorScope frameAllocatorScope;
+
+    WorkloadNode nodes[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { 0 }),
+        MakeNode(WorkloadType::Compute, { 1 }),
+    };
+    nodes[1].Enabled = false;
+
+    WorkloadSchedule schedule;
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), false, schedule, WorkloadQueue::Direct) == "W0 W2");
+    Check_(schedule.Levels[1] == WorkloadSchedule::InvalidLevel);
+    Check_(schedule.Levels[2] == 0);
+    Check_(schedule.NumLevels == 1);
+}
+
+Test_(ScheduleCrossQueueFences)
+{
+    FrameAllocatorScope frameAllocatorScope;
+
+    // Direct -> compute queue -> direct, with the last one also depending on the first
+    WorkloadNode nodes[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::ComputeQueue, { 0 }),
+        MakeNode(WorkloadType::Graphics, { 0, 1 }),
+    };
+
+    WorkloadSchedule schedule;
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), false, schedule, WorkloadQueue::Direct) == "W0 S1 WC1 W2");
+    Check_(DescribeSteps(schedule, WorkloadQueue::Compute) == "WD1 W1 S1");
+    Check_(schedule.NumSignals[uint64(WorkloadQueue::Direct)] == 1);
+    Check_(schedule.NumSignals[uint64(WorkloadQueue::Compute)] == 1);
+}
+
+Test_(ScheduleSplitBarriers)
+{
+    FrameAllocatorScope frameAllocatorScope;
+
+    // Workload 0 isn't consumed until level 2, so its barrier can begin after level 0 and end
+    // right before workload 3, overlapping with workload 2 in between
+    WorkloadNode nodes[] =
+    {
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { }),
+        MakeNode(WorkloadType::Compute, { 1 }),
+        MakeNode(WorkloadType::Compute, { 0, 2 }),
+    };
+
+    WorkloadSchedule schedule;
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), false, schedule, WorkloadQueue::Direct) == "W0 W1 B[F1] W2 B[F0 F2] W3");
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), true, schedule, WorkloadQueue::Direct) == "W0 W1 B[B0 F1] W2 B[E0 F2] W3");
+
+    // Rebuilding with the same graph has to produce the same schedule
+    const std::string first = DescribeSteps(schedule, WorkloadQueue::Direct);
+    Check_(BuildAndDescribe(nodes, ArraySize_(nodes), true, schedule, WorkloadQueue::Direct) == first);
+}
@@ -0,0 +1,293 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework Tests
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Timer.h>
+#include <Utility.h>
+#include "..\\OverlappedExecution\\WorkloadMonitor.h"
+
+#include "TestHarness.h"
+
+using namespace SampleFramework12;
+
+// TSC and QPC can disagree a little after calibration, so times are only compared this closely
+static const float TimeTolerance = 0.01f;
+
+// A value that the fake "GPU" writes at a set time after it starts playing
+struct FakeWrite
+{
+    double TimeMS = 0.0;
+    uint64 Target = 0;
+    bool End = false;
+};
+
+// Stands in for the readback buffers that the workload shaders write their start and end values to.
+// Writes are played back from a separate thread, the same way that the GPU would make them show up.
+class FakeWorkloadBuffers
+{
+
+public:
+
+    static const uint64 MaxTargets = 8;
+
+    volatile uint32 StartData[MaxTargets] = { };
+    volatile uint32 EndData[MaxTargets] = { };
+
+    ~FakeWorkloadBuffers()
+    {
+        Wait();
+    }
+
+    void GetTargets(MonitorTarget* targets, uint64 numTargets) const
+    {
+        for(uint64 i = 0; i < numTargets; ++i)
+        {
+            targets[i].StartData = &StartData[i];
+            targets[i].EndData = &EndData[i];
+            targets[i].ID = 100 + i;
+        }
+    }
+
+    void Play(const FakeWrite* writes, uint64 numWrites, uint32 value)
+    {
+        Wait();
+        thread = std::thread([=]()
+        {
+            Timer timer;
+            for(uint64 i = 0; i < numWrites; ++i)
+            {
+                while(timer.ElapsedMillisecondsD() < writes[i].TimeMS)
+                {
+                    Sleep(0);
+                    timer.Update();
+                }
+
+                if(writes[i].End)
+                    EndData[writes[i].Target] = value;
+                else
+                    StartData[writes[i].Target] = value;
+            }
+        });
+    }
+
+    void Wait()
+    {
+        if(thread.joinable())
+            thread.join();
+    }
+
+protected:
+
+    std::thread thread;
+};
+
+// Arms the monitor, plays back the writes, and returns how long it took for the monitor to go idle
+static double RunFrame(WorkloadMonitor& monitor, FakeWorkloadBuffers& buffers, uint64 frame, uint32 signalValue,
+                       uint64 numTargets, const FakeWrite* writes, uint64 numWrites)
+{
+    MonitorTarget targets[FakeWorkloadBuffers::MaxTargets];
+    buffers.GetTargets(targets, numTargets);
+
+    Timer timer;
+    monitor.BeginFrame(frame, signalValue, targets, numTargets);
+    buffers.Play(writes, numWrites, signalValue);
+    monitor.WaitForIdle();
+    timer.Update();
+    buffers.Wait();
+
+    return timer.ElapsedMillisecondsD();
+}
+
+// Two overlapping workloads, one that follows both of them, and one that starts and finishes between
+// two polls so that only its end value is ever seen
+Test_(MonitorTimesWorkloadsFromFakeBuffers)
+{
+    const FakeWrite writes[] =
+    {
+        { 2.0, 0, false }, { 4.0, 1, false }, { 8.0, 0, true }, { 10.0, 1, true },
+        { 12.0, 2, false }, { 14.0, 3, true }, { 16.0, 2, true },
+    };
+    const uint64 numTargets = 4;
+
+    WorkloadMonitor monitor;
+    monitor.Initialize();
+    Check_(monitor.TSCFrequency() > 0.0);
+    Check_(monitor.Idle());
+
+    // Every policy, and then every policy again with the previous frame's values left in the buffers
+    FakeWorkloadBuffers buffers;
+    const uint64 numPolicies = uint64(MonitorWaitPolicy::NumValues);
+    for(uint64 frame = 0; frame < numPolicies * 2; ++frame)
+    {
+        monitor.SetWaitPolicy(MonitorWaitPolicy(frame % numPolicies));
+        const uint32 signalValue = uint32(frame + 1);
+        const double frameTime = RunFrame(monitor, buffers, frame, signalValue, numTargets, writes, ArraySize_(writes));
+        Check_(monitor.Idle());
+
+        MonitorResult result;
+        Check_(monitor.PopResult(result));
+        Check_(monitor.PopResult(result) == false);
+        Check_(result.Frame == frame);
+        Check_(result.NumTargets == numTargets);
+        Check_(result.TimedOut == false);
+        for(uint64 i = 0; i < numTargets; ++i)
+            Check_(result.IDs[i] == 100 + i);
+
+        // Nothing can be seen before it was written, or after the monitor went idle
+        bool inRange = true;
+        for(uint64 i = 0; i < ArraySize_(writes); ++i)
+        {
+            const FakeWrite& write = writes[i];
+            const float time = write.End ? result.EndTimes[write.Target] : result.StartTimes[write.Target];
+            inRange = inRange && time >= write.TimeMS * (1.0f - TimeTolerance);
+            inRange = inRange && time <= frameTime * (1.0f + TimeTolerance);
+        }
+        Check_(inRange);
+
+        // A busy machine can keep the monitor from polling for a while, which can put two transitions
+        // in the same pass, but it can't flip their order
+        Check_(result.StartTimes[0] <= result.EndTimes[0]);
+        Check_(result.StartTimes[1] <= result.EndTimes[1]);
+        Check_(result.StartTimes[1] <= result.EndTimes[0]);
+        Check_(result.EndTimes[0] <= result.StartTimes[2] && result.EndTimes[1] <= result.StartTimes[2]);
+        Check_(result.StartTimes[2] <= result.EndTimes[2]);
+
+        // The times in milliseconds are the same intervals as the raw TSC values
+        bool matchesTSC = true;
+        for(uint64 i = 0; i < numTargets; ++i)
+        {
+            const double tscDuration = double(result.EndTSC[i] - result.StartTSC[i]) * 1000.0 / monitor.TSCFrequency();
+            matchesTSC = matchesTSC && std::abs(double(result.EndTimes[i] - result.StartTimes[i]) - tscDuration) < 0.001;
+        }
+        Check_(matchesTSC);
+
+        // A missed start gets stamped along with the end
+        Check_(result.StartTSC[3] == result.EndTSC[3]);
+        Check_(result.StartTimes[3] == result.EndTimes[3]);
+    }
+
+    Check_(monitor.NumDroppedResults() == 0);
+    monitor.Shutdown();
+}
+
+// A workload that never finishes shouldn't hang the monitor, and the ones that did finish still get
+// their times
+Test_(MonitorTimesOutOnStuckWorkloads)
+{
+    MonitorSettings settings;
+    settings.WaitPolicy = MonitorWaitPolicy::Yield;
+    settings.TimeoutMS = 25.0f;
+
+    WorkloadMonitor monitor;
+    monitor.Initialize(settings);
+
+    // Target 0 starts and never ends, target 2 never even starts
+    const FakeWrite writes[] = { { 2.0, 0, false }, { 3.0, 1, false }, { 4.0, 1, true } };
+    FakeWorkloadBuffers buffers;
+    const double frameTime = RunFrame(monitor, buffers, 7, 1, 3, writes, ArraySize_(writes));
+    Check_(frameTime >= settings.TimeoutMS * (1.0f - TimeTolerance));
+
+    MonitorResult result;
+    Check_(monitor.PopResult(result));
+    Check_(result.Frame == 7);
+    Check_(result.TimedOut);
+
+    Check_(result.StartTimes[0] >= 2.0f * (1.0f - TimeTolerance));
+    Check_(result.EndTimes[0] == 0.0f && result.EndTSC[0] == 0);
+    Check_(result.StartTimes[1] >= 3.0f * (1.0f - TimeTolerance));
+    Check_(result.EndTimes[1] >= 4.0f * (1.0f - TimeTolerance));
+    Check_(result.StartTimes[2] == 0.0f && result.EndTimes[2] == 0.0f);
+    Check_(result.StartTSC[2] == 0 && result.EndTSC[2] == 0);
+
+    // The next frame isn't affected by the one that timed out
+    const FakeWrite nextWrites[] = { { 1.0, 0, true }, { 1.0, 1, true }, { 1.0, 2, true } };
+    RunFrame(monitor, buffers, 8, 2, 3, nextWrites, ArraySize_(nextWrites));
+    Check_(monitor.PopResult(result));
+    Check_(result.Frame == 8 && result.TimedOut == false);
+
+    monitor.Shutdown();
+}
+
+// Results that aren't consumed fill up the ring, after which new ones get dropped rather than
+// overwriting the ones that are waiting
+Test_(MonitorDropsResultsWhenRingIsFull)
+{
+    WorkloadMonitor monitor;
+    monitor.Initialize();
+
+    // Everything has already finished by the time the monitor is armed
+    FakeWorkloadBuffers buffers;
+    buffers.StartData[0] = buffers.EndData[0] = 1;
+    buffers.StartData[1] = buffers.EndData[1] = 1;
+
+    const uint64 numFrames = 10;
+    for(uint64 frame = 0; frame < numFrames; ++frame)
+        RunFrame(monitor, buffers, frame, 1, 2, nullptr, 0);
+
+    // The size of the monitor's result ring
+    const uint64 ringSize = 8;
+    Check_(monitor.NumDroppedResults() == numFrames - ringSize);
+
+    bool inOrder = true;
+    MonitorResult result;
+    for(uint64 frame = 0; frame < ringSize; ++frame)
+    {
+        inOrder = inOrder && monitor.PopResult(result) && result.Frame == frame;
+        inOrder = inOrder && result.StartTSC[0] == result.EndTSC[0] && result.StartTSC[1] == result.EndTSC[1];
+        inOrder = inOrder && result.TimedOut == false;
+    }
+    Check_(inOrder);
+    Check_(monitor.PopResult(result) == false);
+
+    // There's room again once the ring has been drained
+    RunFrame(monitor, buffers, numFrames, 1, 2, nullptr, 0);
+    Check_(monitor.PopResult(result) && result.Frame == numFrames);
+    Check_(monitor.NumDroppedResults() == numFrames - ringSize);
+
+    monitor.Shutdown();
+}
+
+// One thread pushing and another popping, with a small ring so that both sides keep running into
+// the full and empty cases
+Test_(SPSCRingKeepsOrderAcrossThreads)
+{
+    SPSCRing<uint64, 4> ring;
+    uint64 item = 0;
+    Check_(ring.Pop(item) == false);
+    for(uint64 i = 0; i < 4; ++i)
+        Check_(ring.Push(i));
+    Check_(ring.Push(4) == false);
+    Check_(ring.Count() == 4);
+    for(uint64 i = 0; i < 4; ++i)
+        Check_(ring.Pop(item) && item == i);
+    Check_(ring.Count() == 0);
+
+    const uint64 numItems = 100000;
+    std::thread producer([&]()
+    {
+        for(uint64 i = 0; i < numItems; ++i)
+        {
+            while(ring.Push(i) == false)
+                YieldProcessor();
+        }
+    });
+
+    bool inOrder = true;
+    for(uint64 i = 0; i < numItems; ++i)
+    {
+        while(ring.Pop(item) == false)
+            YieldProcessor();
+        inOrder = inOrder && item == i;
+    }
+    producer.join();
+
+    Check_(inOrder);
+    Check_(ring.Count() == 0);
+}